@@ -43,6 +43,9 @@ void fluid_ensure_obstacle(struct FLUID *fluid, struct SmokeModifierData *smd);
 void fluid_ensure_guiding(struct FLUID *fluid, struct SmokeModifierData *smd);
 void fluid_ensure_invelocity(struct FLUID *fluid, struct SmokeModifierData *smd);
 int fluid_write_data(struct FLUID* fluid, struct SmokeModifierData *smd, int framenr);
+void fluid_flush_writes(struct FLUID* fluid);
+void fluid_start_profile(struct FLUID* fluid, const char *filename, int chrome_trace);
+void fluid_stop_profile(struct FLUID* fluid);
 int fluid_read_data(struct FLUID* fluid, struct SmokeModifierData *smd, int framenr);
 int fluid_read_noise(struct FLUID* fluid, struct SmokeModifierData *smd, int framenr);
 int fluid_read_mesh(struct FLUID* fluid, struct SmokeModifierData *smd, int framenr);
@@ -60,6 +63,7 @@ void fluid_update_variables(struct FLUID* fluid, struct SmokeModifierData *smd);
 int fluid_get_frame(struct FLUID* fluid);
 float fluid_get_timestep(struct FLUID* fluid);
 void fluid_adapt_timestep(struct FLUID* fluid);
+void fluid_add_inflow_region(struct FLUID* fluid, int *min, int *max);
 
 /* Fluid accessors */
 size_t fluid_get_index(int x, int max_x, int y, int max_y, int z /*, int max_z */);
@@ -177,6 +181,19 @@ float liquid_get_snd_particle_velocity_x_at(struct FLUID *liquid, int i);
 float liquid_get_snd_particle_velocity_y_at(struct FLUID *liquid, int i);
 float liquid_get_snd_particle_velocity_z_at(struct FLUID *liquid, int i);
 
+/* Bulk liquid accessors. Copy at most num elements into r_data, consecutive elements are
+ * stride bytes apart (allows filling e.g. MVert.co directly). Return number of copied elements. */
+int liquid_get_vertices(struct FLUID *liquid, float *r_data, int num, size_t stride);
+int liquid_get_normals(struct FLUID *liquid, float *r_data, int num, size_t stride);
+int liquid_get_triangles(struct FLUID *liquid, int *r_data, int num, size_t stride);
+int liquid_get_vertvels(struct FLUID *liquid, float *r_data, int num, size_t stride);
+int liquid_get_flip_particle_flags(struct FLUID *liquid, int *r_data, int num, size_t stride);
+int liquid_get_flip_particle_positions(struct FLUID *liquid, float *r_data, int num, size_t stride);
+int liquid_get_flip_particle_velocities(struct FLUID *liquid, float *r_data, int num, size_t stride);
+int liquid_get_snd_particle_flags(struct FLUID *liquid, int *r_data, int num, size_t stride);
+int liquid_get_snd_particle_positions(struct FLUID *liquid, float *r_data, int num, size_t stride);
+int liquid_get_snd_particle_velocities(struct FLUID *liquid, float *r_data, int num, size_t stride);
+
 #ifdef __cplusplus
 }
 #endif
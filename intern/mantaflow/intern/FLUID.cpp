@@ -31,10 +31,13 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
 #include <zlib.h>
 
 #include "FLUID.h"
 #include "manta.h"
+#include "mantaio.h"
 #include "Python.h"
 #include "fluid_script.h"
 #include "smoke_script.h"
@@ -52,6 +55,10 @@ std::atomic<bool> FLUID::mantaInitialized(false);
 std::atomic<int> FLUID::solverID(0);
 int FLUID::with_debug(0);
 
+// Background cache writer: number of threads and number of files staged in memory before a save blocks
+static const int FLUID_FILE_WRITE_THREADS = 2;
+static const int FLUID_FILE_WRITE_QUEUE = 8;
+
 FLUID::FLUID(int *res, SmokeModifierData *smd) : mCurrentID(++solverID)
 {
 	if (with_debug)
@@ -156,6 +163,17 @@ FLUID::FLUID(int *res, SmokeModifierData *smd) : mCurrentID(++solverID)
 	mSndParticleVelocity   = NULL;
 	mSndParticleLife       = NULL;
 
+	// Native stepping
+	mNativeStep = NULL;
+	mHasInflowRegion = false;
+
+	// Pointer cache, nothing resolved yet
+	mDescriptorGeneration   = -1;
+	mPointerGeneration      = -1;
+	mPointerGenerationNoise = -1;
+	mPointerFeatures        = -1;
+	mPointerFeaturesNoise   = -1;
+
 	// Only start Mantaflow once. No need to start whenever new FLUID objected is allocated
 	if (!mantaInitialized)
 		initializeMantaflow();
@@ -240,12 +258,18 @@ void FLUID::initDomain(SmokeModifierData *smd)
 	std::vector<std::string> pythonCommands;
 
 	// Set manta debug level first
-	pythonCommands.push_back(manta_import + manta_debuglevel);
+	pythonCommands.push_back(manta_import + manta_debuglevel + manta_file_writer);
 
 	std::ostringstream ss;
 	ss <<  "set_manta_debuglevel(" << with_debug << ")";
 	pythonCommands.push_back(ss.str());
 
+	// Cache files are compressed and written in the background while the next frame is simulated
+	// The writer threads are shared by all domains, initializing another domain keeps them running
+	ss.str("");
+	ss <<  "set_manta_file_writer(" << FLUID_FILE_WRITE_THREADS << ", " << FLUID_FILE_WRITE_QUEUE << ")";
+	pythonCommands.push_back(ss.str());
+
 	// Now init basic fluid domain
 	std::string tmpString = fluid_variables
 		+ fluid_solver
@@ -515,6 +539,8 @@ FLUID::~FLUID()
 	if (with_debug)
 		std::cout << "~FLUID: " << mCurrentID << " with res(" << mResX << ", " << mResY << ", " << mResZ << ")" << std::endl;
 
+	freeNativeStep();
+
 	// Destruction string for Python
 	std::string tmpString = "";
 	std::vector<std::string> pythonCommands;
@@ -708,7 +734,7 @@ std::string FLUID::getRealValue(const std::string& varName,  SmokeModifierData *
 	else if (varName == "COLOR_B")
 		ss << smd->domain->active_color[2];
 	else if (varName == "ADVECT_ORDER")
-		ss << 2;
+		ss << FLUID_ADVECT_ORDER;
 	else if (varName == "BUOYANCY_ALPHA")
 		ss << smd->domain->alpha;
 	else if (varName == "BUOYANCY_BETA")
@@ -879,6 +905,8 @@ static std::string getCacheFileEnding(char cache_format)
 			return ".vdb";
 		case FLUID_DOMAIN_FILE_RAW:
 			return ".raw";
+		case FLUID_DOMAIN_FILE_PLAYBACK:
+			return ".mpc";
 		case FLUID_DOMAIN_FILE_BIN_OBJECT:
 			return ".bobj.gz";
 		case FLUID_DOMAIN_FILE_OBJECT:
@@ -890,6 +918,28 @@ static std::string getCacheFileEnding(char cache_format)
 	}
 }
 
+// OpenVDB export settings are global in Mantaflow, so every domain sets its own before saving
+static void addVDBOptions(std::vector<std::string>& pythonCommands, SmokeModifierData *smd)
+{
+	if (smd->domain->cache_data_format != FLUID_DOMAIN_FILE_OPENVDB && smd->domain->cache_noise_format != FLUID_DOMAIN_FILE_OPENVDB)
+		return;
+
+	int compression = 0;
+	if (smd->domain->openvdb_comp == VDB_COMPRESSION_BLOSC)    compression = 2;
+	else if (smd->domain->openvdb_comp == VDB_COMPRESSION_ZIP) compression = 1;
+
+	std::ostringstream ss;
+	ss << "setVDBOptions(halfFloat=" << ((smd->domain->data_depth == 16) ? "True" : "False") << ", compression=" << compression << ")";
+	pythonCommands.push_back(ss.str());
+}
+
+// Cache files can still be queued for the background writer threads, these have to be on disk first
+static bool cacheFileExists(const char *filename)
+{
+	Manta::waitForFileWrite(filename);
+	return BLI_exists(filename);
+}
+
 int FLUID::updateFlipStructures(SmokeModifierData *smd, int framenr)
 {
 	if (FLUID::with_debug)
@@ -912,7 +962,7 @@ int FLUID::updateFlipStructures(SmokeModifierData *smd, int framenr)
 	BLI_join_dirfile(targetFile, sizeof(targetFile), cacheDir, ss.str().c_str());
 	BLI_path_frame(targetFile, framenr, 0);
 
-	if (BLI_exists(targetFile)) {
+	if (cacheFileExists(targetFile)) {
 		updateParticlesFromFile(targetFile, false, false);
 	}
 
@@ -921,7 +971,7 @@ int FLUID::updateFlipStructures(SmokeModifierData *smd, int framenr)
 	BLI_join_dirfile(targetFile, sizeof(targetFile), cacheDir, ss.str().c_str());
 	BLI_path_frame(targetFile, framenr, 0);
 
-	if (BLI_exists(targetFile)) {
+	if (cacheFileExists(targetFile)) {
 		updateParticlesFromFile(targetFile, false, true);
 	}
 	return 1;
@@ -948,7 +998,7 @@ int FLUID::updateMeshStructures(SmokeModifierData *smd, int framenr)
 	BLI_join_dirfile(targetFile, sizeof(targetFile), cacheDir, ss.str().c_str());
 	BLI_path_frame(targetFile, framenr, 0);
 
-	if (BLI_exists(targetFile)) {
+	if (cacheFileExists(targetFile)) {
 		updateMeshFromFile(targetFile);
 	}
 
@@ -958,7 +1008,7 @@ int FLUID::updateMeshStructures(SmokeModifierData *smd, int framenr)
 		BLI_join_dirfile(targetFile, sizeof(targetFile), cacheDir, ss.str().c_str());
 		BLI_path_frame(targetFile, framenr, 0);
 
-		if (BLI_exists(targetFile)) {
+		if (cacheFileExists(targetFile)) {
 			updateMeshFromFile(targetFile);
 		}
 	}
@@ -985,7 +1035,7 @@ int FLUID::updateParticleStructures(SmokeModifierData *smd, int framenr)
 	BLI_join_dirfile(targetFile, sizeof(targetFile), cacheDir, ss.str().c_str());
 	BLI_path_frame(targetFile, framenr, 0);
 
-	if (BLI_exists(targetFile)) {
+	if (cacheFileExists(targetFile)) {
 		updateParticlesFromFile(targetFile, true, false);
 	}
 
@@ -994,7 +1044,7 @@ int FLUID::updateParticleStructures(SmokeModifierData *smd, int framenr)
 	BLI_join_dirfile(targetFile, sizeof(targetFile), cacheDir, ss.str().c_str());
 	BLI_path_frame(targetFile, framenr, 0);
 
-	if (BLI_exists(targetFile)) {
+	if (cacheFileExists(targetFile)) {
 		updateParticlesFromFile(targetFile, true, true);
 	}
 
@@ -1003,7 +1053,7 @@ int FLUID::updateParticleStructures(SmokeModifierData *smd, int framenr)
 	BLI_join_dirfile(targetFile, sizeof(targetFile), cacheDir, ss.str().c_str());
 	BLI_path_frame(targetFile, framenr, 0);
 
-	if (BLI_exists(targetFile)) {
+	if (cacheFileExists(targetFile)) {
 		updateParticlesFromFile(targetFile, true, false);
 	}
 	return 1;
@@ -1039,6 +1089,7 @@ int FLUID::writeData(SmokeModifierData *smd, int framenr)
 	BLI_path_join(cacheDirData, sizeof(cacheDirData), smd->domain->cache_directory, FLUID_DOMAIN_DIR_DATA, NULL);
 	BLI_path_make_safe(cacheDirData);
 
+	addVDBOptions(pythonCommands, smd);
 	ss << "fluid_save_data_" << mCurrentID << "('" << escapeSlashes(cacheDirData) << "', " << framenr << ", '" << dformat << "')";
 	pythonCommands.push_back(ss.str());
 
@@ -1059,12 +1110,48 @@ int FLUID::writeData(SmokeModifierData *smd, int framenr)
 	return 1;
 }
 
+void FLUID::flushWrites()
+{
+	if (with_debug)
+		std::cout << "FLUID::flushWrites()" << std::endl;
+
+	std::vector<std::string> pythonCommands;
+	pythonCommands.push_back(manta_flush_writes);
+	runPythonString(pythonCommands);
+}
+
+void FLUID::startProfile(const char *filename, bool chromeTrace)
+{
+	if (with_debug)
+		std::cout << "FLUID::startProfile()" << std::endl;
+
+	std::ostringstream ss;
+	std::vector<std::string> pythonCommands;
+
+	ss << "manta_start_profile('" << escapeSlashes(filename) << "', " << (chromeTrace ? "True" : "False") << ")";
+	pythonCommands.push_back(manta_start_profile);
+	pythonCommands.push_back(ss.str());
+	runPythonString(pythonCommands);
+}
+
+void FLUID::stopProfile()
+{
+	if (with_debug)
+		std::cout << "FLUID::stopProfile()" << std::endl;
+
+	std::vector<std::string> pythonCommands;
+	pythonCommands.push_back(manta_stop_profile);
+	pythonCommands.push_back("manta_stop_profile()");
+	runPythonString(pythonCommands);
+}
+
 int FLUID::readData(SmokeModifierData *smd, int framenr)
 {
 	if (with_debug)
 		std::cout << "FLUID::readData()" << std::endl;
 
 	if (!mUsingSmoke && !mUsingLiquid) return 0;
+	invalidateNativeSupport();
 
 	std::ostringstream ss;
 	std::vector<std::string> pythonCommands;
@@ -1202,6 +1289,14 @@ int FLUID::bakeData(SmokeModifierData *smd, int framenr)
 	if (with_debug)
 		std::cout << "FLUID::bakeData()" << std::endl;
 
+	// Default pipelines are stepped directly, custom setups go through the scene script
+	int stepped = stepNative(smd, framenr);
+	if (stepped > 0)
+		return 1;
+	invalidateNativeSupport();
+	if (stepped < 0)
+		return 0;
+
 	std::string tmpString, finalString;
 	std::ostringstream ss;
 	std::vector<std::string> pythonCommands;
@@ -1219,6 +1314,7 @@ int FLUID::bakeData(SmokeModifierData *smd, int framenr)
 	BLI_path_make_safe(cacheDirData);
 	BLI_path_make_safe(cacheDirGuiding);
 
+	addVDBOptions(pythonCommands, smd);
 	ss << "bake_fluid_data_" << mCurrentID << "('" << escapeSlashes(cacheDirData) << "', '" << escapeSlashes(cacheDirGuiding) << "', " << framenr << ", '" << dformat << "', '" << pformat << "', '" << gformat << "')";
 	pythonCommands.push_back(ss.str());
 
@@ -1246,6 +1342,7 @@ int FLUID::bakeNoise(SmokeModifierData *smd, int framenr)
 	BLI_path_make_safe(cacheDirData);
 	BLI_path_make_safe(cacheDirNoise);
 
+	addVDBOptions(pythonCommands, smd);
 	ss << "bake_noise_" << mCurrentID << "('" << escapeSlashes(cacheDirData) << "', '" << escapeSlashes(cacheDirNoise) << "', " << framenr << ", '" << dformat << "', '" << nformat << "')";
 	pythonCommands.push_back(ss.str());
 
@@ -1324,6 +1421,7 @@ int FLUID::bakeGuiding(SmokeModifierData *smd, int framenr)
 	BLI_path_join(cacheDirGuiding, sizeof(cacheDirGuiding), smd->domain->cache_directory, FLUID_DOMAIN_DIR_GUIDING, NULL);
 	BLI_path_make_safe(cacheDirGuiding);
 
+	addVDBOptions(pythonCommands, smd);
 	ss << "bake_guiding_" << mCurrentID << "('" << escapeSlashes(cacheDirGuiding) << "', " << framenr << ", '" << gformat << "')";
 	pythonCommands.push_back(ss.str());
 
@@ -1658,11 +1756,8 @@ static void* stringToPointer(char* inputString)
 	return dataPointer;
 }
 
-int FLUID::getFrame()
+int FLUID::getFramePython()
 {
-	if (with_debug)
-		std::cout << "FLUID::getFrame()" << std::endl;
-	
 	std::string func = "frame";
 	std::string id = std::to_string(mCurrentID);
 	std::string solver = "s" + id;
@@ -1670,11 +1765,8 @@ int FLUID::getFrame()
 	return pyObjectToLong(callPythonFunction(solver, func, true));
 }
 
-float FLUID::getTimestep()
+float FLUID::getTimestepPython()
 {
-	if (with_debug)
-		std::cout << "FLUID::getTimestep()" << std::endl;
-
 	std::string func = "timestep";
 	std::string id = std::to_string(mCurrentID);
 	std::string solver = "s" + id;
@@ -1682,11 +1774,8 @@ float FLUID::getTimestep()
 	return pyObjectToDouble(callPythonFunction(solver, func, true));
 }
 
-void FLUID::adaptTimestep()
+void FLUID::adaptTimestepPython()
 {
-	if (with_debug)
-		std::cout << "FLUID::adaptTimestep()" << std::endl;
-
 	std::vector<std::string> pythonCommands;
 	std::ostringstream ss;
 
@@ -1696,8 +1785,92 @@ void FLUID::adaptTimestep()
 	runPythonString(pythonCommands);
 }
 
+/* Copy num elements with numComp components each. Source and destination elements are stride bytes apart. */
+template<class T>
+static int copyStrided(const T *src, size_t srcStride, T *dst, size_t dstStride, int num, int numComp)
+{
+	const char *srcPtr = (const char*) src;
+	char *dstPtr = (char*) dst;
+	for (int i = 0; i < num; i++, srcPtr += srcStride, dstPtr += dstStride) {
+		memcpy(dstPtr, srcPtr, sizeof(T) * numComp);
+	}
+	return num;
+}
+
+int FLUID::getVertices(float *dst, int num, size_t stride)
+{
+	num = std::min(num, getNumVertices());
+	if (!dst || num <= 0) return 0;
+	return copyStrided(mMeshNodes->front().pos, sizeof(Node), dst, stride, num, 3);
+}
+
+int FLUID::getNormals(float *dst, int num, size_t stride)
+{
+	num = std::min(num, getNumNormals());
+	if (!dst || num <= 0) return 0;
+	return copyStrided(mMeshNodes->front().normal, sizeof(Node), dst, stride, num, 3);
+}
+
+int FLUID::getTriangles(int *dst, int num, size_t stride)
+{
+	num = std::min(num, getNumTriangles());
+	if (!dst || num <= 0) return 0;
+	return copyStrided(mMeshTriangles->front().c, sizeof(Triangle), dst, stride, num, 3);
+}
+
+int FLUID::getVertVels(float *dst, int num, size_t stride)
+{
+	num = (mMeshVelocities) ? std::min(num, (int) mMeshVelocities->size()) : 0;
+	if (!dst || num <= 0) return 0;
+	return copyStrided(mMeshVelocities->front().pos, sizeof(pVel), dst, stride, num, 3);
+}
+
+int FLUID::getFlipParticleFlags(int *dst, int num, size_t stride)
+{
+	num = std::min(num, getNumFlipParticles());
+	if (!dst || num <= 0) return 0;
+	return copyStrided(&mFlipParticleData->front().flag, sizeof(pData), dst, stride, num, 1);
+}
+
+int FLUID::getFlipParticlePositions(float *dst, int num, size_t stride)
+{
+	num = std::min(num, getNumFlipParticles());
+	if (!dst || num <= 0) return 0;
+	return copyStrided(mFlipParticleData->front().pos, sizeof(pData), dst, stride, num, 3);
+}
+
+int FLUID::getFlipParticleVelocities(float *dst, int num, size_t stride)
+{
+	num = (mFlipParticleVelocity) ? std::min(num, (int) mFlipParticleVelocity->size()) : 0;
+	if (!dst || num <= 0) return 0;
+	return copyStrided(mFlipParticleVelocity->front().pos, sizeof(pVel), dst, stride, num, 3);
+}
+
+int FLUID::getSndParticleFlags(int *dst, int num, size_t stride)
+{
+	num = std::min(num, getNumSndParticles());
+	if (!dst || num <= 0) return 0;
+	return copyStrided(&mSndParticleData->front().flag, sizeof(pData), dst, stride, num, 1);
+}
+
+int FLUID::getSndParticlePositions(float *dst, int num, size_t stride)
+{
+	num = std::min(num, getNumSndParticles());
+	if (!dst || num <= 0) return 0;
+	return copyStrided(mSndParticleData->front().pos, sizeof(pData), dst, stride, num, 3);
+}
+
+int FLUID::getSndParticleVelocities(float *dst, int num, size_t stride)
+{
+	num = (mSndParticleVelocity) ? std::min(num, (int) mSndParticleVelocity->size()) : 0;
+	if (!dst || num <= 0) return 0;
+	return copyStrided(mSndParticleVelocity->front().pos, sizeof(pVel), dst, stride, num, 3);
+}
+
 void FLUID::updateMeshFromFile(const char* filename)
 {
+	Manta::waitForFileWrite(filename);
+
 	std::string fname(filename);
 	std::string::size_type idx;
 
@@ -1947,6 +2120,8 @@ void FLUID::updateParticlesFromFile(const char* filename, bool isSecondarySys, b
 	if (with_debug)
 		std::cout << "FLUID::updateParticlesFromFile()" << std::endl;
 
+	Manta::waitForFileWrite(filename);
+
 	std::string fname(filename);
 	std::string::size_type idx;
 
@@ -2069,8 +2244,34 @@ void FLUID::updateParticlesFromUni(const char* filename, bool isSecondarySys, bo
 	gzclose(gzf);
 }
 
+int FLUID::getFeatureFlags()
+{
+	const bool flags[] = { mUsingHeat, mUsingColors, mUsingFire, mUsingObstacle, mUsingGuiding, mUsingInvel,
+		mUsingNoise, mUsingMesh, mUsingMVel, mUsingLiquid, mUsingSmoke, mUsingDrops, mUsingBubbles,
+		mUsingFloats, mUsingTracers };
+	int features = 0;
+	for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++)
+		features |= (flags[i]) ? (1 << i) : 0;
+	return features;
+}
+
 void FLUID::updatePointers()
 {
+	PyGILState_STATE gilstate = PyGILState_Ensure();
+
+	// Same grid objects as last time (no grids were allocated, no other features enabled): only fetch
+	// the current data pointers, grids swap their memory during the step
+	int generation = getGridGeneration();
+	int features = getFeatureFlags();
+	if (generation != -1 && generation == mPointerGeneration && features == mPointerFeatures) {
+		refreshPointerTable(mPointerTable);
+		PyGILState_Release(gilstate);
+		return;
+	}
+	mPointerGeneration = generation;
+	mPointerFeatures   = features;
+	mPointerTable.clear();
+
 	if (with_debug)
 		std::cout << "FLUID::updatePointers()" << std::endl;
 
@@ -2090,47 +2291,48 @@ void FLUID::updatePointers()
 	std::string mesh_ext   = "_" + mesh;
 	std::string mesh_ext2  = "_" + mesh2;
 
-	mObstacle  = (int*)   stringToPointer(pyObjectToString(callPythonFunction("flags" + solver_ext, func)));
+	bindGrid(mPointerTable, &mObstacle, "flags" + solver_ext);
 
-	mVelocityX = (float*) stringToPointer(pyObjectToString(callPythonFunction("x_vel" + solver_ext, func)));
-	mVelocityY = (float*) stringToPointer(pyObjectToString(callPythonFunction("y_vel" + solver_ext, func)));
-	mVelocityZ = (float*) stringToPointer(pyObjectToString(callPythonFunction("z_vel" + solver_ext, func)));
+	bindGrid(mPointerTable, &mVelocityX, "x_vel" + solver_ext);
+	bindGrid(mPointerTable, &mVelocityY, "y_vel" + solver_ext);
+	bindGrid(mPointerTable, &mVelocityZ, "z_vel" + solver_ext);
 
-	mForceX    = (float*) stringToPointer(pyObjectToString(callPythonFunction("x_force" + solver_ext, func)));
-	mForceY    = (float*) stringToPointer(pyObjectToString(callPythonFunction("y_force" + solver_ext, func)));
-	mForceZ    = (float*) stringToPointer(pyObjectToString(callPythonFunction("z_force" + solver_ext, func)));
+	bindGrid(mPointerTable, &mForceX, "x_force" + solver_ext);
+	bindGrid(mPointerTable, &mForceY, "y_force" + solver_ext);
+	bindGrid(mPointerTable, &mForceZ, "z_force" + solver_ext);
 
-	mPhiOutIn  = (float*) stringToPointer(pyObjectToString(callPythonFunction("phiOutIn"   + solver_ext, func)));
+	bindGrid(mPointerTable, &mPhiOutIn, "phiOutIn"   + solver_ext);
 
 	if (mUsingObstacle) {
-		mPhiObsIn    = (float*) stringToPointer(pyObjectToString(callPythonFunction("phiObsIn" + solver_ext, func)));
-		mNumObstacle = (int*)   stringToPointer(pyObjectToString(callPythonFunction("numObs"   + solver_ext, func)));
+		bindGrid(mPointerTable, &mPhiObsIn, "phiObsIn" + solver_ext);
+		bindGrid(mPointerTable, &mNumObstacle, "numObs"   + solver_ext);
 
-		mObVelocityX = (float*) stringToPointer(pyObjectToString(callPythonFunction("x_obvel" + solver_ext, func)));
-		mObVelocityY = (float*) stringToPointer(pyObjectToString(callPythonFunction("y_obvel" + solver_ext, func)));
-		mObVelocityZ = (float*) stringToPointer(pyObjectToString(callPythonFunction("z_obvel" + solver_ext, func)));
+		bindGrid(mPointerTable, &mObVelocityX, "x_obvel" + solver_ext);
+		bindGrid(mPointerTable, &mObVelocityY, "y_obvel" + solver_ext);
+		bindGrid(mPointerTable, &mObVelocityZ, "z_obvel" + solver_ext);
 	}
 
 	if (mUsingGuiding) {
-		mPhiGuideIn = (float*) stringToPointer(pyObjectToString(callPythonFunction("phiGuideIn"     + solver_ext, func)));
-		mNumGuide   = (int*)   stringToPointer(pyObjectToString(callPythonFunction("numGuides"      + solver_ext, func)));
+		bindGrid(mPointerTable, &mPhiGuideIn, "phiGuideIn"     + solver_ext);
+		bindGrid(mPointerTable, &mNumGuide, "numGuides"      + solver_ext);
 
-		mGuideVelocityX = (float*) stringToPointer(pyObjectToString(callPythonFunction("x_guidevel" + solver_ext, func)));
-		mGuideVelocityY = (float*) stringToPointer(pyObjectToString(callPythonFunction("y_guidevel" + solver_ext, func)));
-		mGuideVelocityZ = (float*) stringToPointer(pyObjectToString(callPythonFunction("z_guidevel" + solver_ext, func)));
+		bindGrid(mPointerTable, &mGuideVelocityX, "x_guidevel" + solver_ext);
+		bindGrid(mPointerTable, &mGuideVelocityY, "y_guidevel" + solver_ext);
+		bindGrid(mPointerTable, &mGuideVelocityZ, "z_guidevel" + solver_ext);
 	}
 
 	if (mUsingInvel) {
-		mInVelocityX = (float*) stringToPointer(pyObjectToString(callPythonFunction("x_invel" + solver_ext, func)));
-		mInVelocityY = (float*) stringToPointer(pyObjectToString(callPythonFunction("y_invel" + solver_ext, func)));
-		mInVelocityZ = (float*) stringToPointer(pyObjectToString(callPythonFunction("z_invel" + solver_ext, func)));
+		bindGrid(mPointerTable, &mInVelocityX, "x_invel" + solver_ext);
+		bindGrid(mPointerTable, &mInVelocityY, "y_invel" + solver_ext);
+		bindGrid(mPointerTable, &mInVelocityZ, "z_invel" + solver_ext);
 	}
 
 	// Liquid
 	if (mUsingLiquid) {
-		mPhi   = (float*) stringToPointer(pyObjectToString(callPythonFunction("phi"   + solver_ext, func)));
-		mPhiIn = (float*) stringToPointer(pyObjectToString(callPythonFunction("phiIn" + solver_ext, func)));
+		bindGrid(mPointerTable, &mPhi, "phi"   + solver_ext);
+		bindGrid(mPointerTable, &mPhiIn, "phiIn" + solver_ext);
 
+		// Particle and mesh data are no grids, these still go through Python (only if grid objects changed)
 		mFlipParticleData     = (std::vector<pData>*) stringToPointer(pyObjectToString(callPythonFunction("pp"   + solver_ext, func)));
 		mFlipParticleVelocity = (std::vector<pVel>*)  stringToPointer(pyObjectToString(callPythonFunction("pVel" + parts_ext,  func)));
 
@@ -2150,32 +2352,46 @@ void FLUID::updatePointers()
 	
 	// Smoke
 	if (mUsingSmoke) {
-		mDensity        = (float*) stringToPointer(pyObjectToString(callPythonFunction("density"    + solver_ext, func)));
-		mEmissionIn     = (float*) stringToPointer(pyObjectToString(callPythonFunction("emissionIn" + solver_ext, func)));
-		mShadow         = (float*) stringToPointer(pyObjectToString(callPythonFunction("shadow"     + solver_ext, func)));
+		bindGrid(mPointerTable, &mDensity, "density"    + solver_ext);
+		bindGrid(mPointerTable, &mEmissionIn, "emissionIn" + solver_ext);
+		bindGrid(mPointerTable, &mShadow, "shadow"     + solver_ext);
 
 		if (mUsingHeat) {
-			mHeat       = (float*) stringToPointer(pyObjectToString(callPythonFunction("heat"   + solver_ext,    func)));
+			bindGrid(mPointerTable, &mHeat, "heat"   + solver_ext);
 		}
 		if (mUsingFire) {
-			mFlame      = (float*) stringToPointer(pyObjectToString(callPythonFunction("flame"  + solver_ext,   func)));
-			mFuel       = (float*) stringToPointer(pyObjectToString(callPythonFunction("fuel"   + solver_ext,   func)));
-			mReact      = (float*) stringToPointer(pyObjectToString(callPythonFunction("react"  + solver_ext,   func)));
+			bindGrid(mPointerTable, &mFlame, "flame"  + solver_ext);
+			bindGrid(mPointerTable, &mFuel, "fuel"   + solver_ext);
+			bindGrid(mPointerTable, &mReact, "react"  + solver_ext);
 		}
 		if (mUsingColors) {
-			mColorR     = (float*) stringToPointer(pyObjectToString(callPythonFunction("color_r"   + solver_ext, func)));
-			mColorG     = (float*) stringToPointer(pyObjectToString(callPythonFunction("color_g"   + solver_ext, func)));
-			mColorB     = (float*) stringToPointer(pyObjectToString(callPythonFunction("color_b"   + solver_ext, func)));
+			bindGrid(mPointerTable, &mColorR, "color_r"   + solver_ext);
+			bindGrid(mPointerTable, &mColorG, "color_g"   + solver_ext);
+			bindGrid(mPointerTable, &mColorB, "color_b"   + solver_ext);
 		}
 	}
+
+	PyGILState_Release(gilstate);
 }
 
 void FLUID::updatePointersNoise()
 {
+	PyGILState_STATE gilstate = PyGILState_Ensure();
+
+	int generation = getGridGeneration();
+	int features = getFeatureFlags();
+	if (generation != -1 && generation == mPointerGenerationNoise && features == mPointerFeaturesNoise) {
+		refreshPointerTable(mPointerTableNoise);
+		PyGILState_Release(gilstate);
+		return;
+	}
+	mPointerGenerationNoise = generation;
+	mPointerFeaturesNoise   = features;
+	mPointerTableNoise.clear();
+
 	if (with_debug)
 		std::cout << "FLUID::updatePointersHigh()" << std::endl;
 
-	std::string func = "getDataPointer";
 	std::string id = std::to_string(mCurrentID);
 	std::string solver = "s" + id;
 	std::string solver_ext = "_" + solver;
@@ -2190,26 +2406,28 @@ void FLUID::updatePointersNoise()
 	
 	// Smoke
 	if (mUsingSmoke) {
-		mDensityHigh    = (float*) stringToPointer(pyObjectToString(callPythonFunction("density"    + noise_ext, func)));
-		mShadow         = (float*) stringToPointer(pyObjectToString(callPythonFunction("shadow"     + solver_ext, func)));
-		mTextureU       = (float*) stringToPointer(pyObjectToString(callPythonFunction("texture_u"  + solver_ext,   func)));
-		mTextureV       = (float*) stringToPointer(pyObjectToString(callPythonFunction("texture_v"  + solver_ext,   func)));
-		mTextureW       = (float*) stringToPointer(pyObjectToString(callPythonFunction("texture_w"  + solver_ext,   func)));
-		mTextureU2      = (float*) stringToPointer(pyObjectToString(callPythonFunction("texture_u2" + solver_ext,   func)));
-		mTextureV2      = (float*) stringToPointer(pyObjectToString(callPythonFunction("texture_v2" + solver_ext,   func)));
-		mTextureW2      = (float*) stringToPointer(pyObjectToString(callPythonFunction("texture_w2" + solver_ext,   func)));
+		bindGrid(mPointerTableNoise, &mDensityHigh, "density"    + noise_ext);
+		bindGrid(mPointerTableNoise, &mShadow, "shadow"     + solver_ext);
+		bindGrid(mPointerTableNoise, &mTextureU, "texture_u"  + solver_ext);
+		bindGrid(mPointerTableNoise, &mTextureV, "texture_v"  + solver_ext);
+		bindGrid(mPointerTableNoise, &mTextureW, "texture_w"  + solver_ext);
+		bindGrid(mPointerTableNoise, &mTextureU2, "texture_u2" + solver_ext);
+		bindGrid(mPointerTableNoise, &mTextureV2, "texture_v2" + solver_ext);
+		bindGrid(mPointerTableNoise, &mTextureW2, "texture_w2" + solver_ext);
 		
 		if (mUsingFire) {
-			mFlameHigh  = (float*) stringToPointer(pyObjectToString(callPythonFunction("flame" + noise_ext, func)));
-			mFuelHigh   = (float*) stringToPointer(pyObjectToString(callPythonFunction("fuel"  + noise_ext, func)));
-			mReactHigh  = (float*) stringToPointer(pyObjectToString(callPythonFunction("react" + noise_ext, func)));
+			bindGrid(mPointerTableNoise, &mFlameHigh, "flame" + noise_ext);
+			bindGrid(mPointerTableNoise, &mFuelHigh, "fuel"  + noise_ext);
+			bindGrid(mPointerTableNoise, &mReactHigh, "react" + noise_ext);
 		}
 		if (mUsingColors) {
-			mColorRHigh = (float*) stringToPointer(pyObjectToString(callPythonFunction("color_r" + noise_ext, func)));
-			mColorGHigh = (float*) stringToPointer(pyObjectToString(callPythonFunction("color_g" + noise_ext, func)));
-			mColorBHigh = (float*) stringToPointer(pyObjectToString(callPythonFunction("color_b" + noise_ext, func)));
+			bindGrid(mPointerTableNoise, &mColorRHigh, "color_r" + noise_ext);
+			bindGrid(mPointerTableNoise, &mColorGHigh, "color_g" + noise_ext);
+			bindGrid(mPointerTableNoise, &mColorBHigh, "color_b" + noise_ext);
 		}
 	}
+
+	PyGILState_Release(gilstate);
 }
 
 
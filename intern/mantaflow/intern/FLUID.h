@@ -32,8 +32,12 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <atomic>
 
+// Advection order of the default pipelines, for the scene scripts ($ADVECT_ORDER$) and native stepping
+static const int FLUID_ADVECT_ORDER = 2;
+
 struct FLUID {
 public:
 	FLUID(int *res, struct SmokeModifierData *smd);
@@ -65,14 +69,33 @@ public:
 	void initSndParts(SmokeModifierData *smd);
 	void initLiquidSndParts(SmokeModifierData *smd);
 
-	// Pointer transfer: Mantaflow -> Blender
+	// Pointer transfer: Mantaflow -> Blender. Only looks up grids again if they were (re-)allocated
 	void updatePointers();
 	void updatePointersNoise();
 
+	// Native grid descriptor, resolved from the Mantaflow object behind a Python variable
+	typedef struct GridDescriptor {
+		void *data; // first element, NULL if there is no such grid
+		int res[3];
+		int stride; // bytes between consecutive elements
+		int type;   // Mantaflow grid type flags, see GridBase::GridType
+	} GridDescriptor;
+
+	// Grid lookup by variable name (e.g. "density_s1"), cached until one of the solvers creates or frees
+	// grids. Callers must hold the GIL
+	const GridDescriptor& getGridDescriptor(const std::string& varName);
+	// Generation of the grids of all solvers of this domain, -1 if the base solver does not exist (yet)
+	int getGridGeneration();
+
 	// Write cache
 	int writeData(SmokeModifierData *smd, int framenr);
 	// write call for noise, mesh and particles were left in bake calls for now
 
+	// Block until all cache files queued by the background writer are on disk
+	void flushWrites();
+	void startProfile(const char *filename, bool chromeTrace);
+	void stopProfile();
+
 	// Read cache (via Manta save/load)
 	int readData(SmokeModifierData *smd, int framenr);
 	int readNoise(SmokeModifierData *smd, int framenr);
@@ -220,11 +243,29 @@ public:
 	inline int getNumFlipParticles() { return (mFlipParticleData && !mFlipParticleData->empty()) ? mFlipParticleData->size() : 0; }
 	inline int getNumSndParticles() { return (mSndParticleData && !mSndParticleData->empty()) ? mSndParticleData->size() : 0; }
 
+	// Bulk mesh getters: copy at most num elements into dst (stride in bytes between elements), return number of copied elements
+	int getVertices(float *dst, int num, size_t stride);
+	int getNormals(float *dst, int num, size_t stride);
+	int getTriangles(int *dst, int num, size_t stride);
+	int getVertVels(float *dst, int num, size_t stride);
+
+	// Bulk particle getters: same convention as bulk mesh getters
+	int getFlipParticleFlags(int *dst, int num, size_t stride);
+	int getFlipParticlePositions(float *dst, int num, size_t stride);
+	int getFlipParticleVelocities(float *dst, int num, size_t stride);
+	int getSndParticleFlags(int *dst, int num, size_t stride);
+	int getSndParticlePositions(float *dst, int num, size_t stride);
+	int getSndParticleVelocities(float *dst, int num, size_t stride);
+
 	// Direct access to solver time attributes
 	int getFrame();
 	float getTimestep();
 	void adaptTimestep();
 
+	// Cell range [min, max) that was written to outside of the solver step (e.g. by emission), so that
+	// native stepping knows where non-zero smoke values can appear without scanning the whole domain
+	void addInflowRegion(int *min, int *max);
+
 private:
 	// simulation constants
 	size_t mTotalCells;
@@ -335,6 +376,31 @@ private:
 	std::vector<pVel>* mSndParticleVelocity;
 	std::vector<float>* mSndParticleLife;
 
+	// Grid descriptor cache, grid is the Mantaflow grid object (Manta::GridBase)
+	typedef struct GridEntry {
+		GridDescriptor desc;
+		void *grid;
+	} GridEntry;
+	std::map<std::string, GridEntry> mGridDescriptors;
+	int mDescriptorGeneration;
+	GridEntry& getGridEntry(const std::string& varName);
+
+	// Blender-facing pointers and the grids they point into. Built once per grid generation and enabled
+	// features, after that only the data pointers are refreshed (grids swap their memory, e.g. in advection)
+	typedef std::vector<std::pair<void**, GridEntry*> > PointerTable;
+	PointerTable mPointerTable, mPointerTableNoise;
+	int mPointerGeneration, mPointerGenerationNoise;
+	int mPointerFeatures, mPointerFeaturesNoise;
+	int getFeatureFlags();
+	void bindGrid(PointerTable &table, void *target, const std::string& varName);
+	void refreshPointerTable(PointerTable &table);
+
+	// Handles to Mantaflow objects for native stepping, resolved lazily (see FLUID_step.cpp)
+	struct NativeStep;
+	NativeStep* mNativeStep;
+	int mInflowMin[3], mInflowMax[3];
+	bool mHasInflowRegion;
+
 	void initDomain(struct SmokeModifierData *smd);
 	void initNoise(struct SmokeModifierData *smd);
 	void initMesh(struct SmokeModifierData *smd);
@@ -353,6 +419,16 @@ private:
 	void updateMeshFromFile(const char* filename);
 	void updateParticlesFromFile(const char* filename, bool isSecondarySys, bool isVelData);
 
+	// Native stepping, Python scene script is only used as fallback. Callers must hold the GIL for getNativeStep()
+	NativeStep* getNativeStep();
+	void freeNativeStep();
+	// Grids were written to in unknown places (cache read, Python step), smoke tiles need a full rescan
+	void invalidateNativeSupport();
+	// Returns 1 if the step ran, 0 if it was not started (scene script has to step) and -1 if it failed halfway
+	int stepNative(SmokeModifierData *smd, int framenr);
+	int getFramePython();
+	float getTimestepPython();
+	void adaptTimestepPython();
 };
 
 #endif
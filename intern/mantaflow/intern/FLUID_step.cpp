@@ -0,0 +1,634 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2016 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): Sebastian Barschkis (sebbas)
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file mantaflow/intern/FLUID_step.cpp
+ *  \ingroup mantaflow
+ *
+ * Native stepping: runs the default solver pipeline by calling Mantaflow directly
+ * instead of going through the Python scene script for every (sub)step. Also resolves grid
+ * pointers natively for the pointer transfer to Blender.
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include "FLUID.h"
+#include "manta.h"
+#include "Python.h"
+#include "grid.h"
+#include "levelset.h"
+#include "particle.h"
+#include "timing.h"
+#include "tilemask.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_smoke_types.h"
+
+namespace Manta {
+
+// Plugin functions from manta_pp/plugin, called by the native step
+void setObstacleFlags(FlagGrid& flags, const Grid<Real>& phiObs, const MACGrid* fractions = NULL, const Grid<Real>* phiOut = NULL);
+void processBurn(Grid<Real>& fuel, Grid<Real>& density, Grid<Real>& react, Grid<Real>* red = NULL, Grid<Real>* green = NULL,
+                 Grid<Real>* blue = NULL, Grid<Real>* heat = NULL, Real burningRate = 0.75f, Real flameSmoke = 1.0f,
+                 Real ignitionTemp = 1.25f, Real maxTemp = 1.75f, Vec3 flameSmokeColor = Vec3(0.7f, 0.7f, 0.7f));
+void updateFlame(const Grid<Real>& react, Grid<Real>& flame);
+void advectSemiLagrange(const FlagGrid* flags, const MACGrid* vel, GridBase* grid, int order = 1, Real strength = 1.0,
+                        int orderSpace = 1, bool openBounds = false, int boundaryWidth = 1, int clampMode = 2);
+void advectSemiLagrangeMulti(const FlagGrid* flags, const MACGrid* vel, std::vector<PbClass*> grids, int order = 1,
+                             Real strength = 1.0, int orderSpace = 1, int clampMode = 2);
+void advectSemiLagrangeMultiTracked(const FlagGrid* flags, const MACGrid* vel, std::vector<PbClass*> grids, TileMask& support,
+                                    int order, Real strength, int orderSpace, int clampMode);
+void resetOutflow(FlagGrid& flags, Grid<Real>* phi = 0, BasicParticleSystem* parts = 0, Grid<Real>* real = 0,
+                  Grid<int>* index = 0, ParticleIndexSystem* indexSys = 0);
+void vorticityConfinement(MACGrid& vel, const FlagGrid& flags, Real strength);
+void addBuoyancy(const FlagGrid& flags, const Grid<Real>& density, MACGrid& vel, Vec3 gravity, Real coefficient = 1.);
+void addForceField(const FlagGrid& flags, MACGrid& vel, const Grid<Vec3>& force, const Grid<Real>* region = NULL, bool isMAC = false);
+void extrapolateVec3Simple(Grid<Vec3>& vel, Grid<Real>& phi, int distance = 4, bool inside = false);
+void resampleVec3ToMac(Grid<Vec3>& source, MACGrid &target);
+void setInitialVelocity(const FlagGrid& flags, MACGrid& vel, const Grid<Vec3>& invel);
+void setWallBcs(const FlagGrid& flags, MACGrid& vel, const MACGrid* obvel = 0, const MACGrid* fractions = 0,
+                const Grid<Real>* phiObs = 0, int boundaryWidth = 0);
+void solvePressure(MACGrid& vel, Grid<Real>& pressure, const FlagGrid& flags, Real cgAccuracy = 1e-3,
+                   const Grid<Real>* phi = 0, const Grid<Real>* perCellCorr = 0, const MACGrid* fractions = 0,
+                   Real gfClamp = 1e-04, Real cgMaxIterFac = 1.5, bool precondition = true, int preconditioner = 1,
+                   bool enforceCompatibility = false, bool useL2Norm = false, bool zeroPressureFixing = false,
+                   const Grid<Real> *curv = NULL, const Real surfTens = 0., Grid<Real>* retRhs = NULL,
+                   bool packedMatrix = false);
+void copyRealToVec3(Grid<Real> &sourceX, Grid<Real> &sourceY, Grid<Real> &sourceZ, Grid<Vec3> &target);
+void copyVec3ToReal(Grid<Vec3> &source, Grid<Real> &targetX, Grid<Real> &targetY, Grid<Real> &targetZ);
+
+} // namespace
+
+using namespace Manta;
+
+// Handles to the Mantaflow objects that the scene script created for this solver
+struct FLUID::NativeStep {
+	FluidSolver *solver;
+	FlagGrid *flags;
+	MACGrid *vel;
+	Grid<Real> *velX, *velY, *velZ;
+	Grid<Real> *pressure;
+	LevelsetGrid *phiObs, *phiOut, *phiOutIn, *phiObsIn;
+	Grid<Vec3> *forces;
+	Grid<Real> *forceX, *forceY, *forceZ;
+
+	// Obstacle and initial velocity grids
+	MACGrid *obvel;
+	Grid<Vec3> *obvelC;
+	Grid<Real> *obvelX, *obvelY, *obvelZ;
+	MACGrid *invel;
+	Grid<Vec3> *invelC;
+	Grid<Real> *invelX, *invelY, *invelZ;
+
+	// Smoke grids
+	Grid<Real> *density, *heat, *fuel, *react, *flame;
+	Grid<Real> *colorR, *colorG, *colorB;
+
+	// Tiles of the advected smoke grids that can hold non-zero values, kept across steps so that the
+	// advection does not have to scan the domain. NULL until the first native step
+	TileMask *advectSupport;
+	std::vector<PbClass*> advectSupportGrids;
+
+	~NativeStep() { delete advectSupport; }
+};
+
+// Time plugin calls the same way the Python wrappers do, so that timing output stays comparable
+struct ScopedPluginTiming {
+	ScopedPluginTiming(FluidSolver *parent, const std::string& name) : mParent(parent), mName(name) { TimingData::instance().start(mParent, mName); }
+	~ScopedPluginTiming() { TimingData::instance().stop(mParent, mName); }
+	FluidSolver *mParent;
+	std::string mName;
+};
+
+static PyObject* getMainDict()
+{
+	PyObject *main = PyImport_AddModule("__main__"); // borrowed reference
+	return (main) ? PyModule_GetDict(main) : NULL;
+}
+
+// Returns NULL if the variable does not exist or is not a Mantaflow object of type T (e.g. 'obvel_s1 = 0')
+template<class T>
+static T* getMantaObject(PyObject *dict, const std::string& varName)
+{
+	PyObject *obj = PyDict_GetItemString(dict, varName.c_str());
+	return (obj) ? dynamic_cast<T*>(Pb::objFromPy(obj)) : NULL;
+}
+
+template<class T>
+static T getPythonValue(PyObject *dict, const std::string& varName, T defaultValue)
+{
+	PyObject *obj = PyDict_GetItemString(dict, varName.c_str());
+	return (obj) ? fromPy<T>(obj) : defaultValue;
+}
+
+static bool getPythonFlag(PyObject *dict, const std::string& varName)
+{
+	PyObject *obj = PyDict_GetItemString(dict, varName.c_str());
+	return (obj) ? PyObject_IsTrue(obj) == 1 : false;
+}
+
+// Generation of the grids of all solvers of this domain. Descriptors, pointer tables and native handles
+// of an older generation might refer to freed grids and are dropped
+int FLUID::getGridGeneration()
+{
+	PyObject *dict = getMainDict();
+	if (!dict)
+		return -1;
+
+	std::string id = std::to_string(mCurrentID);
+	FluidSolver *base = getMantaObject<FluidSolver>(dict, "s" + id);
+	if (!base)
+		return -1;
+
+	int generation = base->getGridGeneration();
+	const char *solvers[] = { "sn", "sm", "sp", "sg" };
+	for (const char *name : solvers) {
+		FluidSolver *solver = getMantaObject<FluidSolver>(dict, name + id);
+		if (solver)
+			generation = std::max(generation, solver->getGridGeneration());
+	}
+
+	if (generation != mDescriptorGeneration) {
+		mPointerTable.clear();
+		mPointerTableNoise.clear();
+		mGridDescriptors.clear();
+		freeNativeStep();
+		mDescriptorGeneration = generation;
+	}
+	return generation;
+}
+
+static void* getGridData(GridBase *grid)
+{
+	if (grid->getType() & GridBase::TypeReal)
+		return &(*static_cast<Grid<Real>*>(grid))[0];
+	if (grid->getType() & GridBase::TypeInt)
+		return &(*static_cast<Grid<int>*>(grid))[0];
+	if (grid->getType() & GridBase::TypeVec3)
+		return &(*static_cast<Grid<Vec3>*>(grid))[0];
+	return NULL;
+}
+
+static int getGridStride(GridBase *grid)
+{
+	if (grid->getType() & GridBase::TypeReal)
+		return sizeof(Real);
+	if (grid->getType() & GridBase::TypeInt)
+		return sizeof(int);
+	if (grid->getType() & GridBase::TypeVec3)
+		return sizeof(Vec3);
+	return 0;
+}
+
+FLUID::GridEntry& FLUID::getGridEntry(const std::string& varName)
+{
+	getGridGeneration();
+
+	std::map<std::string, GridEntry>::iterator it = mGridDescriptors.find(varName);
+	if (it != mGridDescriptors.end())
+		return it->second;
+
+	GridEntry entry = { { NULL, { 0, 0, 0 }, 0, 0 }, NULL };
+	PyObject *dict = getMainDict();
+	GridBase *grid = (dict) ? getMantaObject<GridBase>(dict, varName) : NULL;
+	if (grid) {
+		entry.grid = grid;
+		entry.desc.data   = getGridData(grid);
+		entry.desc.res[0] = grid->getSizeX();
+		entry.desc.res[1] = grid->getSizeY();
+		entry.desc.res[2] = grid->getSizeZ();
+		entry.desc.stride = getGridStride(grid);
+		entry.desc.type   = grid->getType();
+	}
+	else if (with_debug) {
+		std::cout << "FLUID::getGridEntry(): no grid '" << varName << "'" << std::endl;
+	}
+	return mGridDescriptors[varName] = entry;
+}
+
+const FLUID::GridDescriptor& FLUID::getGridDescriptor(const std::string& varName)
+{
+	GridEntry &entry = getGridEntry(varName);
+	if (entry.grid)
+		entry.desc.data = getGridData((GridBase*) entry.grid);
+	return entry.desc;
+}
+
+void FLUID::bindGrid(PointerTable &table, void *target, const std::string& varName)
+{
+	GridEntry &entry = getGridEntry(varName);
+	*(void**) target = entry.desc.data;
+	if (entry.grid)
+		table.push_back(std::make_pair((void**) target, &entry));
+}
+
+void FLUID::refreshPointerTable(PointerTable &table)
+{
+	for (PointerTable::iterator it = table.begin(); it != table.end(); ++it) {
+		GridEntry *entry = it->second;
+		entry->desc.data = getGridData((GridBase*) entry->grid);
+		*it->first = entry->desc.data;
+	}
+}
+
+void FLUID::freeNativeStep()
+{
+	delete mNativeStep;
+	mNativeStep = NULL;
+}
+
+void FLUID::invalidateNativeSupport()
+{
+	if (mNativeStep) {
+		delete mNativeStep->advectSupport;
+		mNativeStep->advectSupport = NULL;
+	}
+	mHasInflowRegion = false;
+}
+
+void FLUID::addInflowRegion(int *min, int *max)
+{
+	if (!mHasInflowRegion) {
+		for (int i = 0; i < 3; i++) {
+			mInflowMin[i] = min[i];
+			mInflowMax[i] = max[i];
+		}
+		mHasInflowRegion = true;
+		return;
+	}
+	for (int i = 0; i < 3; i++) {
+		mInflowMin[i] = std::min(mInflowMin[i], min[i]);
+		mInflowMax[i] = std::max(mInflowMax[i], max[i]);
+	}
+}
+
+FLUID::NativeStep* FLUID::getNativeStep()
+{
+	// Drops handles to grids that were freed since the last step
+	getGridGeneration();
+	if (mNativeStep)
+		return mNativeStep;
+
+	PyObject *dict = getMainDict();
+	if (!dict)
+		return NULL;
+
+	std::string ext = "_s" + std::to_string(mCurrentID);
+
+	NativeStep *ns = new NativeStep();
+	ns->solver   = getMantaObject<FluidSolver>(dict, "s" + std::to_string(mCurrentID));
+	ns->flags    = getMantaObject<FlagGrid>(dict, "flags" + ext);
+	ns->vel      = getMantaObject<MACGrid>(dict, "vel" + ext);
+	ns->velX     = getMantaObject<Grid<Real> >(dict, "x_vel" + ext);
+	ns->velY     = getMantaObject<Grid<Real> >(dict, "y_vel" + ext);
+	ns->velZ     = getMantaObject<Grid<Real> >(dict, "z_vel" + ext);
+	ns->pressure = getMantaObject<Grid<Real> >(dict, "pressure" + ext);
+	ns->phiObs   = getMantaObject<LevelsetGrid>(dict, "phiObs" + ext);
+	ns->phiOut   = getMantaObject<LevelsetGrid>(dict, "phiOut" + ext);
+	ns->phiOutIn = getMantaObject<LevelsetGrid>(dict, "phiOutIn" + ext);
+	ns->phiObsIn = getMantaObject<LevelsetGrid>(dict, "phiObsIn" + ext);
+	ns->forces   = getMantaObject<Grid<Vec3> >(dict, "forces" + ext);
+	ns->forceX   = getMantaObject<Grid<Real> >(dict, "x_force" + ext);
+	ns->forceY   = getMantaObject<Grid<Real> >(dict, "y_force" + ext);
+	ns->forceZ   = getMantaObject<Grid<Real> >(dict, "z_force" + ext);
+
+	ns->obvel    = getMantaObject<MACGrid>(dict, "obvel" + ext);
+	ns->obvelC   = getMantaObject<Grid<Vec3> >(dict, "obvelC" + ext);
+	ns->obvelX   = getMantaObject<Grid<Real> >(dict, "x_obvel" + ext);
+	ns->obvelY   = getMantaObject<Grid<Real> >(dict, "y_obvel" + ext);
+	ns->obvelZ   = getMantaObject<Grid<Real> >(dict, "z_obvel" + ext);
+	ns->invel    = getMantaObject<MACGrid>(dict, "invel" + ext);
+	ns->invelC   = getMantaObject<Grid<Vec3> >(dict, "invelC" + ext);
+	ns->invelX   = getMantaObject<Grid<Real> >(dict, "x_invel" + ext);
+	ns->invelY   = getMantaObject<Grid<Real> >(dict, "y_invel" + ext);
+	ns->invelZ   = getMantaObject<Grid<Real> >(dict, "z_invel" + ext);
+
+	ns->density  = getMantaObject<Grid<Real> >(dict, "density" + ext);
+	ns->heat     = getMantaObject<Grid<Real> >(dict, "heat" + ext);
+	ns->fuel     = getMantaObject<Grid<Real> >(dict, "fuel" + ext);
+	ns->react    = getMantaObject<Grid<Real> >(dict, "react" + ext);
+	ns->flame    = getMantaObject<Grid<Real> >(dict, "flame" + ext);
+	ns->colorR   = getMantaObject<Grid<Real> >(dict, "color_r" + ext);
+	ns->colorG   = getMantaObject<Grid<Real> >(dict, "color_g" + ext);
+	ns->colorB   = getMantaObject<Grid<Real> >(dict, "color_b" + ext);
+
+	// Solver and velocity are needed by every native code path
+	if (!ns->solver || !ns->vel) {
+		if (with_debug)
+			std::cout << "FLUID::getNativeStep(): could not resolve solver objects, using Python instead" << std::endl;
+		delete ns;
+		return NULL;
+	}
+	mNativeStep = ns;
+	return mNativeStep;
+}
+
+int FLUID::stepNative(SmokeModifierData *smd, int framenr)
+{
+	if (with_debug)
+		std::cout << "FLUID::stepNative()" << std::endl;
+
+	// Only the default smoke pipeline is native. Liquids and guiding still run the scene script.
+	if (!mUsingSmoke)
+		return 0;
+
+	int success = 0;
+	bool modified = false;
+	PyGILState_STATE gilstate = PyGILState_Ensure();
+
+	PyObject *dict = getMainDict();
+	NativeStep *ns = (dict) ? getNativeStep() : NULL;
+	std::string ext = "_s" + std::to_string(mCurrentID);
+
+	// Multiprocessing bakes are driven from Python
+	bool canStep = ns && !(getPythonFlag(dict, "withMP") && !getPythonFlag(dict, "isWindows"));
+	canStep = canStep && !getPythonFlag(dict, "using_guiding" + ext);
+	canStep = canStep && ns->flags && ns->pressure && ns->phiObs && ns->phiOut && ns->phiOutIn && ns->density;
+	canStep = canStep && ns->velX && ns->velY && ns->velZ && ns->forces && ns->forceX && ns->forceY && ns->forceZ;
+
+	if (!canStep) {
+		PyGILState_Release(gilstate);
+		return 0;
+	}
+
+	try {
+		bool usingObstacle = getPythonFlag(dict, "using_obstacle" + ext);
+		bool usingInvel    = getPythonFlag(dict, "using_invel" + ext);
+		bool usingHeat     = getPythonFlag(dict, "using_heat" + ext) && ns->heat;
+		bool usingFire     = getPythonFlag(dict, "using_fire" + ext) && ns->fuel && ns->react && ns->flame;
+		bool usingColors   = getPythonFlag(dict, "using_colors" + ext) && ns->colorR && ns->colorG && ns->colorB;
+		bool doOpen        = getPythonFlag(dict, "doOpen" + ext);
+
+		Real dt0             = getPythonValue<Real>(dict, "dt0" + ext, ns->solver->mFrameLength);
+		Real cfl             = getPythonValue<Real>(dict, "cfl_cond" + ext, ns->solver->mCflCond);
+		Real unitsFac        = getPythonValue<Real>(dict, "toMantaUnitsFac" + ext, 1.);
+		Real vorticity       = getPythonValue<Real>(dict, "vorticity" + ext, 0.);
+		Real buoyancyDens    = getPythonValue<Real>(dict, "buoyancy_dens" + ext, 0.);
+		Real buoyancyHeat    = getPythonValue<Real>(dict, "buoyancy_heat" + ext, 0.);
+		Vec3 gravity         = getPythonValue<Vec3>(dict, "gravity" + ext, Vec3(0.));
+		int boundaryWidth    = getPythonValue<int>(dict, "boundaryWidth" + ext, 1);
+		int res              = getPythonValue<int>(dict, "res" + ext, mMaxRes);
+		const int advectOrder = FLUID_ADVECT_ORDER;
+
+		usingObstacle = usingObstacle && ns->phiObsIn && ns->obvel && ns->obvelC && ns->obvelX && ns->obvelY && ns->obvelZ;
+		usingInvel    = usingInvel && ns->invel && ns->invelC && ns->invelX && ns->invelY && ns->invelZ;
+
+		FluidSolver *parent = ns->solver;
+		parent->mFrame = framenr;
+
+		// smoke_adaptive_step: time params are animatable
+		parent->mFrameLength = dt0;
+		parent->mCflCond = cfl;
+
+		// fluid_pre_step: translate world space velocities and forces to grid space
+		modified = true;
+		ns->velX->clear();
+		ns->velY->clear();
+		ns->velZ->clear();
+		if (usingObstacle) {
+			ns->obvelX->multConst(unitsFac);
+			ns->obvelY->multConst(unitsFac);
+			ns->obvelZ->multConst(unitsFac);
+			ScopedPluginTiming t(parent, "copyRealToVec3");
+			copyRealToVec3(*ns->obvelX, *ns->obvelY, *ns->obvelZ, *ns->obvelC);
+		}
+		if (usingInvel) {
+			ns->invelX->multConst(unitsFac);
+			ns->invelY->multConst(unitsFac);
+			ns->invelZ->multConst(unitsFac);
+			ScopedPluginTiming t(parent, "copyRealToVec3");
+			copyRealToVec3(*ns->invelX, *ns->invelY, *ns->invelZ, *ns->invelC);
+		}
+		ns->forceX->multConst(unitsFac);
+		ns->forceY->multConst(unitsFac);
+		ns->forceZ->multConst(unitsFac);
+		{
+			ScopedPluginTiming t(parent, "copyRealToVec3");
+			copyRealToVec3(*ns->forceX, *ns->forceY, *ns->forceZ, *ns->forces);
+		}
+
+		// Same choice as fluid_pre_step: moving obstacles change the pressure matrix every step, the multigrid
+		// hierarchy has to follow them. Stored in Python as well so that both step paths agree
+		int preconditioner = (usingObstacle && ns->obvelC->getMax() > 0) ?
+		                     getPythonValue<int>(dict, "PcMGDynamic", 2) : getPythonValue<int>(dict, "PcMGStatic", 3);
+		PyObject *pyPreconditioner = PyLong_FromLong(preconditioner);
+		PyDict_SetItemString(dict, ("preconditioner" + ext).c_str(), pyPreconditioner);
+		Py_DECREF(pyPreconditioner);
+
+		if (usingObstacle)
+			ns->phiObs->join(*ns->phiObsIn);
+		ns->phiOut->join(*ns->phiOutIn);
+		{
+			ScopedPluginTiming t(parent, "setObstacleFlags");
+			setObstacleFlags(*ns->flags, *ns->phiObs, NULL, ns->phiOut);
+		}
+		ns->flags->fillGrid();
+
+		if (usingFire) {
+			ScopedPluginTiming t(parent, "processBurn");
+			processBurn(*ns->fuel, *ns->density, *ns->react,
+			            usingColors ? ns->colorR : NULL, usingColors ? ns->colorG : NULL, usingColors ? ns->colorB : NULL,
+			            usingHeat ? ns->heat : NULL, smd->domain->burning_rate, smd->domain->flame_smoke,
+			            smd->domain->flame_ignition, smd->domain->flame_max_temp,
+			            Vec3(smd->domain->flame_smoke_color[0], smd->domain->flame_smoke_color[1], smd->domain->flame_smoke_color[2]));
+		}
+
+		// smoke_step: all scalar fields share one back-trace through vel
+		{
+			std::vector<PbClass*> advectGrids(1, ns->density);
+			if (usingHeat)
+				advectGrids.push_back(ns->heat);
+			if (usingFire) {
+				advectGrids.push_back(ns->fuel);
+				advectGrids.push_back(ns->react);
+			}
+			if (usingColors) {
+				advectGrids.push_back(ns->colorR);
+				advectGrids.push_back(ns->colorG);
+				advectGrids.push_back(ns->colorB);
+			}
+			// Emission wrote to the grids since the last step, everything else the step does only clears values
+			if (!ns->advectSupport || ns->advectSupportGrids != advectGrids) {
+				delete ns->advectSupport;
+				ns->advectSupport = new TileMask(*ns->density);
+				for (size_t n = 0; n < advectGrids.size(); n++)
+					ns->advectSupport->activateNonZero(*(Grid<Real>*) advectGrids[n]);
+				ns->advectSupportGrids = advectGrids;
+			}
+			else if (mHasInflowRegion) {
+				ns->advectSupport->activateRegion(Vec3i(mInflowMin[0], mInflowMin[1], mInflowMin[2]),
+				                                  Vec3i(mInflowMax[0], mInflowMax[1], mInflowMax[2]));
+			}
+			mHasInflowRegion = false;
+			ScopedPluginTiming t(parent, "advectSemiLagrangeMulti");
+			advectSemiLagrangeMultiTracked(ns->flags, ns->vel, advectGrids, *ns->advectSupport, advectOrder, 1.0, 1, 2);
+		}
+		{
+			ScopedPluginTiming t(parent, "advectSemiLagrange");
+			advectSemiLagrange(ns->flags, ns->vel, ns->vel, advectOrder, 1.0, 1, doOpen, boundaryWidth);
+		}
+		if (doOpen) {
+			ScopedPluginTiming t(parent, "resetOutflow");
+			resetOutflow(*ns->flags, NULL, NULL, ns->density);
+		}
+		{
+			ScopedPluginTiming t(parent, "vorticityConfinement");
+			vorticityConfinement(*ns->vel, *ns->flags, vorticity);
+		}
+		{
+			ScopedPluginTiming t(parent, "addBuoyancy");
+			if (usingHeat) {
+				addBuoyancy(*ns->flags, *ns->density, *ns->vel, gravity, buoyancyDens);
+				addBuoyancy(*ns->flags, *ns->heat, *ns->vel, gravity, buoyancyHeat);
+			}
+			else {
+				addBuoyancy(*ns->flags, *ns->density, *ns->vel, gravity);
+			}
+		}
+		{
+			ScopedPluginTiming t(parent, "addForceField");
+			addForceField(*ns->flags, *ns->vel, *ns->forces);
+		}
+		if (usingObstacle) {
+			// ensure velocities inside of obs object, slightly add obvels outside of obs object
+			ScopedPluginTiming t(parent, "extrapolateVec3Simple");
+			extrapolateVec3Simple(*ns->obvelC, *ns->phiObsIn, int(res/2), true);
+			extrapolateVec3Simple(*ns->obvelC, *ns->phiObsIn, 1, false);
+			resampleVec3ToMac(*ns->obvelC, *ns->obvel);
+		}
+		if (usingInvel) {
+			ScopedPluginTiming t(parent, "setInitialVelocity");
+			setInitialVelocity(*ns->flags, *ns->vel, *ns->invel);
+		}
+		{
+			ScopedPluginTiming t(parent, "setWallBcs");
+			setWallBcs(*ns->flags, *ns->vel, usingObstacle ? ns->obvel : NULL);
+		}
+		{
+			// closed domains require pressure fixing
+			ScopedPluginTiming t(parent, "solvePressure");
+			solvePressure(*ns->vel, *ns->pressure, *ns->flags, 1e-3, NULL, NULL, NULL, 1e-04, 1.5, true,
+			              preconditioner, false, false, !doOpen);
+		}
+
+		if (usingFire) {
+			ScopedPluginTiming t(parent, "updateFlame");
+			updateFlame(*ns->react, *ns->flame);
+		}
+
+		{
+			ScopedPluginTiming t(parent, "FluidSolver::step");
+			parent->step();
+		}
+
+		// fluid_post_step
+		ns->forces->clear();
+		ns->forceX->clear();
+		ns->forceY->clear();
+		ns->forceZ->clear();
+		if (usingInvel)
+			ns->invel->clear();
+		ns->phiObs->setConst(9999);
+		ns->phiOutIn->setConst(9999);
+		{
+			// Copy vel grid to reals grids (which Blender internal will in turn use for vel access)
+			ScopedPluginTiming t(parent, "copyVec3ToReal");
+			copyVec3ToReal(*ns->vel, *ns->velX, *ns->velY, *ns->velZ);
+		}
+		success = 1;
+	}
+	catch (std::exception& e) {
+		std::cerr << "FLUID::stepNative(): " << e.what() << std::endl;
+		// Before the first grid write the scene script can still run the step, afterwards the grids are
+		// partly stepped and running it again would step them twice
+		success = (modified) ? -1 : 0;
+	}
+
+	PyGILState_Release(gilstate);
+	return success;
+}
+
+int FLUID::getFrame()
+{
+	if (with_debug)
+		std::cout << "FLUID::getFrame()" << std::endl;
+
+	PyGILState_STATE gilstate = PyGILState_Ensure();
+	NativeStep *ns = getNativeStep();
+	int frame = (ns) ? ns->solver->mFrame : getFramePython();
+	PyGILState_Release(gilstate);
+	return frame;
+}
+
+float FLUID::getTimestep()
+{
+	if (with_debug)
+		std::cout << "FLUID::getTimestep()" << std::endl;
+
+	PyGILState_STATE gilstate = PyGILState_Ensure();
+	NativeStep *ns = getNativeStep();
+	float dt = (ns) ? ns->solver->mDt : getTimestepPython();
+	PyGILState_Release(gilstate);
+	return dt;
+}
+
+void FLUID::adaptTimestep()
+{
+	if (with_debug)
+		std::cout << "FLUID::adaptTimestep()" << std::endl;
+
+	PyGILState_STATE gilstate = PyGILState_Ensure();
+	PyObject *dict = getMainDict();
+	NativeStep *ns = (dict) ? getNativeStep() : NULL;
+
+	if (!ns) {
+		PyGILState_Release(gilstate);
+		adaptTimestepPython();
+		return;
+	}
+
+	try {
+		std::string ext = "_s" + std::to_string(mCurrentID);
+
+		// time params are animatable
+		ns->solver->mFrameLength = getPythonValue<Real>(dict, "dt0" + ext, ns->solver->mFrameLength);
+		ns->solver->mCflCond     = getPythonValue<Real>(dict, "cfl_cond" + ext, ns->solver->mCflCond);
+
+		Real maxVel = ns->vel->getMax();
+
+		// Liquid step script reads the max velocity from Python
+		PyObject *pyMaxVel = PyFloat_FromDouble(maxVel);
+		PyDict_SetItemString(dict, ("maxVel" + ext).c_str(), pyMaxVel);
+		Py_DECREF(pyMaxVel);
+
+		if (getPythonFlag(dict, "using_adaptTime" + ext))
+			ns->solver->adaptTimestep(maxVel);
+	}
+	catch (std::exception& e) {
+		std::cerr << "FLUID::adaptTimestep(): " << e.what() << std::endl;
+	}
+	PyGILState_Release(gilstate);
+}
@@ -64,6 +64,24 @@ extern "C" int fluid_write_data(FLUID* fluid, SmokeModifierData *smd, int framen
 	return fluid->writeData(smd, framenr);
 }
 
+extern "C" void fluid_flush_writes(FLUID* fluid)
+{
+	if (!fluid) return;
+	fluid->flushWrites();
+}
+
+extern "C" void fluid_start_profile(FLUID* fluid, const char *filename, int chrome_trace)
+{
+	if (!fluid || !filename) return;
+	fluid->startProfile(filename, chrome_trace != 0);
+}
+
+extern "C" void fluid_stop_profile(FLUID* fluid)
+{
+	if (!fluid) return;
+	fluid->stopProfile();
+}
+
 extern "C" int fluid_read_data(FLUID* fluid, SmokeModifierData *smd, int framenr)
 {
 	if (!fluid || !smd) return 0;
@@ -166,6 +184,12 @@ extern "C" void fluid_adapt_timestep(FLUID* fluid)
 		fluid->adaptTimestep();
 }
 
+extern "C" void fluid_add_inflow_region(FLUID* fluid, int *min, int *max)
+{
+	if (fluid)
+		fluid->addInflowRegion(min, max);
+}
+
 /* Fluid accessors */
 extern "C" size_t fluid_get_index(int x, int max_x, int y, int max_y, int z /*, int max_z */)
 {
@@ -555,4 +579,17 @@ extern "C" float liquid_get_snd_particle_velocity_x_at(FLUID *liquid, int i) { r
 extern "C" float liquid_get_snd_particle_velocity_y_at(FLUID *liquid, int i) { return liquid->getSndParticleVelocityYAt(i); }
 extern "C" float liquid_get_snd_particle_velocity_z_at(FLUID *liquid, int i) { return liquid->getSndParticleVelocityZAt(i); }
 
+extern "C" int liquid_get_vertices(FLUID *liquid, float *r_data, int num, size_t stride)  { return liquid->getVertices(r_data, num, stride);  }
+extern "C" int liquid_get_normals(FLUID *liquid, float *r_data, int num, size_t stride)   { return liquid->getNormals(r_data, num, stride);   }
+extern "C" int liquid_get_triangles(FLUID *liquid, int *r_data, int num, size_t stride)   { return liquid->getTriangles(r_data, num, stride); }
+extern "C" int liquid_get_vertvels(FLUID *liquid, float *r_data, int num, size_t stride)  { return liquid->getVertVels(r_data, num, stride);  }
+
+extern "C" int liquid_get_flip_particle_flags(FLUID *liquid, int *r_data, int num, size_t stride)        { return liquid->getFlipParticleFlags(r_data, num, stride);      }
+extern "C" int liquid_get_flip_particle_positions(FLUID *liquid, float *r_data, int num, size_t stride)  { return liquid->getFlipParticlePositions(r_data, num, stride);  }
+extern "C" int liquid_get_flip_particle_velocities(FLUID *liquid, float *r_data, int num, size_t stride) { return liquid->getFlipParticleVelocities(r_data, num, stride); }
+
+extern "C" int liquid_get_snd_particle_flags(FLUID *liquid, int *r_data, int num, size_t stride)        { return liquid->getSndParticleFlags(r_data, num, stride);      }
+extern "C" int liquid_get_snd_particle_positions(FLUID *liquid, float *r_data, int num, size_t stride)  { return liquid->getSndParticlePositions(r_data, num, stride);  }
+extern "C" int liquid_get_snd_particle_velocities(FLUID *liquid, float *r_data, int num, size_t stride) { return liquid->getSndParticleVelocities(r_data, num, stride); }
+
 
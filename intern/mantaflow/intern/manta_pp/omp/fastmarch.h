@@ -77,6 +77,7 @@ public:
 	FmValueTransportVec3() : mpVal(0), mpFlags(0) { };
 	~FmValueTransportVec3() { };
 	inline bool isInitialized() { return mpVal != 0; } 
+	inline GRID* getVal() { return mpVal; }
 	void initMarching(GRID* val, const FlagGrid* flags) {
 		mpVal = val;
 		mpFlags = flags;
@@ -148,7 +149,8 @@ public:
 
 	enum SpecialValues { FlagInited = 1, FlagIsOnHeap = 2};
 
-	FastMarch(const FlagGrid& flags, Grid<int>& fmFlags, Grid<Real>& levelset, Real maxTime, MACGrid* velTransport = NULL);
+	//! parallel: solve with Jacobi iterations instead of the heap, addToList() is not needed then
+	FastMarch(const FlagGrid& flags, Grid<int>& fmFlags, Grid<Real>& levelset, Real maxTime, MACGrid* velTransport = NULL, bool parallel = false);
 	~FastMarch() {}
 	
 	//! advect level set function with given velocity */
@@ -177,6 +179,10 @@ protected:
 	//! maximal time to march for
 	Real mMaxTime;
 
+	//! use performIterative() instead of the heap
+	bool mParallel;
+	void performIterative();
+
 	//! fast marching list
 	std::priority_queue<T, std::vector<T>, std::less<T> > mHeap;
 	Real mReheapVal;
@@ -36,6 +36,8 @@ extern "C" {
 
 #if OPENVDB==1
 #include "openvdb/openvdb.h"
+#include "openvdb/tools/Dense.h"
+#include <memory>
 #endif
 
 #include "mantaio.h"
@@ -69,73 +71,73 @@ typedef struct {
 
 #if NO_ZLIB!=1
 template <class GRIDT> 
-void gridConvertWrite(gzFile& gzf, GRIDT& grid, void* ptr, UniHeader& head) {
+void gridConvertWrite(GzWriter& gzf, GRIDT& grid, void* ptr, UniHeader& head) {
 	errMsg("gridConvertWrite: unknown type, not yet supported");
 }
 
 template <>
-void gridConvertWrite(gzFile& gzf, Grid<int>& grid, void* ptr, UniHeader& head) {
-	gzwrite(gzf, &head,    sizeof(UniHeader));
-	gzwrite(gzf, &grid[0], sizeof(int)*head.dimX*head.dimY*head.dimZ);
+void gridConvertWrite(GzWriter& gzf, Grid<int>& grid, void* ptr, UniHeader& head) {
+	gzf.write(&head,    sizeof(UniHeader));
+	gzf.write(&grid[0], sizeof(int)*head.dimX*head.dimY*head.dimZ);
 } 
 template <>
-void gridConvertWrite(gzFile& gzf, Grid<double>& grid, void* ptr, UniHeader& head) {
+void gridConvertWrite(GzWriter& gzf, Grid<double>& grid, void* ptr, UniHeader& head) {
 	head.bytesPerElement = sizeof(float);
-	gzwrite(gzf, &head, sizeof(UniHeader));
+	gzf.write(&head, sizeof(UniHeader));
 	float* ptrf = (float*)ptr;
 	for(int i=0; i<grid.getSizeX()*grid.getSizeY()*grid.getSizeZ(); ++i,++ptrf) {
 		*ptrf = (float)grid[i];
 	} 
-	gzwrite(gzf, ptr, sizeof(float)* head.dimX*head.dimY*head.dimZ);
+	gzf.write(ptr, sizeof(float)* head.dimX*head.dimY*head.dimZ);
 } 
 template <>
-void gridConvertWrite(gzFile& gzf, Grid<Vector3D<double> >& grid, void* ptr, UniHeader& head) {
+void gridConvertWrite(GzWriter& gzf, Grid<Vector3D<double> >& grid, void* ptr, UniHeader& head) {
 	head.bytesPerElement = sizeof(Vector3D<float>);
-	gzwrite(gzf, &head, sizeof(UniHeader));
+	gzf.write(&head, sizeof(UniHeader));
 	float* ptrf = (float*)ptr;
 	for(int i=0; i<grid.getSizeX()*grid.getSizeY()*grid.getSizeZ(); ++i) {
 		for(int c=0; c<3; ++c) { *ptrf = (float)grid[i][c]; ptrf++; }
 	} 
-	gzwrite(gzf, ptr, sizeof(Vector3D<float>) *head.dimX*head.dimY*head.dimZ);
+	gzf.write(ptr, sizeof(Vector3D<float>) *head.dimX*head.dimY*head.dimZ);
 }
 
 template <>
-void gridConvertWrite(gzFile& gzf, Grid4d<int>& grid, void* ptr, UniHeader& head) {
-	gzwrite(gzf, &head,    sizeof(UniHeader));
-	gzwrite(gzf, &grid[0], sizeof(int)*head.dimX*head.dimY*head.dimZ*head.dimT);
+void gridConvertWrite(GzWriter& gzf, Grid4d<int>& grid, void* ptr, UniHeader& head) {
+	gzf.write(&head,    sizeof(UniHeader));
+	gzf.write(&grid[0], sizeof(int)*head.dimX*head.dimY*head.dimZ*head.dimT);
 }
 template <>
-void gridConvertWrite(gzFile& gzf, Grid4d<double>& grid, void* ptr, UniHeader& head) {
+void gridConvertWrite(GzWriter& gzf, Grid4d<double>& grid, void* ptr, UniHeader& head) {
 	head.bytesPerElement = sizeof(float);
-	gzwrite(gzf, &head, sizeof(UniHeader));
+	gzf.write(&head, sizeof(UniHeader));
 	float* ptrf = (float*)ptr;
 	IndexInt s = grid.getStrideT()*grid.getSizeT();
 	for(IndexInt i=0; i<s; ++i,++ptrf) {
 		*ptrf = (float)grid[i];
 	} 
-	gzwrite(gzf, ptr, sizeof(float)* s );
+	gzf.write(ptr, sizeof(float)* s );
 } 
 template <>
-void gridConvertWrite(gzFile& gzf, Grid4d<Vector3D<double> >& grid, void* ptr, UniHeader& head) {
+void gridConvertWrite(GzWriter& gzf, Grid4d<Vector3D<double> >& grid, void* ptr, UniHeader& head) {
 	head.bytesPerElement = sizeof(Vector3D<float>);
-	gzwrite(gzf, &head, sizeof(UniHeader));
+	gzf.write(&head, sizeof(UniHeader));
 	float* ptrf = (float*)ptr;
 	IndexInt s = grid.getStrideT()*grid.getSizeT();
 	for(IndexInt i=0; i<s; ++i) {
 		for(int c=0; c<3; ++c) { *ptrf = (float)grid[i][c]; ptrf++; }
 	} 
-	gzwrite(gzf, ptr, sizeof(Vector3D<float>) *s);
+	gzf.write(ptr, sizeof(Vector3D<float>) *s);
 }
 template <>
-void gridConvertWrite(gzFile& gzf, Grid4d<Vector4D<double> >& grid, void* ptr, UniHeader& head) {
+void gridConvertWrite(GzWriter& gzf, Grid4d<Vector4D<double> >& grid, void* ptr, UniHeader& head) {
 	head.bytesPerElement = sizeof(Vector4D<float>);
-	gzwrite(gzf, &head, sizeof(UniHeader));
+	gzf.write(&head, sizeof(UniHeader));
 	float* ptrf = (float*)ptr;
 	IndexInt s = grid.getStrideT()*grid.getSizeT();
 	for(IndexInt i=0; i<s; ++i) {
 		for(int c=0; c<4; ++c) { *ptrf = (float)grid[i][c]; ptrf++; }
 	} 
-	gzwrite(gzf, ptr, sizeof(Vector4D<float>) *s);
+	gzf.write(ptr, sizeof(Vector4D<float>) *s);
 }
 
 template <class T>
@@ -236,6 +238,166 @@ static int unifyGridType(int type) {
 	return type;
 }
 
+//! uni file v5 ("MNT4"): ID, UniHeader and UniChunkHeader, followed by a table of numChunks+1 byte
+//! offsets into the payload and the independently deflated chunks. Chunks hold whole z slices
+//! (y rows for 2d grids), so they can be (de)compressed in parallel and sub-boxes can be read
+//! without inflating the whole grid. The file itself is not gzipped.
+typedef struct {
+	int numChunks;      // number of deflated chunks
+	int slicesPerChunk; // z slices (2d: y rows) per chunk, the last one can hold fewer
+} UniChunkHeader;
+
+//! uncompressed chunk size, large enough for a good ratio, small enough to balance the threads
+static const IndexInt UNI_CHUNK_BYTES = 1 << 20;
+
+//! conversion between grid values and uni payload values, floating point data is always single prec.
+template <class T> struct UniElement {
+	typedef T FileType;
+	static inline FileType toFile(const T& v)          { return v; }
+	static inline T        fromFile(const FileType& v) { return v; }
+};
+template <> struct UniElement<double> {
+	typedef float FileType;
+	static inline FileType toFile(const double& v)     { return (float)v; }
+	static inline double   fromFile(const FileType& v) { return (double)v; }
+};
+template <> struct UniElement<Vector3D<double> > {
+	typedef Vector3D<float> FileType;
+	static inline FileType         toFile(const Vector3D<double>& v) { return toVec3f(v); }
+	static inline Vector3D<double> fromFile(const FileType& v)       { return toVec3d(v); }
+};
+
+//! z slices of 3d grids, y rows of 2d grids
+static inline int uniNumSlices(const UniHeader& head) {
+	return (head.dimZ > 1) ? head.dimZ : head.dimY;
+}
+static inline IndexInt uniSliceElements(const UniHeader& head) {
+	return (head.dimZ > 1) ? (IndexInt)head.dimX * head.dimY : (IndexInt)head.dimX;
+}
+
+//! Kernel: deflate the chunks of a v5 uni payload
+
+
+ struct knDeflateUniChunks : public KernelBase { knDeflateUniChunks(const char* data, IndexInt bytes, IndexInt chunkBytes, vector< vector<char> >& chunks, vector<int>& ok) :  KernelBase(chunks.size()) ,data(data),bytes(bytes),chunkBytes(chunkBytes),chunks(chunks),ok(ok)   { runMessage(); run(); }   inline void op(IndexInt idx, const char* data, IndexInt bytes, IndexInt chunkBytes, vector< vector<char> >& chunks, vector<int>& ok ) {
+	const IndexInt start = idx * chunkBytes;
+	const uLong len = (uLong)min(chunkBytes, bytes - start);
+	uLongf outLen = compressBound(len);
+	vector<char>& out = chunks[idx];
+	out.resize(outLen);
+	ok[idx] = compress2((Bytef*)&out[0], &outLen, (const Bytef*)(data + start), len, 1) == Z_OK;
+	out.resize(outLen);
+}    inline const char* getArg0() { return data; } typedef char type0;inline IndexInt& getArg1() { return bytes; } typedef IndexInt type1;inline IndexInt& getArg2() { return chunkBytes; } typedef IndexInt type2;inline vector< vector<char> >& getArg3() { return chunks; } typedef vector< vector<char> > type3;inline vector<int>& getArg4() { return ok; } typedef vector<int> type4; void runMessage() { debMsg("Executing kernel knDeflateUniChunks ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,data,bytes,chunkBytes,chunks,ok);  }   } const char* data; IndexInt bytes; IndexInt chunkBytes; vector< vector<char> >& chunks; vector<int>& ok;   };
+//! Kernel: inflate chunks [firstChunk, firstChunk+size) of a v5 uni payload to dst, record failures in ok
+
+
+ struct knInflateUniChunks : public KernelBase { knInflateUniChunks(const char* packed, const vector<unsigned long long>& offsets, int firstChunk, char* dst, IndexInt bytes, IndexInt chunkBytes, vector<int>& ok) :  KernelBase(ok.size()) ,packed(packed),offsets(offsets),firstChunk(firstChunk),dst(dst),bytes(bytes),chunkBytes(chunkBytes),ok(ok)   { runMessage(); run(); }   inline void op(IndexInt idx, const char* packed, const vector<unsigned long long>& offsets, int firstChunk, char* dst, IndexInt bytes, IndexInt chunkBytes, vector<int>& ok ) {
+	const int c = firstChunk + (int)idx;
+	const IndexInt start = idx * chunkBytes;
+	const uLongf expected = (uLongf)min(chunkBytes, bytes - start);
+	uLongf len = expected;
+	const Bytef* in = (const Bytef*)(packed + (offsets[c] - offsets[firstChunk]));
+	ok[idx] = uncompress((Bytef*)(dst + start), &len, in, (uLong)(offsets[c+1] - offsets[c])) == Z_OK && len == expected;
+}    inline const char* getArg0() { return packed; } typedef char type0;inline const vector<unsigned long long>& getArg1() { return offsets; } typedef vector<unsigned long long> type1;inline int& getArg2() { return firstChunk; } typedef int type2;inline char* getArg3() { return dst; } typedef char type3;inline IndexInt& getArg4() { return bytes; } typedef IndexInt type4;inline IndexInt& getArg5() { return chunkBytes; } typedef IndexInt type5;inline vector<int>& getArg6() { return ok; } typedef vector<int> type6; void runMessage() { debMsg("Executing kernel knInflateUniChunks ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,packed,offsets,firstChunk,dst,bytes,chunkBytes,ok);  }   } const char* packed; const vector<unsigned long long>& offsets; int firstChunk; char* dst; IndexInt bytes; IndexInt chunkBytes; vector<int>& ok;   };
+
+
+//! seek to an absolute position, long is 32 bit on Windows so fseek can't reach offsets above 2GB
+static bool fseek64(FILE* file, unsigned long long pos) {
+#	ifdef WIN32
+	return _fseeki64(file, (__int64)pos, SEEK_SET) == 0;
+#	else
+	return fseeko(file, (off_t)pos, SEEK_SET) == 0;
+#	endif
+}
+
+//! skip bytes of a gzip stream, in steps that fit into z_off_t (32 bit on Windows)
+static bool gzSkip(gzFile gzf, IndexInt bytes) {
+	const IndexInt step = 1 << 30;
+	for (IndexInt pos = 0; pos < bytes; pos += step) {
+		if (gzseek(gzf, (z_off_t)min(step, bytes - pos), SEEK_CUR) < 0) return false;
+	}
+	return true;
+}
+
+//! read a complete buffer, gzread takes at most an unsigned int number of bytes per call
+static bool gzReadBuffer(gzFile gzf, char* data, IndexInt bytes) {
+	const IndexInt step = 1 << 30;
+	for (IndexInt pos = 0; pos < bytes; pos += step) {
+		const unsigned int len = (unsigned int)min(step, bytes - pos);
+		if (gzread(gzf, data + pos, len) != (int)len) return false;
+	}
+	return true;
+}
+
+//! reads the chunk table of a v5 uni file, and inflates ranges of slices in parallel
+class UniChunkReader {
+public:
+	UniChunkReader(const string& name) : mName(name) {
+		mFile = fopen(name.c_str(), "rb");
+		if (!mFile) errMsg("can't open file " << name);
+		try {
+			readChunkTable();
+		} catch (...) {
+			fclose(mFile);
+			throw;
+		}
+	}
+	~UniChunkReader() { fclose(mFile); }
+
+	const UniHeader& header() const { return mHead; }
+
+	//! first and end slice of the chunk containing slice s
+	int chunkStart(int s) const { return (s / mChunks.slicesPerChunk) * mChunks.slicesPerChunk; }
+	int chunkEnd(int s) const { return min(chunkStart(s) + mChunks.slicesPerChunk, uniNumSlices(mHead)); }
+
+	//! inflate the chunks covering slices [sliceStart, sliceEnd) to dst, which receives
+	//! the slices chunkStart(sliceStart) to chunkEnd(sliceEnd-1)
+	void read(int sliceStart, int sliceEnd, char* dst) {
+		const int firstChunk = sliceStart / mChunks.slicesPerChunk;
+		const int endChunk   = (sliceEnd-1) / mChunks.slicesPerChunk + 1;
+		assertMsg (sliceStart >= 0 && sliceEnd > sliceStart && endChunk <= mChunks.numChunks, "invalid slice range " << sliceStart << "-" << sliceEnd << " for file " << mName);
+		const IndexInt sliceBytes = uniSliceElements(mHead) * mHead.bytesPerElement;
+		const IndexInt bytes = (chunkEnd(sliceEnd-1) - chunkStart(sliceStart)) * sliceBytes;
+
+		// one read for all required chunks, inflated in parallel
+		vector<char> packed(mOffsets[endChunk] - mOffsets[firstChunk]);
+		const bool readOk = fseek64(mFile, mPayloadStart + mOffsets[firstChunk]) &&
+		                    fread(&packed[0], 1, packed.size(), mFile) == packed.size();
+		assertMsg (readOk, "can't read file " << mName << ", file is truncated");
+		countBytesRead(packed.size());
+		vector<int> ok(endChunk - firstChunk, 0);
+		knInflateUniChunks(&packed[0], mOffsets, firstChunk, dst, bytes, mChunks.slicesPerChunk * sliceBytes, ok);
+		for (size_t i=0; i<ok.size(); ++i)
+			assertMsg (ok[i], "can't read file " << mName << ", chunk " << (firstChunk+i) << " is corrupt");
+	}
+
+protected:
+	void readChunkTable() {
+		char ID[5]={0,0,0,0,0};
+		assertMsg (fread(ID, 1, 4, mFile) == 4 && !strcmp(ID, "MNT4"), "can't read file " << mName << ", not a v5 uni file");
+		assertMsg (fread(&mHead, sizeof(UniHeader), 1, mFile) == 1, "can't read file, no header present");
+		assertMsg (fread(&mChunks, sizeof(UniChunkHeader), 1, mFile) == 1, "can't read file, no chunk header present");
+		assertMsg (mChunks.numChunks > 0 && mChunks.slicesPerChunk > 0, "invalid chunk header in file " << mName);
+		mOffsets.resize(mChunks.numChunks+1);
+		assertMsg (fread(&mOffsets[0], sizeof(unsigned long long), mOffsets.size(), mFile) == mOffsets.size(), "can't read chunk table of file " << mName);
+		mPayloadStart = 4 + sizeof(UniHeader) + sizeof(UniChunkHeader) + sizeof(unsigned long long) * mOffsets.size();
+	}
+
+	string mName;
+	FILE* mFile;
+	UniHeader mHead;
+	UniChunkHeader mChunks;
+	vector<unsigned long long> mOffsets;
+	unsigned long long mPayloadStart;
+};
+
 #endif // NO_ZLIB!=1
 
 //*****************************************************************************
@@ -260,10 +422,10 @@ void writeGridRaw(const string& name, Grid<T>* grid) {
 	debMsg( "writing grid " << grid->getName() << " to raw file " << name ,1);
 	
 #	if NO_ZLIB!=1
-	gzFile gzf = gzopen(name.c_str(), "wb1"); // do some compression
-	if (!gzf) errMsg("can't open file " << name);
-	gzwrite(gzf, &((*grid)[0]), sizeof(T)*grid->getSizeX()*grid->getSizeY()*grid->getSizeZ());
-	gzclose(gzf);
+	GzWriter gzf(name); // do some compression
+	if (!gzf.good()) errMsg("can't open file " << name);
+	gzf.write(&((*grid)[0]), sizeof(T)*grid->getSizeX()*grid->getSizeY()*grid->getSizeZ());
+	gzf.close();
 #	else
 	debMsg( "file format not supported without zlib" ,1);
 #	endif
@@ -274,12 +436,14 @@ void readGridRaw(const string& name, Grid<T>* grid) {
 	debMsg( "reading grid " << grid->getName() << " from raw file " << name ,1);
 	
 #	if NO_ZLIB!=1
+	waitForFileWrite(name);
 	gzFile gzf = gzopen(name.c_str(), "rb");
 	if (!gzf) errMsg("can't open file " << name);
 	
 	IndexInt bytes = sizeof(T)*grid->getSizeX()*grid->getSizeY()*grid->getSizeZ();
 	IndexInt readBytes = gzread(gzf, &((*grid)[0]), bytes);
 	assertMsg(bytes==readBytes, "can't read raw file, stream length does not match, "<<bytes<<" vs "<<readBytes);
+	countBytesRead(readBytes);
 	gzclose(gzf);
 #	else
 	debMsg( "file format not supported without zlib" ,1);
@@ -308,6 +472,7 @@ typedef struct {
 void getUniFileSize(const string& name, int& x, int& y, int& z, int* t, std::string* info) {
 	x = y = z = 0;
 #	if NO_ZLIB!=1
+	waitForFileWrite(name);
 	gzFile gzf = gzopen(name.c_str(), "rb");
 	if (gzf) { 
 		char ID[5]={0,0,0,0,0};
@@ -329,8 +494,8 @@ void getUniFileSize(const string& name, int& x, int& y, int& z, int* t, std::str
 			}
 		}
 
-		// v4
-		if ( (!strcmp(ID, "MNT3")) || (!strcmp(ID, "M4T3")) ) {
+		// v4, v5 (same header, chunked payload)
+		if ( (!strcmp(ID, "MNT3")) || (!strcmp(ID, "M4T3")) || (!strcmp(ID, "MNT4")) ) {
 			UniHeader head;
 			assertMsg (gzread(gzf, &head, sizeof(UniHeader)) == sizeof(UniHeader), "can't read file, no header present"); 
 			x = head.dimX;
@@ -372,14 +537,15 @@ void writeGridUni(const string& name, Grid<T>* grid) {
 	debMsg( "Writing grid " << grid->getName() << " to uni file " << name ,1);
 	
 #	if NO_ZLIB!=1
-	char ID[5] = "MNT3";
+	typedef typename UniElement<T>::FileType FileType;
+	char ID[5] = "MNT4";
 	UniHeader head;
 	head.dimX = grid->getSizeX();
 	head.dimY = grid->getSizeY();
 	head.dimZ = grid->getSizeZ();
 	head.dimT = 0;
 	head.gridType = grid->getType();
-	head.bytesPerElement = sizeof(T);
+	head.bytesPerElement = sizeof(FileType); // always write float values, even if compiled with double precision
 	snprintf( head.info, STR_LEN_GRID, "%s", buildInfoString().c_str() );	
 	MuTime stamp;
 	head.timestamp = stamp.time;
@@ -392,22 +558,40 @@ void writeGridUni(const string& name, Grid<T>* grid) {
 		head.elementType = 2;
 	else 
 		errMsg("unknown element type");
-	
-	gzFile gzf = gzopen(name.c_str(), "wb1"); // do some compression
-	if (!gzf) errMsg("can't open file " << name);
-	
-	gzwrite(gzf, ID, 4);
-#	if FLOATINGPOINT_PRECISION!=1
-	// always write float values, even if compiled with double precision...
-	Grid<T> temp(grid->getParent());
-	// "misuse" temp grid as storage for floating point values (we have double, so it will always fit)
-	gridConvertWrite( gzf, *grid, &(temp[0]), head);
-#	else
-	void* ptr = &((*grid)[0]);
-	gzwrite(gzf, &head, sizeof(UniHeader));
-	gzwrite(gzf, ptr, sizeof(T)*head.dimX*head.dimY*head.dimZ);
-#	endif
-	gzclose(gzf);
+
+	// payload in file precision, only needs a copy if the grid values have to be converted
+	const IndexInt numElements = (IndexInt)head.dimX * head.dimY * head.dimZ;
+	vector<FileType> temp;
+	const char* data = (const char*)&((*grid)[0]);
+	if (sizeof(FileType) != sizeof(T)) {
+		temp.resize(numElements);
+		for (IndexInt i=0; i<numElements; ++i) temp[i] = UniElement<T>::toFile((*grid)[i]);
+		data = (const char*)&temp[0];
+	}
+
+	// deflate chunks of whole slices in parallel
+	const IndexInt sliceBytes = uniSliceElements(head) * sizeof(FileType);
+	UniChunkHeader chunkHead;
+	chunkHead.slicesPerChunk = (int)max((IndexInt)1, UNI_CHUNK_BYTES / sliceBytes);
+	chunkHead.numChunks = (uniNumSlices(head) + chunkHead.slicesPerChunk - 1) / chunkHead.slicesPerChunk;
+	vector< vector<char> > chunks(chunkHead.numChunks);
+	vector<int> ok(chunkHead.numChunks, 0);
+	knDeflateUniChunks(data, numElements * sizeof(FileType), chunkHead.slicesPerChunk * sliceBytes, chunks, ok);
+	vector<unsigned long long> offsets(chunkHead.numChunks+1, 0);
+	for (int c=0; c<chunkHead.numChunks; ++c) {
+		if (!ok[c]) errMsg("can't compress grid " << grid->getName());
+		offsets[c+1] = offsets[c] + chunks[c].size();
+	}
+
+	GzWriter file(name, -1); // chunks are compressed already
+	if (!file.good()) errMsg("can't open file " << name);
+	file.write(ID, 4);
+	file.write(&head, sizeof(UniHeader));
+	file.write(&chunkHead, sizeof(UniChunkHeader));
+	file.write(&offsets[0], sizeof(unsigned long long) * offsets.size());
+	for (int c=0; c<chunkHead.numChunks; ++c)
+		file.write(&chunks[c][0], chunks[c].size());
+	file.close();
 
 #	else
 	debMsg( "file format not supported without zlib" ,1);
@@ -420,13 +604,33 @@ void readGridUni(const string& name, Grid<T>* grid) {
 	debMsg( "Reading grid " << grid->getName() << " from uni file " << name ,1);
 
 #	if NO_ZLIB!=1
+	waitForFileWrite(name);
 	gzFile gzf = gzopen(name.c_str(), "rb");
 	if (!gzf) errMsg("can't open file " << name);
 
 	char ID[5]={0,0,0,0,0};
 	gzread(gzf, ID, 4);
 	
-	if (!strcmp(ID, "DDF2")) {
+	if (!strcmp(ID, "MNT4")) {
+		// current file format, chunked payload (gzread passes the uncompressed ID through)
+		gzclose(gzf);
+		typedef typename UniElement<T>::FileType FileType;
+		UniChunkReader file(name);
+		const UniHeader& head = file.header();
+		assertMsg (head.dimX == grid->getSizeX() && head.dimY == grid->getSizeY() && head.dimZ == grid->getSizeZ(), "grid dim doesn't match, "<< Vec3(head.dimX,head.dimY,head.dimZ)<<" vs "<< grid->getSize() );
+		assertMsg (unifyGridType(head.gridType)==unifyGridType(grid->getType()) , "grid type doesn't match "<< head.gridType<<" vs "<< grid->getType() );
+		assertMsg (head.bytesPerElement == sizeof(FileType), "grid element size doesn't match "<< head.bytesPerElement <<" vs "<< sizeof(FileType) );
+		if (sizeof(FileType) == sizeof(T)) {
+			file.read(0, uniNumSlices(head), (char*)&((*grid)[0]));
+		} else {
+			// convert float to double
+			vector<FileType> temp((IndexInt)head.dimX * head.dimY * head.dimZ);
+			file.read(0, uniNumSlices(head), (char*)&temp[0]);
+			for (IndexInt i=0; i<(IndexInt)temp.size(); ++i) (*grid)[i] = UniElement<T>::fromFile(temp[i]);
+		}
+		return;
+	}
+	else if (!strcmp(ID, "DDF2")) {
 		// legacy file format
 		UniLegacyHeader head;
 		assertMsg (gzread(gzf, &head, sizeof(UniLegacyHeader)) == sizeof(UniLegacyHeader), "can't read file, no header present");
@@ -480,12 +684,74 @@ void readGridUni(const string& name, Grid<T>* grid) {
 	} else {
 		errMsg( "Unknown header '"<<ID<<"' " );
 	}
+	countBytesRead(gztell(gzf));
 	gzclose(gzf);
 #	else
 	debMsg( "file format not supported without zlib" ,1);
 #	endif
 };
 
+template <class T>
+void readGridUniRegion(const string& name, Grid<T>* grid, Vec3i offset) {
+	debMsg( "Reading region of grid " << grid->getName() << " from uni file " << name << " at " << offset ,1);
+
+#	if NO_ZLIB!=1
+	typedef typename UniElement<T>::FileType FileType;
+	waitForFileWrite(name);
+	gzFile gzf = gzopen(name.c_str(), "rb");
+	if (!gzf) errMsg("can't open file " << name);
+	char ID[5]={0,0,0,0,0};
+	gzread(gzf, ID, 4);
+	UniHeader head = UniHeader();
+	const bool knownFormat = !strcmp(ID, "MNT3") || !strcmp(ID, "MNT4");
+	const bool headOk = knownFormat && gzread(gzf, &head, sizeof(UniHeader)) == sizeof(UniHeader);
+	const Vec3i fileSize(head.dimX, head.dimY, head.dimZ);
+	const Vec3i end = offset + grid->getSize();
+	const bool inside = offset.x >= 0 && offset.y >= 0 && offset.z >= 0 && end.x <= fileSize.x && end.y <= fileSize.y && end.z <= fileSize.z;
+	const bool typeOk = unifyGridType(head.gridType)==unifyGridType(grid->getType()) && head.bytesPerElement == sizeof(FileType);
+	// close the file before any of the checks below throws
+	if (!headOk || !inside || !typeOk) gzclose(gzf);
+	if (!knownFormat) errMsg( "Region reads need a v4 or v5 uni file, '"<<ID<<"' is not supported" );
+	assertMsg (headOk, "can't read file, no header present");
+	assertMsg (inside, "region " << offset << " - " << end << " is outside of the grid in file " << name << ", " << fileSize );
+	assertMsg (unifyGridType(head.gridType)==unifyGridType(grid->getType()) , "grid type doesn't match "<< head.gridType<<" vs "<< grid->getType() );
+	assertMsg (head.bytesPerElement == sizeof(FileType), "grid element size doesn't match "<< head.bytesPerElement <<" vs "<< sizeof(FileType) );
+
+	// only the slices overlapping the region are read
+	const bool is3D = head.dimZ > 1;
+	const int sliceStart = is3D ? offset.z : offset.y;
+	const int sliceEnd   = is3D ? end.z    : end.y;
+	const IndexInt sliceElements = uniSliceElements(head);
+	vector<FileType> data;
+	int dataStart = sliceStart; // first slice in data
+	if (!strcmp(ID, "MNT4")) {
+		gzclose(gzf);
+		UniChunkReader file(name);
+		dataStart = file.chunkStart(sliceStart);
+		data.resize((file.chunkEnd(sliceEnd-1) - dataStart) * sliceElements);
+		file.read(sliceStart, sliceEnd, (char*)&data[0]);
+	} else {
+		// v4 files are a single gzip stream, skip to the first slice
+		data.resize((sliceEnd - sliceStart) * sliceElements);
+		const IndexInt bytes = data.size() * sizeof(FileType);
+		const bool readOk = gzSkip(gzf, (IndexInt)sliceStart * sliceElements * sizeof(FileType)) &&
+		                    gzReadBuffer(gzf, (char*)&data[0], bytes);
+		countBytesRead(bytes);
+		gzclose(gzf);
+		assertMsg (readOk, "can't read file " << name << ", file is truncated");
+	}
+
+	// copy the region
+	const IndexInt dataOffset = dataStart * sliceElements;
+	FOR_IJK(*grid) {
+		const IndexInt fileIdx = ((IndexInt)(k + offset.z) * head.dimY + (j + offset.y)) * head.dimX + (i + offset.x);
+		(*grid)(i,j,k) = UniElement<T>::fromFile(data[fileIdx - dataOffset]);
+	}
+#	else
+	debMsg( "file format not supported without zlib" ,1);
+#	endif
+};
+
 template <class T>
 void writeGridVol(const string& name, Grid<T>* grid) {
 	debMsg( "writing grid " << grid->getName() << " to vol file " << name ,1);
@@ -601,23 +867,23 @@ void writeGrid4dUni(const string& name, Grid4d<T>* grid) {
 	else 
 		errMsg("unknown element type");
 	
-	gzFile gzf = gzopen(name.c_str(), "wb1"); // do some compression
-	if (!gzf) errMsg("can't open file " << name);
+	GzWriter gzf(name); // do some compression
+	if (!gzf.good()) errMsg("can't open file " << name);
 	
-	gzwrite(gzf, ID, 4);
+	gzf.write(ID, 4);
 #	if FLOATINGPOINT_PRECISION!=1
 	Grid4d<T> temp(grid->getParent());
 	gridConvertWrite< Grid4d<T> >( gzf, *grid, &(temp[0]), head);
 #	else
-	gzwrite(gzf, &head, sizeof(UniHeader));
+	gzf.write(&head, sizeof(UniHeader));
 
 	// can be too large - write in chunks
 	for(int t=0; t<head.dimT; ++t) { 
 		void* ptr = &((*grid)[           head.dimX*head.dimY*head.dimZ* t ]);
-		gzwrite(gzf, ptr,      sizeof(T)*head.dimX*head.dimY*head.dimZ* 1);
+		gzf.write(ptr,      sizeof(T)*head.dimX*head.dimY*head.dimZ* 1);
 	}
 #	endif
-	gzclose(gzf);
+	gzf.close();
 #	else
 	debMsg( "file format not supported without zlib" ,1);
 #	endif
@@ -637,6 +903,7 @@ void readGrid4dUni(const string& name, Grid4d<T>* grid, int readTslice, Grid4d<T
 
 	// optionally - reuse file handle, if valid one is passed in fileHandle pointer...
 	if( (!fileHandle) || (fileHandle && (*fileHandle == NULL)) ) {
+		waitForFileWrite(name);
 		gzf = gzopen(name.c_str(), "rb");
 		if (!gzf) errMsg("can't open file "<<name);
 
@@ -737,10 +1004,10 @@ void writeGrid4dRaw(const string& name, Grid4d<T>* grid) {
 	debMsg( "writing grid4d " << grid->getName() << " to raw file " << name ,1);
 	
 #	if NO_ZLIB!=1
-	gzFile gzf = gzopen(name.c_str(), "wb1"); // do some compression
-	if (!gzf) errMsg("can't open file " << name);
-	gzwrite(gzf, &((*grid)[0]), sizeof(T)*grid->getSizeX()*grid->getSizeY()*grid->getSizeZ()*grid->getSizeT());
-	gzclose(gzf);
+	GzWriter gzf(name); // do some compression
+	if (!gzf.good()) errMsg("can't open file " << name);
+	gzf.write(&((*grid)[0]), sizeof(T)*grid->getSizeX()*grid->getSizeY()*grid->getSizeZ()*grid->getSizeT());
+	gzf.close();
 #	else
 	debMsg( "file format not supported without zlib" ,1);
 #	endif
@@ -751,12 +1018,14 @@ void readGrid4dRaw(const string& name, Grid4d<T>* grid) {
 	debMsg( "reading grid4d " << grid->getName() << " from raw file " << name ,1);
 	
 #	if NO_ZLIB!=1
+	waitForFileWrite(name);
 	gzFile gzf = gzopen(name.c_str(), "rb");
 	if (!gzf) errMsg("can't open file " << name);
 	
 	IndexInt bytes = sizeof(T)*grid->getSizeX()*grid->getSizeY()*grid->getSizeZ()*grid->getSizeT();
 	IndexInt readBytes = gzread(gzf, &((*grid)[0]), bytes);
 	assertMsg(bytes==readBytes, "can't read raw file, stream length does not match, "<<bytes<<" vs "<<readBytes);
+	countBytesRead(readBytes);
 	gzclose(gzf);
 #	else
 	debMsg( "file format not supported without zlib" ,1);
@@ -769,154 +1038,171 @@ void readGrid4dRaw(const string& name, Grid4d<T>* grid) {
 
 #if OPENVDB==1
 
-template <class T>
-void writeGridVDB(const string& name, Grid<T>* grid) { 
-	debMsg("Writing grid " << grid->getName() << " to vdb file " << name << " not yet supported!", 1);
-}
-
-template <class T>
-void readGridVDB(const string& name, Grid<T>* grid) {
-	debMsg("Reading grid " << grid->getName() << " from vdb file " << name << " not yet supported!", 1);
+//! vdb export settings, see setVDBOptions
+struct VdbOptions {
+	enum Compression { CompressNone = 0, CompressZip = 1, CompressBlosc = 2 };
+	VdbOptions() : threshold(0.), halfFloat(false), compression(CompressBlosc) {}
+	Real threshold;  // voxels closer than this to the background value stay inactive
+	bool halfFloat;  // store floating point values with 16 bits
+	int compression; // blosc falls back to zip if openvdb was built without blosc
+};
+static VdbOptions& vdbOptions() {
+	static VdbOptions options;
+	return options;
 }
 
-template <>
-void writeGridVDB(const string& name, Grid<Real>* grid) {
-	debMsg("Writing real grid " << grid->getName() << " to vdb file " << name, 1);
-
-	// Create an empty floating-point grid with background value 0.
-	openvdb::initialize();
-	openvdb::FloatGrid::Ptr gridVDB = openvdb::FloatGrid::create(); 
-	gridVDB->setTransform( openvdb::math::Transform::createLinearTransform( 1./grid->getSizeX() )); //voxel size
-
-	// Get an accessor for coordinate-based access to voxels.
-	openvdb::FloatGrid::Accessor accessor = gridVDB->getAccessor();
-
-	// Identify the grid as a level set.
-	gridVDB->setGridClass(openvdb::GRID_FOG_VOLUME);
-
-	// Name the grid "density".
-	gridVDB->setName( grid->getName() );
-
-	openvdb::io::File file(name);
-
-	FOR_IJK(*grid) { 
-		openvdb::Coord xyz(i, j, k);
-		accessor.setValue(xyz, (*grid)(i, j, k));	
-	}
-
-	// Add the grid pointer to a container.
-	openvdb::GridPtrVec gridsVDB;
-	gridsVDB.push_back(gridVDB);
-
-	// Write out the contents of the container.
-	file.write(gridsVDB);
-	file.close();
+//! openvdb value and grid types for manta grids
+template <class T> struct VdbTraits {};
+template <> struct VdbTraits<Real> {
+	typedef openvdb::FloatGrid GridType;
+	typedef float ValueType;
+	static inline ValueType toVdb(const Real& v)        { return (float)v; }
+	static inline Real      fromVdb(const ValueType& v) { return (Real)v; }
+};
+template <> struct VdbTraits<Vec3> {
+	typedef openvdb::Vec3SGrid GridType;
+	typedef openvdb::Vec3f ValueType;
+	static inline ValueType toVdb(const Vec3& v)        { return ValueType((float)v.x, (float)v.y, (float)v.z); }
+	static inline Vec3      fromVdb(const ValueType& v) { return Vec3(v[0], v[1], v[2]); }
 };
 
-template <>
-void readGridVDB(const string& name, Grid<Real>* grid) {
-	debMsg("Reading real grid " << grid->getName() << " from vdb file " << name, 1);
-
-	openvdb::initialize();
-	openvdb::io::File file(name);
-	file.open();
-
-	openvdb::GridBase::Ptr baseGrid;
-	for (openvdb::io::File::NameIterator nameIter = file.beginName(); nameIter != file.endName(); ++nameIter)
-	{
-	#ifndef BLENDER
-		// Read in only the grid we are interested in.
-		if (nameIter.gridName() == grid->getName()) {
-			baseGrid = file.readGrid(nameIter.gridName());
-		} else {
-			debMsg("skipping grid " << nameIter.gridName(), 1);
+//! dense view of a grid for the openvdb tools, wraps the grid memory unless values need to be
+//! converted (double precision builds)
+template <class T>
+class VdbDense {
+public:
+	typedef typename VdbTraits<T>::ValueType ValueType;
+	// x changes fastest, like the manta grid layout
+	typedef openvdb::tools::Dense<ValueType, openvdb::tools::LayoutXYZ> DenseType;
+
+	VdbDense(Grid<T>* grid) : mGrid(grid) {
+		ValueType* data = reinterpret_cast<ValueType*>(&(*grid)[0]);
+		if (sizeof(ValueType) != sizeof(T)) {
+			mTemp.resize((size_t)grid->getSizeX() * grid->getSizeY() * grid->getSizeZ());
+			data = &mTemp[0];
 		}
-	#else
-		// For Blender, skip name check and pick first grid from loop
-		baseGrid = file.readGrid(nameIter.gridName());
-		break;
-	#endif
+		const openvdb::CoordBBox bbox(openvdb::Coord(0,0,0), openvdb::Coord(grid->getSizeX()-1, grid->getSizeY()-1, grid->getSizeZ()-1));
+		mDense.reset(new DenseType(bbox, data));
 	}
-	file.close();
-	openvdb::FloatGrid::Ptr gridVDB = openvdb::gridPtrCast<openvdb::FloatGrid>(baseGrid);
 
-	openvdb::FloatGrid::Accessor accessor = gridVDB->getAccessor();
+	DenseType& dense() { return *mDense; }
+	//! update a converted view from the grid values
+	void fromGrid() { for (size_t i=0; i<mTemp.size(); ++i) mTemp[i] = VdbTraits<T>::toVdb((*mGrid)[i]); }
+	//! write a converted view back to the grid
+	void toGrid() { for (size_t i=0; i<mTemp.size(); ++i) (*mGrid)[i] = VdbTraits<T>::fromVdb(mTemp[i]); }
 
-	FOR_IJK(*grid) {
-		openvdb::Coord xyz(i, j, k);
-		float v = accessor.getValue(xyz);
-		(*grid)(i, j, k) = v;
-	}
+protected:
+	Grid<T>* mGrid;
+	vector<ValueType> mTemp;
+	std::unique_ptr<DenseType> mDense;
 };
 
-template <>
-void writeGridVDB(const string& name, Grid<Vec3>* grid) {
-	debMsg("Writing vec3 grid " << grid->getName() << " to vdb file " << name, 1);
-
-	openvdb::initialize(); 
-	openvdb::Vec3SGrid::Ptr gridVDB = openvdb::Vec3SGrid::create();
-	// note , warning - velocity content currently not scaled...
-	gridVDB->setTransform( openvdb::math::Transform::createLinearTransform( 1./grid->getSizeX() )); //voxel size 
-	openvdb::Vec3SGrid::Accessor accessor = gridVDB->getAccessor();
-
-	// MAC or regular vec grid?
-	if(grid->getType() & GridBase::TypeMAC) gridVDB->setGridClass(openvdb::GRID_STAGGERED);
-	else gridVDB->setGridClass(openvdb::GRID_UNKNOWN);
+//! sparse copy of a grid, only voxels differing from the background value 0 by more than the
+//! threshold are activated. The tree is built in parallel by openvdb
+template <class T>
+static openvdb::GridBase::Ptr gridToVDB(Grid<T>* grid, const string& name) {
+	typedef typename VdbTraits<T>::GridType GridType;
+	VdbDense<T> view(grid);
+	view.fromGrid();
+	typename GridType::Ptr gridVDB = GridType::create();
+	openvdb::tools::copyFromDense(view.dense(), *gridVDB, typename GridType::ValueType((float)vdbOptions().threshold), false);
+	gridVDB->setTransform( openvdb::math::Transform::createLinearTransform( 1./grid->getSizeX() )); //voxel size
+	gridVDB->setName(name);
+	gridVDB->setSaveFloatAsHalf(vdbOptions().halfFloat);
+	return gridVDB;
+}
 
-	gridVDB->setName( grid->getName() );
+//! fill a grid from a vdb grid, inactive voxels receive the background value
+template <class T>
+static void gridFromVDB(Grid<T>* grid, openvdb::GridBase::Ptr baseGrid) {
+	typedef typename VdbTraits<T>::GridType GridType;
+	typename GridType::Ptr gridVDB = openvdb::gridPtrCast<GridType>(baseGrid);
+	if (!gridVDB) errMsg("vdb grid " << baseGrid->getName() << " doesn't match the type of grid " << grid->getName());
+	VdbDense<T> view(grid);
+	openvdb::tools::copyToDense(*gridVDB, view.dense(), false);
+	view.toGrid();
+}
 
-	openvdb::io::File file(name);
-	FOR_IJK(*grid) { 
-		openvdb::Coord xyz(i, j, k);
-		Vec3 v = (*grid)(i, j, k);
-		openvdb::Vec3f vo( (float)v[0] , (float)v[1] , (float)v[2] );
-		accessor.setValue(xyz, vo);
-	}
+void writeGridsVDB(const string& name, const vector<GridBase*>& grids, const vector<string>& names) {
+	debMsg("Writing " << grids.size() << " grid(s) to vdb file " << name, 1);
 
+	openvdb::initialize();
 	openvdb::GridPtrVec gridsVDB;
-	gridsVDB.push_back(gridVDB);
+	for (size_t i=0; i<grids.size(); ++i) {
+		GridBase* grid = grids[i];
+		const string gridName = (i < names.size()) ? names[i] : grid->getName();
+		if (grid->getType() & GridBase::TypeReal) {
+			openvdb::GridBase::Ptr gridVDB = gridToVDB((Grid<Real>*)grid, gridName);
+			gridVDB->setGridClass(openvdb::GRID_FOG_VOLUME);
+			gridsVDB.push_back(gridVDB);
+		}
+		else if (grid->getType() & GridBase::TypeVec3) {
+			// note , warning - velocity content currently not scaled...
+			openvdb::GridBase::Ptr gridVDB = gridToVDB((Grid<Vec3>*)grid, gridName);
+			// MAC or regular vec grid?
+			gridVDB->setGridClass((grid->getType() & GridBase::TypeMAC) ? openvdb::GRID_STAGGERED : openvdb::GRID_UNKNOWN);
+			gridsVDB.push_back(gridVDB);
+		}
+		else
+			debMsg("Writing grid " << grid->getName() << " to vdb file " << name << " not yet supported!", 1);
+	}
+	if (gridsVDB.empty()) return;
 
+	// only active voxels are stored
+	openvdb::io::File file(name);
+	uint32_t compression = openvdb::io::COMPRESS_ACTIVE_MASK;
+	if (vdbOptions().compression == VdbOptions::CompressBlosc && openvdb::io::hasBloscCompression())
+		compression |= openvdb::io::COMPRESS_BLOSC;
+	else if (vdbOptions().compression != VdbOptions::CompressNone)
+		compression |= openvdb::io::COMPRESS_ZIP;
+	file.setCompression(compression);
 	file.write(gridsVDB);
 	file.close();
-};
+}
 
-template <>
-void readGridVDB(const string& name, Grid<Vec3>* grid) {
-	debMsg("Reading vec3 grid " << grid->getName() << " from vdb file " << name, 1);
+void readGridsVDB(const string& name, const vector<GridBase*>& grids, const vector<string>& names) {
+	debMsg("Reading " << grids.size() << " grid(s) from vdb file " << name, 1);
 
 	openvdb::initialize();
 	openvdb::io::File file(name);
 	file.open();
-
-	openvdb::GridBase::Ptr baseGrid;
-	for (openvdb::io::File::NameIterator nameIter = file.beginName(); nameIter != file.endName(); ++nameIter)
-	{
-	#ifndef BLENDER
-		// Read in only the grid we are interested in.
-		if (nameIter.gridName() == grid->getName()) {
-			baseGrid = file.readGrid(nameIter.gridName());
-		} else {
-			debMsg("skipping grid " << nameIter.gridName(), 1);
+	for (size_t i=0; i<grids.size(); ++i) {
+		GridBase* grid = grids[i];
+		const string gridName = (i < names.size()) ? names[i] : grid->getName();
+
+		// read in only the grids we are interested in
+		openvdb::GridBase::Ptr baseGrid;
+		if (file.hasGrid(gridName))
+			baseGrid = file.readGrid(gridName);
+#		ifdef BLENDER
+		// for Blender, skip name check of single grid files and pick the grid in the file
+		else if (grids.size() == 1 && file.beginName() != file.endName())
+			baseGrid = file.readGrid(file.beginName().gridName());
+#		endif
+		if (!baseGrid) {
+			debMsg("skipping grid " << gridName << ", not found in vdb file " << name, 1);
+			continue;
 		}
-	#else
-		// For Blender, skip name check and pick first grid from loop
-		baseGrid = file.readGrid(nameIter.gridName());
-		break;
-	#endif
+
+		if (grid->getType() & GridBase::TypeReal)
+			gridFromVDB((Grid<Real>*)grid, baseGrid);
+		else if (grid->getType() & GridBase::TypeVec3)
+			gridFromVDB((Grid<Vec3>*)grid, baseGrid);
+		else
+			debMsg("Reading grid " << grid->getName() << " from vdb file " << name << " not yet supported!", 1);
 	}
 	file.close();
-	openvdb::Vec3SGrid::Ptr gridVDB = openvdb::gridPtrCast<openvdb::Vec3SGrid>(baseGrid);
+}
 
-	openvdb::Vec3SGrid::Accessor accessor = gridVDB->getAccessor();
+template <class T>
+void writeGridVDB(const string& name, Grid<T>* grid) {
+	writeGridsVDB(name, vector<GridBase*>(1, grid), vector<string>());
+}
 
-	FOR_IJK(*grid) {
-		openvdb::Coord xyz(i, j, k);
-		openvdb::Vec3f v = accessor.getValue(xyz);
-		(*grid)(i, j, k).x = (float)v[0];
-		(*grid)(i, j, k).y = (float)v[1];
-		(*grid)(i, j, k).z = (float)v[2];
-	}
-};
+template <class T>
+void readGridVDB(const string& name, Grid<T>* grid) {
+	readGridsVDB(name, vector<GridBase*>(1, grid), vector<string>());
+}
 
 #endif // OPENVDB==1
 
@@ -956,6 +1242,75 @@ void quantizeGrid(Grid<Real>& grid, Real step) { knQuantize(grid,step); } static
 void quantizeGridVec3(Grid<Vec3>& grid, Real step) { knQuantizeVec3(grid,step); } static PyObject* _W_3 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "quantizeGridVec3" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Vec3>& grid = *_args.getPtr<Grid<Vec3> >("grid",0,&_lock); Real step = _args.get<Real >("step",1,&_lock);   _retval = getPyNone(); quantizeGridVec3(grid,step);  _args.check(); } pbFinalizePlugin(parent,"quantizeGridVec3", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("quantizeGridVec3",e.what()); return 0; } } static const Pb::Register _RP_quantizeGridVec3 ("","quantizeGridVec3",_W_3);  extern "C" { void PbRegister_quantizeGridVec3() { KEEP_UNUSED(_RP_quantizeGridVec3); } } 
 
 
+//! load the box starting at offset, with the size of grid, from a uni file (eg to crop a cached simulation)
+//! v5 files only inflate the chunks overlapping the box
+void loadUniRegion(GridBase* grid, const string& name, Vec3i offset=Vec3i(0)) {
+	if (grid->getType() & GridBase::TypeInt)
+		readGridUniRegion(name, (Grid<int>*)grid, offset);
+	else if (grid->getType() & GridBase::TypeReal)
+		readGridUniRegion(name, (Grid<Real>*)grid, offset);
+	else if (grid->getType() & GridBase::TypeVec3)
+		readGridUniRegion(name, (Grid<Vec3>*)grid, offset);
+	else
+		errMsg("loadUniRegion: unknown grid type");
+} static PyObject* _W_4 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "loadUniRegion" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; GridBase* grid = _args.getPtr<GridBase >("grid",0,&_lock); const string& name = _args.get<string >("name",1,&_lock); Vec3i offset = _args.getOpt<Vec3i >("offset",2,Vec3i(0),&_lock);   _retval = getPyNone(); loadUniRegion(grid,name,offset);  _args.check(); } pbFinalizePlugin(parent,"loadUniRegion", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("loadUniRegion",e.what()); return 0; } } static const Pb::Register _RP_loadUniRegion ("","loadUniRegion",_W_4);  extern "C" { void PbRegister_loadUniRegion() { KEEP_UNUSED(_RP_loadUniRegion); } } 
+
+
+//! manta grids from a python list, optionally renamed by a comma separated list of names
+void getGridList(const std::vector<PbClass*>& objects, const string& names, vector<GridBase*>& grids, vector<string>& gridNames) {
+	// make sure unnamed grids get their variable names
+	PbClass::renameObjects();
+	for (size_t i=0; i<objects.size(); ++i) {
+		GridBase* grid = dynamic_cast<GridBase*>(objects[i]);
+		if (!grid) errMsg("object " << objects[i]->getName() << " is not a grid");
+		grids.push_back(grid);
+	}
+	std::istringstream in(names);
+	string gridName;
+	while (std::getline(in, gridName, ','))
+		gridNames.push_back(gridName);
+	if (!gridNames.empty() && gridNames.size() != grids.size()) errMsg("number of grids and names doesn't match");
+}
+
+//! vdb export settings: voxels within threshold of the background value are inactive and not
+//! stored, halfFloat stores floating point values with 16 bits, compression is 0 (none), 1 (zip) or 2 (blosc)
+void setVDBOptions(Real threshold=0., bool halfFloat=false, int compression=2) {
+#	if OPENVDB==1
+	assertMsg (compression >= 0 && compression <= 2, "setVDBOptions: invalid compression " << compression);
+	vdbOptions().threshold = threshold;
+	vdbOptions().halfFloat = halfFloat;
+	vdbOptions().compression = compression;
+#	else
+	debMsg("setVDBOptions: compiled without openvdb support", 1);
+#	endif
+} static PyObject* _W_5 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "setVDBOptions" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Real threshold = _args.getOpt<Real >("threshold",0,0.,&_lock); bool halfFloat = _args.getOpt<bool >("halfFloat",1,false,&_lock); int compression = _args.getOpt<int >("compression",2,2,&_lock);   _retval = getPyNone(); setVDBOptions(threshold,halfFloat,compression);  _args.check(); } pbFinalizePlugin(parent,"setVDBOptions", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("setVDBOptions",e.what()); return 0; } } static const Pb::Register _RP_setVDBOptions ("","setVDBOptions",_W_5);  extern "C" { void PbRegister_setVDBOptions() { KEEP_UNUSED(_RP_setVDBOptions); } } 
+
+//! write several grids (eg all grids of a frame) into one multi-grid vdb file, stored under
+//! their variable names or the comma separated names given
+void saveGridsVDB(const string& name, std::vector<PbClass*> grids, const string& names="") {
+#	if OPENVDB==1
+	vector<GridBase*> gridList;
+	vector<string> nameList;
+	getGridList(grids, names, gridList, nameList);
+	writeGridsVDB(name, gridList, nameList);
+#	else
+	errMsg("saveGridsVDB: compiled without openvdb support");
+#	endif
+} static PyObject* _W_6 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "saveGridsVDB" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const string& name = _args.get<string >("name",0,&_lock); std::vector<PbClass*> grids = _args.get<std::vector<PbClass*> >("grids",1,&_lock); const string& names = _args.getOpt<string >("names",2,"",&_lock);   _retval = getPyNone(); saveGridsVDB(name,grids,names);  _args.check(); } pbFinalizePlugin(parent,"saveGridsVDB", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("saveGridsVDB",e.what()); return 0; } } static const Pb::Register _RP_saveGridsVDB ("","saveGridsVDB",_W_6);  extern "C" { void PbRegister_saveGridsVDB() { KEEP_UNUSED(_RP_saveGridsVDB); } } 
+
+//! read several grids from a multi-grid vdb file, grids not in the file are left unchanged
+void loadGridsVDB(const string& name, std::vector<PbClass*> grids, const string& names="") {
+#	if OPENVDB==1
+	vector<GridBase*> gridList;
+	vector<string> nameList;
+	getGridList(grids, names, gridList, nameList);
+	readGridsVDB(name, gridList, nameList);
+#	else
+	errMsg("loadGridsVDB: compiled without openvdb support");
+#	endif
+} static PyObject* _W_7 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "loadGridsVDB" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const string& name = _args.get<string >("name",0,&_lock); std::vector<PbClass*> grids = _args.get<std::vector<PbClass*> >("grids",1,&_lock); const string& names = _args.getOpt<string >("names",2,"",&_lock);   _retval = getPyNone(); loadGridsVDB(name,grids,names);  _args.check(); } pbFinalizePlugin(parent,"loadGridsVDB", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("loadGridsVDB",e.what()); return 0; } } static const Pb::Register _RP_loadGridsVDB ("","loadGridsVDB",_W_7);  extern "C" { void PbRegister_loadGridsVDB() { KEEP_UNUSED(_RP_loadGridsVDB); } } 
+
+
 
 // explicit instantiation
 template void writeGridRaw<int> (const string& name, Grid<int>*  grid);
@@ -976,6 +1331,9 @@ template void readGridRaw<Vec3> (const string& name, Grid<Vec3>* grid);
 template void readGridUni<int>  (const string& name, Grid<int>*  grid);
 template void readGridUni<Real> (const string& name, Grid<Real>* grid);
 template void readGridUni<Vec3> (const string& name, Grid<Vec3>* grid);
+template void readGridUniRegion<int>  (const string& name, Grid<int>*  grid, Vec3i offset);
+template void readGridUniRegion<Real> (const string& name, Grid<Real>* grid, Vec3i offset);
+template void readGridUniRegion<Vec3> (const string& name, Grid<Vec3>* grid, Vec3i offset);
 template void readGridVol<int>  (const string& name, Grid<int>*  grid);
 template void readGridVol<Vec3> (const string& name, Grid<Vec3>* grid);
 
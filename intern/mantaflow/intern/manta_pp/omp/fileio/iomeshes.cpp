@@ -61,34 +61,34 @@ typedef struct {
 #if NO_ZLIB!=1
 
 template <class T>
-void mdataConvertWrite( gzFile& gzf, MeshDataImpl<T>& mdata, void* ptr, UniMeshHeader& head) {
+void mdataConvertWrite( GzWriter& gzf, MeshDataImpl<T>& mdata, void* ptr, UniMeshHeader& head) {
 	errMsg("mdataConvertWrite: unknown type, not yet supported");
 }
 
 template <>
-void mdataConvertWrite( gzFile& gzf, MeshDataImpl<int>& mdata, void* ptr, UniMeshHeader& head) {
-	gzwrite(gzf, &head,     sizeof(UniMeshHeader));
-	gzwrite(gzf, &mdata[0], sizeof(int)*head.dim);
+void mdataConvertWrite( GzWriter& gzf, MeshDataImpl<int>& mdata, void* ptr, UniMeshHeader& head) {
+	gzf.write(&head,     sizeof(UniMeshHeader));
+	gzf.write(&mdata[0], sizeof(int)*head.dim);
 }
 template <>
-void mdataConvertWrite( gzFile& gzf, MeshDataImpl<double>& mdata, void* ptr, UniMeshHeader& head) {
+void mdataConvertWrite( GzWriter& gzf, MeshDataImpl<double>& mdata, void* ptr, UniMeshHeader& head) {
 	head.bytesPerElement = sizeof(float);
-	gzwrite(gzf, &head, sizeof(UniMeshHeader));
+	gzf.write(&head, sizeof(UniMeshHeader));
 	float* ptrf = (float*)ptr;
 	for(int i=0; i<mdata.size(); ++i,++ptrf) {
 		*ptrf = (float)mdata[i];
 	}
-	gzwrite(gzf, ptr, sizeof(float)* head.dim);
+	gzf.write(ptr, sizeof(float)* head.dim);
 }
 template <>
-void mdataConvertWrite( gzFile& gzf, MeshDataImpl<Vec3>& mdata, void* ptr, UniMeshHeader& head) {
+void mdataConvertWrite( GzWriter& gzf, MeshDataImpl<Vec3>& mdata, void* ptr, UniMeshHeader& head) {
 	head.bytesPerElement = sizeof(Vector3D<float>);
-	gzwrite(gzf, &head, sizeof(UniMeshHeader));
+	gzf.write(&head, sizeof(UniMeshHeader));
 	float* ptrf = (float*)ptr;
 	for(int i=0; i<mdata.size(); ++i) {
 		for(int c=0; c<3; ++c) { *ptrf = (float)mdata[i][c]; ptrf++; }
 	}
-	gzwrite(gzf, ptr, sizeof(Vector3D<float>) *head.dim);
+	gzf.write(ptr, sizeof(Vector3D<float>) *head.dim);
 }
 
 
@@ -145,6 +145,7 @@ void readBobjFile(const string& name, Mesh* mesh, bool append) {
 	const Real dx = mesh->getParent()->getDx();
 	const Vec3 gs = toVec3( mesh->getParent()->getGridSize() );
 
+	waitForFileWrite(name);
 	gzFile gzf = gzopen(name.c_str(), "rb1"); // do some compression
 	if (!gzf)
 		errMsg("readBobj: unable to open file");
@@ -185,6 +186,7 @@ void readBobjFile(const string& name, Mesh* mesh, bool append) {
 		}
 	} 
 	// note - vortex sheet info ignored for now... (see writeBobj)
+	countBytesRead(gztell(gzf));
 	gzclose( gzf );    
 	debMsg( "read mesh , triangles "<<mesh->numTris()<<", vertices "<<mesh->numNodes()<<" ",1 );
 #	else
@@ -198,36 +200,36 @@ void writeBobjFile(const string& name, Mesh* mesh) {
 	const Real  dx = mesh->getParent()->getDx();
 	const Vec3i gs = mesh->getParent()->getGridSize();
 
-	gzFile gzf = gzopen(name.c_str(), "wb1"); // do some compression
-	if (!gzf)
+	GzWriter gzf(name); // do some compression
+	if (!gzf.good())
 		errMsg("writeBobj: unable to open file");
 
 	// write vertices
 	int numVerts = mesh->numNodes();
-	gzwrite(gzf, &numVerts, sizeof(int));
+	gzf.write(&numVerts, sizeof(int));
 	for (int i=0; i<numVerts; i++) {
 		Vector3D<float> pos = toVec3f(mesh->nodes(i).pos);
 		// normalize to unit cube around 0
 		pos -= toVec3f(gs)*0.5;
 		pos *= dx;
-		gzwrite(gzf, &pos.value[0], sizeof(float)*3);
+		gzf.write(&pos.value[0], sizeof(float)*3);
 	}
 
 	// normals
 	mesh->computeVertexNormals();
-	gzwrite(gzf, &numVerts, sizeof(int));
+	gzf.write(&numVerts, sizeof(int));
 	for (int i=0; i<numVerts; i++) {
 		Vector3D<float> pos = toVec3f(mesh->nodes(i).normal);
-		gzwrite(gzf, &pos.value[0], sizeof(float)*3);
+		gzf.write(&pos.value[0], sizeof(float)*3);
 	}
 
 	// write tris
 	int numTris = mesh->numTris();
-	gzwrite(gzf, &numTris, sizeof(int));
+	gzf.write(&numTris, sizeof(int));
 	for(int t=0; t<numTris; t++) {
 		for(int j=0; j<3; j++) { 
 			int trip = mesh->tris(t).c[j];
-			gzwrite(gzf, &trip, sizeof(int)); 
+			gzf.write(&trip, sizeof(int)); 
 		}
 	}
 
@@ -235,7 +237,7 @@ void writeBobjFile(const string& name, Mesh* mesh) {
 	if (mesh->getType() == Mesh::TypeVortexSheet) {
 		VortexSheetMesh* vmesh = (VortexSheetMesh*) mesh;
 		int densId[4] = {0, 'v','d','e'};
-		gzwrite(gzf, &densId[0], sizeof(int) * 4); 
+		gzf.write(&densId[0], sizeof(int) * 4); 
 
 		// compute densities
 		vector<float> triDensity(numTris);
@@ -261,23 +263,23 @@ void writeBobjFile(const string& name, Mesh* mesh) {
 			float dens = 0;
 			if (triPerVertex[point]>0)
 				dens = density[point] / triPerVertex[point];
-			gzwrite(gzf, &dens, sizeof(float));             
+			gzf.write(&dens, sizeof(float));             
 		}
 	}
 
 	// vertex flags
 	if (mesh->getType() == Mesh::TypeVortexSheet) {
 		int Id[4] = {0, 'v','x','f'};
-		gzwrite(gzf, &Id[0], sizeof(int) * 4); 
+		gzf.write(&Id[0], sizeof(int) * 4); 
 
 		// averaged smoke densities
 		for(int point=0; point<numVerts; point++) {
 			float alpha = (mesh->nodes(point).flags & Mesh::NfMarked) ? 1: 0;
-			gzwrite(gzf, &alpha, sizeof(float));             
+			gzf.write(&alpha, sizeof(float));             
 		}
 	}
 
-	gzclose( gzf );    
+	gzf.close();    
 #	else
 	debMsg( "file format not supported without zlib" ,1);
 #	endif
@@ -386,6 +388,7 @@ void readMdataUni(const std::string& name, MeshDataImpl<T>* mdata ) {
 	debMsg( "reading mesh data " << mdata->getName() << " from uni file " << name ,1);
 
 #	if NO_ZLIB!=1
+	waitForFileWrite(name);
 	gzFile gzf = gzopen(name.c_str(), "rb");
 	if (!gzf) errMsg("can't open file " << name );
 
@@ -407,6 +410,7 @@ void readMdataUni(const std::string& name, MeshDataImpl<T>* mdata ) {
 		assertMsg(bytes==readBytes, "can't read uni file, stream length does not match, "<<bytes<<" vs "<<readBytes );
 #		endif
 	}
+	countBytesRead(gztell(gzf));
 	gzclose(gzf);
 #	else
 	debMsg( "file format not supported without zlib" ,1);
@@ -427,9 +431,9 @@ void writeMdataUni(const std::string& name, MeshDataImpl<T>* mdata ) {
 	MuTime stamp;
 	head.timestamp = stamp.time;
 
-	gzFile gzf = gzopen(name.c_str(), "wb1"); // do some compression
-	if (!gzf) errMsg("can't open file " << name);
-	gzwrite(gzf, ID, 4);
+	GzWriter gzf(name); // do some compression
+	if (!gzf.good()) errMsg("can't open file " << name);
+	gzf.write(ID, 4);
 
 #	if FLOATINGPOINT_PRECISION!=1
 	// always write float values, even if compiled with double precision (as for grids)
@@ -437,10 +441,10 @@ void writeMdataUni(const std::string& name, MeshDataImpl<T>* mdata ) {
 	temp.resize( mdata->size() );
 	mdataConvertWrite( gzf, *mdata, &(temp[0]), head);
 #	else
-	gzwrite(gzf, &head, sizeof(UniMeshHeader));
-	gzwrite(gzf, &(mdata->get(0)), sizeof(T)*head.dim);
+	gzf.write(&head, sizeof(UniMeshHeader));
+	gzf.write(&(mdata->get(0)), sizeof(T)*head.dim);
 #	endif
-	gzclose(gzf);
+	gzf.close();
 
 #	else
 	debMsg( "file format not supported without zlib" ,1);
@@ -63,34 +63,34 @@ typedef struct {
 #if NO_ZLIB!=1
 
 template <class T>
-void pdataConvertWrite( gzFile& gzf, ParticleDataImpl<T>& pdata, void* ptr, UniPartHeader& head) {
+void pdataConvertWrite( GzWriter& gzf, ParticleDataImpl<T>& pdata, void* ptr, UniPartHeader& head) {
 	errMsg("pdataConvertWrite: unknown type, not yet supported");
 }
 
 template <>
-void pdataConvertWrite( gzFile& gzf, ParticleDataImpl<int>& pdata, void* ptr, UniPartHeader& head) {
-	gzwrite(gzf, &head,     sizeof(UniPartHeader));
-	gzwrite(gzf, &pdata[0], sizeof(int)*head.dim);
+void pdataConvertWrite( GzWriter& gzf, ParticleDataImpl<int>& pdata, void* ptr, UniPartHeader& head) {
+	gzf.write(&head,     sizeof(UniPartHeader));
+	gzf.write(&pdata[0], sizeof(int)*head.dim);
 } 
 template <>
-void pdataConvertWrite( gzFile& gzf, ParticleDataImpl<double>& pdata, void* ptr, UniPartHeader& head) {
+void pdataConvertWrite( GzWriter& gzf, ParticleDataImpl<double>& pdata, void* ptr, UniPartHeader& head) {
 	head.bytesPerElement = sizeof(float);
-	gzwrite(gzf, &head, sizeof(UniPartHeader));
+	gzf.write(&head, sizeof(UniPartHeader));
 	float* ptrf = (float*)ptr;
 	for(int i=0; i<pdata.size(); ++i,++ptrf) {
 		*ptrf = (float)pdata[i];
 	} 
-	gzwrite(gzf, ptr, sizeof(float)* head.dim);
+	gzf.write(ptr, sizeof(float)* head.dim);
 } 
 template <>
-void pdataConvertWrite( gzFile& gzf, ParticleDataImpl<Vec3>& pdata, void* ptr, UniPartHeader& head) {
+void pdataConvertWrite( GzWriter& gzf, ParticleDataImpl<Vec3>& pdata, void* ptr, UniPartHeader& head) {
 	head.bytesPerElement = sizeof(Vector3D<float>);
-	gzwrite(gzf, &head, sizeof(UniPartHeader));
+	gzf.write(&head, sizeof(UniPartHeader));
 	float* ptrf = (float*)ptr;
 	for(int i=0; i<pdata.size(); ++i) {
 		for(int c=0; c<3; ++c) { *ptrf = (float)pdata[i][c]; ptrf++; }
 	} 
-	gzwrite(gzf, ptr, sizeof(Vector3D<float>) *head.dim);
+	gzf.write(ptr, sizeof(Vector3D<float>) *head.dim);
 }
 
 
@@ -156,25 +156,25 @@ void writeParticlesUni(const std::string& name, const BasicParticleSystem* parts
 	MuTime stamp;
 	head.timestamp = stamp.time;
 	
-	gzFile gzf = gzopen(name.c_str(), "wb1"); // do some compression
-	if (!gzf) errMsg("can't open file " << name);
+	GzWriter gzf(name); // do some compression
+	if (!gzf.good()) errMsg("can't open file " << name);
 	
-	gzwrite(gzf, ID, 4);
+	gzf.write(ID, 4);
 #	if FLOATINGPOINT_PRECISION!=1
 	// warning - hard coded conversion of byte size here...
-	gzwrite(gzf, &head, sizeof(UniPartHeader));
+	gzf.write(&head, sizeof(UniPartHeader));
 	for(int i=0; i<parts->size(); ++i) {
 		Vector3D<float> pos  = toVec3f( (*parts)[i].pos );
 		int             flag = (*parts)[i].flag;
-		gzwrite(gzf, &pos , sizeof(Vector3D<float>) );
-		gzwrite(gzf, &flag, sizeof(int)             );
+		gzf.write(&pos , sizeof(Vector3D<float>) );
+		gzf.write(&flag, sizeof(int)             );
 	}
 #	else
 	assertMsg( sizeof(BasicParticleData) == PartSysSize, "particle data size doesn't match" );
-	gzwrite(gzf, &head, sizeof(UniPartHeader));
-	gzwrite(gzf, &((*parts)[0]), PartSysSize*head.dim);
+	gzf.write(&head, sizeof(UniPartHeader));
+	gzf.write(&((*parts)[0]), PartSysSize*head.dim);
 #	endif
-	gzclose(gzf);
+	gzf.close();
 #	else
 	debMsg( "file format not supported without zlib" ,1);
 #	endif
@@ -184,6 +184,7 @@ void readParticlesUni(const std::string& name, BasicParticleSystem* parts ) {
 	debMsg( "reading particles " << parts->getName() << " from uni file " << name ,1);
 	
 #	if NO_ZLIB!=1
+	waitForFileWrite(name);
 	gzFile gzf = gzopen(name.c_str(), "rb");
 	if (!gzf) errMsg("can't open file " << name);
 
@@ -219,6 +220,7 @@ void readParticlesUni(const std::string& name, BasicParticleSystem* parts ) {
 
 		parts->transformPositions( Vec3i(head.dimX,head.dimY,head.dimZ), parts->getParent()->getGridSize() );
 	}
+	countBytesRead(gztell(gzf));
 	gzclose(gzf);
 #	else
 	debMsg( "file format not supported without zlib" ,1);
@@ -239,9 +241,9 @@ void writePdataUni(const std::string& name, ParticleDataImpl<T>* pdata ) {
 	MuTime stamp;
 	head.timestamp = stamp.time;
 	
-	gzFile gzf = gzopen(name.c_str(), "wb1"); // do some compression
-	if (!gzf) errMsg("can't open file " << name);
-	gzwrite(gzf, ID, 4);
+	GzWriter gzf(name); // do some compression
+	if (!gzf.good()) errMsg("can't open file " << name);
+	gzf.write(ID, 4);
 
 #	if FLOATINGPOINT_PRECISION!=1
 	// always write float values, even if compiled with double precision (as for grids)
@@ -249,10 +251,10 @@ void writePdataUni(const std::string& name, ParticleDataImpl<T>* pdata ) {
 	temp.resize( pdata->size() );
 	pdataConvertWrite( gzf, *pdata, &(temp[0]), head);
 #	else
-	gzwrite(gzf, &head, sizeof(UniPartHeader));
-	gzwrite(gzf, &(pdata->get(0)), sizeof(T)*head.dim);
+	gzf.write(&head, sizeof(UniPartHeader));
+	gzf.write(&(pdata->get(0)), sizeof(T)*head.dim);
 #	endif
-	gzclose(gzf);
+	gzf.close();
 
 #	else
 	debMsg( "file format not supported without zlib" ,1);
@@ -264,6 +266,7 @@ void readPdataUni(const std::string& name, ParticleDataImpl<T>* pdata ) {
 	debMsg( "reading particle data " << pdata->getName() << " from uni file " << name ,1);
 	
 #	if NO_ZLIB!=1
+	waitForFileWrite(name);
 	gzFile gzf = gzopen(name.c_str(), "rb");
 	if (!gzf) errMsg("can't open file " << name );
 
@@ -285,6 +288,7 @@ void readPdataUni(const std::string& name, ParticleDataImpl<T>* pdata ) {
 		assertMsg(bytes==readBytes, "can't read uni file, stream length does not match, "<<bytes<<" vs "<<readBytes );
 #		endif
 	}
+	countBytesRead(gztell(gzf));
 	gzclose(gzf);
 #	else
 	debMsg( "file format not supported without zlib" ,1);
@@ -46,10 +46,12 @@ template<class T>
 T* FluidSolver::GridStorage<T>::get(Vec3i size) {
 	if ((int)grids.size() <= used) {
 		debMsg("FluidSolver::GridStorage::get Allocating new "<<size.x<<","<<size.y<<","<<size.z<<" ",3); 
-		grids.push_back( new T[(long long)(size.x) * size.y * size.z] );
+		cells = (long long)(size.x) * size.y * size.z;
+		grids.push_back( new T[cells] );
 	}
 	if (used > 200)
 		errMsg("too many temp grids used -- are they released properly ?");
+	if (mem) mem->add(cells * sizeof(T));
 	return grids[used++];
 }
 template<class T>
@@ -59,6 +61,7 @@ void FluidSolver::GridStorage<T>::release(T* ptr) {
 	if (used < 0)
 		errMsg("temp grid inconsistency");
 	grids[used] = ptr;
+	if (mem) mem->add(-cells * (long long)sizeof(T));
 }
 
 template<> int* FluidSolver::getGridPointer<int>() {
@@ -70,6 +73,9 @@ template<> Real* FluidSolver::getGridPointer<Real>() {
 template<> Vec3* FluidSolver::getGridPointer<Vec3>() {
 	return mGridsVec.get(mGridSize);    
 }
+template<> Half* FluidSolver::getGridPointer<Half>() {
+	return mGridsHalf.get(mGridSize);    
+}
 template<> Vec4* FluidSolver::getGridPointer<Vec4>() {
 	return mGridsVec4.get(mGridSize);    
 }
@@ -82,6 +88,9 @@ template<> void FluidSolver::freeGridPointer<Real>(Real* ptr) {
 template<> void FluidSolver::freeGridPointer<Vec3>(Vec3* ptr) {
 	mGridsVec.release(ptr);
 }
+template<> void FluidSolver::freeGridPointer<Half>(Half* ptr) {
+	mGridsHalf.release(ptr);
+}
 template<> void FluidSolver::freeGridPointer<Vec4>(Vec4* ptr) {
 	mGridsVec4.release(ptr);
 }
@@ -116,11 +125,16 @@ template<> void FluidSolver::freeGrid4dPointer<Vec4>(Vec4* ptr) {
 //******************************************************************************
 // FluidSolver members
 
+static int sGridGeneration = 0;
+
 FluidSolver::FluidSolver(Vec3i gridsize, int dim, int fourthDim)
 	: PbClass(this), mDt(1.0), mTimeTotal(0.), mFrame(0), 
 	  mCflCond(1000), mDtMin(1.), mDtMax(1.), mFrameLength(1.),
-	  mGridSize(gridsize), mDim(dim) , mTimePerFrame(0.), mLockDt(false), mFourthDim(fourthDim)
+	  mGridSize(gridsize), mDim(dim) , mTimePerFrame(0.), mLockDt(false), mGridGeneration(++sGridGeneration),
+	  mTempGridPeak(0), mTempGridPeakMax(0), mFourthDim(fourthDim)
 {
+	mGridsInt.mem = mGridsReal.mem = mGridsVec.mem = mGridsHalf.mem = mGridsVec4.mem = &mGridMem;
+	mGrids4dInt.mem = mGrids4dReal.mem = mGrids4dVec.mem = mGrids4dVec4.mem = &mGridMem;
 	if(dim==4 && mFourthDim>0) errMsg("Don't create 4D solvers, use 3D with fourth-dim parameter >0 instead.");
 	assertMsg(dim==2 || dim==3, "Only 2D and 3D solvers allowed.");
 	assertMsg(dim!=2 || gridsize.z == 1, "Trying to create 2D solver with size.z != 1");
@@ -130,6 +144,7 @@ FluidSolver::~FluidSolver() {
 	mGridsInt.free();
 	mGridsReal.free();
 	mGridsVec.free();
+	mGridsHalf.free();
 	mGridsVec4.free();
 
 	mGrids4dInt.free();
@@ -145,18 +160,28 @@ PbClass* FluidSolver::create(PbType t, PbTypeVec T, const string& name) {
 		errMsg("Need to specify object type. Use e.g. Solver.create(FlagGrid, ...) or Solver.create(type=FlagGrid, ...)");
 	
 	PbClass* ret = PbClass::createPyObject(t.str() + T.str(), name, _args, this);
+	updateGridGeneration();
 #	else
 	PbClass* ret = NULL;
 #	endif
 	return ret;
 }
 
+void FluidSolver::updateGridGeneration() {
+	mGridGeneration = ++sGridGeneration;
+}
+
 void FluidSolver::step() {
 	// update simulation time with adaptive time stepping 
 	// (use eps value to prevent roundoff errors)
 	mTimePerFrame += mDt;
 	mTimeTotal    += mDt;
 
+	// grids still in use at the end of a step are the persistent ones, everything above was temporary
+	mTempGridPeak    = mGridMem.peak - mGridMem.used;
+	mTempGridPeakMax = std::max(mTempGridPeakMax, mTempGridPeak);
+	mGridMem.peak    = mGridMem.used;
+
 	if( (mTimePerFrame+VECTOR_EPSILON) >mFrameLength) {
 		mFrame++;
 
@@ -174,12 +199,16 @@ void FluidSolver::printMemInfo() {
 	msg << "Allocated grids: int " << mGridsInt.used  <<"/"<< mGridsInt.grids.size()  <<", ";
 	msg << "                 real "<< mGridsReal.used <<"/"<< mGridsReal.grids.size() <<", ";
 	msg << "                 vec3 "<< mGridsVec.used  <<"/"<< mGridsVec.grids.size()  <<". ";
+	msg << "                 half "<< mGridsHalf.used <<"/"<< mGridsHalf.grids.size() <<". ";
 	msg << "                 vec4 "<< mGridsVec4.used <<"/"<< mGridsVec4.grids.size() <<". ";
 	if( supports4D() ) {
 	msg << "Allocated 4d grids: int " << mGrids4dInt.used  <<"/"<< mGrids4dInt.grids.size()  <<", ";
 	msg << "                    real "<< mGrids4dReal.used <<"/"<< mGrids4dReal.grids.size() <<", ";
 	msg << "                    vec3 "<< mGrids4dVec.used  <<"/"<< mGrids4dVec.grids.size()  <<". ";
 	msg << "                    vec4 "<< mGrids4dVec4.used <<"/"<< mGrids4dVec4.grids.size() <<". "; }
+	const double mb = 1. / (1024. * 1024.);
+	msg << "Grid memory: " << mGridMem.used * mb << " MB in use, temporary grids " << mTempGridPeak * mb
+		<< " MB peak in last step, " << mTempGridPeakMax * mb << " MB max. ";
 	printf("%s\n", msg.str().c_str() );
 }
 
@@ -30,6 +30,7 @@
 #include <limits>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
 
 using namespace std;
 namespace Manta {
@@ -52,6 +53,7 @@ template<class T> inline GridBase::GridType typeList() { return GridBase::TypeNo
 template<> inline GridBase::GridType typeList<Real>()  { return GridBase::TypeReal; }
 template<> inline GridBase::GridType typeList<int>()   { return GridBase::TypeInt;  }
 template<> inline GridBase::GridType typeList<Vec3>()  { return GridBase::TypeVec3; }
+template<> inline GridBase::GridType typeList<Half>()  { return GridBase::TypeHalf; }
 
 template<class T>
 Grid<T>::Grid(FluidSolver* parent, bool show)
@@ -97,6 +99,8 @@ Grid<T>::~Grid() {
     if(!externalData)  {
         mParent->freeGridPointer<T>(mData);
     }
+	// grids of python objects can be cached by the caller, temporary grids are not
+	if (getPyObject()) mParent->updateGridGeneration();
 }
 
 template<class T>
@@ -104,6 +108,11 @@ void Grid<T>::clear() {
 	memset(mData, 0, sizeof(T) * mSize.x * mSize.y * mSize.z);    
 }
 
+template<>
+void Grid<Half>::clear() {
+	std::fill(mData, mData + mSize.x * mSize.y * mSize.z, Half());
+}
+
 template<class T>
 void Grid<T>::swap(Grid<T>& other) {
 	if (other.getSizeX() != getSizeX() || other.getSizeY() != getSizeY() || other.getSizeZ() != getSizeZ())
@@ -173,7 +182,7 @@ void Grid<T>::save(string name) {
   for (IndexInt i = 0; i < _sz; i++) op(i,val,minVal); 
 #pragma omp critical
 {this->minVal = min(minVal, this->minVal); } }   } const Grid<Real>& val;  Real minVal;  };
-#line 154 "grid.cpp"
+#line 161 "grid.cpp"
 
 
 
@@ -189,7 +198,7 @@ void Grid<T>::save(string name) {
   for (IndexInt i = 0; i < _sz; i++) op(i,val,maxVal); 
 #pragma omp critical
 {this->maxVal = max(maxVal, this->maxVal); } }   } const Grid<Real>& val;  Real maxVal;  };
-#line 161 "grid.cpp"
+#line 168 "grid.cpp"
 
 
 
@@ -205,7 +214,7 @@ void Grid<T>::save(string name) {
   for (IndexInt i = 0; i < _sz; i++) op(i,val,minVal); 
 #pragma omp critical
 {this->minVal = min(minVal, this->minVal); } }   } const Grid<int>& val;  int minVal;  };
-#line 168 "grid.cpp"
+#line 175 "grid.cpp"
 
 
 
@@ -221,7 +230,7 @@ void Grid<T>::save(string name) {
   for (IndexInt i = 0; i < _sz; i++) op(i,val,maxVal); 
 #pragma omp critical
 {this->maxVal = max(maxVal, this->maxVal); } }   } const Grid<int>& val;  int maxVal;  };
-#line 175 "grid.cpp"
+#line 182 "grid.cpp"
 
 
 
@@ -238,7 +247,7 @@ void Grid<T>::save(string name) {
   for (IndexInt i = 0; i < _sz; i++) op(i,val,minVal); 
 #pragma omp critical
 {this->minVal = min(minVal, this->minVal); } }   } const Grid<Vec3>& val;  Real minVal;  };
-#line 182 "grid.cpp"
+#line 189 "grid.cpp"
 
 
 
@@ -255,7 +264,39 @@ void Grid<T>::save(string name) {
   for (IndexInt i = 0; i < _sz; i++) op(i,val,maxVal); 
 #pragma omp critical
 {this->maxVal = max(maxVal, this->maxVal); } }   } const Grid<Vec3>& val;  Real maxVal;  };
-#line 190 "grid.cpp"
+#line 197 "grid.cpp"
+
+
+
+//! Kernel: Compute min value of Half grid
+
+ struct CompMinHalf : public KernelBase { CompMinHalf(const Grid<Half>& val) :  KernelBase(&val,0) ,val(val) ,minVal(std::numeric_limits<Real>::max())  { runMessage(); run(); }   inline void op(IndexInt idx, const Grid<Half>& val ,Real& minVal)  {
+	if (val[idx] < minVal)
+		minVal = val[idx];
+}    inline operator Real () { return minVal; } inline Real  & getRet() { return minVal; }  inline const Grid<Half>& getArg0() { return val; } typedef Grid<Half> type0; void runMessage() { debMsg("Executing kernel CompMinHalf ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  Real minVal = std::numeric_limits<Real>::max(); 
+#pragma omp for nowait  
+  for (IndexInt i = 0; i < _sz; i++) op(i,val,minVal); 
+#pragma omp critical
+{this->minVal = min(minVal, this->minVal); } }   } const Grid<Half>& val;  Real minVal;  };
+#line 204 "grid.cpp"
+
+
+
+//! Kernel: Compute max value of Half grid
+
+ struct CompMaxHalf : public KernelBase { CompMaxHalf(const Grid<Half>& val) :  KernelBase(&val,0) ,val(val) ,maxVal(-std::numeric_limits<Real>::max())  { runMessage(); run(); }   inline void op(IndexInt idx, const Grid<Half>& val ,Real& maxVal)  {
+	if (val[idx] > maxVal)
+		maxVal = val[idx];
+}    inline operator Real () { return maxVal; } inline Real  & getRet() { return maxVal; }  inline const Grid<Half>& getArg0() { return val; } typedef Grid<Half> type0; void runMessage() { debMsg("Executing kernel CompMaxHalf ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  Real maxVal = -std::numeric_limits<Real>::max(); 
+#pragma omp for nowait  
+  for (IndexInt i = 0; i < _sz; i++) op(i,val,maxVal); 
+#pragma omp critical
+{this->maxVal = max(maxVal, this->maxVal); } }   } const Grid<Half>& val;  Real maxVal;  };
+#line 211 "grid.cpp"
 
 
 
@@ -274,7 +315,7 @@ template <class T>  struct knGridSetConstReal : public KernelBase { knGridSetCon
  {  
 #pragma omp for  
   for (IndexInt i = 0; i < _sz; i++) op(i,me,val);  }   } Grid<T>& me; T val;   };
-#line 206 "grid.cpp"
+#line 227 "grid.cpp"
 
 
 template <class T>  struct knGridAddConstReal : public KernelBase { knGridAddConstReal(Grid<T>& me, T val) :  KernelBase(&me,0) ,me(me),val(val)   { runMessage(); run(); }   inline void op(IndexInt idx, Grid<T>& me, T val )  { me[idx] += val; }    inline Grid<T>& getArg0() { return me; } typedef Grid<T> type0;inline T& getArg1() { return val; } typedef T type1; void runMessage() { debMsg("Executing kernel knGridAddConstReal ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
@@ -282,7 +323,7 @@ template <class T>  struct knGridAddConstReal : public KernelBase { knGridAddCon
  {  
 #pragma omp for  
   for (IndexInt i = 0; i < _sz; i++) op(i,me,val);  }   } Grid<T>& me; T val;   };
-#line 207 "grid.cpp"
+#line 228 "grid.cpp"
 
 
 template <class T>  struct knGridMultConst : public KernelBase { knGridMultConst(Grid<T>& me, T val) :  KernelBase(&me,0) ,me(me),val(val)   { runMessage(); run(); }   inline void op(IndexInt idx, Grid<T>& me, T val )  { me[idx] *= val; }    inline Grid<T>& getArg0() { return me; } typedef Grid<T> type0;inline T& getArg1() { return val; } typedef T type1; void runMessage() { debMsg("Executing kernel knGridMultConst ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
@@ -290,7 +331,7 @@ template <class T>  struct knGridMultConst : public KernelBase { knGridMultConst
  {  
 #pragma omp for  
   for (IndexInt i = 0; i < _sz; i++) op(i,me,val);  }   } Grid<T>& me; T val;   };
-#line 208 "grid.cpp"
+#line 229 "grid.cpp"
 
 
 
@@ -299,7 +340,7 @@ template <class T>  struct knGridSafeDiv : public KernelBase { knGridSafeDiv(Gri
  {  
 #pragma omp for  
   for (IndexInt i = 0; i < _sz; i++) op(i,me,other);  }   } Grid<T>& me; const Grid<T>& other;   };
-#line 210 "grid.cpp"
+#line 231 "grid.cpp"
 
 
 //KERNEL(idx) template<class T> void gridSafeDiv (Grid<T>& me, const Grid<T>& other) { me[idx] = safeDivide(me[idx], other[idx]); }
@@ -309,7 +350,7 @@ template <class T>  struct knGridClamp : public KernelBase { knGridClamp(Grid<T>
  {  
 #pragma omp for  
   for (IndexInt i = 0; i < _sz; i++) op(i,me,min,max);  }   } Grid<T>& me; const T& min; const T& max;   };
-#line 213 "grid.cpp"
+#line 234 "grid.cpp"
 
 
 
@@ -320,7 +361,7 @@ template <class T>  struct knGridStomp : public KernelBase { knGridStomp(Grid<T>
  {  
 #pragma omp for  
   for (IndexInt i = 0; i < _sz; i++) op(i,me,threshold);  }   } Grid<T>& me; const T& threshold;   };
-#line 217 "grid.cpp"
+#line 238 "grid.cpp"
 
 
 
@@ -390,6 +431,17 @@ template<> Real Grid<int>::getMaxAbs() const {
 	int amax = CompMaxInt (*this);
 	return max( fabs((Real)amin), fabs((Real)amax));
 }
+template<> Real Grid<Half>::getMax() const {
+	return CompMaxHalf (*this);
+}
+template<> Real Grid<Half>::getMin() const {
+	return CompMinHalf (*this);
+}
+template<> Real Grid<Half>::getMaxAbs() const {
+	Real amin = CompMinHalf (*this);
+	Real amax = CompMaxHalf (*this);
+	return max( fabs(amin), fabs(amax));
+}
 template<class T> std::string Grid<T>::getDataPointer() {
 	std::ostringstream out;
 	out << mData ;
@@ -450,7 +502,7 @@ template<class T> Real Grid<T>::getL2(int bnd) {
   for (int j=0; j < _maxY; j++) for (int i=0; i < _maxX; i++) op(i,j,k,flags,flag,bnd,mask,cnt); 
 #pragma omp critical
 {this->cnt += cnt; } } }  } const FlagGrid& flags; int flag; int bnd; Grid<Real>* mask;  int cnt;  };
-#line 325 "grid.cpp"
+#line 357 "grid.cpp"
 
 
 
@@ -543,7 +595,45 @@ void copyRealToVec3(Grid<Real> &sourceX, Grid<Real> &sourceY, Grid<Real> &source
 		target(i,j,k).z = sourceZ(i,j,k);
 	}
 } static PyObject* _W_9 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "copyRealToVec3" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Real> & sourceX = *_args.getPtr<Grid<Real>  >("sourceX",0,&_lock); Grid<Real> & sourceY = *_args.getPtr<Grid<Real>  >("sourceY",1,&_lock); Grid<Real> & sourceZ = *_args.getPtr<Grid<Real>  >("sourceZ",2,&_lock); Grid<Vec3> & target = *_args.getPtr<Grid<Vec3>  >("target",3,&_lock);   _retval = getPyNone(); copyRealToVec3(sourceX,sourceY,sourceZ,target);  _args.check(); } pbFinalizePlugin(parent,"copyRealToVec3", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("copyRealToVec3",e.what()); return 0; } } static const Pb::Register _RP_copyRealToVec3 ("","copyRealToVec3",_W_9);  extern "C" { void PbRegister_copyRealToVec3() { KEEP_UNUSED(_RP_copyRealToVec3); } } 
-void convertLevelsetToReal(LevelsetGrid &source , Grid<Real> &target) { debMsg("Deprecated - do not use convertLevelsetToReal... use copyLevelsetToReal instead",1); copyLevelsetToReal(source,target); } static PyObject* _W_10 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "convertLevelsetToReal" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; LevelsetGrid& source = *_args.getPtr<LevelsetGrid >("source",0,&_lock); Grid<Real> & target = *_args.getPtr<Grid<Real>  >("target",1,&_lock);   _retval = getPyNone(); convertLevelsetToReal(source,target);  _args.check(); } pbFinalizePlugin(parent,"convertLevelsetToReal", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("convertLevelsetToReal",e.what()); return 0; } } static const Pb::Register _RP_convertLevelsetToReal ("","convertLevelsetToReal",_W_10);  extern "C" { void PbRegister_convertLevelsetToReal() { KEEP_UNUSED(_RP_convertLevelsetToReal); } } 
+
+//! convert real grids to half precision storage and back
+
+ struct knCopyRealToHalf : public KernelBase { knCopyRealToHalf(const Grid<Real>& source, Grid<Half>& target) :  KernelBase(&source,0) ,source(source),target(target)  { runMessage(); run(); }   inline void op(IndexInt idx, const Grid<Real>& source, Grid<Half>& target )  {
+	target[idx] = source[idx];
+}    inline const Grid<Real>& getArg0() { return source; } typedef Grid<Real> type0;inline Grid<Half>& getArg1() { return target; } typedef Grid<Half> type1; void runMessage() { debMsg("Executing kernel knCopyRealToHalf ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,source,target);  }   } const Grid<Real>& source; Grid<Half>& target;  };
+#line 453 "grid.cpp"
+
+
+void copyRealToHalf(const Grid<Real>& source, Grid<Half>& target) { knCopyRealToHalf(source, target); } static PyObject* _W_10 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "copyRealToHalf" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const Grid<Real>& source = *_args.getPtr<Grid<Real> >("source",0,&_lock); Grid<Half>& target = *_args.getPtr<Grid<Half> >("target",1,&_lock);   _retval = getPyNone(); copyRealToHalf(source,target);  _args.check(); } pbFinalizePlugin(parent,"copyRealToHalf", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("copyRealToHalf",e.what()); return 0; } } static const Pb::Register _RP_copyRealToHalf ("","copyRealToHalf",_W_10);  extern "C" { void PbRegister_copyRealToHalf() { KEEP_UNUSED(_RP_copyRealToHalf); } } 
+
+ struct knCopyHalfToReal : public KernelBase { knCopyHalfToReal(const Grid<Half>& source, Grid<Real>& target) :  KernelBase(&source,0) ,source(source),target(target)  { runMessage(); run(); }   inline void op(IndexInt idx, const Grid<Half>& source, Grid<Real>& target )  {
+	target[idx] = source[idx];
+}    inline const Grid<Half>& getArg0() { return source; } typedef Grid<Half> type0;inline Grid<Real>& getArg1() { return target; } typedef Grid<Real> type1; void runMessage() { debMsg("Executing kernel knCopyHalfToReal ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,source,target);  }   } const Grid<Half>& source; Grid<Real>& target;  };
+#line 458 "grid.cpp"
+
+
+void copyHalfToReal(const Grid<Half>& source, Grid<Real>& target) { knCopyHalfToReal(source, target); } static PyObject* _W_11 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "copyHalfToReal" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const Grid<Half>& source = *_args.getPtr<Grid<Half> >("source",0,&_lock); Grid<Real>& target = *_args.getPtr<Grid<Real> >("target",1,&_lock);   _retval = getPyNone(); copyHalfToReal(source,target);  _args.check(); } pbFinalizePlugin(parent,"copyHalfToReal", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("copyHalfToReal",e.what()); return 0; } } static const Pb::Register _RP_copyHalfToReal ("","copyHalfToReal",_W_11);  extern "C" { void PbRegister_copyHalfToReal() { KEEP_UNUSED(_RP_copyHalfToReal); } } 
+
+//! half grids are written to / read from files as real grids
+template<> void Grid<Half>::save(string name) {
+	Grid<Real> tmp(mParent);
+	copyHalfToReal(*this, tmp);
+	tmp.save(name);
+}
+template<> void Grid<Half>::load(string name) {
+	Grid<Real> tmp(mParent);
+	tmp.load(name);
+	copyRealToHalf(tmp, *this);
+}
+void convertLevelsetToReal(LevelsetGrid &source , Grid<Real> &target) { debMsg("Deprecated - do not use convertLevelsetToReal... use copyLevelsetToReal instead",1); copyLevelsetToReal(source,target); } static PyObject* _W_12 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "convertLevelsetToReal" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; LevelsetGrid& source = *_args.getPtr<LevelsetGrid >("source",0,&_lock); Grid<Real> & target = *_args.getPtr<Grid<Real>  >("target",1,&_lock);   _retval = getPyNone(); convertLevelsetToReal(source,target);  _args.check(); } pbFinalizePlugin(parent,"convertLevelsetToReal", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("convertLevelsetToReal",e.what()); return 0; } } static const Pb::Register _RP_convertLevelsetToReal ("","convertLevelsetToReal",_W_12);  extern "C" { void PbRegister_convertLevelsetToReal() { KEEP_UNUSED(_RP_convertLevelsetToReal); } } 
 
 template<class T> void Grid<T>::printGrid(int zSlice, bool printIndex, int bnd) {
 	std::ostringstream out;
@@ -569,12 +659,12 @@ void swapComponents(Grid<Vec3>& vel, int c1=0, int c2=1, int c3=2) {
 		vel(i,j,k)[1] = v[c2];
 		vel(i,j,k)[2] = v[c3];
 	}
-} static PyObject* _W_11 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "swapComponents" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Vec3>& vel = *_args.getPtr<Grid<Vec3> >("vel",0,&_lock); int c1 = _args.getOpt<int >("c1",1,0,&_lock); int c2 = _args.getOpt<int >("c2",2,1,&_lock); int c3 = _args.getOpt<int >("c3",3,2,&_lock);   _retval = getPyNone(); swapComponents(vel,c1,c2,c3);  _args.check(); } pbFinalizePlugin(parent,"swapComponents", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("swapComponents",e.what()); return 0; } } static const Pb::Register _RP_swapComponents ("","swapComponents",_W_11);  extern "C" { void PbRegister_swapComponents() { KEEP_UNUSED(_RP_swapComponents); } } 
+} static PyObject* _W_13 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "swapComponents" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Vec3>& vel = *_args.getPtr<Grid<Vec3> >("vel",0,&_lock); int c1 = _args.getOpt<int >("c1",1,0,&_lock); int c2 = _args.getOpt<int >("c2",2,1,&_lock); int c3 = _args.getOpt<int >("c3",3,2,&_lock);   _retval = getPyNone(); swapComponents(vel,c1,c2,c3);  _args.check(); } pbFinalizePlugin(parent,"swapComponents", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("swapComponents",e.what()); return 0; } } static const Pb::Register _RP_swapComponents ("","swapComponents",_W_13);  extern "C" { void PbRegister_swapComponents() { KEEP_UNUSED(_RP_swapComponents); } } 
 
 // helper functions for UV grid data (stored grid coordinates as Vec3 values, and uv weight in entry zero)
 
 // make uv weight accesible in python
-Real getUvWeight(Grid<Vec3> &uv) { return uv[0][0]; } static PyObject* _W_12 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "getUvWeight" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Vec3> & uv = *_args.getPtr<Grid<Vec3>  >("uv",0,&_lock);   _retval = toPy(getUvWeight(uv));  _args.check(); } pbFinalizePlugin(parent,"getUvWeight", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("getUvWeight",e.what()); return 0; } } static const Pb::Register _RP_getUvWeight ("","getUvWeight",_W_12);  extern "C" { void PbRegister_getUvWeight() { KEEP_UNUSED(_RP_getUvWeight); } } 
+Real getUvWeight(Grid<Vec3> &uv) { return uv[0][0]; } static PyObject* _W_14 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "getUvWeight" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Vec3> & uv = *_args.getPtr<Grid<Vec3>  >("uv",0,&_lock);   _retval = toPy(getUvWeight(uv));  _args.check(); } pbFinalizePlugin(parent,"getUvWeight", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("getUvWeight",e.what()); return 0; } } static const Pb::Register _RP_getUvWeight ("","getUvWeight",_W_14);  extern "C" { void PbRegister_getUvWeight() { KEEP_UNUSED(_RP_getUvWeight); } } 
 
 // note - right now the UV grids have 0 values at the border after advection... could be fixed with an extrapolation step...
 
@@ -598,14 +688,14 @@ static inline Real computeUvRamp(Real t) {
  {  
 #pragma omp for  
   for (int j=0; j < _maxY; j++) for (int i=0; i < _maxX; i++) op(i,j,k,target);  } }  } Grid<Vec3>& target;   };
-#line 469 "grid.cpp"
+#line 525 "grid.cpp"
 
 
 
 
 void resetUvGrid(Grid<Vec3> &target) {
 	knResetUvGrid reset(target); // note, llvm complains about anonymous declaration here... ?
-} static PyObject* _W_13 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "resetUvGrid" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Vec3> & target = *_args.getPtr<Grid<Vec3>  >("target",0,&_lock);   _retval = getPyNone(); resetUvGrid(target);  _args.check(); } pbFinalizePlugin(parent,"resetUvGrid", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("resetUvGrid",e.what()); return 0; } } static const Pb::Register _RP_resetUvGrid ("","resetUvGrid",_W_13);  extern "C" { void PbRegister_resetUvGrid() { KEEP_UNUSED(_RP_resetUvGrid); } } 
+} static PyObject* _W_15 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "resetUvGrid" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Vec3> & target = *_args.getPtr<Grid<Vec3>  >("target",0,&_lock);   _retval = getPyNone(); resetUvGrid(target);  _args.check(); } pbFinalizePlugin(parent,"resetUvGrid", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("resetUvGrid",e.what()); return 0; } } static const Pb::Register _RP_resetUvGrid ("","resetUvGrid",_W_15);  extern "C" { void PbRegister_resetUvGrid() { KEEP_UNUSED(_RP_resetUvGrid); } } 
 
 void updateUvWeight(Real resetTime, int index, int numUvs, Grid<Vec3> &uv) {
 	const Real t   = uv.getParent()->getTime();
@@ -632,7 +722,7 @@ void updateUvWeight(Real resetTime, int index, int numUvs, Grid<Vec3> &uv) {
 
 	// print info about uv weights?
 	debMsg("Uv grid "<<index<<"/"<<numUvs<< " t="<<currt<<" w="<<uvWeight<<", reset:"<<(int)(currt<lastt) , 2);
-} static PyObject* _W_14 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "updateUvWeight" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Real resetTime = _args.get<Real >("resetTime",0,&_lock); int index = _args.get<int >("index",1,&_lock); int numUvs = _args.get<int >("numUvs",2,&_lock); Grid<Vec3> & uv = *_args.getPtr<Grid<Vec3>  >("uv",3,&_lock);   _retval = getPyNone(); updateUvWeight(resetTime,index,numUvs,uv);  _args.check(); } pbFinalizePlugin(parent,"updateUvWeight", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("updateUvWeight",e.what()); return 0; } } static const Pb::Register _RP_updateUvWeight ("","updateUvWeight",_W_14);  extern "C" { void PbRegister_updateUvWeight() { KEEP_UNUSED(_RP_updateUvWeight); } } 
+} static PyObject* _W_16 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "updateUvWeight" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Real resetTime = _args.get<Real >("resetTime",0,&_lock); int index = _args.get<int >("index",1,&_lock); int numUvs = _args.get<int >("numUvs",2,&_lock); Grid<Vec3> & uv = *_args.getPtr<Grid<Vec3>  >("uv",3,&_lock);   _retval = getPyNone(); updateUvWeight(resetTime,index,numUvs,uv);  _args.check(); } pbFinalizePlugin(parent,"updateUvWeight", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("updateUvWeight",e.what()); return 0; } } static const Pb::Register _RP_updateUvWeight ("","updateUvWeight",_W_16);  extern "C" { void PbRegister_updateUvWeight() { KEEP_UNUSED(_RP_updateUvWeight); } } 
 
 template <class T>  struct knSetBoundary : public KernelBase { knSetBoundary(Grid<T>& grid, T value, int w) :  KernelBase(&grid,0) ,grid(grid),value(value),w(w)   { runMessage(); run(); }  inline void op(int i, int j, int k, Grid<T>& grid, T value, int w )  { 
 	bool bnd = (i<=w || i>=grid.getSizeX()-1-w || j<=w || j>=grid.getSizeY()-1-w || (grid.is3D() && (k<=w || k>=grid.getSizeZ()-1-w)));
@@ -647,7 +737,7 @@ template <class T>  struct knSetBoundary : public KernelBase { knSetBoundary(Gri
  {  
 #pragma omp for  
   for (int j=0; j < _maxY; j++) for (int i=0; i < _maxX; i++) op(i,j,k,grid,value,w);  } }  } Grid<T>& grid; T value; int w;   };
-#line 503 "grid.cpp"
+#line 559 "grid.cpp"
 
 
 
@@ -690,7 +780,7 @@ template <class T>  struct knSetBoundaryNeumann : public KernelBase { knSetBound
  {  
 #pragma omp for  
   for (int j=0; j < _maxY; j++) for (int i=0; i < _maxX; i++) op(i,j,k,grid,w);  } }  } Grid<T>& grid; int w;   };
-#line 514 "grid.cpp"
+#line 570 "grid.cpp"
 
 
 
@@ -715,7 +805,7 @@ template<class T> void Grid<T>::setBoundNeumann(int boundaryWidth) {
  {  
 #pragma omp for  
   for (int j=0; j < _maxY; j++) for (int i=0; i < _maxX; i++) op(i,j,k,grid,value,w);  } }  } Grid<Vec3>& grid; Vec3 value; int w;   };
-#line 546 "grid.cpp"
+#line 602 "grid.cpp"
 
  
 
@@ -733,7 +823,7 @@ template<class T> void Grid<T>::setBoundNeumann(int boundaryWidth) {
  {  
 #pragma omp for  
   for (int j=0; j < _maxY; j++) for (int i=0; i < _maxX; i++) op(i,j,k,grid,value,w);  } }  } Grid<Vec3>& grid; Vec3 value; int w;   };
-#line 556 "grid.cpp"
+#line 612 "grid.cpp"
 
  
 
@@ -756,7 +846,7 @@ void MACGrid::setBoundMAC(Vec3 value, int boundaryWidth, bool normalOnly) {
   for (IndexInt i = 0; i < _sz; i++) op(i,a,flags,result); 
 #pragma omp critical
 {this->result += result; } }   } const Grid<Real>& a; FlagGrid* flags;  double result;  };
-#line 571 "grid.cpp"
+#line 627 "grid.cpp"
 
 
 
@@ -768,7 +858,7 @@ void MACGrid::setBoundMAC(Vec3 value, int boundaryWidth, bool normalOnly) {
   for (IndexInt i = 0; i < _sz; i++) op(i,flags,numEmpty); 
 #pragma omp critical
 {this->numEmpty += numEmpty; } }   } FlagGrid& flags;  int numEmpty;  };
-#line 577 "grid.cpp"
+#line 633 "grid.cpp"
 
 
 
@@ -784,7 +874,7 @@ Real getGridAvg(Grid<Real>& source, FlagGrid* flags=NULL) {
 	if(cells>0.) sum *= 1./cells;
 	else         sum = -1.;
 	return sum;
-} static PyObject* _W_15 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "getGridAvg" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Real>& source = *_args.getPtr<Grid<Real> >("source",0,&_lock); FlagGrid* flags = _args.getPtrOpt<FlagGrid >("flags",1,NULL,&_lock);   _retval = toPy(getGridAvg(source,flags));  _args.check(); } pbFinalizePlugin(parent,"getGridAvg", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("getGridAvg",e.what()); return 0; } } static const Pb::Register _RP_getGridAvg ("","getGridAvg",_W_15);  extern "C" { void PbRegister_getGridAvg() { KEEP_UNUSED(_RP_getGridAvg); } } 
+} static PyObject* _W_17 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "getGridAvg" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Real>& source = *_args.getPtr<Grid<Real> >("source",0,&_lock); FlagGrid* flags = _args.getPtrOpt<FlagGrid >("flags",1,NULL,&_lock);   _retval = toPy(getGridAvg(source,flags));  _args.check(); } pbFinalizePlugin(parent,"getGridAvg", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("getGridAvg",e.what()); return 0; } } static const Pb::Register _RP_getGridAvg ("","getGridAvg",_W_17);  extern "C" { void PbRegister_getGridAvg() { KEEP_UNUSED(_RP_getGridAvg); } } 
 
 //! transfer data between real and vec3 grids
 
@@ -795,10 +885,10 @@ Real getGridAvg(Grid<Real>& source, FlagGrid* flags=NULL) {
  {  
 #pragma omp for  
   for (IndexInt i = 0; i < _sz; i++) op(i,source,target,component);  }   } const Grid<Vec3>& source; Grid<Real>& target; int component;   };
-#line 595 "grid.cpp"
+#line 651 "grid.cpp"
 
 
-void getComponent(const Grid<Vec3>& source, Grid<Real>& target, int component) { knGetComponent(source, target, component); } static PyObject* _W_16 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "getComponent" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const Grid<Vec3>& source = *_args.getPtr<Grid<Vec3> >("source",0,&_lock); Grid<Real>& target = *_args.getPtr<Grid<Real> >("target",1,&_lock); int component = _args.get<int >("component",2,&_lock);   _retval = getPyNone(); getComponent(source,target,component);  _args.check(); } pbFinalizePlugin(parent,"getComponent", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("getComponent",e.what()); return 0; } } static const Pb::Register _RP_getComponent ("","getComponent",_W_16);  extern "C" { void PbRegister_getComponent() { KEEP_UNUSED(_RP_getComponent); } } 
+void getComponent(const Grid<Vec3>& source, Grid<Real>& target, int component) { knGetComponent(source, target, component); } static PyObject* _W_18 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "getComponent" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const Grid<Vec3>& source = *_args.getPtr<Grid<Vec3> >("source",0,&_lock); Grid<Real>& target = *_args.getPtr<Grid<Real> >("target",1,&_lock); int component = _args.get<int >("component",2,&_lock);   _retval = getPyNone(); getComponent(source,target,component);  _args.check(); } pbFinalizePlugin(parent,"getComponent", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("getComponent",e.what()); return 0; } } static const Pb::Register _RP_getComponent ("","getComponent",_W_18);  extern "C" { void PbRegister_getComponent() { KEEP_UNUSED(_RP_getComponent); } } 
 
  struct knSetComponent : public KernelBase { knSetComponent(const Grid<Real>& source, Grid<Vec3>& target, int component) :  KernelBase(&source,0) ,source(source),target(target),component(component)   { runMessage(); run(); }   inline void op(IndexInt idx, const Grid<Real>& source, Grid<Vec3>& target, int component )  { 
 	target[idx][component] = source[idx]; 
@@ -807,10 +897,10 @@ void getComponent(const Grid<Vec3>& source, Grid<Real>& target, int component) {
  {  
 #pragma omp for  
   for (IndexInt i = 0; i < _sz; i++) op(i,source,target,component);  }   } const Grid<Real>& source; Grid<Vec3>& target; int component;   };
-#line 600 "grid.cpp"
+#line 656 "grid.cpp"
 
 
-void setComponent(const Grid<Real>& source, Grid<Vec3>& target, int component) { knSetComponent(source, target, component); } static PyObject* _W_17 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "setComponent" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const Grid<Real>& source = *_args.getPtr<Grid<Real> >("source",0,&_lock); Grid<Vec3>& target = *_args.getPtr<Grid<Vec3> >("target",1,&_lock); int component = _args.get<int >("component",2,&_lock);   _retval = getPyNone(); setComponent(source,target,component);  _args.check(); } pbFinalizePlugin(parent,"setComponent", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("setComponent",e.what()); return 0; } } static const Pb::Register _RP_setComponent ("","setComponent",_W_17);  extern "C" { void PbRegister_setComponent() { KEEP_UNUSED(_RP_setComponent); } } 
+void setComponent(const Grid<Real>& source, Grid<Vec3>& target, int component) { knSetComponent(source, target, component); } static PyObject* _W_19 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "setComponent" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const Grid<Real>& source = *_args.getPtr<Grid<Real> >("source",0,&_lock); Grid<Vec3>& target = *_args.getPtr<Grid<Vec3> >("target",1,&_lock); int component = _args.get<int >("component",2,&_lock);   _retval = getPyNone(); setComponent(source,target,component);  _args.check(); } pbFinalizePlugin(parent,"setComponent", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("setComponent",e.what()); return 0; } } static const Pb::Register _RP_setComponent ("","setComponent",_W_19);  extern "C" { void PbRegister_setComponent() { KEEP_UNUSED(_RP_setComponent); } } 
 
 //******************************************************************************
 // Specialization classes
@@ -996,6 +1086,7 @@ void FlagGrid::fillGrid(int type) {
 template class Grid<int>;
 template class Grid<Real>;
 template class Grid<Vec3>;
+template class Grid<Half>;
 
 } //namespace
 
@@ -12,103 +12,127 @@
 #include "grid.h"
 namespace Manta {
 #ifdef _C_FlagGrid
- static const Pb::Register _R_10 ("FlagGrid","FlagGrid","Grid<int>"); template<> const char* Namify<FlagGrid >::S = "FlagGrid"; 
- static const Pb::Register _R_11 ("FlagGrid","FlagGrid",FlagGrid::_W_26); 
- static const Pb::Register _R_12 ("FlagGrid","initDomain",FlagGrid::_W_27); 
- static const Pb::Register _R_13 ("FlagGrid","updateFromLevelset",FlagGrid::_W_28); 
- static const Pb::Register _R_14 ("FlagGrid","fillGrid",FlagGrid::_W_29); 
- static const Pb::Register _R_15 ("FlagGrid","countCells",FlagGrid::_W_30); 
+ static const Pb::Register _R_11 ("FlagGrid","FlagGrid","Grid<int>"); template<> const char* Namify<FlagGrid >::S = "FlagGrid"; 
+ static const Pb::Register _R_12 ("FlagGrid","FlagGrid",FlagGrid::_W_26); 
+ static const Pb::Register _R_13 ("FlagGrid","initDomain",FlagGrid::_W_27); 
+ static const Pb::Register _R_14 ("FlagGrid","updateFromLevelset",FlagGrid::_W_28); 
+ static const Pb::Register _R_15 ("FlagGrid","fillGrid",FlagGrid::_W_29); 
+ static const Pb::Register _R_16 ("FlagGrid","countCells",FlagGrid::_W_30); 
 #endif
 #ifdef _C_Grid
- static const Pb::Register _R_16 ("Grid<int>","Grid<int>","GridBase"); template<> const char* Namify<Grid<int> >::S = "Grid<int>"; 
- static const Pb::Register _R_17 ("Grid<int>","Grid",Grid<int>::_W_1); 
- static const Pb::Register _R_18 ("Grid<int>","save",Grid<int>::_W_2); 
- static const Pb::Register _R_19 ("Grid<int>","load",Grid<int>::_W_3); 
- static const Pb::Register _R_20 ("Grid<int>","clear",Grid<int>::_W_4); 
- static const Pb::Register _R_21 ("Grid<int>","copyFrom",Grid<int>::_W_5); 
- static const Pb::Register _R_22 ("Grid<int>","add",Grid<int>::_W_6); 
- static const Pb::Register _R_23 ("Grid<int>","sub",Grid<int>::_W_7); 
- static const Pb::Register _R_24 ("Grid<int>","setConst",Grid<int>::_W_8); 
- static const Pb::Register _R_25 ("Grid<int>","addConst",Grid<int>::_W_9); 
- static const Pb::Register _R_26 ("Grid<int>","addScaled",Grid<int>::_W_10); 
- static const Pb::Register _R_27 ("Grid<int>","mult",Grid<int>::_W_11); 
- static const Pb::Register _R_28 ("Grid<int>","multConst",Grid<int>::_W_12); 
- static const Pb::Register _R_29 ("Grid<int>","clamp",Grid<int>::_W_13); 
- static const Pb::Register _R_30 ("Grid<int>","stomp",Grid<int>::_W_14); 
- static const Pb::Register _R_31 ("Grid<int>","getMaxAbs",Grid<int>::_W_15); 
- static const Pb::Register _R_32 ("Grid<int>","getMax",Grid<int>::_W_16); 
- static const Pb::Register _R_33 ("Grid<int>","getMin",Grid<int>::_W_17); 
- static const Pb::Register _R_34 ("Grid<int>","getL1",Grid<int>::_W_18); 
- static const Pb::Register _R_35 ("Grid<int>","getL2",Grid<int>::_W_19); 
- static const Pb::Register _R_36 ("Grid<int>","setBound",Grid<int>::_W_20); 
- static const Pb::Register _R_37 ("Grid<int>","setBoundNeumann",Grid<int>::_W_21); 
- static const Pb::Register _R_38 ("Grid<int>","getDataPointer",Grid<int>::_W_22); 
- static const Pb::Register _R_39 ("Grid<int>","printGrid",Grid<int>::_W_23); 
- static const Pb::Register _R_40 ("Grid<Real>","Grid<Real>","GridBase"); template<> const char* Namify<Grid<Real> >::S = "Grid<Real>"; 
- static const Pb::Register _R_41 ("Grid<Real>","Grid",Grid<Real>::_W_1); 
- static const Pb::Register _R_42 ("Grid<Real>","save",Grid<Real>::_W_2); 
- static const Pb::Register _R_43 ("Grid<Real>","load",Grid<Real>::_W_3); 
- static const Pb::Register _R_44 ("Grid<Real>","clear",Grid<Real>::_W_4); 
- static const Pb::Register _R_45 ("Grid<Real>","copyFrom",Grid<Real>::_W_5); 
- static const Pb::Register _R_46 ("Grid<Real>","add",Grid<Real>::_W_6); 
- static const Pb::Register _R_47 ("Grid<Real>","sub",Grid<Real>::_W_7); 
- static const Pb::Register _R_48 ("Grid<Real>","setConst",Grid<Real>::_W_8); 
- static const Pb::Register _R_49 ("Grid<Real>","addConst",Grid<Real>::_W_9); 
- static const Pb::Register _R_50 ("Grid<Real>","addScaled",Grid<Real>::_W_10); 
- static const Pb::Register _R_51 ("Grid<Real>","mult",Grid<Real>::_W_11); 
- static const Pb::Register _R_52 ("Grid<Real>","multConst",Grid<Real>::_W_12); 
- static const Pb::Register _R_53 ("Grid<Real>","clamp",Grid<Real>::_W_13); 
- static const Pb::Register _R_54 ("Grid<Real>","stomp",Grid<Real>::_W_14); 
- static const Pb::Register _R_55 ("Grid<Real>","getMaxAbs",Grid<Real>::_W_15); 
- static const Pb::Register _R_56 ("Grid<Real>","getMax",Grid<Real>::_W_16); 
- static const Pb::Register _R_57 ("Grid<Real>","getMin",Grid<Real>::_W_17); 
- static const Pb::Register _R_58 ("Grid<Real>","getL1",Grid<Real>::_W_18); 
- static const Pb::Register _R_59 ("Grid<Real>","getL2",Grid<Real>::_W_19); 
- static const Pb::Register _R_60 ("Grid<Real>","setBound",Grid<Real>::_W_20); 
- static const Pb::Register _R_61 ("Grid<Real>","setBoundNeumann",Grid<Real>::_W_21); 
- static const Pb::Register _R_62 ("Grid<Real>","getDataPointer",Grid<Real>::_W_22); 
- static const Pb::Register _R_63 ("Grid<Real>","printGrid",Grid<Real>::_W_23); 
- static const Pb::Register _R_64 ("Grid<Vec3>","Grid<Vec3>","GridBase"); template<> const char* Namify<Grid<Vec3> >::S = "Grid<Vec3>"; 
- static const Pb::Register _R_65 ("Grid<Vec3>","Grid",Grid<Vec3>::_W_1); 
- static const Pb::Register _R_66 ("Grid<Vec3>","save",Grid<Vec3>::_W_2); 
- static const Pb::Register _R_67 ("Grid<Vec3>","load",Grid<Vec3>::_W_3); 
- static const Pb::Register _R_68 ("Grid<Vec3>","clear",Grid<Vec3>::_W_4); 
- static const Pb::Register _R_69 ("Grid<Vec3>","copyFrom",Grid<Vec3>::_W_5); 
- static const Pb::Register _R_70 ("Grid<Vec3>","add",Grid<Vec3>::_W_6); 
- static const Pb::Register _R_71 ("Grid<Vec3>","sub",Grid<Vec3>::_W_7); 
- static const Pb::Register _R_72 ("Grid<Vec3>","setConst",Grid<Vec3>::_W_8); 
- static const Pb::Register _R_73 ("Grid<Vec3>","addConst",Grid<Vec3>::_W_9); 
- static const Pb::Register _R_74 ("Grid<Vec3>","addScaled",Grid<Vec3>::_W_10); 
- static const Pb::Register _R_75 ("Grid<Vec3>","mult",Grid<Vec3>::_W_11); 
- static const Pb::Register _R_76 ("Grid<Vec3>","multConst",Grid<Vec3>::_W_12); 
- static const Pb::Register _R_77 ("Grid<Vec3>","clamp",Grid<Vec3>::_W_13); 
- static const Pb::Register _R_78 ("Grid<Vec3>","stomp",Grid<Vec3>::_W_14); 
- static const Pb::Register _R_79 ("Grid<Vec3>","getMaxAbs",Grid<Vec3>::_W_15); 
- static const Pb::Register _R_80 ("Grid<Vec3>","getMax",Grid<Vec3>::_W_16); 
- static const Pb::Register _R_81 ("Grid<Vec3>","getMin",Grid<Vec3>::_W_17); 
- static const Pb::Register _R_82 ("Grid<Vec3>","getL1",Grid<Vec3>::_W_18); 
- static const Pb::Register _R_83 ("Grid<Vec3>","getL2",Grid<Vec3>::_W_19); 
- static const Pb::Register _R_84 ("Grid<Vec3>","setBound",Grid<Vec3>::_W_20); 
- static const Pb::Register _R_85 ("Grid<Vec3>","setBoundNeumann",Grid<Vec3>::_W_21); 
- static const Pb::Register _R_86 ("Grid<Vec3>","getDataPointer",Grid<Vec3>::_W_22); 
- static const Pb::Register _R_87 ("Grid<Vec3>","printGrid",Grid<Vec3>::_W_23); 
+ static const Pb::Register _R_17 ("Grid<int>","Grid<int>","GridBase"); template<> const char* Namify<Grid<int> >::S = "Grid<int>"; 
+ static const Pb::Register _R_18 ("Grid<int>","Grid",Grid<int>::_W_1); 
+ static const Pb::Register _R_19 ("Grid<int>","save",Grid<int>::_W_2); 
+ static const Pb::Register _R_20 ("Grid<int>","load",Grid<int>::_W_3); 
+ static const Pb::Register _R_21 ("Grid<int>","clear",Grid<int>::_W_4); 
+ static const Pb::Register _R_22 ("Grid<int>","copyFrom",Grid<int>::_W_5); 
+ static const Pb::Register _R_23 ("Grid<int>","add",Grid<int>::_W_6); 
+ static const Pb::Register _R_24 ("Grid<int>","sub",Grid<int>::_W_7); 
+ static const Pb::Register _R_25 ("Grid<int>","setConst",Grid<int>::_W_8); 
+ static const Pb::Register _R_26 ("Grid<int>","addConst",Grid<int>::_W_9); 
+ static const Pb::Register _R_27 ("Grid<int>","addScaled",Grid<int>::_W_10); 
+ static const Pb::Register _R_28 ("Grid<int>","mult",Grid<int>::_W_11); 
+ static const Pb::Register _R_29 ("Grid<int>","multConst",Grid<int>::_W_12); 
+ static const Pb::Register _R_30 ("Grid<int>","clamp",Grid<int>::_W_13); 
+ static const Pb::Register _R_31 ("Grid<int>","stomp",Grid<int>::_W_14); 
+ static const Pb::Register _R_32 ("Grid<int>","getMaxAbs",Grid<int>::_W_15); 
+ static const Pb::Register _R_33 ("Grid<int>","getMax",Grid<int>::_W_16); 
+ static const Pb::Register _R_34 ("Grid<int>","getMin",Grid<int>::_W_17); 
+ static const Pb::Register _R_35 ("Grid<int>","getL1",Grid<int>::_W_18); 
+ static const Pb::Register _R_36 ("Grid<int>","getL2",Grid<int>::_W_19); 
+ static const Pb::Register _R_37 ("Grid<int>","setBound",Grid<int>::_W_20); 
+ static const Pb::Register _R_38 ("Grid<int>","setBoundNeumann",Grid<int>::_W_21); 
+ static const Pb::Register _R_39 ("Grid<int>","getDataPointer",Grid<int>::_W_22); 
+ static const Pb::Register _R_40 ("Grid<int>","printGrid",Grid<int>::_W_23); 
+ static const Pb::Register _R_41 ("Grid<Real>","Grid<Real>","GridBase"); template<> const char* Namify<Grid<Real> >::S = "Grid<Real>"; 
+ static const Pb::Register _R_42 ("Grid<Real>","Grid",Grid<Real>::_W_1); 
+ static const Pb::Register _R_43 ("Grid<Real>","save",Grid<Real>::_W_2); 
+ static const Pb::Register _R_44 ("Grid<Real>","load",Grid<Real>::_W_3); 
+ static const Pb::Register _R_45 ("Grid<Real>","clear",Grid<Real>::_W_4); 
+ static const Pb::Register _R_46 ("Grid<Real>","copyFrom",Grid<Real>::_W_5); 
+ static const Pb::Register _R_47 ("Grid<Real>","add",Grid<Real>::_W_6); 
+ static const Pb::Register _R_48 ("Grid<Real>","sub",Grid<Real>::_W_7); 
+ static const Pb::Register _R_49 ("Grid<Real>","setConst",Grid<Real>::_W_8); 
+ static const Pb::Register _R_50 ("Grid<Real>","addConst",Grid<Real>::_W_9); 
+ static const Pb::Register _R_51 ("Grid<Real>","addScaled",Grid<Real>::_W_10); 
+ static const Pb::Register _R_52 ("Grid<Real>","mult",Grid<Real>::_W_11); 
+ static const Pb::Register _R_53 ("Grid<Real>","multConst",Grid<Real>::_W_12); 
+ static const Pb::Register _R_54 ("Grid<Real>","clamp",Grid<Real>::_W_13); 
+ static const Pb::Register _R_55 ("Grid<Real>","stomp",Grid<Real>::_W_14); 
+ static const Pb::Register _R_56 ("Grid<Real>","getMaxAbs",Grid<Real>::_W_15); 
+ static const Pb::Register _R_57 ("Grid<Real>","getMax",Grid<Real>::_W_16); 
+ static const Pb::Register _R_58 ("Grid<Real>","getMin",Grid<Real>::_W_17); 
+ static const Pb::Register _R_59 ("Grid<Real>","getL1",Grid<Real>::_W_18); 
+ static const Pb::Register _R_60 ("Grid<Real>","getL2",Grid<Real>::_W_19); 
+ static const Pb::Register _R_61 ("Grid<Real>","setBound",Grid<Real>::_W_20); 
+ static const Pb::Register _R_62 ("Grid<Real>","setBoundNeumann",Grid<Real>::_W_21); 
+ static const Pb::Register _R_63 ("Grid<Real>","getDataPointer",Grid<Real>::_W_22); 
+ static const Pb::Register _R_64 ("Grid<Real>","printGrid",Grid<Real>::_W_23); 
+ static const Pb::Register _R_65 ("Grid<Vec3>","Grid<Vec3>","GridBase"); template<> const char* Namify<Grid<Vec3> >::S = "Grid<Vec3>"; 
+ static const Pb::Register _R_66 ("Grid<Vec3>","Grid",Grid<Vec3>::_W_1); 
+ static const Pb::Register _R_67 ("Grid<Vec3>","save",Grid<Vec3>::_W_2); 
+ static const Pb::Register _R_68 ("Grid<Vec3>","load",Grid<Vec3>::_W_3); 
+ static const Pb::Register _R_69 ("Grid<Vec3>","clear",Grid<Vec3>::_W_4); 
+ static const Pb::Register _R_70 ("Grid<Vec3>","copyFrom",Grid<Vec3>::_W_5); 
+ static const Pb::Register _R_71 ("Grid<Vec3>","add",Grid<Vec3>::_W_6); 
+ static const Pb::Register _R_72 ("Grid<Vec3>","sub",Grid<Vec3>::_W_7); 
+ static const Pb::Register _R_73 ("Grid<Vec3>","setConst",Grid<Vec3>::_W_8); 
+ static const Pb::Register _R_74 ("Grid<Vec3>","addConst",Grid<Vec3>::_W_9); 
+ static const Pb::Register _R_75 ("Grid<Vec3>","addScaled",Grid<Vec3>::_W_10); 
+ static const Pb::Register _R_76 ("Grid<Vec3>","mult",Grid<Vec3>::_W_11); 
+ static const Pb::Register _R_77 ("Grid<Vec3>","multConst",Grid<Vec3>::_W_12); 
+ static const Pb::Register _R_78 ("Grid<Vec3>","clamp",Grid<Vec3>::_W_13); 
+ static const Pb::Register _R_79 ("Grid<Vec3>","stomp",Grid<Vec3>::_W_14); 
+ static const Pb::Register _R_80 ("Grid<Vec3>","getMaxAbs",Grid<Vec3>::_W_15); 
+ static const Pb::Register _R_81 ("Grid<Vec3>","getMax",Grid<Vec3>::_W_16); 
+ static const Pb::Register _R_82 ("Grid<Vec3>","getMin",Grid<Vec3>::_W_17); 
+ static const Pb::Register _R_83 ("Grid<Vec3>","getL1",Grid<Vec3>::_W_18); 
+ static const Pb::Register _R_84 ("Grid<Vec3>","getL2",Grid<Vec3>::_W_19); 
+ static const Pb::Register _R_85 ("Grid<Vec3>","setBound",Grid<Vec3>::_W_20); 
+ static const Pb::Register _R_86 ("Grid<Vec3>","setBoundNeumann",Grid<Vec3>::_W_21); 
+ static const Pb::Register _R_87 ("Grid<Vec3>","getDataPointer",Grid<Vec3>::_W_22); 
+ static const Pb::Register _R_88 ("Grid<Vec3>","printGrid",Grid<Vec3>::_W_23); 
+ static const Pb::Register _R_89 ("Grid<Half>","Grid<Half>","GridBase"); template<> const char* Namify<Grid<Half> >::S = "Grid<Half>"; 
+ static const Pb::Register _R_90 ("Grid<Half>","Grid",Grid<Half>::_W_1); 
+ static const Pb::Register _R_91 ("Grid<Half>","save",Grid<Half>::_W_2); 
+ static const Pb::Register _R_92 ("Grid<Half>","load",Grid<Half>::_W_3); 
+ static const Pb::Register _R_93 ("Grid<Half>","clear",Grid<Half>::_W_4); 
+ static const Pb::Register _R_94 ("Grid<Half>","copyFrom",Grid<Half>::_W_5); 
+ static const Pb::Register _R_95 ("Grid<Half>","add",Grid<Half>::_W_6); 
+ static const Pb::Register _R_96 ("Grid<Half>","sub",Grid<Half>::_W_7); 
+ static const Pb::Register _R_97 ("Grid<Half>","setConst",Grid<Half>::_W_8); 
+ static const Pb::Register _R_98 ("Grid<Half>","addConst",Grid<Half>::_W_9); 
+ static const Pb::Register _R_99 ("Grid<Half>","addScaled",Grid<Half>::_W_10); 
+ static const Pb::Register _R_100 ("Grid<Half>","mult",Grid<Half>::_W_11); 
+ static const Pb::Register _R_101 ("Grid<Half>","multConst",Grid<Half>::_W_12); 
+ static const Pb::Register _R_102 ("Grid<Half>","clamp",Grid<Half>::_W_13); 
+ static const Pb::Register _R_103 ("Grid<Half>","stomp",Grid<Half>::_W_14); 
+ static const Pb::Register _R_104 ("Grid<Half>","getMaxAbs",Grid<Half>::_W_15); 
+ static const Pb::Register _R_105 ("Grid<Half>","getMax",Grid<Half>::_W_16); 
+ static const Pb::Register _R_106 ("Grid<Half>","getMin",Grid<Half>::_W_17); 
+ static const Pb::Register _R_107 ("Grid<Half>","getL1",Grid<Half>::_W_18); 
+ static const Pb::Register _R_108 ("Grid<Half>","getL2",Grid<Half>::_W_19); 
+ static const Pb::Register _R_109 ("Grid<Half>","setBound",Grid<Half>::_W_20); 
+ static const Pb::Register _R_110 ("Grid<Half>","setBoundNeumann",Grid<Half>::_W_21); 
+ static const Pb::Register _R_111 ("Grid<Half>","getDataPointer",Grid<Half>::_W_22); 
+ static const Pb::Register _R_112 ("Grid<Half>","printGrid",Grid<Half>::_W_23); 
 #endif
 #ifdef _C_GridBase
- static const Pb::Register _R_88 ("GridBase","GridBase","PbClass"); template<> const char* Namify<GridBase >::S = "GridBase"; 
- static const Pb::Register _R_89 ("GridBase","GridBase",GridBase::_W_0); 
+ static const Pb::Register _R_113 ("GridBase","GridBase","PbClass"); template<> const char* Namify<GridBase >::S = "GridBase"; 
+ static const Pb::Register _R_114 ("GridBase","GridBase",GridBase::_W_0); 
 #endif
 #ifdef _C_MACGrid
- static const Pb::Register _R_90 ("MACGrid","MACGrid","Grid<Vec3>"); template<> const char* Namify<MACGrid >::S = "MACGrid"; 
- static const Pb::Register _R_91 ("MACGrid","MACGrid",MACGrid::_W_24); 
- static const Pb::Register _R_92 ("MACGrid","setBoundMAC",MACGrid::_W_25); 
+ static const Pb::Register _R_115 ("MACGrid","MACGrid","Grid<Vec3>"); template<> const char* Namify<MACGrid >::S = "MACGrid"; 
+ static const Pb::Register _R_116 ("MACGrid","MACGrid",MACGrid::_W_24); 
+ static const Pb::Register _R_117 ("MACGrid","setBoundMAC",MACGrid::_W_25); 
 #endif
 static const Pb::Register _R_7 ("Grid<int>","IntGrid","");
 static const Pb::Register _R_8 ("Grid<Real>","RealGrid","");
 static const Pb::Register _R_9 ("Grid<Vec3>","VecGrid","");
+static const Pb::Register _R_10 ("Grid<Half>","HalfGrid","");
 extern "C" {
 void PbRegister_file_7()
 {
-	KEEP_UNUSED(_R_10);
 	KEEP_UNUSED(_R_11);
 	KEEP_UNUSED(_R_12);
 	KEEP_UNUSED(_R_13);
@@ -191,5 +215,30 @@ void PbRegister_file_7()
 	KEEP_UNUSED(_R_90);
 	KEEP_UNUSED(_R_91);
 	KEEP_UNUSED(_R_92);
+	KEEP_UNUSED(_R_93);
+	KEEP_UNUSED(_R_94);
+	KEEP_UNUSED(_R_95);
+	KEEP_UNUSED(_R_96);
+	KEEP_UNUSED(_R_97);
+	KEEP_UNUSED(_R_98);
+	KEEP_UNUSED(_R_99);
+	KEEP_UNUSED(_R_100);
+	KEEP_UNUSED(_R_101);
+	KEEP_UNUSED(_R_102);
+	KEEP_UNUSED(_R_103);
+	KEEP_UNUSED(_R_104);
+	KEEP_UNUSED(_R_105);
+	KEEP_UNUSED(_R_106);
+	KEEP_UNUSED(_R_107);
+	KEEP_UNUSED(_R_108);
+	KEEP_UNUSED(_R_109);
+	KEEP_UNUSED(_R_110);
+	KEEP_UNUSED(_R_111);
+	KEEP_UNUSED(_R_112);
+	KEEP_UNUSED(_R_113);
+	KEEP_UNUSED(_R_114);
+	KEEP_UNUSED(_R_115);
+	KEEP_UNUSED(_R_116);
+	KEEP_UNUSED(_R_117);
 }
 }}
\ No newline at end of file
@@ -178,12 +178,12 @@ void LevelsetGrid::subtract(const LevelsetGrid& o) { KnSubtract(*this, o); }
 //  note - uses flags to identify border (could also be done based on ls values)
 static void doReinitMarch( Grid<Real>& phi,
 		const FlagGrid& flags, Real maxTime, MACGrid* velTransport,
-		bool ignoreWalls, bool correctOuterLayer, int obstacleType )
+		bool ignoreWalls, bool correctOuterLayer, int obstacleType, bool parallel )
 {
 	const int dim = (phi.is3D() ? 3 : 2); 
 	Grid<int> fmFlags( phi.getParent() );
 
-	FastMarch<FmHeapEntryIn, -1> marchIn (flags, fmFlags, phi, maxTime, NULL );
+	FastMarch<FmHeapEntryIn, -1> marchIn (flags, fmFlags, phi, maxTime, NULL, parallel );
 	
 	// march inside
 	InitFmIn (flags, fmFlags, phi, ignoreWalls, obstacleType);
@@ -219,7 +219,7 @@ static void doReinitMarch( Grid<Real>& phi,
 
 	InitFmOut (flags, fmFlags, phi, ignoreWalls, obstacleType);
 	
-	FastMarch<FmHeapEntryOut, +1> marchOut(flags, fmFlags, phi, maxTime, velTransport );
+	FastMarch<FmHeapEntryOut, +1> marchOut(flags, fmFlags, phi, maxTime, velTransport, parallel );
 
 	// by default, correctOuterLayer is on
 	if (correctOuterLayer) {
@@ -279,9 +279,9 @@ static void doReinitMarch( Grid<Real>& phi,
 //! call for levelset grids & external real grids
 
 void LevelsetGrid::reinitMarching( const FlagGrid& flags, Real maxTime, MACGrid* velTransport,
-		bool ignoreWalls, bool correctOuterLayer, int obstacleType )
+		bool ignoreWalls, bool correctOuterLayer, int obstacleType, bool parallel )
 {
-	doReinitMarch( *this, flags, maxTime, velTransport, ignoreWalls, correctOuterLayer, obstacleType );
+	doReinitMarch( *this, flags, maxTime, velTransport, ignoreWalls, correctOuterLayer, obstacleType, parallel );
 }
 
 
@@ -294,26 +294,44 @@ void LevelsetGrid::initFromFlags(const FlagGrid& flags, bool ignoreWalls) {
 	}
 }
 
-//! run marching cubes to create a mesh for the 0-levelset
-void LevelsetGrid::createMesh(Mesh& mesh) {
-	assertMsg(is3D(), "Only 3D grids supported so far");
-	
-	mesh.clear();
-		
-	const Real invalidTime = invalidTimeValue();
-	const Real isoValue = 1e-4;
-	
-	// create some temp grids
-	Grid<int> edgeVX(mParent);
-	Grid<int> edgeVY(mParent);
-	Grid<int> edgeVZ(mParent);
-	
-	for(int i=0; i<mSize.x-1; i++)
-	for(int j=0; j<mSize.y-1; j++)
-	for(int k=0; k<mSize.z-1; k++) {
-		 Real value[8] = { get(i,j,k),   get(i+1,j,k),   get(i+1,j+1,k),   get(i,j+1,k),
-						   get(i,j,k+1), get(i+1,j,k+1), get(i+1,j+1,k+1), get(i,j+1,k+1) };
-		
+//! marching cubes output of a slab of x-layers, with slab local vertex indices
+struct McSlab {
+	std::vector<Node> nodes;
+	std::vector<Triangle> tris;
+	//! vertices on the shared y and z edges of the first and last layer, (edge, vertex) sorted by edge
+	std::vector<std::pair<IndexInt,int> > lower, upper;
+	//! global index of each vertex, and of the first vertex / triangle owned by this slab
+	std::vector<int> index;
+	int nodeStart, triStart;
+};
+
+//! extract the triangles of one slab in the same order as a serial sweep over i,j,k
+
+ struct knMarchingCubesSlab : public KernelBase { knMarchingCubesSlab(int numSlabs, const LevelsetGrid& phi, const int slabWidth, const Real isoValue, std::vector<McSlab>& slabs) :  KernelBase(numSlabs) ,numSlabs(numSlabs),phi(phi),slabWidth(slabWidth),isoValue(isoValue),slabs(slabs)   { runMessage(); run(); }   inline void op(IndexInt idx, int numSlabs, const LevelsetGrid& phi, const int slabWidth, const Real isoValue, std::vector<McSlab>& slabs ) {
+	const int i0 = idx*slabWidth, i1 = std::min(i0+slabWidth, phi.getSizeX()-1);
+	const int sy = phi.getSizeY(), sz = phi.getSizeZ();
+	const IndexInt plane = (IndexInt)sy * sz;
+	const Real invalidTime = phi.invalidTimeValue();
+	McSlab& slab = slabs[idx];
+
+	// edge vertex indices (+1) of this slab, layer i0 is shared with the previous slab
+	std::vector<int> edgeVX((i1-i0)*plane, 0), edgeVY((i1-i0+1)*plane, 0), edgeVZ((i1-i0+1)*plane, 0);
+
+	for(int i=i0; i<i1; i++)
+	for(int j=0; j<sy-1; j++) {
+		// skip rows of cubes that are completely inside or outside
+		const bool inside = -phi(i,j,0) < isoValue;
+		bool empty = true;
+		for(int k=0; k<sz && empty; k++) {
+			empty = (-phi(i,j,k) < isoValue) == inside && (-phi(i+1,j,k) < isoValue) == inside &&
+					(-phi(i,j+1,k) < isoValue) == inside && (-phi(i+1,j+1,k) < isoValue) == inside;
+		}
+		if (empty) continue;
+
+		for(int k=0; k<sz-1; k++) {
+		 Real value[8] = { phi(i,j,k),   phi(i+1,j,k),   phi(i+1,j+1,k),   phi(i,j+1,k),
+						   phi(i,j,k+1), phi(i+1,j,k+1), phi(i+1,j+1,k+1), phi(i,j+1,k+1) };
+
 		// build lookup index, check for invalid times
 		bool skip = false;
 		int cubeIdx = 0;
@@ -321,20 +339,21 @@ void LevelsetGrid::createMesh(Mesh& mesh) {
 			value[l] *= -1;
 			if (-value[l] <= invalidTime)
 				skip = true;
-			if (value[l] < isoValue) 
+			if (value[l] < isoValue)
 				cubeIdx |= 1<<l;
 		}
 		if (skip || (mcEdgeTable[cubeIdx] == 0)) continue;
-		
+
 		// where to look up if this point already exists
+		const IndexInt e0 = ((i-i0)*sy + j)*sz + k;
 		int triIndices[12];
-		int *eVert[12] = { &edgeVX(i,j,k),   &edgeVY(i+1,j,k),   &edgeVX(i,j+1,k),   &edgeVY(i,j,k), 
-						   &edgeVX(i,j,k+1), &edgeVY(i+1,j,k+1), &edgeVX(i,j+1,k+1), &edgeVY(i,j,k+1), 
-						   &edgeVZ(i,j,k),   &edgeVZ(i+1,j,k),   &edgeVZ(i+1,j+1,k), &edgeVZ(i,j+1,k) };
-		
+		int *eVert[12] = { &edgeVX[e0],    &edgeVY[e0+plane],   &edgeVX[e0+sz],   &edgeVY[e0],
+						   &edgeVX[e0+1],  &edgeVY[e0+plane+1], &edgeVX[e0+sz+1], &edgeVY[e0+1],
+						   &edgeVZ[e0],    &edgeVZ[e0+plane],   &edgeVZ[e0+plane+sz], &edgeVZ[e0+sz] };
+
 		const Vec3 pos[9] = { Vec3(i,j,k),   Vec3(i+1,j,k),   Vec3(i+1,j+1,k),   Vec3(i,j+1,k),
 						Vec3(i,j,k+1), Vec3(i+1,j,k+1), Vec3(i+1,j+1,k+1), Vec3(i,j+1,k+1) };
-		
+
 		for (int e=0; e<12; e++) {
 			if (mcEdgeTable[cubeIdx] & (1<<e)) {
 				// vertex already calculated ?
@@ -351,13 +370,14 @@ void LevelsetGrid::createMesh(Mesh& mesh) {
 					// init isolevel vertex
 					Node vertex;
 					vertex.pos = p1 + (p2-p1)*mu + Vec3(Real(0.5));
-					vertex.normal = getNormalized( 
-										getGradient( *this, i+cubieOffsetX[e1], j+cubieOffsetY[e1], k+cubieOffsetZ[e1]) * (1.0-mu) +
-										getGradient( *this, i+cubieOffsetX[e2], j+cubieOffsetY[e2], k+cubieOffsetZ[e2]) * (    mu)) ;
-					
-					triIndices[e] = mesh.addNode(vertex) + 1;
-					
-					// store vertex 
+					vertex.normal = getNormalized(
+										getGradient( phi, i+cubieOffsetX[e1], j+cubieOffsetY[e1], k+cubieOffsetZ[e1]) * (1.0-mu) +
+										getGradient( phi, i+cubieOffsetX[e2], j+cubieOffsetY[e2], k+cubieOffsetZ[e2]) * (    mu)) ;
+
+					slab.nodes.push_back(vertex);
+					triIndices[e] = slab.nodes.size();
+
+					// store vertex
 					*eVert[e] = triIndices[e];
 				} else {
 					// retrieve  from vert array
@@ -365,15 +385,89 @@ void LevelsetGrid::createMesh(Mesh& mesh) {
 				}
 			}
 		}
-		
-		// Create the triangles... 
+
+		// Create the triangles...
 		for(int e=0; mcTriTable[cubeIdx][e]!=-1; e+=3) {
-			mesh.addTri( Triangle( triIndices[ mcTriTable[cubeIdx][e+0]] - 1,
+			slab.tris.push_back( Triangle( triIndices[ mcTriTable[cubeIdx][e+0]] - 1,
 										triIndices[ mcTriTable[cubeIdx][e+1]] - 1,
 										triIndices[ mcTriTable[cubeIdx][e+2]] - 1));
 		}
+		}
 	}
+
+	// remember the vertices on the y and z edges of the first and last layer
+	const IndexInt last = (i1-i0)*plane;
+	for (IndexInt n=0; n<plane; n++) if (edgeVY[n])      slab.lower.push_back(std::make_pair(n, edgeVY[n]-1));
+	for (IndexInt n=0; n<plane; n++) if (edgeVZ[n])      slab.lower.push_back(std::make_pair(plane+n, edgeVZ[n]-1));
+	for (IndexInt n=0; n<plane; n++) if (edgeVY[last+n]) slab.upper.push_back(std::make_pair(n, edgeVY[last+n]-1));
+	for (IndexInt n=0; n<plane; n++) if (edgeVZ[last+n]) slab.upper.push_back(std::make_pair(plane+n, edgeVZ[last+n]-1));
+}    inline int& getArg0() { return numSlabs; } typedef int type0;inline const LevelsetGrid& getArg1() { return phi; } typedef LevelsetGrid type1;inline const int& getArg2() { return slabWidth; } typedef int type2;inline const Real& getArg3() { return isoValue; } typedef Real type3;inline std::vector<McSlab>& getArg4() { return slabs; } typedef std::vector<McSlab> type4; void runMessage() { debMsg("Executing kernel knMarchingCubesSlab ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,numSlabs,phi,slabWidth,isoValue,slabs);  }   } int numSlabs; const LevelsetGrid& phi; const int slabWidth; const Real isoValue; std::vector<McSlab>& slabs;   };
+
+
+ struct knFillMeshSlab : public KernelBase { knFillMeshSlab(int numSlabs, const std::vector<McSlab>& slabs, Mesh& mesh) :  KernelBase(numSlabs) ,numSlabs(numSlabs),slabs(slabs),mesh(mesh)   { runMessage(); run(); }   inline void op(IndexInt idx, int numSlabs, const std::vector<McSlab>& slabs, Mesh& mesh ) {
+	const McSlab& slab = slabs[idx];
+	for (size_t v=0; v<slab.nodes.size(); v++) {
+		if (slab.index[v] >= slab.nodeStart) mesh.nodes(slab.index[v]) = slab.nodes[v];
+	}
+	for (size_t t=0; t<slab.tris.size(); t++) {
+		const Triangle& tri = slab.tris[t];
+		mesh.tris(slab.triStart + t) = Triangle(slab.index[tri.c[0]], slab.index[tri.c[1]], slab.index[tri.c[2]]);
+	}
+}    inline int& getArg0() { return numSlabs; } typedef int type0;inline const std::vector<McSlab>& getArg1() { return slabs; } typedef std::vector<McSlab> type1;inline Mesh& getArg2() { return mesh; } typedef Mesh type2; void runMessage() { debMsg("Executing kernel knFillMeshSlab ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,numSlabs,slabs,mesh);  }   } int numSlabs; const std::vector<McSlab>& slabs; Mesh& mesh;   };
+
+
+//! run marching cubes to create a mesh for the 0-levelset
+void LevelsetGrid::createMesh(Mesh& mesh) {
+	assertMsg(is3D(), "Only 3D grids supported so far");
 	
+	mesh.clear();
+		
+	const Real isoValue = 1e-4;
+	const int slabWidth = 8;
+	const int numSlabs = std::max(mSize.x - 1 + slabWidth - 1, 0) / slabWidth;
+
+	// pass 1, run all slabs in parallel
+	std::vector<McSlab> slabs(numSlabs);
+	knMarchingCubesSlab(numSlabs, *this, slabWidth, isoValue, slabs);
+
+	// number the vertices in serial order, a vertex on a shared edge belongs to the
+	// earlier slab if both slabs created it
+	int numNodes = 0, numTris = 0;
+	for (int s=0; s<numSlabs; s++) {
+		McSlab& slab = slabs[s];
+		slab.index.assign(slab.nodes.size(), -1);
+		if (s > 0) {
+			const McSlab& prev = slabs[s-1];
+			size_t a = 0, b = 0;
+			while (a < slab.lower.size() && b < prev.upper.size()) {
+				if      (slab.lower[a].first < prev.upper[b].first) a++;
+				else if (slab.lower[a].first > prev.upper[b].first) b++;
+				else slab.index[slab.lower[a++].second] = prev.index[prev.upper[b++].second];
+			}
+		}
+		slab.nodeStart = numNodes;
+		for (size_t v=0; v<slab.nodes.size(); v++) {
+			if (slab.index[v] < 0) slab.index[v] = numNodes++;
+		}
+		slab.triStart = numTris;
+		numTris += slab.tris.size();
+	}
+
+	// pass 2, copy into the mesh in parallel
+	mesh.resizeNodes(numNodes);
+	mesh.resizeTris(numTris);
+	for (IndexInt i=0; i<mesh.getNumMdata(); i++)
+		mesh.getMdata(i)->resize(numNodes);
+	knFillMeshSlab(numSlabs, slabs, mesh);
+
 	//mesh.rebuildCorners();
 	//mesh.rebuildLookup();
 
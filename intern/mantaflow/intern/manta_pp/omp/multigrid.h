@@ -77,6 +77,16 @@ class GridMg {
 		//     (and rhs) and scales these equations by a fixed factor < 1.
 		void setTrivialEquationScale(Real scale) { mTrivialEquationScale = scale; }
 
+		//! Reuse the coarse grid hierarchy in subsequent calls to setA:
+		// Until maxChangedFraction of the level 0 vertices changed their active state since the
+		// last regeneration, only the affected coarse vertices and operator entries are updated.
+		// Otherwise, the hierarchy is regenerated from scratch.
+		void setReuseHierarchy(bool reuse, Real maxChangedFraction = Real(0.01));
+		bool getReuseHierarchy() const { return mReuseHierarchy; }
+
+		//! mark A as outdated, it is set again before the next solve
+		void invalidateA() { mIsASet = false; mIsRhsSet = false; }
+
 	private:		
 		Vec3i vecIdx(int   v, int l) const { return Vec3i(v%mSize[l].x, (v%(mSize[l].x*mSize[l].y))/mSize[l].x, v/(mSize[l].x*mSize[l].y)); }
 		int   linIdx(Vec3i V, int l) const { return V.x + V.y*mPitch[l].y + V.z*mPitch[l].z; }
@@ -86,6 +96,8 @@ class GridMg {
 
 		void genCoarseGrid(int l);
 		void genCoraseGridOperator(int l);
+		void genCoarseStencil(int v, int l, Real* stencil) const;
+		bool updateHierarchy();
 
 		void smoothGS(int l, bool reversedOrder);
 		void calcResidual(int l);
@@ -136,11 +148,28 @@ class GridMg {
 		bool mIsASet;
 		bool mIsRhsSet;
 
+		// hierarchy reuse: level 0 system of the previous setA call and
+		// per-level flags of changed vertices (1: operator, 2: active state)
+		bool mReuseHierarchy;
+		bool mHasHierarchy;
+		Real mMaxChangedFraction;
+		int mNumChangedSinceRebuild;
+		int mMinOrder;
+		std::vector<Real> mA0Prev;
+		std::vector<VertexType> mType0Prev;
+		std::vector<std::vector<char>> mDirty;
+		// per coarse level: the fine vertex each active coarse vertex was selected for
+		// and the selection order, see updateHierarchy
+		std::vector<std::vector<int>> mOwner;
+		std::vector<std::vector<int>> mOrder;
+
 		// provide kernels with access
 		friend struct knActivateVertices;
 		friend struct knActivateCoarseVertices;
 		friend struct knSetRhs;
 		friend struct knGenCoarseGridOperator;
+		friend struct knMarkChangedVertices;
+		friend struct knUpdateCoarseGridOperator;
 		friend struct knSmoothColor;
 		friend struct knCalcResidual;
 		friend struct knResidualNormSumSqr;
@@ -26,6 +26,7 @@
 #include "vectorbase.h"
 #include "grid.h"
 #include "kernel.h"
+#include "tilemask.h"
 #include <limits>
 
 using namespace std;
@@ -331,6 +332,138 @@ template <class T>  struct MacCormackClamp : public KernelBase { MacCormackClamp
 
 
 
+//! Per cell helpers for the multi-grid advection kernels, shared by the dense and the tiled variants
+
+inline static void semiLagrangeMultiCell(int i, int j, int k, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& src, Real dt, int orderSpace) {
+	// traceback position, shared by all grids
+	Vec3 pos = Vec3(i+0.5f,j+0.5f,k+0.5f) - vel.getCentered(i,j,k) * dt;
+	for (size_t n=0; n<dst.size(); n++)
+		(*dst[n])(i,j,k) = src[n]->getInterpolatedHi(pos, orderSpace);
+}
+
+inline static void macCormackCorrectMultiCell(IndexInt idx, const FlagGrid& flags, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& old, const std::vector<Grid<Real>*>& fwd, Real strength) {
+	const bool isFluid = flags.isFluid(idx);
+	for (size_t n=0; n<dst.size(); n++) {
+		Real val = (*fwd[n])[idx];
+
+		// only correct inside fluid region; note, strenth of correction can be modified here
+		if (isFluid)
+			val += strength * 0.5 * ((*old[n])[idx] - (*dst[n])[idx]);
+		(*dst[n])[idx] = val;
+	}
+}
+
+inline static void macCormackClampMultiCell(int i, int j, int k, const FlagGrid& flags, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& orig, const std::vector<Grid<Real>*>& fwd, Real dt, const int clampMode) {
+	Vec3i gridUpper  = flags.getSize() - 1;
+	const Vec3 velDt = vel.getCentered(i,j,k) * dt;
+	bool  useFwd     = false;
+
+	if(1 && clampMode==1) {
+		// lookup forward/backward , round to closest NB
+		Vec3i posFwd = toVec3i( Vec3(i,j,k) + Vec3(0.5,0.5,0.5) - velDt );
+		Vec3i posBwd = toVec3i( Vec3(i,j,k) + Vec3(0.5,0.5,0.5) + velDt );
+
+		// test if lookups point out of grid or into obstacle (note doClampComponent already checks sides, below is needed for valid flags access)
+		if (posFwd.x < 0 || posFwd.y < 0 || posFwd.z < 0 ||
+			posBwd.x < 0 || posBwd.y < 0 || posBwd.z < 0 ||
+			posFwd.x > gridUpper.x || posFwd.y > gridUpper.y || ((posFwd.z > gridUpper.z)&&flags.is3D()) ||
+			posBwd.x > gridUpper.x || posBwd.y > gridUpper.y || ((posBwd.z > gridUpper.z)&&flags.is3D()) ||
+			flags.isObstacle(posFwd) || flags.isObstacle(posBwd) ) 
+		{
+			useFwd = true;
+		}
+	}
+	// clampMode 2 handles flags in doClampComponent call
+
+	for (size_t n=0; n<dst.size(); n++) {
+		const Real dfwd = (*fwd[n])(i,j,k);
+		Real dval = doClampComponent<Real>(gridUpper, flags, (*dst[n])(i,j,k), *orig[n], dfwd, Vec3(i,j,k), velDt, clampMode );
+		(*dst[n])(i,j,k) = (useFwd) ? dfwd : dval;
+	}
+}
+
+//! Semi-Lagrange interpolation kernel for a list of Real grids, traces back each cell only once
+
+
+ struct SemiLagrangeMulti : public KernelBase { SemiLagrangeMulti(const FlagGrid& flags, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& src, Real dt, int orderSpace) :  KernelBase(&flags,1) ,flags(flags),vel(vel),dst(dst),src(src),dt(dt),orderSpace(orderSpace)   { runMessage(); run(); }  inline void op(int i, int j, int k, const FlagGrid& flags, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& src, Real dt, int orderSpace ) {
+	semiLagrangeMultiCell(i,j,k, vel, dst, src, dt, orderSpace);
+}   inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline const MACGrid& getArg1() { return vel; } typedef MACGrid type1;inline std::vector<Grid<Real>*>& getArg2() { return dst; } typedef std::vector<Grid<Real>*> type2;inline const std::vector<Grid<Real>*>& getArg3() { return src; } typedef std::vector<Grid<Real>*> type3;inline Real& getArg4() { return dt; } typedef Real type4;inline int& getArg5() { return orderSpace; } typedef int type5; void runMessage() { debMsg("Executing kernel SemiLagrangeMulti ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ > 1) { 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (int k=minZ; k < maxZ; k++) for (int j=1; j < _maxY; j++) for (int i=1; i < _maxX; i++) op(i,j,k,flags,vel,dst,src,dt,orderSpace);  } } else { const int k=0; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (int j=1; j < _maxY; j++) for (int i=1; i < _maxX; i++) op(i,j,k,flags,vel,dst,src,dt,orderSpace);  } }  } const FlagGrid& flags; const MACGrid& vel; std::vector<Grid<Real>*>& dst; const std::vector<Grid<Real>*>& src; Real dt; int orderSpace;   };
+
+//! Kernel: MacCormack correction for a list of Real grids, dst holds the backward step on entry
+
+
+ struct MacCormackCorrectMulti : public KernelBase { MacCormackCorrectMulti(const FlagGrid& flags, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& old, const std::vector<Grid<Real>*>& fwd, Real strength) :  KernelBase(&flags,0) ,flags(flags),dst(dst),old(old),fwd(fwd),strength(strength)   { runMessage(); run(); }   inline void op(IndexInt idx, const FlagGrid& flags, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& old, const std::vector<Grid<Real>*>& fwd, Real strength ) {
+	macCormackCorrectMultiCell(idx, flags, dst, old, fwd, strength);
+}    inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline std::vector<Grid<Real>*>& getArg1() { return dst; } typedef std::vector<Grid<Real>*> type1;inline const std::vector<Grid<Real>*>& getArg2() { return old; } typedef std::vector<Grid<Real>*> type2;inline const std::vector<Grid<Real>*>& getArg3() { return fwd; } typedef std::vector<Grid<Real>*> type3;inline Real& getArg4() { return strength; } typedef Real type4; void runMessage() { debMsg("Executing kernel MacCormackCorrectMulti ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,flags,dst,old,fwd,strength);  }   } const FlagGrid& flags; std::vector<Grid<Real>*>& dst; const std::vector<Grid<Real>*>& old; const std::vector<Grid<Real>*>& fwd; Real strength;   };
+
+//! Kernel: same as MacCormackClamp, but for a list of Real grids sharing the forward/backward lookups
+
+
+ struct MacCormackClampMulti : public KernelBase { MacCormackClampMulti(const FlagGrid& flags, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& orig, const std::vector<Grid<Real>*>& fwd, Real dt, const int clampMode) :  KernelBase(&flags,1) ,flags(flags),vel(vel),dst(dst),orig(orig),fwd(fwd),dt(dt),clampMode(clampMode)   { runMessage(); run(); }  inline void op(int i, int j, int k, const FlagGrid& flags, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& orig, const std::vector<Grid<Real>*>& fwd, Real dt, const int clampMode ) {
+	macCormackClampMultiCell(i,j,k, flags, vel, dst, orig, fwd, dt, clampMode);
+}   inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline const MACGrid& getArg1() { return vel; } typedef MACGrid type1;inline std::vector<Grid<Real>*>& getArg2() { return dst; } typedef std::vector<Grid<Real>*> type2;inline const std::vector<Grid<Real>*>& getArg3() { return orig; } typedef std::vector<Grid<Real>*> type3;inline const std::vector<Grid<Real>*>& getArg4() { return fwd; } typedef std::vector<Grid<Real>*> type4;inline Real& getArg5() { return dt; } typedef Real type5;inline const int& getArg6() { return clampMode; } typedef int type6; void runMessage() { debMsg("Executing kernel MacCormackClampMulti ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ > 1) { 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (int k=minZ; k < maxZ; k++) for (int j=1; j < _maxY; j++) for (int i=1; i < _maxX; i++) op(i,j,k,flags,vel,dst,orig,fwd,dt,clampMode);  } } else { const int k=0; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (int j=1; j < _maxY; j++) for (int i=1; i < _maxX; i++) op(i,j,k,flags,vel,dst,orig,fwd,dt,clampMode);  } }  } const FlagGrid& flags; const MACGrid& vel; std::vector<Grid<Real>*>& dst; const std::vector<Grid<Real>*>& orig; const std::vector<Grid<Real>*>& fwd; Real dt; const int clampMode;   };
+
+
+//! Kernel: SemiLagrangeMulti, restricted to active tiles
+
+
+ struct SemiLagrangeMultiTiles : public KernelBase { SemiLagrangeMultiTiles(const TileMask& mask, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& src, Real dt, int orderSpace) :  KernelBase(mask.numActive()) ,mask(mask),vel(vel),dst(dst),src(src),dt(dt),orderSpace(orderSpace)   { runMessage(); run(); }   inline void op(IndexInt idx, const TileMask& mask, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& src, Real dt, int orderSpace ) {
+	FOR_TILE_IJK_BND(mask, idx, 1) {
+		semiLagrangeMultiCell(i,j,k, vel, dst, src, dt, orderSpace);
+	}
+}    inline const TileMask& getArg0() { return mask; } typedef TileMask type0;inline const MACGrid& getArg1() { return vel; } typedef MACGrid type1;inline std::vector<Grid<Real>*>& getArg2() { return dst; } typedef std::vector<Grid<Real>*> type2;inline const std::vector<Grid<Real>*>& getArg3() { return src; } typedef std::vector<Grid<Real>*> type3;inline Real& getArg4() { return dt; } typedef Real type4;inline int& getArg5() { return orderSpace; } typedef int type5; void runMessage() { debMsg("Executing kernel SemiLagrangeMultiTiles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,mask,vel,dst,src,dt,orderSpace);  }   } const TileMask& mask; const MACGrid& vel; std::vector<Grid<Real>*>& dst; const std::vector<Grid<Real>*>& src; Real dt; int orderSpace;   };
+
+//! Kernel: MacCormackCorrectMulti, restricted to active tiles
+
+
+ struct MacCormackCorrectMultiTiles : public KernelBase { MacCormackCorrectMultiTiles(const TileMask& mask, const FlagGrid& flags, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& old, const std::vector<Grid<Real>*>& fwd, Real strength) :  KernelBase(mask.numActive()) ,mask(mask),flags(flags),dst(dst),old(old),fwd(fwd),strength(strength)   { runMessage(); run(); }   inline void op(IndexInt idx, const TileMask& mask, const FlagGrid& flags, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& old, const std::vector<Grid<Real>*>& fwd, Real strength ) {
+	FOR_TILE_IJK_BND(mask, idx, 0) {
+		macCormackCorrectMultiCell(flags.index(i,j,k), flags, dst, old, fwd, strength);
+	}
+}    inline const TileMask& getArg0() { return mask; } typedef TileMask type0;inline const FlagGrid& getArg1() { return flags; } typedef FlagGrid type1;inline std::vector<Grid<Real>*>& getArg2() { return dst; } typedef std::vector<Grid<Real>*> type2;inline const std::vector<Grid<Real>*>& getArg3() { return old; } typedef std::vector<Grid<Real>*> type3;inline const std::vector<Grid<Real>*>& getArg4() { return fwd; } typedef std::vector<Grid<Real>*> type4;inline Real& getArg5() { return strength; } typedef Real type5; void runMessage() { debMsg("Executing kernel MacCormackCorrectMultiTiles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,mask,flags,dst,old,fwd,strength);  }   } const TileMask& mask; const FlagGrid& flags; std::vector<Grid<Real>*>& dst; const std::vector<Grid<Real>*>& old; const std::vector<Grid<Real>*>& fwd; Real strength;   };
+
+//! Kernel: MacCormackClampMulti, restricted to active tiles
+
+
+ struct MacCormackClampMultiTiles : public KernelBase { MacCormackClampMultiTiles(const TileMask& mask, const FlagGrid& flags, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& orig, const std::vector<Grid<Real>*>& fwd, Real dt, const int clampMode) :  KernelBase(mask.numActive()) ,mask(mask),flags(flags),vel(vel),dst(dst),orig(orig),fwd(fwd),dt(dt),clampMode(clampMode)   { runMessage(); run(); }   inline void op(IndexInt idx, const TileMask& mask, const FlagGrid& flags, const MACGrid& vel, std::vector<Grid<Real>*>& dst, const std::vector<Grid<Real>*>& orig, const std::vector<Grid<Real>*>& fwd, Real dt, const int clampMode ) {
+	FOR_TILE_IJK_BND(mask, idx, 1) {
+		macCormackClampMultiCell(i,j,k, flags, vel, dst, orig, fwd, dt, clampMode);
+	}
+}    inline const TileMask& getArg0() { return mask; } typedef TileMask type0;inline const FlagGrid& getArg1() { return flags; } typedef FlagGrid type1;inline const MACGrid& getArg2() { return vel; } typedef MACGrid type2;inline std::vector<Grid<Real>*>& getArg3() { return dst; } typedef std::vector<Grid<Real>*> type3;inline const std::vector<Grid<Real>*>& getArg4() { return orig; } typedef std::vector<Grid<Real>*> type4;inline const std::vector<Grid<Real>*>& getArg5() { return fwd; } typedef std::vector<Grid<Real>*> type5;inline Real& getArg6() { return dt; } typedef Real type6;inline const int& getArg7() { return clampMode; } typedef int type7; void runMessage() { debMsg("Executing kernel MacCormackClampMultiTiles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,mask,flags,vel,dst,orig,fwd,dt,clampMode);  }   } const TileMask& mask; const FlagGrid& flags; const MACGrid& vel; std::vector<Grid<Real>*>& dst; const std::vector<Grid<Real>*>& orig; const std::vector<Grid<Real>*>& fwd; Real dt; const int clampMode;   };
+
+
 //! template function for performing SL advection
 //! (Note boundary width only needed for specialization for MAC grids below)
 template<class GridType> 
@@ -510,6 +643,89 @@ void fnAdvectSemiLagrange<MACGrid>(FluidSolver* parent, const FlagGrid& flags, c
 }
 
 
+//! Multi-grid advection of Real grids, skips empty tiles for grids with zero background
+//! support (optional) holds the tiles that can contain non-zero values on entry, so that the grids don't
+//! need to be scanned, and is set to the tiles that can contain non-zero values after the advection
+static void fnAdvectSemiLagrangeMulti(FluidSolver* parent, const FlagGrid& flags, const MACGrid& vel, std::vector<Grid<Real>*>& orig, int order, Real strength, int orderSpace, int clampMode, TileMask* support = NULL) {
+	Real dt = parent->getDt();
+	std::vector<Grid<Real>*> fwd, bwd;
+
+	// grids with zero background stay zero away from their non-zero cells, so only tiles
+	// within reach of the traceback (both passes for MacCormack) need to be computed
+	TileMask mask(flags);
+	bool sparse = true;
+	for (size_t n=0; n<orig.size(); n++) {
+		if (orig[n]->getType() & GridBase::TypeLevelset) sparse = false;
+	}
+	if (sparse) {
+		if (support) {
+			assertMsg(support->numTiles() == mask.numTiles(), "AdvectSemiLagrangeMulti: support has a different size");
+			mask = *support;
+		}
+		else {
+			for (size_t n=0; n<orig.size(); n++)
+				mask.activateNonZero(*orig[n]);
+		}
+		const Real disp  = sqrt(3.) * vel.getMaxAbs() * fabs(dt); // bound for centered velocity
+		const Real reach = disp + (orderSpace == 1 ? 1 : 2) + 1;    // interpolation stencil and rounding
+		mask.dilate(TileMask::tilesForCells(order == 2 ? 2*reach + 1 : reach));
+		mask.update();
+		sparse = mask.useSparse();
+	}
+
+	// forward step
+	for (size_t n=0; n<orig.size(); n++)
+		fwd.push_back(new Grid<Real>(parent));
+	if (sparse) SemiLagrangeMultiTiles (mask, vel, fwd, orig, dt, orderSpace);
+	else        SemiLagrangeMulti (flags, vel, fwd, orig, dt, orderSpace);
+
+	if (order == 2) { // MacCormack
+		for (size_t n=0; n<orig.size(); n++)
+			bwd.push_back(new Grid<Real>(parent));
+
+		// bwd <- backwards step
+		if (sparse) SemiLagrangeMultiTiles (mask, vel, bwd, fwd, -dt, orderSpace);
+		else        SemiLagrangeMulti (flags, vel, bwd, fwd, -dt, orderSpace);
+
+		// bwd <- compute correction (in place)
+		if (sparse) MacCormackCorrectMultiTiles (mask, flags, bwd, orig, fwd, strength);
+		else        MacCormackCorrectMulti (flags, bwd, orig, fwd, strength);
+
+		// clamp values
+		if (sparse) MacCormackClampMultiTiles (mask, flags, vel, bwd, orig, fwd, dt, clampMode);
+		else        MacCormackClampMulti (flags, vel, bwd, orig, fwd, dt, clampMode);
+	}
+
+	std::vector<Grid<Real>*>& result = (order == 2) ? bwd : fwd;
+	for (size_t n=0; n<orig.size(); n++)
+		orig[n]->swap(*result[n]);
+
+	for (size_t n=0; n<fwd.size(); n++) delete fwd[n];
+	for (size_t n=0; n<bwd.size(); n++) delete bwd[n];
+
+	if (support) {
+		// the result is zero outside of the computed tiles, only those need to be checked
+		support->clear();
+		for (size_t n=0; n<orig.size(); n++) {
+			if (sparse) support->activateNonZero(*orig[n], mask);
+			else        support->activateNonZero(*orig[n]);
+		}
+		support->update();
+	}
+}
+
+//! Real grids of a list of python objects for the multi-grid advection
+static std::vector<Grid<Real>*> getAdvectGridsMulti(const std::vector<PbClass*>& grids) {
+	std::vector<Grid<Real>*> orig;
+	for (size_t n=0; n<grids.size(); n++) {
+		GridBase* grid = dynamic_cast<GridBase*>(grids[n]);
+		if (!grid || !(grid->getType() & GridBase::TypeReal))
+			errMsg("AdvectSemiLagrangeMulti: Grid Type is not supported (only Real, Levelset)");
+		orig.push_back((Grid<Real>*) grid);
+	}
+	return orig;
+}
+
 //! Perform semi-lagrangian advection of target Real- or Vec3 grid
 //! Open boundary handling needs information about width of border
 //! Clamping modes: 1 regular clamp leading to more overshoot and sharper results, 2 revert to 1st order slightly smoother less overshoot (enable when 1 gives artifacts)
@@ -519,19 +735,57 @@ void advectSemiLagrange(const FlagGrid* flags, const MACGrid* vel, GridBase* gri
 	assertMsg(order==1 || order==2, "AdvectSemiLagrange: Only order 1 (regular SL) and 2 (MacCormack) supported");
 	
 	// determine type of grid    
-	if (grid->getType() & GridBase::TypeReal) {
+	if (grid->getType() & GridBase::TypeLevelset) {
 		fnAdvectSemiLagrange< Grid<Real> >(flags->getParent(), *flags, *vel, *((Grid<Real>*) grid), order, strength, orderSpace, openBounds, boundaryWidth, clampMode);
 	}
+	else if (grid->getType() & GridBase::TypeReal) {
+		// same result as fnAdvectSemiLagrange, but can skip empty regions
+		std::vector<Grid<Real>*> grids(1, (Grid<Real>*) grid);
+		fnAdvectSemiLagrangeMulti(flags->getParent(), *flags, *vel, grids, order, strength, orderSpace, clampMode);
+	}
 	else if (grid->getType() & GridBase::TypeMAC) {    
 		fnAdvectSemiLagrange< MACGrid >(flags->getParent(), *flags, *vel, *((MACGrid*) grid), order, strength, orderSpace, openBounds, boundaryWidth, clampMode);
 	}
 	else if (grid->getType() & GridBase::TypeVec3) {    
 		fnAdvectSemiLagrange< Grid<Vec3> >(flags->getParent(), *flags, *vel, *((Grid<Vec3>*) grid), order, strength, orderSpace, openBounds, boundaryWidth, clampMode);
 	}
+	else if (grid->getType() & GridBase::TypeHalf) {
+		// half precision storage, computations are done in full precision
+		fnAdvectSemiLagrange< Grid<Half> >(flags->getParent(), *flags, *vel, *((Grid<Half>*) grid), order, strength, orderSpace, openBounds, boundaryWidth, clampMode);
+	}
 	else
-		errMsg("AdvectSemiLagrange: Grid Type is not supported (only Real, Vec3, MAC, Levelset)");    
+		errMsg("AdvectSemiLagrange: Grid Type is not supported (only Real, Half, Vec3, MAC, Levelset)");    
 } static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "advectSemiLagrange" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const FlagGrid* flags = _args.getPtr<FlagGrid >("flags",0,&_lock); const MACGrid* vel = _args.getPtr<MACGrid >("vel",1,&_lock); GridBase* grid = _args.getPtr<GridBase >("grid",2,&_lock); int order = _args.getOpt<int >("order",3,1,&_lock); Real strength = _args.getOpt<Real >("strength",4,1.0,&_lock); int orderSpace = _args.getOpt<int >("orderSpace",5,1,&_lock); bool openBounds = _args.getOpt<bool >("openBounds",6,false,&_lock); int boundaryWidth = _args.getOpt<int >("boundaryWidth",7,1,&_lock); int clampMode = _args.getOpt<int >("clampMode",8,2,&_lock);   _retval = getPyNone(); advectSemiLagrange(flags,vel,grid,order,strength,orderSpace,openBounds,boundaryWidth,clampMode);  _args.check(); } pbFinalizePlugin(parent,"advectSemiLagrange", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("advectSemiLagrange",e.what()); return 0; } } static const Pb::Register _RP_advectSemiLagrange ("","advectSemiLagrange",_W_1);  extern "C" { void PbRegister_advectSemiLagrange() { KEEP_UNUSED(_RP_advectSemiLagrange); } } 
 
+
+//! Perform semi-lagrangian advection of a list of Real grids (incl. levelsets) with the same velocity
+//! Back-traces each cell once for all grids, also for the MacCormack forward/backward passes
+//! Same parameters as advectSemiLagrange, open boundaries only affect MAC grids and are thus not needed here
+
+
+void advectSemiLagrangeMulti(const FlagGrid* flags, const MACGrid* vel, std::vector<PbClass*> grids, int order = 1, Real strength = 1.0, int orderSpace = 1, int clampMode = 2) {
+	assertMsg(order==1 || order==2, "AdvectSemiLagrangeMulti: Only order 1 (regular SL) and 2 (MacCormack) supported");
+
+	std::vector<Grid<Real>*> orig = getAdvectGridsMulti(grids);
+	if (orig.empty())
+		return;
+
+	fnAdvectSemiLagrangeMulti(flags->getParent(), *flags, *vel, orig, order, strength, orderSpace, clampMode);
+} static PyObject* _W_2 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "advectSemiLagrangeMulti" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const FlagGrid* flags = _args.getPtr<FlagGrid >("flags",0,&_lock); const MACGrid* vel = _args.getPtr<MACGrid >("vel",1,&_lock); std::vector<PbClass*> grids = _args.get<std::vector<PbClass*> >("grids",2,&_lock); int order = _args.getOpt<int >("order",3,1,&_lock); Real strength = _args.getOpt<Real >("strength",4,1.0,&_lock); int orderSpace = _args.getOpt<int >("orderSpace",5,1,&_lock); int clampMode = _args.getOpt<int >("clampMode",6,2,&_lock);   _retval = getPyNone(); advectSemiLagrangeMulti(flags,vel,grids,order,strength,orderSpace,clampMode);  _args.check(); } pbFinalizePlugin(parent,"advectSemiLagrangeMulti", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("advectSemiLagrangeMulti",e.what()); return 0; } } static const Pb::Register _RP_advectSemiLagrangeMulti ("","advectSemiLagrangeMulti",_W_2);  extern "C" { void PbRegister_advectSemiLagrangeMulti() { KEEP_UNUSED(_RP_advectSemiLagrangeMulti); } } 
+
+//! Same as advectSemiLagrangeMulti, for callers that keep track of the non-zero tiles of the grids across steps
+//! On entry support needs to hold the tiles returned by the last call plus all regions written since then,
+//! on return it holds the tiles of the advected grids. Skips scanning the whole domain for non-zero values
+void advectSemiLagrangeMultiTracked(const FlagGrid* flags, const MACGrid* vel, std::vector<PbClass*> grids, TileMask& support, int order, Real strength, int orderSpace, int clampMode) {
+	assertMsg(order==1 || order==2, "AdvectSemiLagrangeMulti: Only order 1 (regular SL) and 2 (MacCormack) supported");
+
+	std::vector<Grid<Real>*> orig = getAdvectGridsMulti(grids);
+	if (orig.empty())
+		return;
+
+	fnAdvectSemiLagrangeMulti(flags->getParent(), *flags, *vel, orig, order, strength, orderSpace, clampMode, &support);
+}
+
 } // end namespace DDF 
 
 
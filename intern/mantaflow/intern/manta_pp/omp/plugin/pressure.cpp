@@ -26,6 +26,8 @@
 #include "kernel.h"
 #include "conjugategrad.h"
 #include "multigrid.h"
+#include "timing.h"
+#include "tilemask.h"
 
 using namespace std;
 namespace Manta {
@@ -33,10 +35,23 @@ namespace Manta {
 //! Preconditioner for CG solver
 // - None: Use standard CG
 // - MIC: Modified incomplete Cholesky preconditioner
+// - MICWavefront: same as MIC, but factorization and substitutions run
+//       in parallel along wavefronts of grid rows (identical results)
 // - MGDynamic: Multigrid preconditioner, rebuilt for each solve
 // - MGStatic: Multigrid preconditioner, built only once (faster than
 //       MGDynamic, but works only if Poisson equation does not change)
-enum Preconditioner { PcNone = 0, PcMIC = 1, PcMGDynamic = 2, PcMGStatic = 3 };
+enum Preconditioner { PcNone = 0, PcMIC = 1, PcMGDynamic = 2, PcMGStatic = 3, PcMICWavefront = 4 };
+
+static const char* preconditionerName(int preconditioner) {
+	switch (preconditioner) {
+		case PcNone:         return "none";
+		case PcMIC:          return "MIC";
+		case PcMGDynamic:    return "MG dynamic";
+		case PcMGStatic:     return "MG static";
+		case PcMICWavefront: return "MIC wavefront";
+		default:             return "unknown";
+	}
+}
 
 inline static Real surfTensHelper(const IndexInt idx, const int offset, const Grid<Real> &phi, const Grid<Real> &curv, const Real surfTens, const Real gfClamp);
 
@@ -173,10 +188,8 @@ inline static Real surfTensHelper(const IndexInt idx, const int offset, const Gr
 	return surfTens*(curv[idx+offset] - ghostFluidHelper(idx, offset, phi, gfClamp) * curv[idx]);
 }
 
-//! Kernel: Adapt A0 for ghost fluid
-
-
- struct ApplyGhostFluidDiagonal : public KernelBase { ApplyGhostFluidDiagonal(Grid<Real> &A0, const FlagGrid &flags, const Grid<Real> &phi, Real gfClamp) :  KernelBase(&A0,1) ,A0(A0),flags(flags),phi(phi),gfClamp(gfClamp)   { runMessage(); run(); }  inline void op(int i, int j, int k, Grid<Real> &A0, const FlagGrid &flags, const Grid<Real> &phi, Real gfClamp )  {
+//! Ghost fluid diagonal of a single cell, see ApplyGhostFluidDiagonal
+inline static void applyGhostFluidDiagonalCell(int i, int j, int k, Grid<Real> &A0, const FlagGrid &flags, const Grid<Real> &phi, Real gfClamp) {
 	const int X = flags.getStrideX(), Y = flags.getStrideY(), Z = flags.getStrideZ();
 	IndexInt idx = flags.index(i,j,k);
 	if (!flags.isFluid(idx)) return;
@@ -189,6 +202,13 @@ inline static Real surfTensHelper(const IndexInt idx, const int offset, const Gr
 		if (flags.isEmpty(i,j,k-1)) A0[idx] -= ghostFluidHelper(idx, -Z, phi, gfClamp);
 		if (flags.isEmpty(i,j,k+1)) A0[idx] -= ghostFluidHelper(idx, +Z, phi, gfClamp);
 	}
+}
+
+//! Kernel: Adapt A0 for ghost fluid
+
+
+ struct ApplyGhostFluidDiagonal : public KernelBase { ApplyGhostFluidDiagonal(Grid<Real> &A0, const FlagGrid &flags, const Grid<Real> &phi, Real gfClamp) :  KernelBase(&A0,1) ,A0(A0),flags(flags),phi(phi),gfClamp(gfClamp)   { runMessage(); run(); }  inline void op(int i, int j, int k, Grid<Real> &A0, const FlagGrid &flags, const Grid<Real> &phi, Real gfClamp )  {
+	applyGhostFluidDiagonalCell(i,j,k, A0, flags, phi, gfClamp);
 }   inline Grid<Real> & getArg0() { return A0; } typedef Grid<Real>  type0;inline const FlagGrid& getArg1() { return flags; } typedef FlagGrid type1;inline const Grid<Real> & getArg2() { return phi; } typedef Grid<Real>  type2;inline Real& getArg3() { return gfClamp; } typedef Real type3; void runMessage() { debMsg("Executing kernel ApplyGhostFluidDiagonal ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ > 1) { 
 #pragma omp parallel 
  {  
@@ -202,6 +222,32 @@ inline static Real surfTensHelper(const IndexInt idx, const int offset, const Gr
 
 
 
+//! Kernel: MakeLaplaceMatrix, restricted to active tiles
+
+
+ struct MakeLaplaceMatrixTiles : public KernelBase { MakeLaplaceMatrixTiles(const TileMask& mask, const FlagGrid& flags, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, const MACGrid* fractions) :  KernelBase(mask.numActive()) ,mask(mask),flags(flags),A0(A0),Ai(Ai),Aj(Aj),Ak(Ak),fractions(fractions)   { runMessage(); run(); }   inline void op(IndexInt idx, const TileMask& mask, const FlagGrid& flags, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, const MACGrid* fractions ) {
+	FOR_TILE_IJK_BND(mask, idx, 1) {
+		makeLaplaceMatrixCell(i,j,k, flags, A0, Ai, Aj, Ak, fractions);
+	}
+}    inline const TileMask& getArg0() { return mask; } typedef TileMask type0;inline const FlagGrid& getArg1() { return flags; } typedef FlagGrid type1;inline Grid<Real>& getArg2() { return A0; } typedef Grid<Real> type2;inline Grid<Real>& getArg3() { return Ai; } typedef Grid<Real> type3;inline Grid<Real>& getArg4() { return Aj; } typedef Grid<Real> type4;inline Grid<Real>& getArg5() { return Ak; } typedef Grid<Real> type5;inline const MACGrid* getArg6() { return fractions; } typedef MACGrid type6; void runMessage() { debMsg("Executing kernel MakeLaplaceMatrixTiles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,mask,flags,A0,Ai,Aj,Ak,fractions);  }   } const TileMask& mask; const FlagGrid& flags; Grid<Real>& A0; Grid<Real>& Ai; Grid<Real>& Aj; Grid<Real>& Ak; const MACGrid* fractions;   };
+
+//! Kernel: ApplyGhostFluidDiagonal, restricted to active tiles
+
+
+ struct ApplyGhostFluidDiagonalTiles : public KernelBase { ApplyGhostFluidDiagonalTiles(const TileMask& mask, Grid<Real>& A0, const FlagGrid& flags, const Grid<Real>& phi, Real gfClamp) :  KernelBase(mask.numActive()) ,mask(mask),A0(A0),flags(flags),phi(phi),gfClamp(gfClamp)   { runMessage(); run(); }   inline void op(IndexInt idx, const TileMask& mask, Grid<Real>& A0, const FlagGrid& flags, const Grid<Real>& phi, Real gfClamp ) {
+	FOR_TILE_IJK_BND(mask, idx, 1) {
+		applyGhostFluidDiagonalCell(i,j,k, A0, flags, phi, gfClamp);
+	}
+}    inline const TileMask& getArg0() { return mask; } typedef TileMask type0;inline Grid<Real>& getArg1() { return A0; } typedef Grid<Real> type1;inline const FlagGrid& getArg2() { return flags; } typedef FlagGrid type2;inline const Grid<Real>& getArg3() { return phi; } typedef Grid<Real> type3;inline Real& getArg4() { return gfClamp; } typedef Real type4; void runMessage() { debMsg("Executing kernel ApplyGhostFluidDiagonalTiles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,mask,A0,flags,phi,gfClamp);  }   } const TileMask& mask; Grid<Real>& A0; const FlagGrid& flags; const Grid<Real>& phi; Real gfClamp;   };
+
 //! Kernel: Apply velocity update: ghost fluid contribution
 
 
@@ -398,7 +444,7 @@ void computePressureRhs(Grid<Real>& rhs, const MACGrid& vel, const Grid<Real>& p
 //! fractions: for 2nd order obstacle boundaries, optional
 //! gfClamp: clamping threshold for ghost fluid method
 //! cgMaxIterFac: heuristic to determine maximal number of CG iteations, increase for more accurate solutions
-//! preconditioner: MIC, or MG (see Preconditioner enum)
+//! preconditioner: MIC, MIC wavefront, or MG (see Preconditioner enum)
 //! useL2Norm: use max norm by default, can be turned to L2 here
 //! zeroPressureFixing: remove null space by fixing a single pressure value, needed for MG 
 //! curv: curvature for surface tension effects
@@ -418,8 +464,10 @@ void computePressureRhs(Grid<Real>& rhs, const MACGrid& vel, const Grid<Real>& p
 
 
 
-void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, const FlagGrid& flags, Real cgAccuracy = 1e-3, const Grid<Real>* phi = 0, const Grid<Real>* perCellCorr = 0, const MACGrid* fractions = 0, Real gfClamp = 1e-04, Real cgMaxIterFac = 1.5, bool precondition = true, int preconditioner = PcMIC, bool enforceCompatibility = false, bool useL2Norm = false, bool zeroPressureFixing = false, const Grid<Real> *curv = NULL, const Real surfTens = 0.) {
+void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, const FlagGrid& flags, Real cgAccuracy = 1e-3, const Grid<Real>* phi = 0, const Grid<Real>* perCellCorr = 0, const MACGrid* fractions = 0, Real gfClamp = 1e-04, Real cgMaxIterFac = 1.5, bool precondition = true, int preconditioner = PcMIC, bool enforceCompatibility = false, bool useL2Norm = false, bool zeroPressureFixing = false, const Grid<Real> *curv = NULL, const Real surfTens = 0., bool packedMatrix = false) {
 	if (precondition==false) preconditioner = PcNone; // for backwards compatibility
+	if (preconditioner < PcNone || preconditioner > PcMICWavefront)
+		errMsg("solvePressure: unknown preconditioner " << preconditioner);
 
 	// reserve temp grids
 	FluidSolver* parent = flags.getParent();
@@ -431,11 +479,16 @@ void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, co
 	Grid<Real> Ak(parent);
 	Grid<Real> tmp(parent);
 		
-	// setup matrix and boundaries 
-	MakeLaplaceMatrix(flags, A0, Ai, Aj, Ak, fractions);
-
-	if (phi) {
-		ApplyGhostFluidDiagonal(A0, flags, *phi, gfClamp);
+	// setup matrix and boundaries, only fluid cells have non-zero entries
+	TileMask mask(flags);
+	mask.activateType(flags, FlagGrid::TypeFluid);
+	mask.update();
+	if (mask.useSparse()) {
+		MakeLaplaceMatrixTiles(mask, flags, A0, Ai, Aj, Ak, fractions);
+		if (phi) ApplyGhostFluidDiagonalTiles(mask, A0, flags, *phi, gfClamp);
+	} else {
+		MakeLaplaceMatrix(flags, A0, Ai, Aj, Ak, fractions);
+		if (phi) ApplyGhostFluidDiagonal(A0, flags, *phi, gfClamp);
 	}
 	
 	// check whether we need to fix some pressure value...
@@ -492,6 +545,7 @@ void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, co
 	
 	gcg->setAccuracy( cgAccuracy ); 
 	gcg->setUseL2Norm( useL2Norm );
+	gcg->setPackedMatrix( packedMatrix );
 
 	int maxIter = 0;
 	
@@ -499,7 +553,7 @@ void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, co
 	GridMg* pmg = nullptr;
 
 	// optional preconditioning	
-	if (preconditioner == PcNone || preconditioner == PcMIC) {			
+	if (preconditioner == PcNone || preconditioner == PcMIC || preconditioner == PcMICWavefront) {			
 		maxIter = (int)(cgMaxIterFac * flags.getSize().max()) * (flags.is3D() ? 1 : 4);
 
 		pca0 = new Grid<Real>(parent);
@@ -507,8 +561,10 @@ void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, co
 		pca2 = new Grid<Real>(parent);
 		pca3 = new Grid<Real>(parent);
 
-		gcg->setICPreconditioner( preconditioner == PcMIC ? GridCgInterface::PC_mICP : GridCgInterface::PC_None, 
-			pca0, pca1, pca2, pca3);
+		GridCgInterface::PreconditionType pcMethod = GridCgInterface::PC_None;
+		if (preconditioner == PcMIC)          pcMethod = GridCgInterface::PC_mICP;
+		if (preconditioner == PcMICWavefront) pcMethod = GridCgInterface::PC_mICPWavefront;
+		gcg->setICPreconditioner(pcMethod, pca0, pca1, pca2, pca3);
 	} else if (preconditioner == PcMGDynamic || preconditioner == PcMGStatic) {
 		maxIter = 100;
 
@@ -518,6 +574,12 @@ void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, co
 			gMapMG[parent] = pmg;
 		}
 
+		// PcMGDynamic: A changes between solves, update the kept hierarchy where needed
+		if (preconditioner == PcMGDynamic) {
+			pmg->setReuseHierarchy(true);
+			pmg->invalidateA();
+		}
+
 		gcg->setMGPreconditioner( GridCgInterface::PC_MGP, pmg);
 	}
 
@@ -526,7 +588,9 @@ void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, co
 		if (!gcg->iterate()) iter=maxIter;
 		debMsg("FluidSolver::solvePressure iteration "<<iter<<", residual: "<<gcg->getResNorm(), 9);
 	} 
-	debMsg("FluidSolver::solvePressure iterations:"<<gcg->getIterations()<<", residual:"<<gcg->getResNorm(), 2);
+	debMsg("FluidSolver::solvePressure iterations:"<<gcg->getIterations()<<", residual:"<<gcg->getResNorm()<<", preconditioner:"<<preconditionerName(preconditioner)<<(gcg->getResNorm()<cgAccuracy ? "" : " (not converged)"), 2);
+	TimingData::instance().addCounter("cgIterations", gcg->getIterations());
+	TimingData::instance().setCounter("cgResidual", gcg->getResNorm());
 
 	// Cleanup
 	if (gcg)  delete gcg;
@@ -535,10 +599,9 @@ void solvePressureSystem(Grid<Real>& rhs, MACGrid& vel, Grid<Real>& pressure, co
 	if (pca2) delete pca2;
 	if (pca3) delete pca3;
 
-	// PcMGDynamic: always delete multigrid solver after use
-	// PcMGStatic: keep multigrid solver for next solve
-	if (pmg && preconditioner==PcMGDynamic) releaseMG(parent);
-} static PyObject* _W_2 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "solvePressureSystem" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Real>& rhs = *_args.getPtr<Grid<Real> >("rhs",0,&_lock); MACGrid& vel = *_args.getPtr<MACGrid >("vel",1,&_lock); Grid<Real>& pressure = *_args.getPtr<Grid<Real> >("pressure",2,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",3,&_lock); Real cgAccuracy = _args.getOpt<Real >("cgAccuracy",4,1e-3,&_lock); const Grid<Real>* phi = _args.getPtrOpt<Grid<Real> >("phi",5,0,&_lock); const Grid<Real>* perCellCorr = _args.getPtrOpt<Grid<Real> >("perCellCorr",6,0,&_lock); const MACGrid* fractions = _args.getPtrOpt<MACGrid >("fractions",7,0,&_lock); Real gfClamp = _args.getOpt<Real >("gfClamp",8,1e-04,&_lock); Real cgMaxIterFac = _args.getOpt<Real >("cgMaxIterFac",9,1.5,&_lock); bool precondition = _args.getOpt<bool >("precondition",10,true,&_lock); int preconditioner = _args.getOpt<int >("preconditioner",11,PcMIC,&_lock); bool enforceCompatibility = _args.getOpt<bool >("enforceCompatibility",12,false,&_lock); bool useL2Norm = _args.getOpt<bool >("useL2Norm",13,false,&_lock); bool zeroPressureFixing = _args.getOpt<bool >("zeroPressureFixing",14,false,&_lock); const Grid<Real> * curv = _args.getPtrOpt<Grid<Real>  >("curv",15,NULL,&_lock); const Real surfTens = _args.getOpt<Real >("surfTens",16,0.,&_lock);   _retval = getPyNone(); solvePressureSystem(rhs,vel,pressure,flags,cgAccuracy,phi,perCellCorr,fractions,gfClamp,cgMaxIterFac,precondition,preconditioner,enforceCompatibility,useL2Norm,zeroPressureFixing,curv,surfTens);  _args.check(); } pbFinalizePlugin(parent,"solvePressureSystem", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("solvePressureSystem",e.what()); return 0; } } static const Pb::Register _RP_solvePressureSystem ("","solvePressureSystem",_W_2);  extern "C" { void PbRegister_solvePressureSystem() { KEEP_UNUSED(_RP_solvePressureSystem); } } 
+	// PcMGDynamic and PcMGStatic: keep multigrid solver for next solve,
+	// release it with releaseMG
+} static PyObject* _W_2 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "solvePressureSystem" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Real>& rhs = *_args.getPtr<Grid<Real> >("rhs",0,&_lock); MACGrid& vel = *_args.getPtr<MACGrid >("vel",1,&_lock); Grid<Real>& pressure = *_args.getPtr<Grid<Real> >("pressure",2,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",3,&_lock); Real cgAccuracy = _args.getOpt<Real >("cgAccuracy",4,1e-3,&_lock); const Grid<Real>* phi = _args.getPtrOpt<Grid<Real> >("phi",5,0,&_lock); const Grid<Real>* perCellCorr = _args.getPtrOpt<Grid<Real> >("perCellCorr",6,0,&_lock); const MACGrid* fractions = _args.getPtrOpt<MACGrid >("fractions",7,0,&_lock); Real gfClamp = _args.getOpt<Real >("gfClamp",8,1e-04,&_lock); Real cgMaxIterFac = _args.getOpt<Real >("cgMaxIterFac",9,1.5,&_lock); bool precondition = _args.getOpt<bool >("precondition",10,true,&_lock); int preconditioner = _args.getOpt<int >("preconditioner",11,PcMIC,&_lock); bool enforceCompatibility = _args.getOpt<bool >("enforceCompatibility",12,false,&_lock); bool useL2Norm = _args.getOpt<bool >("useL2Norm",13,false,&_lock); bool zeroPressureFixing = _args.getOpt<bool >("zeroPressureFixing",14,false,&_lock); const Grid<Real> * curv = _args.getPtrOpt<Grid<Real>  >("curv",15,NULL,&_lock); const Real surfTens = _args.getOpt<Real >("surfTens",16,0.,&_lock); bool packedMatrix = _args.getOpt<bool >("packedMatrix",17,false,&_lock);   _retval = getPyNone(); solvePressureSystem(rhs,vel,pressure,flags,cgAccuracy,phi,perCellCorr,fractions,gfClamp,cgMaxIterFac,precondition,preconditioner,enforceCompatibility,useL2Norm,zeroPressureFixing,curv,surfTens,packedMatrix);  _args.check(); } pbFinalizePlugin(parent,"solvePressureSystem", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("solvePressureSystem",e.what()); return 0; } } static const Pb::Register _RP_solvePressureSystem ("","solvePressureSystem",_W_2);  extern "C" { void PbRegister_solvePressureSystem() { KEEP_UNUSED(_RP_solvePressureSystem); } } 
 
 //! Apply pressure gradient to make velocity field divergence free
 
@@ -579,7 +642,7 @@ void correctVelocity(MACGrid& vel, Grid<Real>& pressure, const FlagGrid& flags,
 
 
 
-void solvePressure(MACGrid& vel, Grid<Real>& pressure, const FlagGrid& flags, Real cgAccuracy = 1e-3, const Grid<Real>* phi = 0, const Grid<Real>* perCellCorr = 0, const MACGrid* fractions = 0, Real gfClamp = 1e-04, Real cgMaxIterFac = 1.5, bool precondition = true, int preconditioner = PcMIC, bool enforceCompatibility = false, bool useL2Norm = false, bool zeroPressureFixing = false, const Grid<Real> *curv = NULL, const Real surfTens = 0., Grid<Real>* retRhs = NULL ) {
+void solvePressure(MACGrid& vel, Grid<Real>& pressure, const FlagGrid& flags, Real cgAccuracy = 1e-3, const Grid<Real>* phi = 0, const Grid<Real>* perCellCorr = 0, const MACGrid* fractions = 0, Real gfClamp = 1e-04, Real cgMaxIterFac = 1.5, bool precondition = true, int preconditioner = PcMIC, bool enforceCompatibility = false, bool useL2Norm = false, bool zeroPressureFixing = false, const Grid<Real> *curv = NULL, const Real surfTens = 0., Grid<Real>* retRhs = NULL, bool packedMatrix = false ) {
 	Grid<Real> rhs(vel.getParent());
 
 	computePressureRhs(rhs, vel, pressure, flags, cgAccuracy,
@@ -590,7 +653,7 @@ void solvePressure(MACGrid& vel, Grid<Real>& pressure, const FlagGrid& flags, Re
 	solvePressureSystem(rhs, vel, pressure, flags, cgAccuracy,
 		phi, perCellCorr, fractions, gfClamp,
 		cgMaxIterFac, precondition, preconditioner, enforceCompatibility,
-		useL2Norm, zeroPressureFixing, curv, surfTens);
+		useL2Norm, zeroPressureFixing, curv, surfTens, packedMatrix);
 
 	correctVelocity(vel, pressure, flags, cgAccuracy,
 		phi, perCellCorr, fractions, gfClamp,
@@ -601,7 +664,7 @@ void solvePressure(MACGrid& vel, Grid<Real>& pressure, const FlagGrid& flags, Re
 	if(retRhs) {
 		retRhs->copyFrom( rhs );
 	}
-} static PyObject* _W_4 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "solvePressure" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; MACGrid& vel = *_args.getPtr<MACGrid >("vel",0,&_lock); Grid<Real>& pressure = *_args.getPtr<Grid<Real> >("pressure",1,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",2,&_lock); Real cgAccuracy = _args.getOpt<Real >("cgAccuracy",3,1e-3,&_lock); const Grid<Real>* phi = _args.getPtrOpt<Grid<Real> >("phi",4,0,&_lock); const Grid<Real>* perCellCorr = _args.getPtrOpt<Grid<Real> >("perCellCorr",5,0,&_lock); const MACGrid* fractions = _args.getPtrOpt<MACGrid >("fractions",6,0,&_lock); Real gfClamp = _args.getOpt<Real >("gfClamp",7,1e-04,&_lock); Real cgMaxIterFac = _args.getOpt<Real >("cgMaxIterFac",8,1.5,&_lock); bool precondition = _args.getOpt<bool >("precondition",9,true,&_lock); int preconditioner = _args.getOpt<int >("preconditioner",10,PcMIC,&_lock); bool enforceCompatibility = _args.getOpt<bool >("enforceCompatibility",11,false,&_lock); bool useL2Norm = _args.getOpt<bool >("useL2Norm",12,false,&_lock); bool zeroPressureFixing = _args.getOpt<bool >("zeroPressureFixing",13,false,&_lock); const Grid<Real> * curv = _args.getPtrOpt<Grid<Real>  >("curv",14,NULL,&_lock); const Real surfTens = _args.getOpt<Real >("surfTens",15,0.,&_lock); Grid<Real>* retRhs = _args.getPtrOpt<Grid<Real> >("retRhs",16,NULL ,&_lock);   _retval = getPyNone(); solvePressure(vel,pressure,flags,cgAccuracy,phi,perCellCorr,fractions,gfClamp,cgMaxIterFac,precondition,preconditioner,enforceCompatibility,useL2Norm,zeroPressureFixing,curv,surfTens,retRhs);  _args.check(); } pbFinalizePlugin(parent,"solvePressure", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("solvePressure",e.what()); return 0; } } static const Pb::Register _RP_solvePressure ("","solvePressure",_W_4);  extern "C" { void PbRegister_solvePressure() { KEEP_UNUSED(_RP_solvePressure); } } 
+} static PyObject* _W_4 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "solvePressure" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; MACGrid& vel = *_args.getPtr<MACGrid >("vel",0,&_lock); Grid<Real>& pressure = *_args.getPtr<Grid<Real> >("pressure",1,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",2,&_lock); Real cgAccuracy = _args.getOpt<Real >("cgAccuracy",3,1e-3,&_lock); const Grid<Real>* phi = _args.getPtrOpt<Grid<Real> >("phi",4,0,&_lock); const Grid<Real>* perCellCorr = _args.getPtrOpt<Grid<Real> >("perCellCorr",5,0,&_lock); const MACGrid* fractions = _args.getPtrOpt<MACGrid >("fractions",6,0,&_lock); Real gfClamp = _args.getOpt<Real >("gfClamp",7,1e-04,&_lock); Real cgMaxIterFac = _args.getOpt<Real >("cgMaxIterFac",8,1.5,&_lock); bool precondition = _args.getOpt<bool >("precondition",9,true,&_lock); int preconditioner = _args.getOpt<int >("preconditioner",10,PcMIC,&_lock); bool enforceCompatibility = _args.getOpt<bool >("enforceCompatibility",11,false,&_lock); bool useL2Norm = _args.getOpt<bool >("useL2Norm",12,false,&_lock); bool zeroPressureFixing = _args.getOpt<bool >("zeroPressureFixing",13,false,&_lock); const Grid<Real> * curv = _args.getPtrOpt<Grid<Real>  >("curv",14,NULL,&_lock); const Real surfTens = _args.getOpt<Real >("surfTens",15,0.,&_lock); Grid<Real>* retRhs = _args.getPtrOpt<Grid<Real> >("retRhs",16,NULL,&_lock); bool packedMatrix = _args.getOpt<bool >("packedMatrix",17,false ,&_lock);   _retval = getPyNone(); solvePressure(vel,pressure,flags,cgAccuracy,phi,perCellCorr,fractions,gfClamp,cgMaxIterFac,precondition,preconditioner,enforceCompatibility,useL2Norm,zeroPressureFixing,curv,surfTens,retRhs,packedMatrix);  _args.check(); } pbFinalizePlugin(parent,"solvePressure", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("solvePressure",e.what()); return 0; } } static const Pb::Register _RP_solvePressure ("","solvePressure",_W_4);  extern "C" { void PbRegister_solvePressure() { KEEP_UNUSED(_RP_solvePressure); } } 
 
 } // end namespace
 
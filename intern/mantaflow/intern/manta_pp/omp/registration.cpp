@@ -14,6 +14,8 @@ extern "C" {
 		extern void PbRegister_copyLevelsetToReal() ;
 		extern void PbRegister_copyVec3ToReal() ;
 		extern void PbRegister_copyRealToVec3() ;
+		extern void PbRegister_copyRealToHalf() ;
+		extern void PbRegister_copyHalfToReal() ;
 		extern void PbRegister_convertLevelsetToReal() ;
 		extern void PbRegister_swapComponents() ;
 		extern void PbRegister_getUvWeight() ;
@@ -42,8 +44,13 @@ extern "C" {
 		extern void PbRegister_printUniFileInfoString() ;
 		extern void PbRegister_quantizeGrid() ;
 		extern void PbRegister_quantizeGridVec3() ;
+		extern void PbRegister_loadUniRegion() ;
+		extern void PbRegister_setVDBOptions() ;
+		extern void PbRegister_saveGridsVDB() ;
+		extern void PbRegister_loadGridsVDB() ;
 		extern void PbRegister_resetPhiInObs() ;
 		extern void PbRegister_advectSemiLagrange() ;
+		extern void PbRegister_advectSemiLagrangeMulti() ;
 		extern void PbRegister_addGravity() ;
 		extern void PbRegister_addGravityNoScale() ;
 		extern void PbRegister_addBuoyancy() ;
@@ -66,6 +73,7 @@ extern "C" {
 		extern void PbRegister_adjustNumber() ;
 		extern void PbRegister_debugIntToReal() ;
 		extern void PbRegister_gridParticleIndex() ;
+		extern void PbRegister_reorderParticles() ;
 		extern void PbRegister_unionParticleLevelset() ;
 		extern void PbRegister_averagedParticleLevelset() ;
 		extern void PbRegister_improvedParticleLevelset() ;
@@ -134,6 +142,7 @@ extern "C" {
 		extern void PbRegister_updateSndParts() ;
 		extern void PbRegister_sampleSndParts() ;
 		extern void PbRegister_particleSurfaceTurbulence() ;
+		extern void PbRegister_releaseSurfaceTurbulence() ;
 		extern void PbRegister_debugCheckParts() ;
 		extern void PbRegister_markAsFixed() ;
 		extern void PbRegister_texcoordInflow() ;
@@ -159,6 +168,11 @@ extern "C" {
 		extern void PbRegister_totalSum() ;
 		extern void PbRegister_normalizeSumTo() ;
 		extern void PbRegister_cgSolveWE() ;
+		extern void PbRegister_setFileWriteThreads() ;
+		extern void PbRegister_flushFileWrites() ;
+		extern void PbRegister_savePlaybackCache() ;
+		extern void PbRegister_loadPlaybackCache() ;
+		extern void PbRegister_setPlaybackCacheSize() ;
 		extern void PbRegister_file_0();
 		extern void PbRegister_file_1();
 		extern void PbRegister_file_2();
@@ -201,6 +215,8 @@ namespace Pb {
 		PbRegister_copyLevelsetToReal() ;
 		PbRegister_copyVec3ToReal() ;
 		PbRegister_copyRealToVec3() ;
+		PbRegister_copyRealToHalf() ;
+		PbRegister_copyHalfToReal() ;
 		PbRegister_convertLevelsetToReal() ;
 		PbRegister_swapComponents() ;
 		PbRegister_getUvWeight() ;
@@ -229,8 +245,13 @@ namespace Pb {
 		PbRegister_printUniFileInfoString() ;
 		PbRegister_quantizeGrid() ;
 		PbRegister_quantizeGridVec3() ;
+		PbRegister_loadUniRegion() ;
+		PbRegister_setVDBOptions() ;
+		PbRegister_saveGridsVDB() ;
+		PbRegister_loadGridsVDB() ;
 		PbRegister_resetPhiInObs() ;
 		PbRegister_advectSemiLagrange() ;
+		PbRegister_advectSemiLagrangeMulti() ;
 		PbRegister_addGravity() ;
 		PbRegister_addGravityNoScale() ;
 		PbRegister_addBuoyancy() ;
@@ -253,6 +274,7 @@ namespace Pb {
 		PbRegister_adjustNumber() ;
 		PbRegister_debugIntToReal() ;
 		PbRegister_gridParticleIndex() ;
+		PbRegister_reorderParticles() ;
 		PbRegister_unionParticleLevelset() ;
 		PbRegister_averagedParticleLevelset() ;
 		PbRegister_improvedParticleLevelset() ;
@@ -321,6 +343,7 @@ namespace Pb {
 		PbRegister_updateSndParts() ;
 		PbRegister_sampleSndParts() ;
 		PbRegister_particleSurfaceTurbulence() ;
+		PbRegister_releaseSurfaceTurbulence() ;
 		PbRegister_debugCheckParts() ;
 		PbRegister_markAsFixed() ;
 		PbRegister_texcoordInflow() ;
@@ -346,6 +369,11 @@ namespace Pb {
 		PbRegister_totalSum() ;
 		PbRegister_normalizeSumTo() ;
 		PbRegister_cgSolveWE() ;
+		PbRegister_setFileWriteThreads() ;
+		PbRegister_flushFileWrites() ;
+		PbRegister_savePlaybackCache() ;
+		PbRegister_loadPlaybackCache() ;
+		PbRegister_setPlaybackCacheSize() ;
 		PbRegister_file_0();
 		PbRegister_file_1();
 		PbRegister_file_2();
@@ -21,46 +21,82 @@
 namespace Manta {
     
 enum IntegrationMode { IntEuler=0, IntRK2, IntRK4 };
-    
+
+// parallel stage updates. Only the start positions are copied (to a Vec3 array), positions are
+// updated in place in the point structs
+
+template <class S>   struct knGetPointPos : public KernelBase { knGetPointPos(const std::vector<S>& x, std::vector<Vec3>& x0) :  KernelBase(x.size()) ,x(x),x0(x0)   { runMessage(); run(); }   inline void op(IndexInt idx, const std::vector<S>& x, std::vector<Vec3>& x0 ) {
+	x0[idx] = x[idx].pos;
+}    inline const std::vector<S>& getArg0() { return x; } typedef std::vector<S> type0;inline std::vector<Vec3>& getArg1() { return x0; } typedef std::vector<Vec3> type1; void runMessage() { debMsg("Executing kernel knGetPointPos ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,x,x0);  }   } const std::vector<S>& x; std::vector<Vec3>& x0;   };
+
+template <class S>   struct knSetPointPos : public KernelBase { knSetPointPos(std::vector<S>& x, const std::vector<Vec3>& x0, const std::vector<Vec3>& u, const Real factor) :  KernelBase(x.size()) ,x(x),x0(x0),u(u),factor(factor)   { runMessage(); run(); }   inline void op(IndexInt idx, std::vector<S>& x, const std::vector<Vec3>& x0, const std::vector<Vec3>& u, const Real factor ) {
+	x[idx].pos = x0[idx] + factor * u[idx];
+}    inline std::vector<S>& getArg0() { return x; } typedef std::vector<S> type0;inline const std::vector<Vec3>& getArg1() { return x0; } typedef std::vector<Vec3> type1;inline const std::vector<Vec3>& getArg2() { return u; } typedef std::vector<Vec3> type2;inline const Real& getArg3() { return factor; } typedef Real type3; void runMessage() { debMsg("Executing kernel knSetPointPos ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,x,x0,u,factor);  }   } std::vector<S>& x; const std::vector<Vec3>& x0; const std::vector<Vec3>& u; const Real factor;   };
+
+template <class S>   struct knAddPointPos : public KernelBase { knAddPointPos(std::vector<S>& x, const std::vector<Vec3>& u) :  KernelBase(x.size()) ,x(x),u(u)   { runMessage(); run(); }   inline void op(IndexInt idx, std::vector<S>& x, const std::vector<Vec3>& u ) {
+	x[idx].pos += u[idx];
+}    inline std::vector<S>& getArg0() { return x; } typedef std::vector<S> type0;inline const std::vector<Vec3>& getArg1() { return u; } typedef std::vector<Vec3> type1; void runMessage() { debMsg("Executing kernel knAddPointPos ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,x,u);  }   } std::vector<S>& x; const std::vector<Vec3>& u;   };
+
+ struct knAccumulateVel : public KernelBase { knAccumulateVel(std::vector<Vec3>& uTotal, const std::vector<Vec3>& u, const Real factor) :  KernelBase(u.size()) ,uTotal(uTotal),u(u),factor(factor)   { runMessage(); run(); }   inline void op(IndexInt idx, std::vector<Vec3>& uTotal, const std::vector<Vec3>& u, const Real factor ) {
+	uTotal[idx] += factor * u[idx];
+}    inline std::vector<Vec3>& getArg0() { return uTotal; } typedef std::vector<Vec3> type0;inline const std::vector<Vec3>& getArg1() { return u; } typedef std::vector<Vec3> type1;inline const Real& getArg2() { return factor; } typedef Real type2; void runMessage() { debMsg("Executing kernel knAccumulateVel ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; 
+#pragma omp parallel 
+ {  
+#pragma omp for  
+  for (IndexInt i = 0; i < _sz; i++) op(i,uTotal,u,factor);  }   } std::vector<Vec3>& uTotal; const std::vector<Vec3>& u; const Real factor;   };
+
+
 //! Integrate a particle set with a given velocity kernel
 template<class VelKernel>
 void integratePointSet(VelKernel& k, int mode) {
     typedef typename VelKernel::type0 PosType;
+    typedef typename PosType::value_type PointType;
     PosType& x = k.getArg0();
     const std::vector<Vec3>& u = k.getRet();
-    const int N = x.size();
         
     if (mode == IntEuler) {
-        for(int i=0; i<N; i++) x[i].pos += u[i];
+        knAddPointPos<PointType>(x, u);
     } 
     else if (mode == IntRK2) {
-        PosType x0(x);
+        // only keep the start positions, not the whole point data
+        std::vector<Vec3> x0(x.size());
+        knGetPointPos<PointType>(x, x0);
         
-        for(int i=0; i<N; i++) x[i].pos = x0[i].pos + 0.5*u[i];
+        knSetPointPos<PointType>(x, x0, u, 0.5);
         
         k.run();
-        for(int i=0; i<N; i++) x[i].pos = x0[i].pos + u[i];
+        knSetPointPos<PointType>(x, x0, u, 1.);
     } 
     else if (mode == IntRK4) {
-        PosType x0(x);
+        std::vector<Vec3> x0(x.size());
+        knGetPointPos<PointType>(x, x0);
         std::vector<Vec3> uTotal(u);
         
-        for(int i=0; i<N; i++) x[i].pos = x0[i].pos + 0.5*u[i];
+        knSetPointPos<PointType>(x, x0, u, 0.5);
         
         k.run();
-        for(int i=0; i<N; i++) {
-            x[i].pos = x0[i].pos + 0.5*u[i];
-            uTotal[i] += 2*u[i];
-        }
+        knSetPointPos<PointType>(x, x0, u, 0.5);
+        knAccumulateVel(uTotal, u, 2.);
         
         k.run();
-        for(int i=0; i<N; i++) {
-            x[i].pos = x0[i].pos + u[i];
-            uTotal[i] += 2*u[i];
-        }
+        knSetPointPos<PointType>(x, x0, u, 1.);
+        knAccumulateVel(uTotal, u, 2.);
         
         k.run();
-        for(int i=0; i<N; i++) x[i].pos = x0[i].pos + (Real)(1./6.) * (uTotal[i] + u[i]);
+        knAccumulateVel(uTotal, u, 1.);
+        knSetPointPos<PointType>(x, x0, uTotal, (Real)(1./6.));
     }
     else 
         errMsg("unknown integration type");
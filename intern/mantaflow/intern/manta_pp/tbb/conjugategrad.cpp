@@ -23,8 +23,10 @@
  *
  ******************************************************************************/
 
+#include <type_traits>
 #include "conjugategrad.h"
 #include "commonkernels.h"
+#include "timing.h"
 
 using namespace std;
 namespace Manta {
@@ -74,6 +76,60 @@ void InitPreconditionIncompCholesky(const FlagGrid& flags,
 	InvertCheckFluid (flags, A0);
 };
 
+//! Modified IC factorization of a single cell, see InitPreconditionModifiedIncompCholesky2
+inline static void modifiedIncompCholeskyCell(int i, int j, int k, const FlagGrid& flags,
+				Grid<Real>&Aprecond, 
+				Grid<Real>&A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak)
+{
+	if (!flags.isFluid(i,j,k)) return;
+
+	const Real tau = 0.97;
+	const Real sigma = 0.25;
+		
+	// compute modified incomplete cholesky
+	Real e = 0.;
+	e = A0(i,j,k) 
+		- square(Ai(i-1,j,k) * Aprecond(i-1,j,k) )
+		- square(Aj(i,j-1,k) * Aprecond(i,j-1,k) )
+		- square(Ak(i,j,k-1) * Aprecond(i,j,k-1) ) ;
+	e -= tau * (
+			Ai(i-1,j,k) * ( Aj(i-1,j,k) + Ak(i-1,j,k) )* square( Aprecond(i-1,j,k) ) +
+			Aj(i,j-1,k) * ( Ai(i,j-1,k) + Ak(i,j-1,k) )* square( Aprecond(i,j-1,k) ) +
+			Ak(i,j,k-1) * ( Ai(i,j,k-1) + Aj(i,j,k-1) )* square( Aprecond(i,j,k-1) ) +
+			0. );
+
+	// stability cutoff
+	if(e < sigma * A0(i,j,k))
+		e = A0(i,j,k);
+
+	Aprecond(i,j,k) = 1. / sqrt( e );
+}
+
+//! mICP forward substitution of a single cell, needs cells (i-1,j,k), (i,j-1,k), (i,j,k-1) first
+inline static void modifiedIncompCholeskyForwardCell(int i, int j, int k, Grid<Real>& dst, Grid<Real>& Var1, const FlagGrid& flags,
+				Grid<Real>& Aprecond, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak)
+{
+	if (!flags.isFluid(i,j,k)) return;
+	const Real p = Aprecond(i,j,k);
+	dst(i,j,k) = p * (Var1(i,j,k)
+			 - dst(i-1,j,k) * Ai(i-1,j,k) * Aprecond(i-1,j,k)
+			 - dst(i,j-1,k) * Aj(i,j-1,k) * Aprecond(i,j-1,k)
+			 - dst(i,j,k-1) * Ak(i,j,k-1) * Aprecond(i,j,k-1) );
+}
+
+//! mICP backward substitution of a single cell, needs cells (i+1,j,k), (i,j+1,k), (i,j,k+1) first
+inline static void modifiedIncompCholeskyBackwardCell(int i, int j, int k, Grid<Real>& dst, const FlagGrid& flags,
+				Grid<Real>& Aprecond, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak)
+{
+	const IndexInt idx = Aprecond.index(i,j,k);
+	if (!flags.isFluid(idx)) return;
+	const Real p = Aprecond[idx];
+	dst[idx] = p * ( dst[idx] 
+		   - dst(i+1,j,k) * Ai[idx] * p
+		   - dst(i,j+1,k) * Aj[idx] * p
+		   - dst(i,j,k+1) * Ak[idx] * p);
+}
+
 //! Preconditioning using modified IC ala Bridson (needs 1 add. grid)
 void InitPreconditionModifiedIncompCholesky2(const FlagGrid& flags,
 				Grid<Real>&Aprecond, 
@@ -83,28 +139,7 @@ void InitPreconditionModifiedIncompCholesky2(const FlagGrid& flags,
 	Aprecond.clear();
 	
 	FOR_IJK(flags) {
-		if (!flags.isFluid(i,j,k)) continue;
-
-		const Real tau = 0.97;
-		const Real sigma = 0.25;
-			
-		// compute modified incomplete cholesky
-		Real e = 0.;
-		e = A0(i,j,k) 
-			- square(Ai(i-1,j,k) * Aprecond(i-1,j,k) )
-			- square(Aj(i,j-1,k) * Aprecond(i,j-1,k) )
-			- square(Ak(i,j,k-1) * Aprecond(i,j,k-1) ) ;
-		e -= tau * (
-				Ai(i-1,j,k) * ( Aj(i-1,j,k) + Ak(i-1,j,k) )* square( Aprecond(i-1,j,k) ) +
-				Aj(i,j-1,k) * ( Ai(i,j-1,k) + Ak(i,j-1,k) )* square( Aprecond(i,j-1,k) ) +
-				Ak(i,j,k-1) * ( Ai(i,j,k-1) + Aj(i,j,k-1) )* square( Aprecond(i,j,k-1) ) +
-				0. );
-
-		// stability cutoff
-		if(e < sigma * A0(i,j,k))
-			e = A0(i,j,k);
-
-		Aprecond(i,j,k) = 1. / sqrt( e );
+		modifiedIncompCholeskyCell(i,j,k, flags, Aprecond, A0, Ai, Aj, Ak);
 	}
 };
 
@@ -150,23 +185,87 @@ void ApplyPreconditionModifiedIncompCholesky2(Grid<Real>& dst, Grid<Real>& Var1,
 {
 	// forward substitution        
 	FOR_IJK(dst) {
-		if (!flags.isFluid(i,j,k)) continue;
-		const Real p = Aprecond(i,j,k);
-		dst(i,j,k) = p * (Var1(i,j,k)
-				 - dst(i-1,j,k) * Ai(i-1,j,k) * Aprecond(i-1,j,k)
-				 - dst(i,j-1,k) * Aj(i,j-1,k) * Aprecond(i,j-1,k)
-				 - dst(i,j,k-1) * Ak(i,j,k-1) * Aprecond(i,j,k-1) );
+		modifiedIncompCholeskyForwardCell(i,j,k, dst, Var1, flags, Aprecond, Ai, Aj, Ak);
 	}
 	
 	// backward substitution
 	FOR_IJK_REVERSE(dst) {            
-		const IndexInt idx = A0.index(i,j,k);
-		if (!flags.isFluid(idx)) continue;
-		const Real p = Aprecond[idx];
-		dst[idx] = p * ( dst[idx] 
-			   - dst(i+1,j,k) * Ai[idx] * p
-			   - dst(i,j+1,k) * Aj[idx] * p
-			   - dst(i,j,k+1) * Ak[idx] * p);
+		modifiedIncompCholeskyBackwardCell(i,j,k, dst, flags, Aprecond, Ai, Aj, Ak);
+	}
+}
+
+//! Kernel: modified IC factorization for all rows (j,k) of one wavefront level, j+k == level
+
+
+ struct knMICInitWavefront : public KernelBase { knMICInitWavefront(const FlagGrid& flags, Grid<Real>& Aprecond, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, int level, int kStart, IndexInt numRows) :  KernelBase(numRows) ,flags(flags),Aprecond(Aprecond),A0(A0),Ai(Ai),Aj(Aj),Ak(Ak),level(level),kStart(kStart)   { runMessage(); run(); }   inline void op(IndexInt idx, const FlagGrid& flags, Grid<Real>& Aprecond, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, int level, int kStart ) const {
+	const int k = kStart + (int)idx;
+	const int j = level - k;
+	for (int i=0; i<flags.getSizeX(); i++)
+		modifiedIncompCholeskyCell(i,j,k, flags, Aprecond, A0, Ai, Aj, Ak);
+}    inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline Grid<Real>& getArg1() { return Aprecond; } typedef Grid<Real> type1;inline Grid<Real>& getArg2() { return A0; } typedef Grid<Real> type2;inline Grid<Real>& getArg3() { return Ai; } typedef Grid<Real> type3;inline Grid<Real>& getArg4() { return Aj; } typedef Grid<Real> type4;inline Grid<Real>& getArg5() { return Ak; } typedef Grid<Real> type5;inline int& getArg6() { return level; } typedef int type6;inline int& getArg7() { return kStart; } typedef int type7; void runMessage() { debMsg("Executing kernel knMICInitWavefront ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, flags,Aprecond,A0,Ai,Aj,Ak,level,kStart);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const FlagGrid& flags; Grid<Real>& Aprecond; Grid<Real>& A0; Grid<Real>& Ai; Grid<Real>& Aj; Grid<Real>& Ak; int level; int kStart;   };
+
+//! Kernel: mICP forward substitution for all rows of one wavefront level
+
+
+ struct knMICForwardWavefront : public KernelBase { knMICForwardWavefront(const FlagGrid& flags, Grid<Real>& dst, Grid<Real>& Var1, Grid<Real>& Aprecond, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, int level, int kStart, IndexInt numRows) :  KernelBase(numRows) ,flags(flags),dst(dst),Var1(Var1),Aprecond(Aprecond),Ai(Ai),Aj(Aj),Ak(Ak),level(level),kStart(kStart)   { runMessage(); run(); }   inline void op(IndexInt idx, const FlagGrid& flags, Grid<Real>& dst, Grid<Real>& Var1, Grid<Real>& Aprecond, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, int level, int kStart ) const {
+	const int k = kStart + (int)idx;
+	const int j = level - k;
+	for (int i=0; i<flags.getSizeX(); i++)
+		modifiedIncompCholeskyForwardCell(i,j,k, dst, Var1, flags, Aprecond, Ai, Aj, Ak);
+}    inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline Grid<Real>& getArg1() { return dst; } typedef Grid<Real> type1;inline Grid<Real>& getArg2() { return Var1; } typedef Grid<Real> type2;inline Grid<Real>& getArg3() { return Aprecond; } typedef Grid<Real> type3;inline Grid<Real>& getArg4() { return Ai; } typedef Grid<Real> type4;inline Grid<Real>& getArg5() { return Aj; } typedef Grid<Real> type5;inline Grid<Real>& getArg6() { return Ak; } typedef Grid<Real> type6;inline int& getArg7() { return level; } typedef int type7;inline int& getArg8() { return kStart; } typedef int type8; void runMessage() { debMsg("Executing kernel knMICForwardWavefront ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, flags,dst,Var1,Aprecond,Ai,Aj,Ak,level,kStart);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const FlagGrid& flags; Grid<Real>& dst; Grid<Real>& Var1; Grid<Real>& Aprecond; Grid<Real>& Ai; Grid<Real>& Aj; Grid<Real>& Ak; int level; int kStart;   };
+
+//! Kernel: mICP backward substitution for all rows of one wavefront level
+
+
+ struct knMICBackwardWavefront : public KernelBase { knMICBackwardWavefront(const FlagGrid& flags, Grid<Real>& dst, Grid<Real>& Aprecond, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, int level, int kStart, IndexInt numRows) :  KernelBase(numRows) ,flags(flags),dst(dst),Aprecond(Aprecond),Ai(Ai),Aj(Aj),Ak(Ak),level(level),kStart(kStart)   { runMessage(); run(); }   inline void op(IndexInt idx, const FlagGrid& flags, Grid<Real>& dst, Grid<Real>& Aprecond, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, int level, int kStart ) const {
+	const int k = kStart + (int)idx;
+	const int j = level - k;
+	for (int i=flags.getSizeX()-1; i>=0; i--)
+		modifiedIncompCholeskyBackwardCell(i,j,k, dst, flags, Aprecond, Ai, Aj, Ak);
+}    inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline Grid<Real>& getArg1() { return dst; } typedef Grid<Real> type1;inline Grid<Real>& getArg2() { return Aprecond; } typedef Grid<Real> type2;inline Grid<Real>& getArg3() { return Ai; } typedef Grid<Real> type3;inline Grid<Real>& getArg4() { return Aj; } typedef Grid<Real> type4;inline Grid<Real>& getArg5() { return Ak; } typedef Grid<Real> type5;inline int& getArg6() { return level; } typedef int type6;inline int& getArg7() { return kStart; } typedef int type7; void runMessage() { debMsg("Executing kernel knMICBackwardWavefront ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, flags,dst,Aprecond,Ai,Aj,Ak,level,kStart);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const FlagGrid& flags; Grid<Real>& dst; Grid<Real>& Aprecond; Grid<Real>& Ai; Grid<Real>& Aj; Grid<Real>& Ak; int level; int kStart;   };
+
+//! Rows (j,k) with j+k == level, clamped to the grid
+static inline void getWavefrontRows(const FlagGrid& flags, int level, int& kStart, int& numRows)
+{
+	kStart = std::max(0, level - (flags.getSizeY()-1));
+	numRows = std::min(flags.getSizeZ()-1, level) - kStart + 1;
+}
+
+//! Preconditioning using modified IC ala Bridson, parallelized with wavefronts: row (j,k) only depends
+//! on rows (j-1,k) and (j,k-1), so all rows of a level j+k can be factorized concurrently.
+//! Gives the same result as InitPreconditionModifiedIncompCholesky2
+void InitPreconditionModifiedIncompCholesky2Wavefront(const FlagGrid& flags,
+				Grid<Real>&Aprecond, 
+				Grid<Real>&A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak) 
+{
+	Aprecond.clear();
+
+	const int numLevels = flags.getSizeY() + flags.getSizeZ() - 1;
+	for (int level=0; level<numLevels; level++) {
+		int kStart, numRows;
+		getWavefrontRows(flags, level, kStart, numRows);
+		knMICInitWavefront(flags, Aprecond, A0, Ai, Aj, Ak, level, kStart, numRows);
+	}
+}
+
+//! Apply Bridson-style mICP, substitutions run level by level like the wavefront factorization
+void ApplyPreconditionModifiedIncompCholesky2Wavefront(Grid<Real>& dst, Grid<Real>& Var1, const FlagGrid& flags,
+				Grid<Real>& Aprecond, 
+				Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak) 
+{
+	const int numLevels = flags.getSizeY() + flags.getSizeZ() - 1;
+	int kStart, numRows;
+
+	// forward substitution
+	for (int level=0; level<numLevels; level++) {
+		getWavefrontRows(flags, level, kStart, numRows);
+		knMICForwardWavefront(flags, dst, Var1, Aprecond, Ai, Aj, Ak, level, kStart, numRows);
+	}
+
+	// backward substitution
+	for (int level=numLevels-1; level>=0; level--) {
+		getWavefrontRows(flags, level, kStart, numRows);
+		knMICBackwardWavefront(flags, dst, Aprecond, Ai, Aj, Ak, level, kStart, numRows);
 	}
 }
 
@@ -207,6 +306,72 @@ void ApplyPreconditionMultigrid(GridMg* pMG, Grid<Real>& dst, Grid<Real>& Var1)
 	dst[idx] = src[idx] + factor * dst[idx];
 }    inline Grid<Real>& getArg0() { return dst; } typedef Grid<Real> type0;inline Grid<Real>& getArg1() { return src; } typedef Grid<Real> type1;inline Real& getArg2() { return factor; } typedef Real type2; void runMessage() { debMsg("Executing kernel UpdateSearchVec ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, dst,src,factor);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  Grid<Real>& dst; Grid<Real>& src; Real factor;   };
 
+//! Kernel: apply symmetric stored matrix (2D or 3D) and compute dot(dst, src) in the same pass
+/*! Uses double precision internally */
+
+ struct ApplyMatrixDot : public KernelBase { ApplyMatrixDot(const FlagGrid& flags, Grid<Real>& dst, const Grid<Real>& src, const Grid<Real>& A0, const Grid<Real>& Ai, const Grid<Real>& Aj, const Grid<Real>& Ak, bool is3D) :  KernelBase(&flags,0) ,flags(flags),dst(dst),src(src),A0(A0),Ai(Ai),Aj(Aj),Ak(Ak),is3D(is3D) ,result(0.0)  { runMessage(); run(); }   inline void op(IndexInt idx, const FlagGrid& flags, Grid<Real>& dst, const Grid<Real>& src, const Grid<Real>& A0, const Grid<Real>& Ai, const Grid<Real>& Aj, const Grid<Real>& Ak, bool is3D ,double& result)  {
+	if (!flags.isFluid(idx)) {
+		dst[idx] = src[idx];
+	} else {
+		Real sum = src[idx] * A0[idx]
+				+ src[idx-X] * Ai[idx-X]
+				+ src[idx+X] * Ai[idx]
+				+ src[idx-Y] * Aj[idx-Y]
+				+ src[idx+Y] * Aj[idx];
+		if (is3D) {
+			sum += src[idx-Z] * Ak[idx-Z]
+				+ src[idx+Z] * Ak[idx];
+		}
+		dst[idx] = sum;
+	}
+	result += (dst[idx] * src[idx]);
+}    inline operator double () { return result; } inline double  & getRet() { return result; }  inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline Grid<Real>& getArg1() { return dst; } typedef Grid<Real> type1;inline const Grid<Real>& getArg2() { return src; } typedef Grid<Real> type2;inline const Grid<Real>& getArg3() { return A0; } typedef Grid<Real> type3;inline const Grid<Real>& getArg4() { return Ai; } typedef Grid<Real> type4;inline const Grid<Real>& getArg5() { return Aj; } typedef Grid<Real> type5;inline const Grid<Real>& getArg6() { return Ak; } typedef Grid<Real> type6;inline bool& getArg7() { return is3D; } typedef bool type7; void runMessage() { debMsg("Executing kernel ApplyMatrixDot ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, flags,dst,src,A0,Ai,Aj,Ak,is3D,result);   } void run() {   tbb::parallel_reduce (tbb::blocked_range<IndexInt>(0, size), *this);   }  ApplyMatrixDot (ApplyMatrixDot& o, tbb::split) : KernelBase(o) ,flags(o.flags),dst(o.dst),src(o.src),A0(o.A0),Ai(o.Ai),Aj(o.Aj),Ak(o.Ak),is3D(o.is3D) ,result(0.0) {} void join(const ApplyMatrixDot & o) { result += o.result;  }  const FlagGrid& flags; Grid<Real>& dst; const Grid<Real>& src; const Grid<Real>& A0; const Grid<Real>& Ai; const Grid<Real>& Aj; const Grid<Real>& Ak; bool is3D; double result;  };
+
+//! Kernel: same as ApplyMatrixDot, with coefficients interleaved in single precision
+
+ struct ApplyPackedMatrixDot : public KernelBase { ApplyPackedMatrixDot(const FlagGrid& flags, Grid<Real>& dst, const Grid<Real>& src, const std::vector<float>& A, bool is3D) :  KernelBase(&flags,0) ,flags(flags),dst(dst),src(src),A(A),is3D(is3D) ,result(0.0)  { runMessage(); run(); }   inline void op(IndexInt idx, const FlagGrid& flags, Grid<Real>& dst, const Grid<Real>& src, const std::vector<float>& A, bool is3D ,double& result)  {
+	if (!flags.isFluid(idx)) {
+		dst[idx] = src[idx];
+	} else {
+		// A holds (A0, Ai, Aj, Ak) per cell
+		const float* a = &A[4*idx];
+		Real sum = src[idx] * a[0]
+				+ src[idx-X] * a[1-4*X]
+				+ src[idx+X] * a[1]
+				+ src[idx-Y] * a[2-4*Y]
+				+ src[idx+Y] * a[2];
+		if (is3D) {
+			sum += src[idx-Z] * a[3-4*Z]
+				+ src[idx+Z] * a[3];
+		}
+		dst[idx] = sum;
+	}
+	result += (dst[idx] * src[idx]);
+}    inline operator double () { return result; } inline double  & getRet() { return result; }  inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline Grid<Real>& getArg1() { return dst; } typedef Grid<Real> type1;inline const Grid<Real>& getArg2() { return src; } typedef Grid<Real> type2;inline const std::vector<float>& getArg3() { return A; } typedef std::vector<float> type3;inline bool& getArg4() { return is3D; } typedef bool type4; void runMessage() { debMsg("Executing kernel ApplyPackedMatrixDot ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, flags,dst,src,A,is3D,result);   } void run() {   tbb::parallel_reduce (tbb::blocked_range<IndexInt>(0, size), *this);   }  ApplyPackedMatrixDot (ApplyPackedMatrixDot& o, tbb::split) : KernelBase(o) ,flags(o.flags),dst(o.dst),src(o.src),A(o.A),is3D(o.is3D) ,result(0.0) {} void join(const ApplyPackedMatrixDot & o) { result += o.result;  }  const FlagGrid& flags; Grid<Real>& dst; const Grid<Real>& src; const std::vector<float>& A; bool is3D; double result;  };
+
+//! Kernel: interleave matrix coefficients in single precision, see ApplyPackedMatrixDot
+
+ struct PackMatrix : public KernelBase { PackMatrix(const Grid<Real>& A0, const Grid<Real>& Ai, const Grid<Real>& Aj, const Grid<Real>& Ak, std::vector<float>& A) :  KernelBase(&A0,0) ,A0(A0),Ai(Ai),Aj(Aj),Ak(Ak),A(A)  { runMessage(); run(); }   inline void op(IndexInt idx, const Grid<Real>& A0, const Grid<Real>& Ai, const Grid<Real>& Aj, const Grid<Real>& Ak, std::vector<float>& A ) const {
+	A[4*idx+0] = (float)A0[idx];
+	A[4*idx+1] = (float)Ai[idx];
+	A[4*idx+2] = (float)Aj[idx];
+	A[4*idx+3] = (float)Ak[idx];
+}    inline const Grid<Real>& getArg0() { return A0; } typedef Grid<Real> type0;inline const Grid<Real>& getArg1() { return Ai; } typedef Grid<Real> type1;inline const Grid<Real>& getArg2() { return Aj; } typedef Grid<Real> type2;inline const Grid<Real>& getArg3() { return Ak; } typedef Grid<Real> type3;inline std::vector<float>& getArg4() { return A; } typedef std::vector<float> type4; void runMessage() { debMsg("Executing kernel PackMatrix ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, A0,Ai,Aj,Ak,A);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const Grid<Real>& A0; const Grid<Real>& Ai; const Grid<Real>& Aj; const Grid<Real>& Ak; std::vector<float>& A;  };
+
+//! Kernel: dst += search * alpha, residual -= tmp * alpha, and the residual norms in the same pass
+
+ struct UpdateSolutionResidual : public KernelBase { UpdateSolutionResidual(Grid<Real>& dst, Grid<Real>& residual, const Grid<Real>& search, const Grid<Real>& tmp, Real alpha) :  KernelBase(&dst,0) ,dst(dst),residual(residual),search(search),tmp(tmp),alpha(alpha) ,sumSqr(0) ,maxAbs(0)  { runMessage(); run(); }   inline void op(IndexInt idx, Grid<Real>& dst, Grid<Real>& residual, const Grid<Real>& search, const Grid<Real>& tmp, Real alpha ,double& sumSqr ,Real& maxAbs)  {
+	dst[idx] += search[idx] * alpha;
+
+	const Real res = residual[idx] + tmp[idx] * -alpha;
+	residual[idx] = res;
+
+	sumSqr += square((double)res);
+	if (fabs(res) > maxAbs)
+		maxAbs = fabs(res);
+}    inline Grid<Real>& getArg0() { return dst; } typedef Grid<Real> type0;inline Grid<Real>& getArg1() { return residual; } typedef Grid<Real> type1;inline const Grid<Real>& getArg2() { return search; } typedef Grid<Real> type2;inline const Grid<Real>& getArg3() { return tmp; } typedef Grid<Real> type3;inline Real& getArg4() { return alpha; } typedef Real type4; void runMessage() { debMsg("Executing kernel UpdateSolutionResidual ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, dst,residual,search,tmp,alpha,sumSqr,maxAbs);   } void run() {   tbb::parallel_reduce (tbb::blocked_range<IndexInt>(0, size), *this);   }  UpdateSolutionResidual (UpdateSolutionResidual& o, tbb::split) : KernelBase(o) ,dst(o.dst),residual(o.residual),search(o.search),tmp(o.tmp),alpha(o.alpha) ,sumSqr(0) ,maxAbs(0) {} void join(const UpdateSolutionResidual & o) { sumSqr += o.sumSqr; maxAbs = max(maxAbs, o.maxAbs);  }  Grid<Real>& dst; Grid<Real>& residual; const Grid<Real>& search; const Grid<Real>& tmp; Real alpha; double sumSqr; Real maxAbs;  };
+
+
 //*****************************************************************************
 //  CG class
 
@@ -215,7 +380,9 @@ GridCg<APPLYMAT>::GridCg(Grid<Real>& dst, Grid<Real>& rhs, Grid<Real>& residual,
 			   Grid<Real>* pA0, Grid<Real>* pAi, Grid<Real>* pAj, Grid<Real>* pAk) :
 	GridCgInterface(), mInited(false), mIterations(0), mDst(dst), mRhs(rhs), mResidual(residual),
 	mSearch(search), mFlags(flags), mTmp(tmp), mpA0(pA0), mpAi(pAi), mpAj(pAj), mpAk(pAk),
-	mPcMethod(PC_None), mpPCA0(nullptr), mpPCAi(nullptr), mpPCAj(nullptr), mpPCAk(nullptr), mMG(nullptr), mSigma(0.), mAccuracy(VECTOR_EPSILON), mResNorm(1e20) 
+	mFused(std::is_same<APPLYMAT, ApplyMatrix>::value || std::is_same<APPLYMAT, ApplyMatrix2D>::value),
+	mIs3D(std::is_same<APPLYMAT, ApplyMatrix>::value),
+	mPcMethod(PC_None), mpPCA0(nullptr), mpPCAi(nullptr), mpPCAj(nullptr), mpPCAk(nullptr), mMG(nullptr), mSigma(0.), mAccuracy(VECTOR_EPSILON), mResNorm(1e20)
 { }
 
 template<class APPLYMAT>
@@ -225,6 +392,13 @@ void GridCg<APPLYMAT>::doInit() {
 
 	mDst.clear();
 	mResidual.copyFrom( mRhs ); // p=0, residual = b
+
+	if (mFused && mPackedMatrix) {
+		mPackedA.resize(4 * mDst.getSizeX() * mDst.getSizeY() * mDst.getSizeZ());
+		PackMatrix(*mpA0, *mpAi, *mpAj, *mpAk, mPackedA);
+	} else {
+		std::vector<float>().swap(mPackedA);
+	}
 	
 	if (mPcMethod == PC_ICP) {
 		assertMsg(mDst.is3D(), "ICP only supports 3D grids so far");
@@ -234,6 +408,10 @@ void GridCg<APPLYMAT>::doInit() {
 		assertMsg(mDst.is3D(), "mICP only supports 3D grids so far");
 		InitPreconditionModifiedIncompCholesky2(mFlags, *mpPCA0, *mpA0, *mpAi, *mpAj, *mpAk);
 		ApplyPreconditionModifiedIncompCholesky2(mTmp, mResidual, mFlags, *mpPCA0, *mpA0, *mpAi, *mpAj, *mpAk);
+	} else if (mPcMethod == PC_mICPWavefront) {
+		assertMsg(mDst.is3D(), "mICP only supports 3D grids so far");
+		InitPreconditionModifiedIncompCholesky2Wavefront(mFlags, *mpPCA0, *mpA0, *mpAi, *mpAj, *mpAk);
+		ApplyPreconditionModifiedIncompCholesky2Wavefront(mTmp, mResidual, mFlags, *mpPCA0, *mpA0, *mpAi, *mpAj, *mpAk);
 	} else if (mPcMethod == PC_MGP) {
 		InitPreconditionMultigrid(mMG, *mpA0, *mpAi, *mpAj, *mpAk, mAccuracy);
 		ApplyPreconditionMultigrid(mMG, mTmp, mResidual);
@@ -256,30 +434,48 @@ bool GridCg<APPLYMAT>::iterate() {
 	// this could reinterpret the mpA pointers (not so clean right now)
 	// tmp = applyMat(search)
 	
-	APPLYMAT (mFlags, mTmp, mSearch, *mpA0, *mpAi, *mpAj, *mpAk);
-	
 	// alpha = sigma/dot(tmp, search)
-	Real dp = GridDotProduct(mTmp, mSearch);
+	Real dp;
+	if (mFused) {
+		if (mPackedA.empty()) dp = ApplyMatrixDot(mFlags, mTmp, mSearch, *mpA0, *mpAi, *mpAj, *mpAk, mIs3D);
+		else                  dp = ApplyPackedMatrixDot(mFlags, mTmp, mSearch, mPackedA, mIs3D);
+	} else {
+		APPLYMAT (mFlags, mTmp, mSearch, *mpA0, *mpAi, *mpAj, *mpAk);
+		dp = GridDotProduct(mTmp, mSearch);
+	}
 	Real alpha = 0.;
 	if(fabs(dp)>0.) alpha = mSigma / (Real)dp;
-	
-	gridScaledAdd<Real,Real>(mDst, mSearch, alpha);    // dst += search * alpha
-	gridScaledAdd<Real,Real>(mResidual, mTmp, -alpha); // residual += tmp * -alpha
+
+	double resSumSqr = 0.;
+	Real resMaxAbs = 0.;
+	if (mFused) {
+		UpdateSolutionResidual upd(mDst, mResidual, mSearch, mTmp, alpha);
+		resSumSqr = upd.sumSqr;
+		resMaxAbs = upd.maxAbs;
+	} else {
+		gridScaledAdd<Real,Real>(mDst, mSearch, alpha);    // dst += search * alpha
+		gridScaledAdd<Real,Real>(mResidual, mTmp, -alpha); // residual += tmp * -alpha
+	}
+
+	// without preconditioner, the residual is used directly instead of a copy in tmp
+	const bool noCopy = mFused && mPcMethod == PC_None;
 	
 	if (mPcMethod == PC_ICP)
 		ApplyPreconditionIncompCholesky(mTmp, mResidual, mFlags, *mpPCA0, *mpPCAi, *mpPCAj, *mpPCAk, *mpA0, *mpAi, *mpAj, *mpAk);
 	else if (mPcMethod == PC_mICP)
 		ApplyPreconditionModifiedIncompCholesky2(mTmp, mResidual, mFlags, *mpPCA0, *mpA0, *mpAi, *mpAj, *mpAk);
+	else if (mPcMethod == PC_mICPWavefront)
+		ApplyPreconditionModifiedIncompCholesky2Wavefront(mTmp, mResidual, mFlags, *mpPCA0, *mpA0, *mpAi, *mpAj, *mpAk);
 	else if (mPcMethod == PC_MGP)
 		ApplyPreconditionMultigrid(mMG, mTmp, mResidual);
-	else
+	else if (!noCopy)
 		mTmp.copyFrom( mResidual );
-		
+
 	// use the l2 norm of the residual for convergence check? (usually max norm is recommended instead)
-	if(this->mUseL2Norm) { 
-		mResNorm = GridSumSqr(mResidual).sum; 
+	if(this->mUseL2Norm) {
+		mResNorm = mFused ? resSumSqr : GridSumSqr(mResidual).sum;
 	} else {
-		mResNorm = mResidual.getMaxAbs();        
+		mResNorm = mFused ? resMaxAbs : mResidual.getMaxAbs();
 	}
 
 	// abort here to safe some work...
@@ -288,11 +484,11 @@ bool GridCg<APPLYMAT>::iterate() {
 		return false;
 	}
 
-	Real sigmaNew = GridDotProduct(mTmp, mResidual);
+	Real sigmaNew = noCopy ? resSumSqr : GridDotProduct(mTmp, mResidual);
 	Real beta = sigmaNew / mSigma;
-	
+
 	// search =  tmp + beta * search
-	UpdateSearchVec (mSearch, mTmp, beta);
+	UpdateSearchVec (mSearch, noCopy ? mResidual : mTmp, beta);
 
 	debMsg("GridCg::iterate i="<<mIterations<<" sigmaNew="<<sigmaNew<<" sigmaLast="<<mSigma<<" alpha="<<alpha<<" beta="<<beta<<" ", CG_DEBUGLEVEL);
 	mSigma = sigmaNew;
@@ -315,13 +511,15 @@ void GridCg<APPLYMAT>::solve(int maxIter) {
 	for (int iter=0; iter<maxIter; iter++) {
 		if (!iterate()) iter=maxIter;
 	} 
+	TimingData::instance().addCounter("cgIterations", mIterations);
+	TimingData::instance().setCounter("cgResidual", mResNorm);
 	return;
 }
 
 static bool gPrint2dWarning = true;
 template<class APPLYMAT>
 void GridCg<APPLYMAT>::setICPreconditioner(PreconditionType method, Grid<Real> *A0, Grid<Real> *Ai, Grid<Real> *Aj, Grid<Real> *Ak) {
-	assertMsg(method==PC_ICP || method==PC_mICP, "GridCg<APPLYMAT>::setICPreconditioner: Invalid method specified.");
+	assertMsg(method==PC_ICP || method==PC_mICP || method==PC_mICPWavefront, "GridCg<APPLYMAT>::setICPreconditioner: Invalid method specified.");
 
 	mPcMethod = method;
 	if( (!A0->is3D())) {
@@ -361,7 +559,7 @@ template class GridCg<ApplyMatrix2D>;
 //  see lidDrivenCavity.py for an example
 
 
-void cgSolveDiffusion(const FlagGrid& flags, GridBase& grid, Real alpha = 0.25, Real cgMaxIterFac = 1.0, Real cgAccuracy = 1e-4 ) {
+void cgSolveDiffusion(const FlagGrid& flags, GridBase& grid, Real alpha = 0.25, Real cgMaxIterFac = 1.0, Real cgAccuracy = 1e-4, bool packedMatrix = false ) {
 	// reserve temp grids
 	FluidSolver* parent = flags.getParent();
 	Grid<Real> rhs(parent);
@@ -399,6 +597,7 @@ void cgSolveDiffusion(const FlagGrid& flags, GridBase& grid, Real alpha = 0.25,
 			gcg = new GridCg<ApplyMatrix2D>(u, rhs, residual, search, flags, tmp, &A0, &Ai, &Aj, &Ak ); 
 
 		gcg->setAccuracy( cgAccuracy ); 
+		gcg->setPackedMatrix( packedMatrix );
 		gcg->solve(maxIter);
 
 		debMsg("FluidSolver::solveDiffusion iterations:"<<gcg->getIterations()<<", res:"<<gcg->getSigma(), CG_DEBUGLEVEL);
@@ -415,6 +614,7 @@ void cgSolveDiffusion(const FlagGrid& flags, GridBase& grid, Real alpha = 0.25,
 		else
 			gcg = new GridCg<ApplyMatrix2D>(u, rhs, residual, search, flags, tmp, &A0, &Ai, &Aj, &Ak ); 
 		gcg->setAccuracy( cgAccuracy ); 
+		gcg->setPackedMatrix( packedMatrix );
 
 		// diffuse every component separately
 		for(int component = 0; component< (grid.is3D() ? 3:2); ++component) {
@@ -432,7 +632,7 @@ void cgSolveDiffusion(const FlagGrid& flags, GridBase& grid, Real alpha = 0.25,
 	}
 
 	delete gcg;
-} static PyObject* _W_0 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "cgSolveDiffusion" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",0,&_lock); GridBase& grid = *_args.getPtr<GridBase >("grid",1,&_lock); Real alpha = _args.getOpt<Real >("alpha",2,0.25,&_lock); Real cgMaxIterFac = _args.getOpt<Real >("cgMaxIterFac",3,1.0,&_lock); Real cgAccuracy = _args.getOpt<Real >("cgAccuracy",4,1e-4 ,&_lock);   _retval = getPyNone(); cgSolveDiffusion(flags,grid,alpha,cgMaxIterFac,cgAccuracy);  _args.check(); } pbFinalizePlugin(parent,"cgSolveDiffusion", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("cgSolveDiffusion",e.what()); return 0; } } static const Pb::Register _RP_cgSolveDiffusion ("","cgSolveDiffusion",_W_0);  extern "C" { void PbRegister_cgSolveDiffusion() { KEEP_UNUSED(_RP_cgSolveDiffusion); } } 
+} static PyObject* _W_0 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "cgSolveDiffusion" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",0,&_lock); GridBase& grid = *_args.getPtr<GridBase >("grid",1,&_lock); Real alpha = _args.getOpt<Real >("alpha",2,0.25,&_lock); Real cgMaxIterFac = _args.getOpt<Real >("cgMaxIterFac",3,1.0,&_lock); Real cgAccuracy = _args.getOpt<Real >("cgAccuracy",4,1e-4,&_lock); bool packedMatrix = _args.getOpt<bool >("packedMatrix",5,false ,&_lock);   _retval = getPyNone(); cgSolveDiffusion(flags,grid,alpha,cgMaxIterFac,cgAccuracy,packedMatrix);  _args.check(); } pbFinalizePlugin(parent,"cgSolveDiffusion", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("cgSolveDiffusion",e.what()); return 0; } } static const Pb::Register _RP_cgSolveDiffusion ("","cgSolveDiffusion",_W_0);  extern "C" { void PbRegister_cgSolveDiffusion() { KEEP_UNUSED(_RP_cgSolveDiffusion); } } 
 
 
 
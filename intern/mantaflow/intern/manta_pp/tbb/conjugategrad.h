@@ -38,9 +38,9 @@ static const bool CG_DEBUG = false;
 //! Basic CG interface 
 class GridCgInterface {
 	public:
-		enum PreconditionType { PC_None=0, PC_ICP, PC_mICP, PC_MGP };
+		enum PreconditionType { PC_None=0, PC_ICP, PC_mICP, PC_MGP, PC_mICPWavefront };
 		
-		GridCgInterface() : mUseL2Norm(true) {};
+		GridCgInterface() : mUseL2Norm(true), mPackedMatrix(false) {};
 		virtual ~GridCgInterface() {};
 
 		// solving functions
@@ -62,11 +62,16 @@ class GridCgInterface {
 		virtual void forceReinit() = 0;
 
 		void setUseL2Norm(bool set) { mUseL2Norm = set; }
+		//! interleave the matrix coefficients in single precision for the matrix application
+		// (no loss of precision for float builds), only used by the fused iteration kernels
+		void setPackedMatrix(bool set) { mPackedMatrix = set; }
 
 	protected:
 
 		// use l2 norm of residualfor threshold? (otherwise uses max norm)
-		bool mUseL2Norm; 
+		bool mUseL2Norm;
+		// use interleaved single precision matrix coefficients?
+		bool mPackedMatrix; 
 };
 
 
@@ -112,6 +117,12 @@ class GridCg : public GridCgInterface {
 
 		Grid<Real> *mpA0, *mpAi, *mpAj, *mpAk;
 
+		//! standard 2D/3D matrix: the iteration uses fused kernels, one pass for the
+		// matrix application and dot product, one for the solution and residual updates
+		bool mFused;
+		bool mIs3D;
+		std::vector<float> mPackedA;
+
 		PreconditionType mPcMethod;
 		//! preconditioning grids
 		Grid<Real> *mpPCA0, *mpPCAi, *mpPCAj, *mpPCAk;
@@ -162,9 +173,8 @@ class GridCg : public GridCgInterface {
 				+ src[idx+Y] * Aj[idx];
 }    inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline Grid<Real>& getArg1() { return dst; } typedef Grid<Real> type1;inline const Grid<Real>& getArg2() { return src; } typedef Grid<Real> type2;inline Grid<Real>& getArg3() { return A0; } typedef Grid<Real> type3;inline Grid<Real>& getArg4() { return Ai; } typedef Grid<Real> type4;inline Grid<Real>& getArg5() { return Aj; } typedef Grid<Real> type5;inline Grid<Real>& getArg6() { return Ak; } typedef Grid<Real> type6; void runMessage() { debMsg("Executing kernel ApplyMatrix2D ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, flags,dst,src,A0,Ai,Aj,Ak);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const FlagGrid& flags; Grid<Real>& dst; const Grid<Real>& src; Grid<Real>& A0; Grid<Real>& Ai; Grid<Real>& Aj; Grid<Real>& Ak;   };
 
-//! Kernel: Construct the matrix for the poisson equation
-
- struct MakeLaplaceMatrix : public KernelBase { MakeLaplaceMatrix(const FlagGrid& flags, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, const MACGrid* fractions = 0) :  KernelBase(&flags,1) ,flags(flags),A0(A0),Ai(Ai),Aj(Aj),Ak(Ak),fractions(fractions)   { runMessage(); run(); }  inline void op(int i, int j, int k, const FlagGrid& flags, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, const MACGrid* fractions = 0 ) const {
+//! Matrix entries of a single cell for the poisson equation, see MakeLaplaceMatrix
+inline void makeLaplaceMatrixCell(int i, int j, int k, const FlagGrid& flags, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, const MACGrid* fractions) {
 	if (!flags.isFluid(i,j,k))
 		return;
 	
@@ -196,6 +206,12 @@ class GridCg : public GridCgInterface {
 		if (flags.is3D() && flags.isFluid(i,j,k+1)) Ak(i,j,k) = -fractions->get(i,j,k+1).z;
 	}
 
+}
+
+//! Kernel: Construct the matrix for the poisson equation
+
+ struct MakeLaplaceMatrix : public KernelBase { MakeLaplaceMatrix(const FlagGrid& flags, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, const MACGrid* fractions = 0) :  KernelBase(&flags,1) ,flags(flags),A0(A0),Ai(Ai),Aj(Aj),Ak(Ak),fractions(fractions)   { runMessage(); run(); }  inline void op(int i, int j, int k, const FlagGrid& flags, Grid<Real>& A0, Grid<Real>& Ai, Grid<Real>& Aj, Grid<Real>& Ak, const MACGrid* fractions = 0 ) const {
+	makeLaplaceMatrixCell(i,j,k, flags, A0, Ai, Aj, Ak, fractions);
 }   inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline Grid<Real>& getArg1() { return A0; } typedef Grid<Real> type1;inline Grid<Real>& getArg2() { return Ai; } typedef Grid<Real> type2;inline Grid<Real>& getArg3() { return Aj; } typedef Grid<Real> type3;inline Grid<Real>& getArg4() { return Ak; } typedef Grid<Real> type4;inline const MACGrid* getArg5() { return fractions; } typedef MACGrid type5; void runMessage() { debMsg("Executing kernel MakeLaplaceMatrix ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ>1) { for (int k=__r.begin(); k!=(int)__r.end(); k++) for (int j=1; j<_maxY; j++) for (int i=1; i<_maxX; i++) op(i,j,k,flags,A0,Ai,Aj,Ak,fractions); } else { const int k=0; for (int j=__r.begin(); j!=(int)__r.end(); j++) for (int i=1; i<_maxX; i++) op(i,j,k,flags,A0,Ai,Aj,Ak,fractions); }  } void run() {  if (maxZ>1) tbb::parallel_for (tbb::blocked_range<IndexInt>(minZ, maxZ), *this); else tbb::parallel_for (tbb::blocked_range<IndexInt>(1, maxY), *this);  }  const FlagGrid& flags; Grid<Real>& A0; Grid<Real>& Ai; Grid<Real>& Aj; Grid<Real>& Ak; const MACGrid* fractions;   };
 
 
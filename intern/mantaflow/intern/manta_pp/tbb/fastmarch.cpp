@@ -33,8 +33,8 @@ using namespace std;
 namespace Manta {
 	
 template<class COMP, int TDIR>
-FastMarch<COMP,TDIR>::FastMarch(const FlagGrid& flags, Grid<int>& fmFlags, Grid<Real>& levelset, Real maxTime, MACGrid* velTransport )
-	: mLevelset(levelset), mFlags(flags), mFmFlags(fmFlags)
+FastMarch<COMP,TDIR>::FastMarch(const FlagGrid& flags, Grid<int>& fmFlags, Grid<Real>& levelset, Real maxTime, MACGrid* velTransport, bool parallel )
+	: mLevelset(levelset), mFlags(flags), mFmFlags(fmFlags), mParallel(parallel)
 {
 	if (velTransport)
 		mVelTransport.initMarching(velTransport, &flags);
@@ -143,6 +143,8 @@ inline Real FastMarch<COMP,TDIR>::calculateDistance(const Vec3i& idx) {
 
 template<class COMP, int TDIR>
 void FastMarch<COMP,TDIR>::addToList(const Vec3i& p, const Vec3i& src) {
+	// parallel marching visits all cells that are not initialized, nothing to queue
+	if (mParallel) return;
 	if (!mLevelset.isInBounds(p,1)) return;
 	const IndexInt idx = mLevelset.index(p);
 	
@@ -204,10 +206,130 @@ void FastMarch<COMP,TDIR>::addToList(const Vec3i& p, const Vec3i& src) {
 	}
 }   inline Grid<Real>& getArg0() { return phi; } typedef Grid<Real> type0; void runMessage() { debMsg("Executing kernel SetLevelsetBoundaries ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {  const int _maxX = maxX; const int _maxY = maxY; for (int k=minZ; k< maxZ; k++) for (int j=0; j< _maxY; j++) for (int i=0; i< _maxX; i++) op(i,j,k, phi);  } Grid<Real>& phi;   };
 
+/*****************************************************************************/
+// parallel marching, see FastMarch::performIterative()
+
+static const int FmInited = FastMarch<FmHeapEntryOut, +1>::FlagInited;
+
+//! distance value of cells that have not been reached yet
+static const Real FmUnknown = 1e10;
+
+//! upwind solution of |grad d| = 1 from the smaller valid neighbor along each axis,
+//  nb and w return the neighbor direction and the transport weight per axis (0 if unused)
+static inline Real fmUpwindDistance(const Grid<Real>& dist, IndexInt idx, const IndexInt stride[3], Real maxTime, int nb[3], Real w[3]) {
+	const int dim = dist.is3D() ? 3 : 2;
+	Real a[3];
+	int axis[3];
+	int cnt = 0;
+	for (int c=0; c<3; c++) {
+		nb[c] = 0;
+		w[c] = 0.;
+		if (c >= dim) continue;
+		const Real dm = dist[idx - stride[c]];
+		const Real dp = dist[idx + stride[c]];
+		const Real v = min(dm, dp);
+		if (v > maxTime) continue;
+
+		// insert sorted, prefer the +1 neighbor like FastMarch::calcWeights
+		nb[c] = (dp <= dm) ? 1 : -1;
+		int pos = cnt++;
+		for (; pos > 0 && a[pos-1] > v; pos--) {
+			a[pos] = a[pos-1];
+			axis[pos] = axis[pos-1];
+		}
+		a[pos] = v;
+		axis[pos] = c;
+	}
+	if (cnt == 0) return FmUnknown;
+
+	// use as many axes as are upwind of the result
+	Real ret = a[0] + 1.;
+	int used = 1;
+	if (cnt > 1 && ret > a[1]) {
+		ret = 0.5 * (a[0] + a[1] + sqrt(max(Real(0.), Real(2.) - square(a[1] - a[0]))));
+		used = 2;
+		if (cnt > 2 && ret > a[2]) {
+			const Real sum = a[0] + a[1] + a[2];
+			const Real sumSqr = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+			ret = (sum + sqrt(max(Real(0.), sum*sum - Real(3.) * (sumSqr - Real(1.))))) / 3.;
+			used = 3;
+		}
+	}
+
+	// weights needed for transport, same as in FastMarch::calculateDistance
+	Real norm = 0.;
+	for (int m=0; m<used; m++) {
+		w[axis[m]] = ret - a[m];
+		norm += w[axis[m]];
+	}
+	for (int m=used; m<cnt; m++) nb[axis[m]] = 0;
+	if (norm > 0.) {
+		for (int c=0; c<dim; c++) w[c] /= norm;
+	} else {
+		w[axis[0]] = 1.;
+	}
+	return ret;
+}
+
+//! unsigned distance of initialized cells in marching direction, unknown for all others
+
+ struct knFmInitIterative : public KernelBase { knFmInitIterative(const Grid<int>& fmFlags, const Grid<Real>& phi, Grid<Real>& dist, int tdir) :  KernelBase(&phi,0) ,fmFlags(fmFlags),phi(phi),dist(dist),tdir(tdir)  { runMessage(); run(); }   inline void op(IndexInt idx, const Grid<int>& fmFlags, const Grid<Real>& phi, Grid<Real>& dist, int tdir ) const {
+	dist[idx] = (fmFlags[idx] == FmInited) ? phi[idx] * tdir : FmUnknown;
+}    inline const Grid<int>& getArg0() { return fmFlags; } typedef Grid<int> type0;inline const Grid<Real>& getArg1() { return phi; } typedef Grid<Real> type1;inline Grid<Real>& getArg2() { return dist; } typedef Grid<Real> type2;inline int& getArg3() { return tdir; } typedef int type3; void runMessage() { debMsg("Executing kernel knFmInitIterative ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, fmFlags,phi,dist,tdir);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const Grid<int>& fmFlags; const Grid<Real>& phi; Grid<Real>& dist; int tdir;  };
+
+//! one Jacobi iteration of the upwind update, returns the number of cells that changed
+
+ struct knFmIterate : public KernelBase { knFmIterate(const Grid<int>& fmFlags, const Grid<Real>& src, Grid<Real>& dst, Real maxTime) :  KernelBase(&src,1) ,fmFlags(fmFlags),src(src),dst(dst),maxTime(maxTime) ,changed(0)  { runMessage(); run(); }  inline void op(int i, int j, int k, const Grid<int>& fmFlags, const Grid<Real>& src, Grid<Real>& dst, Real maxTime ,int& changed)  {
+	const IndexInt idx = src.index(i,j,k);
+	if (fmFlags[idx] == FmInited) return;
+
+	const IndexInt stride[3] = { X, Y, Z };
+	int nb[3];
+	Real w[3];
+	const Real d = fmUpwindDistance(src, idx, stride, maxTime, nb, w);
+	dst[idx] = d;
+	if (fabs(d - src[idx]) > 1e-5) changed++;
+}   inline operator int () { return changed; } inline int  & getRet() { return changed; }  inline const Grid<int>& getArg0() { return fmFlags; } typedef Grid<int> type0;inline const Grid<Real>& getArg1() { return src; } typedef Grid<Real> type1;inline Grid<Real>& getArg2() { return dst; } typedef Grid<Real> type2;inline Real& getArg3() { return maxTime; } typedef Real type3; void runMessage() { debMsg("Executing kernel knFmIterate ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r)  {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ>1) { for (int k=__r.begin(); k!=(int)__r.end(); k++) for (int j=1; j<_maxY; j++) for (int i=1; i<_maxX; i++) op(i,j,k,fmFlags,src,dst,maxTime,changed); } else { const int k=0; for (int j=__r.begin(); j!=(int)__r.end(); j++) for (int i=1; i<_maxX; i++) op(i,j,k,fmFlags,src,dst,maxTime,changed); }  } void run() {  if (maxZ>1) tbb::parallel_reduce (tbb::blocked_range<IndexInt>(minZ, maxZ), *this); else tbb::parallel_reduce (tbb::blocked_range<IndexInt>(1, maxY), *this);  }  knFmIterate (knFmIterate& o, tbb::split) : KernelBase(o) ,fmFlags(o.fmFlags),src(o.src),dst(o.dst),maxTime(o.maxTime) ,changed(0) {} void join(const knFmIterate & o) { changed += o.changed;  }  const Grid<int>& fmFlags; const Grid<Real>& src; Grid<Real>& dst; Real maxTime;  int changed;  };
+
+//! one Jacobi iteration of the velocity transport along the converged distances, see FmValueTransportVec3
+
+ struct knFmTransportVel : public KernelBase { knFmTransportVel(const FlagGrid& flags, const Grid<int>& fmFlags, const Grid<Real>& dist, const MACGrid& src, MACGrid& dst, Real maxTime) :  KernelBase(&dist,1) ,flags(flags),fmFlags(fmFlags),dist(dist),src(src),dst(dst),maxTime(maxTime) ,changed(0)  { runMessage(); run(); }  inline void op(int i, int j, int k, const FlagGrid& flags, const Grid<int>& fmFlags, const Grid<Real>& dist, const MACGrid& src, MACGrid& dst, Real maxTime ,int& changed)  {
+	const IndexInt idx = dist.index(i,j,k);
+	if (fmFlags[idx] == FmInited || dist[idx] >= FmUnknown || !flags.isEmpty(idx)) return;
+
+	const IndexInt stride[3] = { X, Y, Z };
+	int nb[3];
+	Real w[3];
+	fmUpwindDistance(dist, idx, stride, maxTime, nb, w);
+	Vec3 val(0.);
+	for (int c=0; c<3; c++) {
+		if (nb[c] != 0) val += src[idx + nb[c] * stride[c]] * w[c];
+	}
+
+	// set velocity components if adjacent is empty
+	Vec3 v = src[idx];
+	if (flags.isEmpty(idx-X)) v.x = val.x;
+	if (flags.isEmpty(idx-Y)) v.y = val.y;
+	if (flags.is3D() && flags.isEmpty(idx-Z)) v.z = val.z;
+	dst[idx] = v;
+	if (v.x != src[idx].x || v.y != src[idx].y || v.z != src[idx].z) changed++;
+}   inline operator int () { return changed; } inline int  & getRet() { return changed; }  inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline const Grid<int>& getArg1() { return fmFlags; } typedef Grid<int> type1;inline const Grid<Real>& getArg2() { return dist; } typedef Grid<Real> type2;inline const MACGrid& getArg3() { return src; } typedef MACGrid type3;inline MACGrid& getArg4() { return dst; } typedef MACGrid type4;inline Real& getArg5() { return maxTime; } typedef Real type5; void runMessage() { debMsg("Executing kernel knFmTransportVel ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r)  {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ>1) { for (int k=__r.begin(); k!=(int)__r.end(); k++) for (int j=1; j<_maxY; j++) for (int i=1; i<_maxX; i++) op(i,j,k,flags,fmFlags,dist,src,dst,maxTime,changed); } else { const int k=0; for (int j=__r.begin(); j!=(int)__r.end(); j++) for (int i=1; i<_maxX; i++) op(i,j,k,flags,fmFlags,dist,src,dst,maxTime,changed); }  } void run() {  if (maxZ>1) tbb::parallel_reduce (tbb::blocked_range<IndexInt>(minZ, maxZ), *this); else tbb::parallel_reduce (tbb::blocked_range<IndexInt>(1, maxY), *this);  }  knFmTransportVel (knFmTransportVel& o, tbb::split) : KernelBase(o) ,flags(o.flags),fmFlags(o.fmFlags),dist(o.dist),src(o.src),dst(o.dst),maxTime(o.maxTime) ,changed(0) {} void join(const knFmTransportVel & o) { changed += o.changed;  }  const FlagGrid& flags; const Grid<int>& fmFlags; const Grid<Real>& dist; const MACGrid& src; MACGrid& dst; Real maxTime;  int changed;  };
+
+//! write back reached cells as initialized
+
+ struct knFmFinishIterative : public KernelBase { knFmFinishIterative(Grid<int>& fmFlags, Grid<Real>& phi, const Grid<Real>& dist, int tdir) :  KernelBase(&phi,0) ,fmFlags(fmFlags),phi(phi),dist(dist),tdir(tdir)  { runMessage(); run(); }   inline void op(IndexInt idx, Grid<int>& fmFlags, Grid<Real>& phi, const Grid<Real>& dist, int tdir ) const {
+	if (fmFlags[idx] == FmInited || dist[idx] >= FmUnknown) return;
+	phi[idx] = dist[idx] * tdir;
+	fmFlags[idx] = FmInited;
+}    inline Grid<int>& getArg0() { return fmFlags; } typedef Grid<int> type0;inline Grid<Real>& getArg1() { return phi; } typedef Grid<Real> type1;inline const Grid<Real>& getArg2() { return dist; } typedef Grid<Real> type2;inline int& getArg3() { return tdir; } typedef int type3; void runMessage() { debMsg("Executing kernel knFmFinishIterative ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, fmFlags,phi,dist,tdir);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  Grid<int>& fmFlags; Grid<Real>& phi; const Grid<Real>& dist; int tdir;  };
+
 /*****************************************************************************/
 //! Walk...
 template<class COMP, int TDIR>
 void FastMarch<COMP,TDIR>::performMarching() {
+	// in parallel mode the heap stays empty
+	if (mParallel) performIterative();
+
 	mReheapVal = 0.0;
 	while(mHeap.size() > 0) {
 		
@@ -232,6 +354,43 @@ void FastMarch<COMP,TDIR>::performMarching() {
 	setls.getArg0(); // get rid of compiler warning...
 }
 
+//! Parallel alternative to the heap walk: Jacobi iterations of the upwind update over all cells
+//  that are not initialized, until no distance changes anymore. Values are computed as
+//  unsigned distances in marching direction and written back to the levelset at the end.
+template<class COMP, int TDIR>
+void FastMarch<COMP,TDIR>::performIterative() {
+	const Real maxTime = mMaxTime * TDIR;
+	Grid<Real> dist(mLevelset.getParent()), distNew(mLevelset.getParent());
+	knFmInitIterative(mFmFlags, mLevelset, dist, TDIR);
+	distNew.copyFrom(dist);
+
+	// information travels at least one cell per iteration, the limit only guards against
+	// round-off oscillations
+	const int maxIter = 4 * ((int)maxTime + 2);
+	int iter = 0;
+	for (int changed = 1; changed > 0 && iter < maxIter; iter++) {
+		changed = knFmIterate(mFmFlags, dist, distNew, maxTime);
+		dist.swap(distNew);
+	}
+	debMsg("FastMarch::performIterative " << iter << " iterations", 2);
+
+	if (mVelTransport.isInitialized()) {
+		// velTransport might use external data, so alternate with a copy instead of swapping
+		MACGrid& vel = *mVelTransport.getVal();
+		MACGrid velTmp(vel.getParent());
+		velTmp.copyFrom(vel);
+		MACGrid* src = &vel;
+		MACGrid* dst = &velTmp;
+		for (int changed = 1, it = 0; changed > 0 && it < maxIter; it++) {
+			changed = knFmTransportVel(mFlags, mFmFlags, dist, *src, *dst, maxTime);
+			std::swap(src, dst);
+		}
+		if (src != &vel) vel.copyFrom(*src);
+	}
+
+	knFmFinishIterative(mFmFlags, mLevelset, dist, TDIR);
+}
+
 // explicit instantiation
 template class FastMarch<FmHeapEntryIn, -1>;
 template class FastMarch<FmHeapEntryOut, +1>;
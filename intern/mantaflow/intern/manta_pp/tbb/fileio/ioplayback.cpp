@@ -0,0 +1,346 @@
+// DO NOT EDIT !
+// This file is generated using the MantaFlow preprocessor (prep generate).
+
+
+
+
+/******************************************************************************
+ *
+ * MantaFlow fluid solver framework
+ *
+ * This program is free software, distributed under the terms of the
+ * Apache License, Version 2.0
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Playback cache: uncompressed multi-grid frame files that are memory-mapped
+ * for reading, recently used frames stay mapped
+ *
+ ******************************************************************************/
+
+#include <cstring>
+#include <list>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "mantaio.h"
+#include "grid.h"
+
+using namespace std;
+
+namespace Manta {
+
+static const int PLAYBACK_VERSION = 1;
+static const int PLAYBACK_NAME_LEN = 64;
+//! grid data starts at page boundaries of the mapped file
+static const uint64_t PLAYBACK_ALIGN = 4096;
+
+//! playback cache file header, followed by numGrids table entries
+typedef struct {
+	char id[4];       // "MNTP"
+	int version;
+	int numGrids;
+	int bytesPerReal; // files are only read by builds with the same floating point precision
+} PlaybackHeader;
+
+typedef struct {
+	char name[PLAYBACK_NAME_LEN];
+	int gridType;     // GridBase::GridType
+	int dim[3];
+	uint64_t offset;  // grid data in the native layout of Grid<T>
+	uint64_t bytes;
+} PlaybackEntry;
+
+//! raw data of int, real and vec3 grids
+static char* playbackGridData(GridBase* grid, uint64_t& bytes) {
+	const uint64_t cells = (uint64_t)grid->getSizeX() * grid->getSizeY() * grid->getSizeZ();
+	if (grid->getType() & GridBase::TypeInt) {
+		bytes = cells * sizeof(int);
+		return (char*) &(*(Grid<int>*)grid)[0];
+	}
+	if (grid->getType() & GridBase::TypeReal) {
+		bytes = cells * sizeof(Real);
+		return (char*) &(*(Grid<Real>*)grid)[0];
+	}
+	if (grid->getType() & GridBase::TypeVec3) {
+		bytes = cells * sizeof(Vec3);
+		return (char*) &(*(Grid<Vec3>*)grid)[0];
+	}
+	errMsg("playback cache: unknown type of grid " << grid->getName());
+	return NULL;
+}
+
+static int playbackBaseType(int gridType) {
+	return gridType & (GridBase::TypeInt | GridBase::TypeReal | GridBase::TypeVec3);
+}
+
+//******************************************************************************
+// Mapped files
+
+//! read-only memory mapping of a whole file
+class MappedFile {
+public:
+	MappedFile(const string& name) : mName(name), mData(NULL), mSize(0), mTime(0), mNode(0)
+#	ifdef WIN32
+		, mFile(INVALID_HANDLE_VALUE), mMapping(NULL)
+#	endif
+	{}
+	~MappedFile() { unmap(); }
+
+	bool map() {
+		if (!stat(mSize, mTime, mNode) || mSize == 0) return false;
+#		ifdef WIN32
+		mFile = CreateFileA(mName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (mFile == INVALID_HANDLE_VALUE) return false;
+		mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mMapping) mData = (const char*) MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+#		else
+		int fd = open(mName.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		void* ptr = mmap(NULL, mSize, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd); // the mapping keeps its own reference
+		if (ptr != MAP_FAILED) {
+			mData = (const char*) ptr;
+			// start reading ahead, the whole frame is copied into the grids right away
+			posix_madvise(ptr, mSize, POSIX_MADV_WILLNEED);
+		}
+#		endif
+		if (!mData) unmap();
+		return mData != NULL;
+	}
+
+	void unmap() {
+#		ifdef WIN32
+		if (mData) UnmapViewOfFile(mData);
+		if (mMapping) CloseHandle(mMapping);
+		if (mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+		mMapping = NULL;
+		mFile = INVALID_HANDLE_VALUE;
+#		else
+		if (mData) munmap((void*)mData, mSize);
+#		endif
+		mData = NULL;
+	}
+
+	//! the file was rewritten or replaced since it was mapped, eg by baking again
+	bool outdated() const {
+		uint64_t size, node; int64_t time;
+		return !stat(size, time, node) || size != mSize || time != mTime || node != mNode;
+	}
+
+	const string& name() const { return mName; }
+	const char* data() const { return mData; }
+	uint64_t size() const { return mSize; }
+
+protected:
+	bool stat(uint64_t& size, int64_t& time, uint64_t& node) const {
+#		ifdef WIN32
+		struct _stat64 st;
+		if (_stat64(mName.c_str(), &st) != 0) return false;
+#		else
+		struct stat st;
+		if (::stat(mName.c_str(), &st) != 0) return false;
+#		endif
+		size = (uint64_t)st.st_size;
+		time = (int64_t)st.st_mtime;
+		node = (uint64_t)st.st_ino;
+		return true;
+	}
+
+	string mName;
+	const char* mData;
+	uint64_t mSize;
+	int64_t mTime;
+	uint64_t mNode;
+#	ifdef WIN32
+	HANDLE mFile, mMapping;
+#	endif
+};
+
+//! least recently used mapped frames, so that scrubbing back and forth doesn't open files again
+class PlaybackCache {
+public:
+	PlaybackCache() : mMaxFrames(8) {}
+	~PlaybackCache() {
+		while (!mFrames.empty()) evict();
+	}
+
+	//! mapped file, the most recently used one stays mapped even if the cache size is 0
+	MappedFile* get(const string& name) {
+		for (list<MappedFile*>::iterator it = mFrames.begin(); it != mFrames.end(); ++it) {
+			if ((*it)->name() != name) continue;
+			MappedFile* file = *it;
+			mFrames.erase(it);
+			if (file->outdated()) {
+				delete file;
+				break;
+			}
+			mFrames.push_front(file);
+			return file;
+		}
+		MappedFile* file = new MappedFile(name);
+		if (!file->map()) {
+			delete file;
+			errMsg("can't map playback cache file " << name);
+		}
+		mFrames.push_front(file);
+		while ((int)mFrames.size() > max(mMaxFrames, 1)) evict();
+		return file;
+	}
+
+	//! unmap a file before it is written again
+	void drop(const string& name) {
+		for (list<MappedFile*>::iterator it = mFrames.begin(); it != mFrames.end(); ++it) {
+			if ((*it)->name() != name) continue;
+			delete *it;
+			mFrames.erase(it);
+			return;
+		}
+	}
+
+	void setSize(int frames) {
+		mMaxFrames = max(frames, 0);
+		while ((int)mFrames.size() > max(mMaxFrames, 1)) evict();
+	}
+
+protected:
+	void evict() {
+		delete mFrames.back();
+		mFrames.pop_back();
+	}
+
+	list<MappedFile*> mFrames; // most recently used first
+	int mMaxFrames;
+};
+
+static PlaybackCache& playbackCache() {
+	static PlaybackCache cache;
+	return cache;
+}
+
+//******************************************************************************
+// Reading and writing
+
+void writeGridsPlayback(const string& name, const vector<GridBase*>& grids, const vector<string>& names) {
+	debMsg("Writing " << grids.size() << " grid(s) to playback cache file " << name, 1);
+
+	PlaybackHeader header;
+	memcpy(header.id, "MNTP", 4);
+	header.version = PLAYBACK_VERSION;
+	header.numGrids = (int)grids.size();
+	header.bytesPerReal = sizeof(Real);
+
+	vector<PlaybackEntry> entries(grids.size());
+	vector<const char*> data(grids.size());
+	uint64_t offset = sizeof(PlaybackHeader) + grids.size() * sizeof(PlaybackEntry);
+	for (size_t i=0; i<grids.size(); ++i) {
+		GridBase* grid = grids[i];
+		const string gridName = (i < names.size()) ? names[i] : grid->getName();
+		if (gridName.size() >= (size_t)PLAYBACK_NAME_LEN) errMsg("playback cache: grid name " << gridName << " is too long");
+
+		PlaybackEntry& entry = entries[i];
+		memset(&entry, 0, sizeof(PlaybackEntry));
+		strncpy(entry.name, gridName.c_str(), PLAYBACK_NAME_LEN-1);
+		entry.gridType = grid->getType();
+		entry.dim[0] = grid->getSizeX();
+		entry.dim[1] = grid->getSizeY();
+		entry.dim[2] = grid->getSizeZ();
+		offset = (offset + PLAYBACK_ALIGN - 1) / PLAYBACK_ALIGN * PLAYBACK_ALIGN;
+		entry.offset = offset;
+		data[i] = playbackGridData(grid, entry.bytes);
+		offset += entry.bytes;
+	}
+
+	// never write into a mapped file
+	playbackCache().drop(name);
+
+	// uncompressed, see GzWriter
+	GzWriter file(name, -1);
+	if (!file.good()) errMsg("can't open file " << name);
+	file.write(&header, sizeof(PlaybackHeader));
+	if (!entries.empty()) file.write(&entries[0], entries.size() * sizeof(PlaybackEntry));
+	uint64_t pos = sizeof(PlaybackHeader) + entries.size() * sizeof(PlaybackEntry);
+	const vector<char> padding(PLAYBACK_ALIGN, 0);
+	for (size_t i=0; i<entries.size(); ++i) {
+		file.write(&padding[0], entries[i].offset - pos);
+		file.write(data[i], entries[i].bytes);
+		pos = entries[i].offset + entries[i].bytes;
+	}
+	file.close();
+}
+
+void readGridsPlayback(const string& name, const vector<GridBase*>& grids, const vector<string>& names) {
+	debMsg("Reading " << grids.size() << " grid(s) from playback cache file " << name, 1);
+
+	waitForFileWrite(name);
+	MappedFile* file = playbackCache().get(name);
+
+	const PlaybackHeader* header = (const PlaybackHeader*) file->data();
+	if (file->size() < sizeof(PlaybackHeader) || memcmp(header->id, "MNTP", 4) != 0)
+		errMsg("file " << name << " is not a playback cache file");
+	if (header->version != PLAYBACK_VERSION)
+		errMsg("playback cache file " << name << " has unsupported version " << header->version);
+	if (header->bytesPerReal != (int)sizeof(Real))
+		errMsg("playback cache file " << name << " was written with a different floating point precision");
+	if (file->size() < sizeof(PlaybackHeader) + header->numGrids * sizeof(PlaybackEntry))
+		errMsg("playback cache file " << name << " is truncated");
+	const PlaybackEntry* entries = (const PlaybackEntry*) (file->data() + sizeof(PlaybackHeader));
+
+	for (size_t i=0; i<grids.size(); ++i) {
+		GridBase* grid = grids[i];
+		const string gridName = (i < names.size()) ? names[i] : grid->getName();
+
+		const PlaybackEntry* entry = NULL;
+		for (int j=0; j<header->numGrids && !entry; ++j) {
+			if (strncmp(entries[j].name, gridName.c_str(), PLAYBACK_NAME_LEN) == 0) entry = &entries[j];
+		}
+		if (!entry) errMsg("grid " << gridName << " not found in playback cache file " << name);
+
+		uint64_t bytes;
+		char* data = playbackGridData(grid, bytes);
+		if (playbackBaseType(entry->gridType) != playbackBaseType(grid->getType()))
+			errMsg("grid " << gridName << " in playback cache file " << name << " has a different type");
+		if (entry->dim[0] != grid->getSizeX() || entry->dim[1] != grid->getSizeY() || entry->dim[2] != grid->getSizeZ())
+			errMsg("grid " << gridName << " in playback cache file " << name << " has size " << Vec3i(entry->dim[0], entry->dim[1], entry->dim[2]) << ", expected " << grid->getSize());
+		if (entry->bytes != bytes || entry->offset + entry->bytes > file->size())
+			errMsg("playback cache file " << name << " is truncated");
+
+		memcpy(data, file->data() + entry->offset, bytes);
+		countBytesRead(bytes);
+	}
+}
+
+//******************************************************************************
+// Python interface
+
+//! write several grids (eg all grids of a frame) into one uncompressed playback cache file,
+//! stored under their variable names or the comma separated names given
+void savePlaybackCache(const string& name, std::vector<PbClass*> grids, const string& names="") {
+	vector<GridBase*> gridList;
+	vector<string> nameList;
+	getGridList(grids, names, gridList, nameList);
+	writeGridsPlayback(name, gridList, nameList);
+} static PyObject* _W_0 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "savePlaybackCache" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const string& name = _args.get<string >("name",0,&_lock); std::vector<PbClass*> grids = _args.get<std::vector<PbClass*> >("grids",1,&_lock); const string& names = _args.getOpt<string >("names",2,"",&_lock);   _retval = getPyNone(); savePlaybackCache(name,grids,names);  _args.check(); } pbFinalizePlugin(parent,"savePlaybackCache", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("savePlaybackCache",e.what()); return 0; } } static const Pb::Register _RP_savePlaybackCache ("","savePlaybackCache",_W_0);  extern "C" { void PbRegister_savePlaybackCache() { KEEP_UNUSED(_RP_savePlaybackCache); } }
+
+//! copy grids from a memory-mapped playback cache file, one memcpy per grid
+void loadPlaybackCache(const string& name, std::vector<PbClass*> grids, const string& names="") {
+	vector<GridBase*> gridList;
+	vector<string> nameList;
+	getGridList(grids, names, gridList, nameList);
+	readGridsPlayback(name, gridList, nameList);
+} static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "loadPlaybackCache" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const string& name = _args.get<string >("name",0,&_lock); std::vector<PbClass*> grids = _args.get<std::vector<PbClass*> >("grids",1,&_lock); const string& names = _args.getOpt<string >("names",2,"",&_lock);   _retval = getPyNone(); loadPlaybackCache(name,grids,names);  _args.check(); } pbFinalizePlugin(parent,"loadPlaybackCache", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("loadPlaybackCache",e.what()); return 0; } } static const Pb::Register _RP_loadPlaybackCache ("","loadPlaybackCache",_W_1);  extern "C" { void PbRegister_loadPlaybackCache() { KEEP_UNUSED(_RP_loadPlaybackCache); } }
+
+//! number of playback cache files that stay mapped after loading
+void setPlaybackCacheSize(int frames=8) {
+	playbackCache().setSize(frames);
+} static PyObject* _W_2 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "setPlaybackCacheSize" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; int frames = _args.getOpt<int >("frames",0,8,&_lock);   _retval = getPyNone(); setPlaybackCacheSize(frames);  _args.check(); } pbFinalizePlugin(parent,"setPlaybackCacheSize", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("setPlaybackCacheSize",e.what()); return 0; } } static const Pb::Register _RP_setPlaybackCacheSize ("","setPlaybackCacheSize",_W_2);  extern "C" { void PbRegister_setPlaybackCacheSize() { KEEP_UNUSED(_RP_setPlaybackCacheSize); } }
+
+} // namespace
@@ -0,0 +1,305 @@
+// DO NOT EDIT !
+// This file is generated using the MantaFlow preprocessor (prep generate).
+
+
+
+
+/******************************************************************************
+ *
+ * MantaFlow fluid solver framework
+ *
+ * This program is free software, distributed under the terms of the
+ * Apache License, Version 2.0
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Staged writing of compressed files, optionally on background threads
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <deque>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if NO_ZLIB!=1
+extern "C" {
+#include <zlib.h>
+}
+#endif
+
+#ifdef WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "mantaio.h"
+#include "manta.h"
+#include "timing.h"
+
+using namespace std;
+
+namespace Manta {
+
+#if NO_ZLIB!=1
+
+//! write a complete buffer, gzwrite takes at most an unsigned int number of bytes per call
+static bool gzWriteBuffer(gzFile gzf, const char* data, size_t bytes) {
+	const size_t chunk = 1 << 30;
+	for (size_t pos = 0; pos < bytes; pos += chunk) {
+		const unsigned int len = (unsigned int)min(chunk, bytes - pos);
+		if (gzwrite(gzf, data + pos, len) != (int)len) return false;
+	}
+	return true;
+}
+
+//! open an output file, compression levels < 0 write plain files
+static void* openFile(const string& name, int level) {
+	if (level < 0) return fopen(name.c_str(), "wb");
+	char mode[4] = "wb1";
+	mode[2] = '0' + level;
+	return gzopen(name.c_str(), mode);
+}
+
+static bool writeFile(void* file, int level, const char* data, size_t bytes) {
+	if (level < 0) return fwrite(data, 1, bytes, (FILE*)file) == bytes;
+	return gzWriteBuffer((gzFile)file, data, bytes);
+}
+
+static void closeFile(void* file, int level) {
+	if (level < 0) fclose((FILE*)file);
+	else           gzclose((gzFile)file);
+}
+
+//! paths of queued files are compared with unified separators, readers may build them differently
+static string pendingKey(const string& name) {
+	string key;
+	for (size_t i=0; i<name.size(); ++i) {
+		const char c = (name[i] == '\\') ? '/' : name[i];
+		if (c == '/' && !key.empty() && key[key.size()-1] == '/') continue;
+		key += c;
+	}
+	return key;
+}
+
+//! a staged file, compressed and written by one of the writer threads
+struct FileWriteJob {
+	string name;
+	int level;
+	vector<char>* data;
+};
+
+//! bounded queue of staged files and the threads writing them, shared by all solvers of the process
+class FileWriteQueue {
+public:
+	FileWriteQueue() : mMaxQueued(0), mBusy(0), mStop(false), mPid(0) {}
+	~FileWriteQueue() { stopThreads(); }
+
+	//! (re)start the writer threads, 0 threads switches to synchronous writing. Running threads
+	//! are kept if nothing changes, another solver can still have files in the queue
+	void setThreads(int numThreads, int maxQueued) {
+		if (active() && (int)mThreads.size() == numThreads && mMaxQueued == max(maxQueued, 1)) return;
+		flush();
+		stopThreads();
+		mMaxQueued = max(maxQueued, 1);
+		mPid = getpid();
+		for (int i=0; i<numThreads; ++i)
+			mThreads.push_back(thread(&FileWriteQueue::work, this));
+	}
+
+	//! threads are not inherited by forked processes, these write synchronously
+	bool active() const { return !mThreads.empty() && mPid == getpid(); }
+
+	//! queue a staged file, blocks while the queue is full
+	void push(const FileWriteJob& job) {
+		unique_lock<mutex> lock(mMutex);
+		mChanged.wait(lock, [this] { return (int)mJobs.size() < mMaxQueued; });
+		mJobs.push_back(job);
+		mPending.insert(pendingKey(job.name));
+		mQueued.notify_one();
+	}
+
+	//! wait until a file is on disk, files that are not queued return immediately
+	void wait(const string& name) {
+		if (!active()) return;
+		const string key = pendingKey(name);
+		unique_lock<mutex> lock(mMutex);
+		mChanged.wait(lock, [&] { return mPending.count(key) == 0; });
+	}
+
+	//! report the first error of the writer threads since the last check, the file that failed
+	//! was queued by an earlier save call
+	void checkErrors() {
+		if (!active()) return;
+		string error;
+		{
+			lock_guard<mutex> lock(mMutex);
+			error.swap(mError);
+		}
+		if (!error.empty()) errMsg(error);
+	}
+
+	//! wait until all queued files are written, and report errors from the writer threads
+	void flush() {
+		if (!active()) return;
+		string error;
+		{
+			unique_lock<mutex> lock(mMutex);
+			mChanged.wait(lock, [this] { return mJobs.empty() && mBusy == 0; });
+			error.swap(mError);
+		}
+		if (!error.empty()) errMsg(error);
+	}
+
+protected:
+	void stopThreads() {
+		if (!mThreads.empty() && mPid != getpid()) {
+			// threads of the parent process, these can't be joined (or destroyed) after a fork
+			new vector<thread>(std::move(mThreads));
+			mThreads.clear();
+			return;
+		}
+		{
+			lock_guard<mutex> lock(mMutex);
+			mStop = true;
+		}
+		mQueued.notify_all();
+		for (size_t i=0; i<mThreads.size(); ++i)
+			if (mThreads[i].joinable()) mThreads[i].join();
+		mThreads.clear();
+		mStop = false;
+	}
+
+	void work() {
+		while (true) {
+			FileWriteJob job;
+			{
+				unique_lock<mutex> lock(mMutex);
+				mQueued.wait(lock, [this] { return mStop || !mJobs.empty(); });
+				if (mJobs.empty()) return; // stop requested and nothing left
+				job = mJobs.front();
+				mJobs.pop_front();
+				mBusy++;
+			}
+			mChanged.notify_all(); // there is space in the queue again
+
+			string error;
+			void* file = openFile(job.name, job.level);
+			if (!file)
+				error = "can't open file " + job.name;
+			else {
+				if (!writeFile(file, job.level, job.data->data(), job.data->size()))
+					error = "can't write file " + job.name;
+				closeFile(file, job.level);
+			}
+			delete job.data;
+
+			{
+				lock_guard<mutex> lock(mMutex);
+				if (!error.empty() && mError.empty()) mError = error;
+				mPending.erase(mPending.find(pendingKey(job.name)));
+				mBusy--;
+			}
+			mChanged.notify_all();
+		}
+	}
+
+	vector<thread> mThreads;
+	deque<FileWriteJob> mJobs;
+	multiset<string> mPending;
+	mutex mMutex;
+	condition_variable mQueued, mChanged;
+	int mMaxQueued, mBusy;
+	bool mStop;
+	int mPid;
+	string mError;
+};
+
+static FileWriteQueue& writeQueue() {
+	static FileWriteQueue queue;
+	return queue;
+}
+
+//******************************************************************************
+// GzWriter
+
+GzWriter::GzWriter(const string& name, int level) :
+	mName(name), mLevel(level), mGzf(NULL), mData(NULL)
+{
+	// fail the next save after a background write failed, instead of only when the writes are flushed
+	writeQueue().checkErrors();
+	if (writeQueue().active()) {
+		// staging buffer, the grid or particle data can change as soon as the save call returns
+		mData = new vector<char>();
+	} else {
+		mGzf = openFile(name, level);
+	}
+}
+
+GzWriter::~GzWriter() {
+	// not closed, eg due to an error while writing: never queue incomplete files
+	if (mGzf) closeFile(mGzf, mLevel);
+	delete mData;
+}
+
+void GzWriter::write(const void* data, size_t bytes) {
+	TimingData::instance().addCounter("bytesWritten", (double)bytes);
+	if (mData) {
+		const char* ptr = (const char*)data;
+		mData->insert(mData->end(), ptr, ptr + bytes);
+	} else if (mGzf) {
+		writeFile(mGzf, mLevel, (const char*)data, bytes);
+	}
+}
+
+void GzWriter::close() {
+	if (mData) {
+		FileWriteJob job;
+		job.name  = mName;
+		job.level = mLevel;
+		job.data  = mData;
+		mData = NULL;
+		writeQueue().push(job);
+	} else if (mGzf) {
+		closeFile(mGzf, mLevel);
+		mGzf = NULL;
+	}
+}
+
+void waitForFileWrite(const string& name) {
+	writeQueue().wait(name);
+}
+
+#else
+
+void waitForFileWrite(const string& name) {}
+
+#endif // NO_ZLIB!=1
+
+void countBytesRead(size_t bytes) {
+	TimingData::instance().addCounter("bytesRead", (double)bytes);
+}
+
+//******************************************************************************
+// Python interface
+
+//! write compressed cache files (.uni, .raw, .bobj.gz) on background threads. Data is copied
+//! into a staging buffer when saving, at most queueSize files are held in memory at once.
+//! The threads are shared by all solvers, calling this again with the same settings keeps them
+void setFileWriteThreads(int threads=0, int queueSize=8) {
+#	if NO_ZLIB!=1
+	writeQueue().setThreads(threads, queueSize);
+#	endif
+} static PyObject* _W_0 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "setFileWriteThreads" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; int threads = _args.getOpt<int >("threads",0,0,&_lock); int queueSize = _args.getOpt<int >("queueSize",1,8,&_lock);   _retval = getPyNone(); setFileWriteThreads(threads,queueSize);  _args.check(); } pbFinalizePlugin(parent,"setFileWriteThreads", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("setFileWriteThreads",e.what()); return 0; } } static const Pb::Register _RP_setFileWriteThreads ("","setFileWriteThreads",_W_0);  extern "C" { void PbRegister_setFileWriteThreads() { KEEP_UNUSED(_RP_setFileWriteThreads); } }
+
+//! wait until all queued files are written
+void flushFileWrites() {
+#	if NO_ZLIB!=1
+	writeQueue().flush();
+#	endif
+} static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "flushFileWrites" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock;   _retval = getPyNone(); flushFileWrites();  _args.check(); } pbFinalizePlugin(parent,"flushFileWrites", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("flushFileWrites",e.what()); return 0; } } static const Pb::Register _RP_flushFileWrites ("","flushFileWrites",_W_1);  extern "C" { void PbRegister_flushFileWrites() { KEEP_UNUSED(_RP_flushFileWrites); } }
+
+} // namespace
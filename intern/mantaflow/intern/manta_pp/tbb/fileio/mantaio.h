@@ -27,11 +27,15 @@
 #define _FILEIO_H
 
 #include <string>
+#include <vector>
+#include "vectorbase.h"
 
 namespace Manta {
 
 // forward decl.
 class Mesh;
+class GridBase;
+class PbClass;
 class FlagGrid;
 template<class T> class Grid;
 template<class T> class Grid4d;
@@ -52,9 +56,12 @@ template<class T> void writeGridTxt(const std::string& name, Grid<T>* grid);
 #if OPENVDB==1
 template<class T> void writeGridVDB(const std::string& name, Grid<T>* grid);
 template<class T> void readGridVDB(const std::string& name, Grid<T>* grid);
+void writeGridsVDB(const std::string& name, const std::vector<GridBase*>& grids, const std::vector<std::string>& names);
+void readGridsVDB (const std::string& name, const std::vector<GridBase*>& grids, const std::vector<std::string>& names);
 #endif // OPENVDB==1
 
 template<class T> void readGridUni (const std::string& name, Grid<T>* grid);
+template<class T> void readGridUniRegion (const std::string& name, Grid<T>* grid, Vec3i offset);
 template<class T> void readGridRaw (const std::string& name, Grid<T>* grid);
 template<class T> void readGridVol (const std::string& name, Grid<T>* grid);
 
@@ -75,6 +82,41 @@ template <class T> void readMdataUni (const std::string& name, MeshDataImpl<T>*
 
 void getUniFileSize(const std::string& name, int& x, int& y, int& z, int* t = NULL, std::string* info = NULL);
 
+//! manta grids from a python list, optionally renamed by a comma separated list of names
+void getGridList(const std::vector<PbClass*>& objects, const std::string& names, std::vector<GridBase*>& grids, std::vector<std::string>& gridNames);
+void writeGridsPlayback(const std::string& name, const std::vector<GridBase*>& grids, const std::vector<std::string>& names);
+void readGridsPlayback (const std::string& name, const std::vector<GridBase*>& grids, const std::vector<std::string>& names);
+
+//! compressed output file, written directly or copied to a staging buffer that is compressed
+//! and written by the background writer threads if these are enabled (see setFileWriteThreads).
+//! Compression levels < 0 write a plain file, for data that is compressed already
+class GzWriter {
+public:
+	GzWriter(const std::string& name, int level=1);
+	~GzWriter();
+	bool good() const { return mGzf || mData; }
+	void write(const void* data, size_t bytes);
+	//! finish the file, staged files that are never closed are dropped
+	void close();
+protected:
+	GzWriter(const GzWriter&);
+	GzWriter& operator=(const GzWriter&);
+
+	std::string mName;
+	int mLevel;
+	void* mGzf;
+	std::vector<char>* mData;
+};
+
+//! block until a queued file has been written, needed before reading it
+void waitForFileWrite(const std::string& name);
+void setFileWriteThreads(int threads, int queueSize);
+void flushFileWrites();
+
+//! profile counter of the bytes read from cache files, uncompressed for gzip streams (see TimingData::addCounter).
+//! Bytes passed to a GzWriter are counted as written
+void countBytesRead(size_t bytes);
+
 } // namespace
 
 #endif
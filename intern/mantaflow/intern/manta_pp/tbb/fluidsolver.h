@@ -67,6 +67,16 @@ class FluidSolver : public PbClass {public:
 	template<class T> T*   getGridPointer();
 	template<class T> void freeGridPointer(T* ptr);    
 
+	//! changes whenever grids known to python are created or freed, so that callers can cache grid objects.
+	//! Generations are counted across all solvers, a new solver never repeats the generation of a deleted one
+	inline int getGridGeneration() const { return mGridGeneration; }
+	void updateGridGeneration();
+
+	//! grid memory in use (bytes), and peak memory of temporary grids in the last step and over all steps
+	inline long long getGridMemory() const { return mGridMem.used; }
+	inline long long getTempGridPeak() const { return mTempGridPeak; }
+	inline long long getTempGridPeakMax() const { return mTempGridPeakMax; }
+
 	//! expose animation time to python
 	Real mDt;static PyObject* _GET_mDt(PyObject* self, void* cl) { FluidSolver* pbo = dynamic_cast<FluidSolver*>(Pb::objFromPy(self)); return toPy(pbo->mDt); } static int _SET_mDt(PyObject* self, PyObject* val, void* cl) { FluidSolver* pbo = dynamic_cast<FluidSolver*>(Pb::objFromPy(self)); pbo->mDt = fromPy<Real  >(val); return 0; }  
 	Real mTimeTotal;static PyObject* _GET_mTimeTotal(PyObject* self, void* cl) { FluidSolver* pbo = dynamic_cast<FluidSolver*>(Pb::objFromPy(self)); return toPy(pbo->mTimeTotal); } static int _SET_mTimeTotal(PyObject* self, PyObject* val, void* cl) { FluidSolver* pbo = dynamic_cast<FluidSolver*>(Pb::objFromPy(self)); pbo->mTimeTotal = fromPy<Real  >(val); return 0; }
@@ -82,23 +92,37 @@ protected:
 	const int mDim;
 	Real      mTimePerFrame;
 	bool      mLockDt;
+	int       mGridGeneration;
 		
+	//! memory of all grids in use, shared by the grid storages of a solver
+	struct GridMemory {
+		GridMemory() : used(0), peak(0) {}
+		inline void add(long long bytes) { used += bytes; if (used > peak) peak = used; }
+		long long used, peak;
+	};
+	GridMemory mGridMem;
+	long long  mTempGridPeak, mTempGridPeakMax;
+
 	//! subclass for managing grid memory
-	//! stored as a stack to allow fast allocation
+	//! stored as a stack to allow fast allocation, temporary grids of plugins reuse the
+	//! memory of previously released grids instead of allocating (and page faulting) again
 	template<class T> struct GridStorage {
-		GridStorage() : used(0) {}
+		GridStorage() : used(0), cells(0), mem(NULL) {}
 		T* get(Vec3i size);
 		void free();
 		void release(T* ptr);
 		
 		std::vector<T*> grids;
 		int used;
+		long long cells;
+		GridMemory* mem;
 	};
 	
 	//! memory for regular (3d) grids
 	GridStorage<int>  mGridsInt;
 	GridStorage<Real> mGridsReal;
 	GridStorage<Vec3> mGridsVec;
+	GridStorage<Half> mGridsHalf;
 
 
 	//! 4d data section, only required for simulations working with space-time data 
@@ -38,9 +38,10 @@ class LevelsetGrid : public Grid<Real> {public:
         LevelsetGrid(FluidSolver* parent, Real* data, bool show = true);
 	
 	//! reconstruct the levelset using fast marching
+	//! parallel: use the parallel iterative solver instead of the serial heap
 	
 
-void reinitMarching(const FlagGrid& flags, Real maxTime=4.0, MACGrid* velTransport=NULL, bool ignoreWalls=false, bool correctOuterLayer=true, int obstacleType = FlagGrid::TypeObstacle ); static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); LevelsetGrid* pbo = dynamic_cast<LevelsetGrid*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "LevelsetGrid::reinitMarching" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock; const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",0,&_lock); Real maxTime = _args.getOpt<Real >("maxTime",1,4.0,&_lock); MACGrid* velTransport = _args.getPtrOpt<MACGrid >("velTransport",2,NULL,&_lock); bool ignoreWalls = _args.getOpt<bool >("ignoreWalls",3,false,&_lock); bool correctOuterLayer = _args.getOpt<bool >("correctOuterLayer",4,true,&_lock); int obstacleType = _args.getOpt<int >("obstacleType",5,FlagGrid::TypeObstacle ,&_lock);  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->reinitMarching(flags,maxTime,velTransport,ignoreWalls,correctOuterLayer,obstacleType);  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"LevelsetGrid::reinitMarching" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("LevelsetGrid::reinitMarching",e.what()); return 0; } }
+void reinitMarching(const FlagGrid& flags, Real maxTime=4.0, MACGrid* velTransport=NULL, bool ignoreWalls=false, bool correctOuterLayer=true, int obstacleType = FlagGrid::TypeObstacle , bool parallel=false); static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); LevelsetGrid* pbo = dynamic_cast<LevelsetGrid*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "LevelsetGrid::reinitMarching" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock; const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",0,&_lock); Real maxTime = _args.getOpt<Real >("maxTime",1,4.0,&_lock); MACGrid* velTransport = _args.getPtrOpt<MACGrid >("velTransport",2,NULL,&_lock); bool ignoreWalls = _args.getOpt<bool >("ignoreWalls",3,false,&_lock); bool correctOuterLayer = _args.getOpt<bool >("correctOuterLayer",4,true,&_lock); int obstacleType = _args.getOpt<int >("obstacleType",5,FlagGrid::TypeObstacle ,&_lock); bool parallel = _args.getOpt<bool >("parallel",6,false,&_lock);  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->reinitMarching(flags,maxTime,velTransport,ignoreWalls,correctOuterLayer,obstacleType,parallel);  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"LevelsetGrid::reinitMarching" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("LevelsetGrid::reinitMarching",e.what()); return 0; } }
 
 	//! create a triangle mesh from the levelset isosurface
 	void createMesh(Mesh& mesh); static PyObject* _W_2 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); LevelsetGrid* pbo = dynamic_cast<LevelsetGrid*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "LevelsetGrid::createMesh" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock; Mesh& mesh = *_args.getPtr<Mesh >("mesh",0,&_lock);  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->createMesh(mesh);  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"LevelsetGrid::createMesh" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("LevelsetGrid::createMesh",e.what()); return 0; } }
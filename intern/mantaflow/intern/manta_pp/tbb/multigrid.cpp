@@ -235,7 +235,12 @@ GridMg::GridMg(const Vec3i& gridSize)
 	mCoarsestLevelAccuracy(Real(1E-8)),
 	mTrivialEquationScale(Real(1E-6)),
 	mIsASet(false),
-	mIsRhsSet(false)
+	mIsRhsSet(false),
+	mReuseHierarchy(false),
+	mHasHierarchy(false),
+	mMaxChangedFraction(Real(0.01)),
+	mNumChangedSinceRebuild(0),
+	mMinOrder(0)
 {
 	MG_TIMINGS(MuTime time;)
 
@@ -257,6 +262,8 @@ GridMg::GridMg(const Vec3i& gridSize)
 	mb.push_back(std::vector<Real>(n));
 	mr.push_back(std::vector<Real>(n));
 	mType.push_back(std::vector<VertexType>(n));
+	mOwner.push_back(std::vector<int>());
+	mOrder.push_back(std::vector<int>());
 	mCGtmp1.push_back(std::vector<double>());
 	mCGtmp2.push_back(std::vector<double>());
 	mCGtmp3.push_back(std::vector<double>());
@@ -279,6 +286,8 @@ GridMg::GridMg(const Vec3i& gridSize)
 		mb.push_back(std::vector<Real>(n));
 		mr.push_back(std::vector<Real>(n));
 		mType.push_back(std::vector<VertexType>(n));
+		mOwner.push_back(std::vector<int>(n, -1));
+		mOrder.push_back(std::vector<int>(n, 0));
 		mCGtmp1.push_back(std::vector<double>());
 		mCGtmp2.push_back(std::vector<double>());
 		mCGtmp3.push_back(std::vector<double>());
@@ -395,10 +404,45 @@ void GridMg::analyzeStencil(int v, bool is3D, bool& isStencilSumNonZero, bool& i
 	}
 }    inline std::vector<GridMg::VertexType>& getArg0() { return type_0; } typedef std::vector<GridMg::VertexType> type0;inline std::vector<Real>& getArg1() { return A0; } typedef std::vector<Real> type1;inline bool& getArg2() { return nonZeroStencilSumFound; } typedef bool type2;inline bool& getArg3() { return trivialEquationsFound; } typedef bool type3;inline const GridMg& getArg4() { return mg; } typedef GridMg type4; void runMessage() { debMsg("Executing kernel knActivateVertices ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, type_0,A0,nonZeroStencilSumFound,trivialEquationsFound,mg);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  std::vector<GridMg::VertexType>& type_0; std::vector<Real>& A0; bool& nonZeroStencilSumFound; bool& trivialEquationsFound; const GridMg& mg;   };
 
+
+ struct knMarkChangedVertices : public KernelBase { knMarkChangedVertices(std::vector<char>& dirty, const std::vector<Real>& A0Prev, const std::vector<GridMg::VertexType>& type0Prev, const GridMg& mg) :  KernelBase(dirty.size()) ,dirty(dirty),A0Prev(A0Prev),type0Prev(type0Prev),mg(mg)   { runMessage(); run(); }   inline void op(IndexInt idx, std::vector<char>& dirty, const std::vector<Real>& A0Prev, const std::vector<GridMg::VertexType>& type0Prev, const GridMg& mg ) const {
+	char flag = 0;
+
+	// active state changed
+	if ((mg.mType[0][idx] == GridMg::vtInactive) != (type0Prev[idx] == GridMg::vtInactive)) flag |= 2;
+
+	// stencil entries stored at idx changed
+	for (int i=0; i<mg.mStencilSize0; i++) {
+		if (mg.mA[0][idx*mg.mStencilSize0 + i] != A0Prev[idx*mg.mStencilSize0 + i]) flag |= 1;
+	}
+
+	dirty[idx] = flag;
+}    inline std::vector<char>& getArg0() { return dirty; } typedef std::vector<char> type0;inline const std::vector<Real>& getArg1() { return A0Prev; } typedef std::vector<Real> type1;inline const std::vector<GridMg::VertexType>& getArg2() { return type0Prev; } typedef std::vector<GridMg::VertexType> type2;inline const GridMg& getArg3() { return mg; } typedef GridMg type3; void runMessage() { debMsg("Executing kernel knMarkChangedVertices ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, dirty,A0Prev,type0Prev,mg);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } std::vector<char>& dirty; const std::vector<Real>& A0Prev; const std::vector<GridMg::VertexType>& type0Prev; const GridMg& mg;   };
+
+
+void GridMg::setReuseHierarchy(bool reuse, Real maxChangedFraction)
+{
+	if (reuse != mReuseHierarchy) {
+		// the previous system is only tracked while reusing
+		std::vector<Real>().swap(mA0Prev);
+		std::vector<VertexType>().swap(mType0Prev);
+		std::vector<std::vector<char>>().swap(mDirty);
+	}
+	mReuseHierarchy = reuse;
+	mMaxChangedFraction = maxChangedFraction;
+}
+
 void GridMg::setA(const Grid<Real>* pA0, const Grid<Real>* pAi, const Grid<Real>* pAj, const Grid<Real>* pAk)
 {
 	MG_TIMINGS(MuTime time;)
-		
+
+	// keep the previous level 0 system to find the changed equations
+	const bool update = mReuseHierarchy && mHasHierarchy;
+	if (update) {
+		if (mA0Prev.size() == mA[0].size()) { mA0Prev.swap(mA[0]); mType0Prev.swap(mType[0]); }
+		else                                { mA0Prev = mA[0];     mType0Prev = mType[0]; }
+	}
+
 	// Copy level 0
 	knCopyA(mx[0], mA[0], mStencilSize0, mIs3D, pA0, pAi, pAj, pAk);
 		
@@ -413,13 +457,20 @@ void GridMg::setA(const Grid<Real>* pA0, const Grid<Real>* pAi, const Grid<Real>
 	// Sanity check: if all rows of A sum up to 0 --> A doesn't have full rank (opposite direction isn't necessarily true)
     if (!nonZeroStencilSumFound) debMsg("GridMg::setA: Found constant mode: A*1=0! A does not have full rank and multigrid may not converge. (forgot to fix a pressure value?)", 1);
 	
-	// Create coarse grids and operators on levels >0
-	for (int l=1; l<mA.size(); l++) {
-		MG_TIMINGS(time.get();)
-		genCoarseGrid(l);	
-		MG_TIMINGS(debMsg("GridMg: Generated level "<<l<<" in "<<time.update(), 1);)
-		genCoraseGridOperator(l);	
-		MG_TIMINGS(debMsg("GridMg: Generated operator "<<l<<" in "<<time.update(), 1);)
+	// Update the coarse levels of the previous hierarchy if possible,
+	// otherwise create coarse grids and operators on levels >0
+	if (update && updateHierarchy()) {
+		MG_TIMINGS(debMsg("GridMg: Updated hierarchy in "<<time.update(), 1);)
+	} else {
+		for (size_t l=1; l<mA.size(); l++) {
+			MG_TIMINGS(time.get();)
+			genCoarseGrid(l);
+			MG_TIMINGS(debMsg("GridMg: Generated level "<<l<<" in "<<time.update(), 1);)
+			genCoraseGridOperator(l);
+			MG_TIMINGS(debMsg("GridMg: Generated operator "<<l<<" in "<<time.update(), 1);)
+		}
+		mHasHierarchy = true;
+		mNumChangedSinceRebuild = 0;
 	}
 
 	mIsASet   = true;
@@ -538,6 +589,8 @@ void GridMg::genCoarseGrid(int l)
 
 	// initialize all coarse vertices with 'free'
 	knSet<VertexType>(mType[l], vtFree);
+	knSet<int>(mOwner[l], -1);
+	int order = 0;
 
 	// initialize min heap of (ID: fine grid vertex, key: #free interpolation vertices) pairs
 	NKMinHeap heap(int(mb[l-1].size()), mIs3D ? 9 : 5); // max 8 (or 4 in 2D) free interpolation vertices
@@ -570,6 +623,8 @@ void GridMg::genCoarseGrid(int l)
 					mType[l][i] = vtRemoved; 
 				} else {
 					mType[l][i] = vtZero; 
+					mOwner[l][i] = v;
+					mOrder[l][i] = order++;
 					vdone = true;
 				}
 
@@ -591,81 +646,85 @@ void GridMg::genCoarseGrid(int l)
 
 
 
- struct knGenCoarseGridOperator : public KernelBase { knGenCoarseGridOperator(std::vector<Real>& sizeRef, std::vector<Real>& A, int l, const GridMg& mg) :  KernelBase(sizeRef.size()) ,sizeRef(sizeRef),A(A),l(l),mg(mg)   { runMessage(); run(); }   inline void op(IndexInt idx, std::vector<Real>& sizeRef, std::vector<Real>& A, int l, const GridMg& mg ) const {
-	if (mg.mType[l][idx] == GridMg::vtInactive) return;
-
-	for (int i=0; i<mg.mStencilSize; i++) { A[idx*mg.mStencilSize+i] = Real(0); } // clear stencil
-
-	Vec3i V = mg.vecIdx(int(idx),l);
+// Calculate the stencil of A_l at the active coarse vertex v by considering all vertex paths of the form:
+// (V) <--restriction-- (U) <--A_{l-1}-- (W) <--interpolation-- (N)
+// V and N are vertices on the coarse grid level l,
+// U and W are vertices on the fine grid level l-1.
+void GridMg::genCoarseStencil(int v, int l, Real* stencil) const
+{
+	for (int i=0; i<mStencilSize; i++) { stencil[i] = Real(0); } // clear stencil
 
-	// Calculate the stencil of A_l at V by considering all vertex paths of the form:
-	// (V) <--restriction-- (U) <--A_{l-1}-- (W) <--interpolation-- (N)
-	// V and N are vertices on the coarse grid level l, 
-	// U and W are vertices on the fine grid level l-1.
+	Vec3i V = vecIdx(v,l);
 
 	if (l==1) {
 		// loop over precomputed paths
-		for (auto it = mg.mCoarseningPaths0.begin(); it != mg.mCoarseningPaths0.end(); it++) {
+		for (auto it = mCoarseningPaths0.begin(); it != mCoarseningPaths0.end(); it++) {
 			Vec3i N = V + it->N;
-			int n = mg.linIdx(N,l);
-			if (!mg.inGrid(N,l) || mg.mType[l][n]==GridMg::vtInactive) continue;
+			int n = linIdx(N,l);
+			if (!inGrid(N,l) || mType[l][n]==vtInactive) continue;
 
 			Vec3i U = V*2 + it->U;
-			int u = mg.linIdx(U,l-1);
-			if (!mg.inGrid(U,l-1) || mg.mType[l-1][u]==GridMg::vtInactive) continue;
+			int u = linIdx(U,l-1);
+			if (!inGrid(U,l-1) || mType[l-1][u]==vtInactive) continue;
 
 			Vec3i W = V*2 + it->W;
-			int w = mg.linIdx(W,l-1);
-			if (!mg.inGrid(W,l-1) || mg.mType[l-1][w]==GridMg::vtInactive) continue;
-				
+			int w = linIdx(W,l-1);
+			if (!inGrid(W,l-1) || mType[l-1][w]==vtInactive) continue;
+
 			if (it->inUStencil) {
-				A[idx*mg.mStencilSize + it->sc] += it->rw * mg.mA[l-1][u*mg.mStencilSize0 + it->sf] *it->iw;			
+				stencil[it->sc] += it->rw * mA[l-1][u*mStencilSize0 + it->sf] *it->iw;
 			} else {
-				A[idx*mg.mStencilSize + it->sc] += it->rw * mg.mA[l-1][w*mg.mStencilSize0 + it->sf] *it->iw;			
+				stencil[it->sc] += it->rw * mA[l-1][w*mStencilSize0 + it->sf] *it->iw;
 			}
 		}
 	} else {
-		// l > 1: 
+		// l > 1:
 		// loop over restriction vertices U on level l-1 associated with V
-		FOR_VEC_MINMAX(U, vmax(0, V*2-1), vmin(mg.mSize[l-1]-1, V*2+1)) {
-			int u = mg.linIdx(U,l-1);
-			if (mg.mType[l-1][u] == GridMg::vtInactive) continue;
+		FOR_VEC_MINMAX(U, vmax(0, V*2-1), vmin(mSize[l-1]-1, V*2+1)) {
+			int u = linIdx(U,l-1);
+			if (mType[l-1][u] == vtInactive) continue;
 
-			// restriction weight			
-			Real rw = Real(1) / Real(1 << ((U.x % 2) + (U.y % 2) + (U.z % 2))); 
+			// restriction weight
+			Real rw = Real(1) / Real(1 << ((U.x % 2) + (U.y % 2) + (U.z % 2)));
 
 			// loop over all stencil neighbors N of V on level l that can be reached via restriction to U
-			FOR_VEC_MINMAX(N, (U-1)/2, vmin(mg.mSize[l]-1, (U+2)/2)) {
-				int n = mg.linIdx(N,l);
-				if (mg.mType[l][n] == GridMg::vtInactive) continue;
-							
+			FOR_VEC_MINMAX(N, (U-1)/2, vmin(mSize[l]-1, (U+2)/2)) {
+				int n = linIdx(N,l);
+				if (mType[l][n] == vtInactive) continue;
+
 				// stencil entry at V associated to N (coarse grid level l)
-				Vec3i SC = N - V + mg.mStencilMax;
+				Vec3i SC = N - V + mStencilMax;
 				int sc = SC.x + 3*SC.y + 9*SC.z;
-				if (sc < mg.mStencilSize-1) continue;
+				if (sc < mStencilSize-1) continue;
 
-				// loop over all vertices W which are in the stencil of A_{l-1} at U 
+				// loop over all vertices W which are in the stencil of A_{l-1} at U
 				// and which interpolate from N
-				FOR_VEC_MINMAX(W, vmax(              0, vmax(U-1,N*2-1)),
-				                  vmin(mg.mSize[l-1]-1, vmin(U+1,N*2+1))) {
-					int w = mg.linIdx(W,l-1);
-					if (mg.mType[l-1][w] == GridMg::vtInactive) continue;
+				FOR_VEC_MINMAX(W, vmax(           0, vmax(U-1,N*2-1)),
+				                  vmin(mSize[l-1]-1, vmin(U+1,N*2+1))) {
+					int w = linIdx(W,l-1);
+					if (mType[l-1][w] == vtInactive) continue;
 
 					// stencil entry at U associated to W (fine grid level l-1)
-					Vec3i SF = W - U + mg.mStencilMax;
+					Vec3i SF = W - U + mStencilMax;
 					int sf = SF.x + 3*SF.y + 9*SF.z;
 
 					Real iw = Real(1) / Real(1 << ((W.x % 2) + (W.y % 2) + (W.z % 2))); // interpolation weight
 
-					if (sf < mg.mStencilSize) {
-						A[idx*mg.mStencilSize + sc-mg.mStencilSize+1] += rw * mg.mA[l-1][w*mg.mStencilSize + mg.mStencilSize-1-sf] *iw;
+					if (sf < mStencilSize) {
+						stencil[sc-mStencilSize+1] += rw * mA[l-1][w*mStencilSize + mStencilSize-1-sf] *iw;
 					} else {
-						A[idx*mg.mStencilSize + sc-mg.mStencilSize+1] += rw * mg.mA[l-1][u*mg.mStencilSize + sf-mg.mStencilSize+1] *iw;
+						stencil[sc-mStencilSize+1] += rw * mA[l-1][u*mStencilSize + sf-mStencilSize+1] *iw;
 					}
 				}
 			}
 		}
 	}
+}
+
+ struct knGenCoarseGridOperator : public KernelBase { knGenCoarseGridOperator(std::vector<Real>& sizeRef, std::vector<Real>& A, int l, const GridMg& mg) :  KernelBase(sizeRef.size()) ,sizeRef(sizeRef),A(A),l(l),mg(mg)   { runMessage(); run(); }   inline void op(IndexInt idx, std::vector<Real>& sizeRef, std::vector<Real>& A, int l, const GridMg& mg ) const {
+	if (mg.mType[l][idx] == GridMg::vtInactive) return;
+
+	mg.genCoarseStencil(int(idx), l, &A[idx*mg.mStencilSize]);
 }    inline std::vector<Real>& getArg0() { return sizeRef; } typedef std::vector<Real> type0;inline std::vector<Real>& getArg1() { return A; } typedef std::vector<Real> type1;inline int& getArg2() { return l; } typedef int type2;inline const GridMg& getArg3() { return mg; } typedef GridMg type3; void runMessage() { debMsg("Executing kernel knGenCoarseGridOperator ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, sizeRef,A,l,mg);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  std::vector<Real>& sizeRef; std::vector<Real>& A; int l; const GridMg& mg;   };
 
 
@@ -676,18 +735,222 @@ void GridMg::genCoraseGridOperator(int l)
 	// for each coarse grid vertex V
 	knGenCoarseGridOperator(mx[l], mA[l], l, *this);
 }
-	
 
 
 
- struct knSmoothColor : public KernelBase { knSmoothColor(ThreadSize& numBlocks, std::vector<Real>& x, const Vec3i& blockSize, const std::vector<Vec3i>& colorOffs, int l, const GridMg& mg) :  KernelBase(numBlocks.size()) ,numBlocks(numBlocks),x(x),blockSize(blockSize),colorOffs(colorOffs),l(l),mg(mg)   { runMessage(); run(); }   inline void op(IndexInt idx, ThreadSize& numBlocks, std::vector<Real>& x, const Vec3i& blockSize, const std::vector<Vec3i>& colorOffs, int l, const GridMg& mg ) const {
-	Vec3i blockOff (int(idx)%blockSize.x, (int(idx)%(blockSize.x*blockSize.y))/blockSize.x, int(idx)/(blockSize.x*blockSize.y));
+
+ struct knUpdateCoarseGridOperator : public KernelBase { knUpdateCoarseGridOperator(const std::vector<int>& vertices, std::vector<Real>& A, std::vector<char>& dirty, int l, const GridMg& mg) :  KernelBase(vertices.size()) ,vertices(vertices),A(A),dirty(dirty),l(l),mg(mg)   { runMessage(); run(); }   inline void op(IndexInt idx, const std::vector<int>& vertices, std::vector<Real>& A, std::vector<char>& dirty, int l, const GridMg& mg ) const {
+	const int v = vertices[idx];
+	if (mg.mType[l][v] == GridMg::vtInactive) return;
+
+	Real stencil[14];
+	mg.genCoarseStencil(v, l, stencil);
+
+	for (int i=0; i<mg.mStencilSize; i++) {
+		if (A[v*mg.mStencilSize + i] != stencil[i]) {
+			A[v*mg.mStencilSize + i] = stencil[i];
+			dirty[v] |= 1;
+		}
+	}
+}    inline const std::vector<int>& getArg0() { return vertices; } typedef std::vector<int> type0;inline std::vector<Real>& getArg1() { return A; } typedef std::vector<Real> type1;inline std::vector<char>& getArg2() { return dirty; } typedef std::vector<char> type2;inline int& getArg3() { return l; } typedef int type3;inline const GridMg& getArg4() { return mg; } typedef GridMg type4; void runMessage() { debMsg("Executing kernel knUpdateCoarseGridOperator ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, vertices,A,dirty,l,mg);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const std::vector<int>& vertices; std::vector<Real>& A; std::vector<char>& dirty; int l; const GridMg& mg;   };
+
+
+// Update coarse levels 1..L of the existing hierarchy after A changed on level 0:
+// Coarse vertices are only re-evaluated where fine vertices changed their active state,
+// and only operator entries depending on changed fine entries or types are recomputed.
+//
+// The interpolation has to keep its full rank. genCoarseGrid selects each coarse vertex
+// for a fine vertex (its owner) that only interpolates from coarse vertices selected
+// before, so the rows of the owners form a triangular matrix with non-zero diagonal.
+// Coarse vertices activated here get an owner without other interpolation vertices and
+// are ordered first. Vertices whose owner became inactive are taken over by another
+// fine vertex that keeps this order. If there is none, or an active fine vertex has no
+// active interpolation vertex, the level and the coarser ones are regenerated.
+// Returns false if the whole hierarchy has to be regenerated instead.
+bool GridMg::updateHierarchy()
+{
+	if (mDirty.size() != mType.size()) {
+		mDirty.clear();
+		for (size_t l=0; l<mType.size(); l++) mDirty.push_back(std::vector<char>(mType[l].size(), 0));
+	}
+	auto clearDirty = [this]() { for (size_t l=0; l<mDirty.size(); l++) knSet<char>(mDirty[l], 0); };
+
+	// collect changed vertices on level 0
+	knMarkChangedVertices(mDirty[0], mA0Prev, mType0Prev, *this);
+
+	std::vector<int> fine, coarse, coarseChanged;
+	int numTypeChanges = 0;
+	for (size_t v=0; v<mDirty[0].size(); v++) {
+		if (mDirty[0][v]) {
+			fine.push_back(v);
+			if (mDirty[0][v] & 2) numTypeChanges++;
+		}
+	}
+
+	// the reused coarse grids degrade with accumulated changes
+	mNumChangedSinceRebuild += numTypeChanges;
+	if (mNumChangedSinceRebuild > mMaxChangedFraction * Real(mType[0].size())) {
+		debMsg("GridMg::setA: "<<mNumChangedSinceRebuild<<" vertices changed their state, regenerating hierarchy", 2);
+		clearDirty();
+		return false;
+	}
+
+	for (size_t l=1; l<mA.size(); l++)
+	{
+		coarse.clear();
+		coarseChanged.clear();
+
+		auto hasActiveFineVertex = [this, l](const Vec3i& I) {
+			FOR_VEC_MINMAX(R, vmax(0, I*2-1), vmin(mSize[l-1]-1, I*2+1)) {
+				if (mType[l-1][linIdx(R,l-1)] != vtInactive) return true;
+			}
+			return false;
+		};
+
+		// update coarse vertex types around fine vertices that changed their state:
+		// coarse vertices without active fine vertices are removed, active fine vertices
+		// without any active interpolation vertex activate the first one.
+		for (int f : fine) {
+			if (!(mDirty[l-1][f] & 2)) continue;
+
+			Vec3i F = vecIdx(f,l-1);
+			bool represented = false;
+
+			FOR_VEC_MINMAX(I, F/2, (F+1)/2) {
+				int i = linIdx(I,l);
+				if (mType[l][i] == vtInactive) continue;
+
+				if (hasActiveFineVertex(I)) {
+					represented = true;
+				} else {
+					mType[l][i] = vtInactive;
+					mOwner[l][i] = -1;
+					mDirty[l][i] |= 2;
+					coarseChanged.push_back(i);
+				}
+			}
+
+			if (!represented && mType[l-1][f] != vtInactive) {
+				int i = linIdx(F/2,l);
+				mType[l][i] = vtActive;
+				mOwner[l][i] = f;
+				mOrder[l][i] = --mMinOrder;
+				mDirty[l][i] |= 2;
+				coarseChanged.push_back(i);
+			}
+		}
+
+		// a new owner of coarse vertex i must not own another coarse vertex,
+		// and may only interpolate from coarse vertices ordered before i
+		auto findOwner = [this, l](const Vec3i& I, int i) {
+			FOR_VEC_MINMAX(R, vmax(0, I*2-1), vmin(mSize[l-1]-1, I*2+1)) {
+				int r = linIdx(R,l-1);
+				if (mType[l-1][r] == vtInactive) continue;
+
+				bool valid = true;
+				FOR_VEC_MINMAX(N, R/2, (R+1)/2) {
+					int n = linIdx(N,l);
+					if (n == i || mType[l][n] == vtInactive) continue;
+					if (mOwner[l][n] == r || mOrder[l][n] > mOrder[l][i]) valid = false;
+				}
+				if (valid) return r;
+			}
+			return -1;
+		};
+
+		bool fullRank = true;
+		for (int f : fine) {
+			if (!(mDirty[l-1][f] & 2)) continue;
+
+			Vec3i F = vecIdx(f,l-1);
+			bool interpolated = false;
+
+			FOR_VEC_MINMAX(I, F/2, (F+1)/2) {
+				int i = linIdx(I,l);
+				if (mType[l][i] == vtInactive) continue;
+
+				interpolated = true;
+				if (mOwner[l][i] == f && mType[l-1][f] == vtInactive) {
+					mOwner[l][i] = findOwner(I, i);
+					if (mOwner[l][i] < 0) fullRank = false;
+				}
+			}
+			if (!interpolated && mType[l-1][f] != vtInactive) fullRank = false;
+		}
+		if (!fullRank) {
+			debMsg("GridMg::setA: interpolation from level "<<l<<" lost its full rank, regenerating levels "<<l<<" to "<<mA.size()-1, 2);
+			for (size_t k=l; k<mA.size(); k++) {
+				genCoarseGrid(k);
+				genCoraseGridOperator(k);
+			}
+			if (l == 1) mNumChangedSinceRebuild = 0;
+			clearDirty();
+			return true;
+		}
+
+		// collect coarse vertices whose stencil depends on changed fine vertices
+		// (within distance 2 on level l-1) or changed coarse vertex types
+		auto addCoarseVertices = [&](const Vec3i& lo, const Vec3i& hi) {
+			FOR_VEC_MINMAX(V, vmax(0, lo), vmin(mSize[l]-1, hi)) {
+				int v = linIdx(V,l);
+				if (!(mDirty[l][v] & 4)) { mDirty[l][v] |= 4; coarse.push_back(v); }
+			}
+		};
+		for (int f : fine) {
+			Vec3i F = vecIdx(f,l-1);
+			addCoarseVertices((F-1)/2, (F+2)/2);
+		}
+		for (int c : coarseChanged) {
+			Vec3i C = vecIdx(c,l);
+			addCoarseVertices(C-1, C+1);
+		}
+
+		knUpdateCoarseGridOperator(coarse, mA[l], mDirty[l], l, *this);
+
+		// an active coarse vertex needs a positive diagonal entry, otherwise the reused grid is not valid anymore
+		bool valid = true;
+		for (int v : coarse) {
+			mDirty[l][v] &= ~4;
+			if (mType[l][v] != vtInactive && !(mA[l][v*mStencilSize + 0] > Real(0))) valid = false;
+		}
+		if (!valid) {
+			debMsg("GridMg::setA: invalid coarse operator on level "<<l<<", regenerating hierarchy", 2);
+			clearDirty();
+			return false;
+		}
+
+		for (int f : fine) mDirty[l-1][f] = 0;
+
+		// changed coarse vertices are the changed fine vertices of the next level
+		fine.clear();
+		for (int v : coarse) { if (mDirty[l][v]) fine.push_back(v); }
+	}
+
+	for (int f : fine) mDirty.back()[f] = 0;
+
+	debMsg("GridMg::setA: updated hierarchy, "<<numTypeChanges<<" vertices changed their state", 2);
+	return true;
+}
 	
-	for (int off = 0; off < colorOffs.size(); off++) {
-				
-		Vec3i V = blockOff*2 + colorOffs[off];
-		if (!mg.inGrid(V,l)) continue;
-				
+
+
+
+ struct knSmoothColor : public KernelBase { knSmoothColor(ThreadSize& numRows, std::vector<Real>& x, int color, int l, const GridMg& mg) :  KernelBase(numRows.size()) ,numRows(numRows),x(x),color(color),l(l),mg(mg)   { runMessage(); run(); }   inline void op(IndexInt idx, ThreadSize& numRows, std::vector<Real>& x, int color, int l, const GridMg& mg ) const {
+	// row of vertices with the given color, every second vertex along x
+	Vec3i V;
+	int x0;
+	if (l==0) {
+		V.y = int(idx) % mg.mSize[0].y;
+		V.z = int(idx) / mg.mSize[0].y;
+		x0  = (V.y + V.z + color) % 2;
+	} else {
+		const int numRowsY = (mg.mSize[l].y - ((color>>1)&1) + 1) / 2;
+		V.y = ((color>>1)&1) + 2*(int(idx) % numRowsY);
+		V.z = ((color>>2)&1) + 2*(int(idx) / numRowsY);
+		x0  = color & 1;
+	}
+
+	for (V.x = x0; V.x < mg.mSize[l].x; V.x += 2) {
 		const int v = mg.linIdx(V,l);
 		if (mg.mType[l][v] == GridMg::vtInactive) continue;
 
@@ -720,31 +983,25 @@ void GridMg::genCoraseGridOperator(int l)
 			x[v] = sum / mg.mA[l][v*mg.mStencilSize + 0];
 		}
 	}
-}    inline ThreadSize& getArg0() { return numBlocks; } typedef ThreadSize type0;inline std::vector<Real>& getArg1() { return x; } typedef std::vector<Real> type1;inline const Vec3i& getArg2() { return blockSize; } typedef Vec3i type2;inline const std::vector<Vec3i>& getArg3() { return colorOffs; } typedef std::vector<Vec3i> type3;inline int& getArg4() { return l; } typedef int type4;inline const GridMg& getArg5() { return mg; } typedef GridMg type5; void runMessage() { debMsg("Executing kernel knSmoothColor ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, numBlocks,x,blockSize,colorOffs,l,mg);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  ThreadSize& numBlocks; std::vector<Real>& x; const Vec3i& blockSize; const std::vector<Vec3i>& colorOffs; int l; const GridMg& mg;   };
+}    inline ThreadSize& getArg0() { return numRows; } typedef ThreadSize type0;inline std::vector<Real>& getArg1() { return x; } typedef std::vector<Real> type1;inline int& getArg2() { return color; } typedef int type2;inline int& getArg3() { return l; } typedef int type3;inline const GridMg& getArg4() { return mg; } typedef GridMg type4; void runMessage() { debMsg("Executing kernel knSmoothColor ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, numRows,x,color,l,mg);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } ThreadSize& numRows; std::vector<Real>& x; int color; int l; const GridMg& mg;   };
 
 void GridMg::smoothGS(int l, bool reversedOrder)
 {
-	// Multicolor Gauss-Seidel with two colors for the 5/7-point stencil on level 0 
-	// and with four/eight colors for the 9/27-point stencil on levels > 0
-	std::vector<std::vector<Vec3i>> colorOffs;
-	const Vec3i a[8] = {Vec3i(0,0,0), Vec3i(1,0,0), Vec3i(0,1,0), Vec3i(1,1,0), 
-		                Vec3i(0,0,1), Vec3i(1,0,1), Vec3i(0,1,1), Vec3i(1,1,1)};
-	if (mIs3D) {
-		if (l==0) colorOffs = {{a[0],a[3],a[5],a[6]}, {a[1],a[2],a[4],a[7]}};
-		else      colorOffs = {{a[0]}, {a[1]}, {a[2]}, {a[3]}, {a[4]}, {a[5]}, {a[6]}, {a[7]}};
-	} else {
-		if (l==0) colorOffs = {{a[0],a[3]}, {a[1],a[2]}};
-		else      colorOffs = {{a[0]}, {a[1]}, {a[2]}, {a[3]}};
-	}
+	// Multicolor Gauss-Seidel with two colors (red-black) for the 5/7-point stencil on level 0
+	// and with four/eight colors for the 9/27-point stencil on levels > 0.
+	// Vertices of one color are independent, the rows of a color are smoothed in parallel:
+	// - level 0: color of vertex V is (V.x+V.y+V.z)%2
+	// - levels > 0: color of vertex V is (V.x%2) + 2*(V.y%2) + 4*(V.z%2)
+	const int numColors = (l==0) ? 2 : (mIs3D ? 8 : 4);
 
-	// Divide grid into 2x2 blocks for parallelization
-	Vec3i blockSize = (mSize[l]+1)/2;
-	ThreadSize numBlocks(blockSize.x * blockSize.y * blockSize.z);
-	
-	for (int c = 0; c < colorOffs.size(); c++) {
-		int color = reversedOrder ? int(colorOffs.size())-1-c : c;
+	for (int c = 0; c < numColors; c++) {
+		int color = reversedOrder ? numColors-1-c : c;
+
+		IndexInt rows = IndexInt(mSize[l].y) * mSize[l].z;
+		if (l>0) rows = IndexInt((mSize[l].y - ((color>>1)&1) + 1) / 2) * ((mSize[l].z - ((color>>2)&1) + 1) / 2);
+		ThreadSize numRows(rows);
 
-		knSmoothColor(numBlocks, mx[l], blockSize, colorOffs[color], l, *this);
+		knSmoothColor(numRows, mx[l], color, l, *this);
 	}
 }
 
@@ -311,6 +311,12 @@ void ParticleDataImpl<T>::copyValueSlow(IndexInt from, IndexInt to) {
 	this->copyValue(from,to);
 }
 template<class T>
+void ParticleDataImpl<T>::reorder(const std::vector<IndexInt>& order) {
+	std::vector<T> sorted(order.size());
+	knGatherParticleData<T>(order, mData, sorted);
+	mData.swap(sorted);
+}
+template<class T>
 ParticleDataBase* ParticleDataImpl<T>::clone() {
 	ParticleDataImpl<T>* npd = new ParticleDataImpl<T>( getParent(), this );
 	return npd;
@@ -609,6 +615,57 @@ Real ParticleDataImpl<Vec3>::getMax() {
 }
 
 
+//******************************************************************************
+// ParticleSlabs
+
+//! counting sort by slab, chunks of particles are counted and sorted in parallel
+
+ struct knCountParticleSlabs : public KernelBase { knCountParticleSlabs(IndexInt numChunks, const BasicParticleSystem& parts, const int axis, const int layers, const int numSlabs, std::vector<IndexInt>& counts) :  KernelBase(numChunks) ,numChunks(numChunks),parts(parts),axis(axis),layers(layers),numSlabs(numSlabs),counts(counts)   { runMessage(); run(); }   inline void op(IndexInt idx, IndexInt numChunks, const BasicParticleSystem& parts, const int axis, const int layers, const int numSlabs, std::vector<IndexInt>& counts ) const {
+	const IndexInt end = std::min((idx+1) * ParticleSlabs::CHUNK, parts.size());
+	for (IndexInt i=idx*ParticleSlabs::CHUNK; i<end; ++i) {
+		if (!parts.isActive(i)) continue;
+		const int slab = clamp((int)parts[i].pos[axis], 0, layers-1) / ParticleSlabs::LAYERS;
+		counts[idx*numSlabs + slab]++;
+	}
+}    inline IndexInt& getArg0() { return numChunks; } typedef IndexInt type0;inline const BasicParticleSystem& getArg1() { return parts; } typedef BasicParticleSystem type1;inline const int& getArg2() { return axis; } typedef int type2;inline const int& getArg3() { return layers; } typedef int type3;inline const int& getArg4() { return numSlabs; } typedef int type4;inline std::vector<IndexInt>& getArg5() { return counts; } typedef std::vector<IndexInt> type5; void runMessage() { debMsg("Executing kernel knCountParticleSlabs ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, numChunks,parts,axis,layers,numSlabs,counts);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } IndexInt numChunks; const BasicParticleSystem& parts; const int axis; const int layers; const int numSlabs; std::vector<IndexInt>& counts;   };
+
+ struct knSortParticleSlabs : public KernelBase { knSortParticleSlabs(IndexInt numChunks, const BasicParticleSystem& parts, const int axis, const int layers, const int numSlabs, std::vector<IndexInt>& offsets, std::vector<IndexInt>& order) :  KernelBase(numChunks) ,numChunks(numChunks),parts(parts),axis(axis),layers(layers),numSlabs(numSlabs),offsets(offsets),order(order)   { runMessage(); run(); }   inline void op(IndexInt idx, IndexInt numChunks, const BasicParticleSystem& parts, const int axis, const int layers, const int numSlabs, std::vector<IndexInt>& offsets, std::vector<IndexInt>& order ) const {
+	const IndexInt end = std::min((idx+1) * ParticleSlabs::CHUNK, parts.size());
+	for (IndexInt i=idx*ParticleSlabs::CHUNK; i<end; ++i) {
+		if (!parts.isActive(i)) continue;
+		const int slab = clamp((int)parts[i].pos[axis], 0, layers-1) / ParticleSlabs::LAYERS;
+		order[offsets[idx*numSlabs + slab]++] = i;
+	}
+}    inline IndexInt& getArg0() { return numChunks; } typedef IndexInt type0;inline const BasicParticleSystem& getArg1() { return parts; } typedef BasicParticleSystem type1;inline const int& getArg2() { return axis; } typedef int type2;inline const int& getArg3() { return layers; } typedef int type3;inline const int& getArg4() { return numSlabs; } typedef int type4;inline std::vector<IndexInt>& getArg5() { return offsets; } typedef std::vector<IndexInt> type5;inline std::vector<IndexInt>& getArg6() { return order; } typedef std::vector<IndexInt> type6; void runMessage() { debMsg("Executing kernel knSortParticleSlabs ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, numChunks,parts,axis,layers,numSlabs,offsets,order);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } IndexInt numChunks; const BasicParticleSystem& parts; const int axis; const int layers; const int numSlabs; std::vector<IndexInt>& offsets; std::vector<IndexInt>& order;   };
+
+
+ParticleSlabs::ParticleSlabs(const BasicParticleSystem& parts, const Vec3i& gridSize) {
+	const int axis = (gridSize.z > 1) ? 2 : 1;
+	const int layers = gridSize[axis];
+	mNumSlabs = (layers + LAYERS - 1) / LAYERS;
+
+	const IndexInt numChunks = (parts.size() + CHUNK - 1) / CHUNK;
+	std::vector<IndexInt> offsets(numChunks * mNumSlabs, 0);
+	knCountParticleSlabs(numChunks, parts, axis, layers, mNumSlabs, offsets);
+
+	// slab major, chunk minor: each chunk writes its particles in index order after the previous chunk
+	mStart.resize(mNumSlabs + 1);
+	IndexInt sum = 0;
+	for (int s=0; s<mNumSlabs; ++s) {
+		mStart[s] = sum;
+		for (IndexInt c=0; c<numChunks; ++c) {
+			const IndexInt count = offsets[c*mNumSlabs + s];
+			offsets[c*mNumSlabs + s] = sum;
+			sum += count;
+		}
+	}
+	mStart[mNumSlabs] = sum;
+
+	mOrder.resize(sum);
+	knSortParticleSlabs(numChunks, parts, axis, layers, mNumSlabs, offsets, mOrder);
+}
+
+
 // explicit instantiation
 template class ParticleDataImpl<int>;
 template class ParticleDataImpl<Real>;
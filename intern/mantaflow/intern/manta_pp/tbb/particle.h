@@ -153,10 +153,14 @@ template<class S> class ParticleSystem : public ParticleBase {public:
 	void insertBufferedParticles();
 	//! resize data vector, and all pdata fields
 	void resizeAll(IndexInt newsize);
+	//! permute particles and all pdata fields, new particle i is old particle order[i]
+	void reorder(const std::vector<IndexInt>& order);
 	
 	//! adding and deleting 
 	inline void kill(IndexInt idx);
 	IndexInt add(const S& data);
+	//! add num default initialized particles in one go, returns the index of the first one
+	IndexInt addEntries(IndexInt num);
 	//! remove all particles, init 0 length arrays (also pdata)
 	void clear(); static PyObject* _W_8 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); ParticleSystem* pbo = dynamic_cast<ParticleSystem*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "ParticleSystem::clear" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock;  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->clear();  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"ParticleSystem::clear" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("ParticleSystem::clear",e.what()); return 0; } }
 			
@@ -259,6 +263,32 @@ class ParticleIndexSystem : public ParticleSystem<ParticleIndexData> {public:
 
 
 
+//******************************************************************************
+
+//! Particles sorted into slabs of a few grid layers along z (y in 2D), for parallel
+//! particle-to-grid transfers. A particle only writes to the layers of its own and the
+//! neighboring slabs, so all slabs of one color (even or odd) can be processed in parallel.
+//! Particles stay in index order within a slab, sums don't depend on the number of threads
+class ParticleSlabs {
+public:
+	ParticleSlabs(const BasicParticleSystem& parts, const Vec3i& gridSize);
+
+	//! number of slabs of one color, slab i of color c is 2*i+c
+	inline int size(int color) const { return (mNumSlabs + 1 - color) / 2; }
+	inline IndexInt begin(int slab) const { return mStart[slab]; }
+	inline IndexInt end(int slab) const { return mStart[slab+1]; }
+	//! index of the i-th sorted particle, inactive particles are skipped
+	inline IndexInt operator[](IndexInt i) const { return mOrder[i]; }
+
+	static const int LAYERS = 4;
+	//! particles per chunk of the parallel counting sort
+	static const IndexInt CHUNK = 1<<14;
+
+protected:
+	int mNumSlabs;
+	std::vector<IndexInt> mStart, mOrder;
+};
+
 //******************************************************************************
 
 //! Particle set with connectivity
@@ -296,6 +326,7 @@ class ParticleDataBase : public PbClass {public:
 	virtual PdataType getType() const { assertMsg( false , "Dont use, override..."); return TypeNone; } 
 	virtual void resize(IndexInt size)     { assertMsg( false , "Dont use, override..."); return;  }
 	virtual void copyValueSlow(IndexInt from, IndexInt to) { assertMsg( false , "Dont use, override..."); return;  }
+	virtual void reorder(const std::vector<IndexInt>& order) { assertMsg( false , "Dont use, override..."); return;  }
 
 	//! set base pointer
 	void setParticleSys(ParticleBase* set) { mpParticleSys = set; }
@@ -334,6 +365,7 @@ template<class T> class ParticleDataImpl : public ParticleDataBase {public:
 	virtual PdataType getType() const;
 	virtual void resize(IndexInt s);
 	virtual void copyValueSlow(IndexInt from, IndexInt to);
+	virtual void reorder(const std::vector<IndexInt>& order);
 
 	IndexInt  size() const { return mData.size(); }
 
@@ -396,6 +428,12 @@ protected:
 
 const int DELETE_PART = 20; // chunk size for compression
 
+//! gather particle data into a new order, shared by particle systems and pdata
+
+template <class T>   struct knGatherParticleData : public KernelBase { knGatherParticleData(const std::vector<IndexInt>& order, const std::vector<T>& src, std::vector<T>& dst) :  KernelBase(order.size()) ,order(order),src(src),dst(dst)   { runMessage(); run(); }   inline void op(IndexInt idx, const std::vector<IndexInt>& order, const std::vector<T>& src, std::vector<T>& dst ) const {
+	dst[idx] = src[order[idx]];
+}    inline const std::vector<IndexInt>& getArg0() { return order; } typedef std::vector<IndexInt> type0;inline const std::vector<T>& getArg1() { return src; } typedef std::vector<T> type1;inline std::vector<T>& getArg2() { return dst; } typedef std::vector<T> type2; void runMessage() { debMsg("Executing kernel knGatherParticleData ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, order,src,dst);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const std::vector<IndexInt>& order; const std::vector<T>& src; std::vector<T>& dst;   };
+
 void ParticleBase::addBuffered(const Vec3& pos, int flag) {
 	mNewBufferPos.push_back(pos);
 	mNewBufferFlag.push_back(flag);
@@ -415,6 +453,14 @@ IndexInt ParticleSystem<S>::add(const S& data) {
 	return mData.size()-1;
 }
 
+template<class S>
+IndexInt ParticleSystem<S>::addEntries(IndexInt num) {
+	const IndexInt first = mData.size();
+	resizeAll(first + num);
+	mDeleteChunk = mData.size() / DELETE_PART;
+	return first;
+}
+
 template<class S>
 inline void ParticleSystem<S>::kill(IndexInt idx)     { 
 	assertMsg(idx>=0 && idx<size(), "Index out of bounds");
@@ -422,17 +468,22 @@ inline void ParticleSystem<S>::kill(IndexInt idx)     {
 	if ( (++mDeletes > mDeleteChunk) && (mAllowCompress) ) compress(); 
 }
 
+template <class S>   struct knGetPosPdata : public KernelBase { knGetPosPdata(const ParticleSystem<S>& p, ParticleDataImpl<Vec3>& target) :  KernelBase(p.size()) ,p(p),target(target)   { runMessage(); run(); }   inline void op(IndexInt idx, const ParticleSystem<S>& p, ParticleDataImpl<Vec3>& target ) const {
+	target[idx] = p[idx].pos;
+}    inline const ParticleSystem<S>& getArg0() { return p; } typedef ParticleSystem<S> type0;inline ParticleDataImpl<Vec3>& getArg1() { return target; } typedef ParticleDataImpl<Vec3> type1; void runMessage() { debMsg("Executing kernel knGetPosPdata ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, p,target);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const ParticleSystem<S>& p; ParticleDataImpl<Vec3>& target;   };
+
+template <class S>   struct knSetPosPdata : public KernelBase { knSetPosPdata(ParticleSystem<S>& p, const ParticleDataImpl<Vec3>& source) :  KernelBase(p.size()) ,p(p),source(source)   { runMessage(); run(); }   inline void op(IndexInt idx, ParticleSystem<S>& p, const ParticleDataImpl<Vec3>& source ) const {
+	p[idx].pos = source[idx];
+}    inline ParticleSystem<S>& getArg0() { return p; } typedef ParticleSystem<S> type0;inline const ParticleDataImpl<Vec3>& getArg1() { return source; } typedef ParticleDataImpl<Vec3> type1; void runMessage() { debMsg("Executing kernel knSetPosPdata ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, p,source);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } ParticleSystem<S>& p; const ParticleDataImpl<Vec3>& source;   };
+
+
 template<class S>
 void ParticleSystem<S>::getPosPdata(ParticleDataImpl<Vec3>& target) const {
-	for(IndexInt i=0; i<(IndexInt)this->size(); ++i) {
-		target[i] = this->getPos(i);
-	}
+	knGetPosPdata<S>(*this, target);
 }
 template<class S>
 void ParticleSystem<S>::setPosPdata(const ParticleDataImpl<Vec3>& source) {
-	for(IndexInt i=0; i<(IndexInt)this->size(); ++i) {
-		this->setPos(i, source[i]);
-	}
+	knSetPosPdata<S>(*this, source);
 }
 
 template<class S>
@@ -519,7 +570,7 @@ void ParticleSystem<S>::advectInGrid(const FlagGrid& flags, const MACGrid& vel,
 	if(!deleteInObstacle) {
 		posOld = new ParticleDataImpl<Vec3>(this->getParent());
 		posOld->resize(mData.size());
-		for(IndexInt i=0; i<(IndexInt)mData.size();++i) (*posOld)[i] = mData[i].pos;
+		getPosPdata(*posOld);
 	}
 
 	// update positions
@@ -596,6 +647,16 @@ void ParticleSystem<S>::resizeAll(IndexInt size) {
 		mPartData[i]->resize(size);
 }
 
+template<class S>
+void ParticleSystem<S>::reorder(const std::vector<IndexInt>& order) {
+	assertMsg( (IndexInt)order.size() == size(), "reorder needs an entry for every particle" );
+	std::vector<S> sorted(order.size());
+	knGatherParticleData<S>(order, mData, sorted);
+	mData.swap(sorted);
+	for(IndexInt i=0; i<(IndexInt)mPartData.size(); ++i)
+		mPartData[i]->reorder(order);
+}
+
 template<class S>
 void ParticleSystem<S>::compress() {
 	IndexInt nextRead = mData.size();
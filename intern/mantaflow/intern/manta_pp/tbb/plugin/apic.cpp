@@ -33,7 +33,8 @@ namespace Manta {
 
 
 
- struct knApicMapLinearVec3ToMACGrid : public KernelBase { knApicMapLinearVec3ToMACGrid( const BasicParticleSystem &p, MACGrid &mg, MACGrid &vg, const ParticleDataImpl<Vec3> &vp, const ParticleDataImpl<Vec3> &cpx, const ParticleDataImpl<Vec3> &cpy, const ParticleDataImpl<Vec3> &cpz, const ParticleDataImpl<int> *ptype, const int exclude) :  KernelBase(p.size()) ,p(p),mg(mg),vg(vg),vp(vp),cpx(cpx),cpy(cpy),cpz(cpz),ptype(ptype),exclude(exclude)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystem &p, MACGrid &mg, MACGrid &vg, const ParticleDataImpl<Vec3> &vp, const ParticleDataImpl<Vec3> &cpx, const ParticleDataImpl<Vec3> &cpy, const ParticleDataImpl<Vec3> &cpz, const ParticleDataImpl<int> *ptype, const int exclude )  {
+//! scatter the affine velocity of one particle to the faces around it
+static inline void apicMapParticle(IndexInt idx, const BasicParticleSystem& p, MACGrid& mg, MACGrid& vg, const ParticleDataImpl<Vec3>& vp, const ParticleDataImpl<Vec3>& cpx, const ParticleDataImpl<Vec3>& cpy, const ParticleDataImpl<Vec3>& cpz, const ParticleDataImpl<int>* ptype, const int exclude) {
 	if (!p.isActive(idx) || (ptype && ((*ptype)[idx] & exclude))) return;
 	const IndexInt dX[2] = { 0, vg.getStrideX() };
 	const IndexInt dY[2] = { 0, vg.getStrideY() };
@@ -91,7 +92,16 @@ namespace Manta {
 					vg[gidx+dX[i]+dY[j]+dZ[k]].z += w*dot(cpz[idx], gpos + Vec3(i, j, k) - pos);
 				}
 	}
-}    inline const BasicParticleSystem& getArg0() { return p; } typedef BasicParticleSystem type0;inline MACGrid& getArg1() { return mg; } typedef MACGrid type1;inline MACGrid& getArg2() { return vg; } typedef MACGrid type2;inline const ParticleDataImpl<Vec3> & getArg3() { return vp; } typedef ParticleDataImpl<Vec3>  type3;inline const ParticleDataImpl<Vec3> & getArg4() { return cpx; } typedef ParticleDataImpl<Vec3>  type4;inline const ParticleDataImpl<Vec3> & getArg5() { return cpy; } typedef ParticleDataImpl<Vec3>  type5;inline const ParticleDataImpl<Vec3> & getArg6() { return cpz; } typedef ParticleDataImpl<Vec3>  type6;inline const ParticleDataImpl<int> * getArg7() { return ptype; } typedef ParticleDataImpl<int>  type7;inline const int& getArg8() { return exclude; } typedef int type8; void runMessage() { debMsg("Executing kernel knApicMapLinearVec3ToMACGrid ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; for (IndexInt i = 0; i < _sz; i++) op(i, p,mg,vg,vp,cpx,cpy,cpz,ptype,exclude);   } const BasicParticleSystem& p; MACGrid& mg; MACGrid& vg; const ParticleDataImpl<Vec3> & vp; const ParticleDataImpl<Vec3> & cpx; const ParticleDataImpl<Vec3> & cpy; const ParticleDataImpl<Vec3> & cpz; const ParticleDataImpl<int> * ptype; const int exclude;   };
+}
+
+ struct knApicMapLinearVec3ToMACGrid : public KernelBase { knApicMapLinearVec3ToMACGrid(const ParticleSlabs& slabs, const int color, const BasicParticleSystem& p, MACGrid& mg, MACGrid& vg, const ParticleDataImpl<Vec3>& vp, const ParticleDataImpl<Vec3>& cpx, const ParticleDataImpl<Vec3>& cpy, const ParticleDataImpl<Vec3>& cpz, const ParticleDataImpl<int>* ptype, const int exclude) :  KernelBase(slabs.size(color)) ,slabs(slabs),color(color),p(p),mg(mg),vg(vg),vp(vp),cpx(cpx),cpy(cpy),cpz(cpz),ptype(ptype),exclude(exclude)   { runMessage(); run(); }   inline void op(IndexInt idx, const ParticleSlabs& slabs, const int color, const BasicParticleSystem& p, MACGrid& mg, MACGrid& vg, const ParticleDataImpl<Vec3>& vp, const ParticleDataImpl<Vec3>& cpx, const ParticleDataImpl<Vec3>& cpy, const ParticleDataImpl<Vec3>& cpz, const ParticleDataImpl<int>* ptype, const int exclude ) const {
+	const int slab = 2*idx + color;
+	for (IndexInt j=slabs.begin(slab); j<slabs.end(slab); ++j) {
+		const IndexInt i = slabs[j];
+		apicMapParticle(i, p, mg, vg, vp, cpx, cpy, cpz, ptype, exclude);
+	}
+}    inline const ParticleSlabs& getArg0() { return slabs; } typedef ParticleSlabs type0;inline const int& getArg1() { return color; } typedef int type1;inline const BasicParticleSystem& getArg2() { return p; } typedef BasicParticleSystem type2;inline MACGrid& getArg3() { return mg; } typedef MACGrid type3;inline MACGrid& getArg4() { return vg; } typedef MACGrid type4;inline const ParticleDataImpl<Vec3>& getArg5() { return vp; } typedef ParticleDataImpl<Vec3> type5;inline const ParticleDataImpl<Vec3>& getArg6() { return cpx; } typedef ParticleDataImpl<Vec3> type6;inline const ParticleDataImpl<Vec3>& getArg7() { return cpy; } typedef ParticleDataImpl<Vec3> type7;inline const ParticleDataImpl<Vec3>& getArg8() { return cpz; } typedef ParticleDataImpl<Vec3> type8;inline const ParticleDataImpl<int>* getArg9() { return ptype; } typedef ParticleDataImpl<int> type9;inline const int& getArg10() { return exclude; } typedef int type10; void runMessage() { debMsg("Executing kernel knApicMapLinearVec3ToMACGrid ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, slabs,color,p,mg,vg,vp,cpx,cpy,cpz,ptype,exclude);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const ParticleSlabs& slabs; const int color; const BasicParticleSystem& p; MACGrid& mg; MACGrid& vg; const ParticleDataImpl<Vec3>& vp; const ParticleDataImpl<Vec3>& cpx; const ParticleDataImpl<Vec3>& cpy; const ParticleDataImpl<Vec3>& cpz; const ParticleDataImpl<int>* ptype; const int exclude;   };
+
 
 
 
@@ -107,7 +117,9 @@ void apicMapPartsToMAC( const FlagGrid &flags, MACGrid &vel, const BasicParticle
 	else mass->clear();
 
 	vel.clear();
-	knApicMapLinearVec3ToMACGrid(parts, *mass, vel, partVel, cpx, cpy, cpz, ptype, exclude);
+	const ParticleSlabs slabs(parts, flags.getSize());
+	for (int color=0; color<2; ++color)
+		knApicMapLinearVec3ToMACGrid(slabs, color, parts, *mass, vel, partVel, cpx, cpy, cpz, ptype, exclude);
 	mass->stomp(VECTOR_EPSILON);
 	vel.safeDivide(*mass);
 
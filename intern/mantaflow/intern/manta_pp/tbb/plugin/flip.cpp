@@ -29,6 +29,7 @@
 #include "commonkernels.h"
 #include "randomstream.h"
 #include "levelset.h"
+#include "tilemask.h"
 #include "shapes.h"
 #include "matrixbase.h"
 
@@ -151,7 +152,8 @@ void sampleShapeWithParticles(const Shape& shape, const FlagGrid& flags, BasicPa
 	}
 }   inline FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline int& getArg1() { return dummy; } typedef int type1; void runMessage() { debMsg("Executing kernel knClearFluidFlags ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ>1) { for (int k=__r.begin(); k!=(int)__r.end(); k++) for (int j=0; j<_maxY; j++) for (int i=0; i<_maxX; i++) op(i,j,k,flags,dummy); } else { const int k=0; for (int j=__r.begin(); j!=(int)__r.end(); j++) for (int i=0; i<_maxX; i++) op(i,j,k,flags,dummy); }  } void run() {  if (maxZ>1) tbb::parallel_for (tbb::blocked_range<IndexInt>(minZ, maxZ), *this); else tbb::parallel_for (tbb::blocked_range<IndexInt>(0, maxY), *this);  }  FlagGrid& flags; int dummy;   };
 
- struct knSetNbObstacle : public KernelBase { knSetNbObstacle(FlagGrid& nflags, const FlagGrid& flags, const Grid<Real>& phiObs) :  KernelBase(&nflags,1) ,nflags(nflags),flags(flags),phiObs(phiObs)   { runMessage(); run(); }  inline void op(int i, int j, int k, FlagGrid& nflags, const FlagGrid& flags, const Grid<Real>& phiObs ) const {
+//! Second order obstacle BCs for a single cell, see knSetNbObstacle
+inline static void setNbObstacleCell(int i, int j, int k, FlagGrid& nflags, const FlagGrid& flags, const Grid<Real>& phiObs) {
 	if ( phiObs(i,j,k)>0. ) return;
 	if (flags.isEmpty(i,j,k)) {
 		bool set=false;
@@ -165,7 +167,21 @@ void sampleShapeWithParticles(const Shape& shape, const FlagGrid& flags, BasicPa
 		}
 		if(set) nflags(i,j,k) = (flags(i,j,k) | FlagGrid::TypeFluid) & ~FlagGrid::TypeEmpty;
 	}
+}
+
+ struct knSetNbObstacle : public KernelBase { knSetNbObstacle(FlagGrid& nflags, const FlagGrid& flags, const Grid<Real>& phiObs) :  KernelBase(&nflags,1) ,nflags(nflags),flags(flags),phiObs(phiObs)   { runMessage(); run(); }  inline void op(int i, int j, int k, FlagGrid& nflags, const FlagGrid& flags, const Grid<Real>& phiObs ) const {
+	setNbObstacleCell(i,j,k, nflags, flags, phiObs);
 }   inline FlagGrid& getArg0() { return nflags; } typedef FlagGrid type0;inline const FlagGrid& getArg1() { return flags; } typedef FlagGrid type1;inline const Grid<Real>& getArg2() { return phiObs; } typedef Grid<Real> type2; void runMessage() { debMsg("Executing kernel knSetNbObstacle ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ>1) { for (int k=__r.begin(); k!=(int)__r.end(); k++) for (int j=1; j<_maxY; j++) for (int i=1; i<_maxX; i++) op(i,j,k,nflags,flags,phiObs); } else { const int k=0; for (int j=__r.begin(); j!=(int)__r.end(); j++) for (int i=1; i<_maxX; i++) op(i,j,k,nflags,flags,phiObs); }  } void run() {  if (maxZ>1) tbb::parallel_for (tbb::blocked_range<IndexInt>(minZ, maxZ), *this); else tbb::parallel_for (tbb::blocked_range<IndexInt>(1, maxY), *this);  }  FlagGrid& nflags; const FlagGrid& flags; const Grid<Real>& phiObs;   };
+
+//! Kernel: knSetNbObstacle, restricted to active tiles
+
+
+ struct knSetNbObstacleTiles : public KernelBase { knSetNbObstacleTiles(const TileMask& mask, FlagGrid& nflags, const FlagGrid& flags, const Grid<Real>& phiObs) :  KernelBase(mask.numActive()) ,mask(mask),nflags(nflags),flags(flags),phiObs(phiObs)   { runMessage(); run(); }   inline void op(IndexInt idx, const TileMask& mask, FlagGrid& nflags, const FlagGrid& flags, const Grid<Real>& phiObs ) const {
+	FOR_TILE_IJK_BND(mask, idx, 1) {
+		setNbObstacleCell(i,j,k, nflags, flags, phiObs);
+	}
+}    inline const TileMask& getArg0() { return mask; } typedef TileMask type0;inline FlagGrid& getArg1() { return nflags; } typedef FlagGrid type1;inline const FlagGrid& getArg2() { return flags; } typedef FlagGrid type2;inline const Grid<Real>& getArg3() { return phiObs; } typedef Grid<Real> type3; void runMessage() { debMsg("Executing kernel knSetNbObstacleTiles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, mask,nflags,flags,phiObs);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const TileMask& mask; FlagGrid& nflags; const FlagGrid& flags; const Grid<Real>& phiObs;   };
+
 void markFluidCells(const BasicParticleSystem& parts, FlagGrid& flags, const Grid<Real>* phiObs=NULL, const ParticleDataImpl<int>* ptype=NULL, const int exclude=0) {
 	// remove all fluid cells
 	knClearFluidFlags(flags, 0);
@@ -181,7 +197,12 @@ void markFluidCells(const BasicParticleSystem& parts, FlagGrid& flags, const Gri
 	// special for second order obstacle BCs, check empty cells in boundary region
 	if(phiObs) {
 		FlagGrid tmp(flags);
-		knSetNbObstacle(tmp, flags, *phiObs);
+		TileMask mask(flags);
+		mask.activateType(flags, FlagGrid::TypeFluid);
+		mask.dilate(1);
+		mask.update();
+		if (mask.useSparse()) knSetNbObstacleTiles(mask, tmp, flags, *phiObs);
+		else                  knSetNbObstacle(tmp, flags, *phiObs);
 		flags.swap(tmp);
 	}
 } static PyObject* _W_3 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "markFluidCells" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const BasicParticleSystem& parts = *_args.getPtr<BasicParticleSystem >("parts",0,&_lock); FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",1,&_lock); const Grid<Real>* phiObs = _args.getPtrOpt<Grid<Real> >("phiObs",2,NULL,&_lock); const ParticleDataImpl<int>* ptype = _args.getPtrOpt<ParticleDataImpl<int> >("ptype",3,NULL,&_lock); const int exclude = _args.getOpt<int >("exclude",4,0,&_lock);   _retval = getPyNone(); markFluidCells(parts,flags,phiObs,ptype,exclude);  _args.check(); } pbFinalizePlugin(parent,"markFluidCells", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("markFluidCells",e.what()); return 0; } } static const Pb::Register _RP_markFluidCells ("","markFluidCells",_W_3);  extern "C" { void PbRegister_markFluidCells() { KEEP_UNUSED(_RP_markFluidCells); } } 
@@ -270,57 +291,110 @@ void debugIntToReal(const Grid<int>& source, Grid<Real>& dest, Real factor=1. )
 // (ie,  particles[index(i+1,j,k)] already belongs to cell i+1,j,k)
 
 
+//! particles of a slab only fall into the cells of its layers, so slabs are counted and
+//! scattered independently; particles stay in index order within each cell
+
+ struct knCountParticleCells : public KernelBase { knCountParticleCells(IndexInt numSlabs, const ParticleSlabs& slabs, const BasicParticleSystem& parts, Grid<int>& index) :  KernelBase(numSlabs) ,numSlabs(numSlabs),slabs(slabs),parts(parts),index(index)   { runMessage(); run(); }   inline void op(IndexInt idx, IndexInt numSlabs, const ParticleSlabs& slabs, const BasicParticleSystem& parts, Grid<int>& index ) const {
+	for (IndexInt i=slabs.begin(idx); i<slabs.end(idx); ++i) {
+		const IndexInt p = slabs[i];
+		const Vec3i c = toVec3i( parts[p].pos );
+		if (! index.isInBounds(c)) continue;
+		index(c)++;
+	}
+}    inline IndexInt& getArg0() { return numSlabs; } typedef IndexInt type0;inline const ParticleSlabs& getArg1() { return slabs; } typedef ParticleSlabs type1;inline const BasicParticleSystem& getArg2() { return parts; } typedef BasicParticleSystem type2;inline Grid<int>& getArg3() { return index; } typedef Grid<int> type3; void runMessage() { debMsg("Executing kernel knCountParticleCells ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, numSlabs,slabs,parts,index);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } IndexInt numSlabs; const ParticleSlabs& slabs; const BasicParticleSystem& parts; Grid<int>& index;   };
+
+ struct knSumSlabCells : public KernelBase { knSumSlabCells(IndexInt numSlabs, const Grid<int>& index, const IndexInt layerCells, std::vector<IndexInt>& offsets) :  KernelBase(numSlabs) ,numSlabs(numSlabs),index(index),layerCells(layerCells),offsets(offsets)   { runMessage(); run(); }   inline void op(IndexInt idx, IndexInt numSlabs, const Grid<int>& index, const IndexInt layerCells, std::vector<IndexInt>& offsets ) const {
+	const IndexInt total = (IndexInt)index.getSizeX() * index.getSizeY() * index.getSizeZ();
+	const IndexInt begin = std::min(idx * ParticleSlabs::LAYERS * layerCells, total);
+	const IndexInt end   = std::min((idx+1) * ParticleSlabs::LAYERS * layerCells, total);
+	IndexInt sum = 0;
+	for (IndexInt i=begin; i<end; ++i) sum += index[i];
+	offsets[idx+1] = sum;
+}    inline IndexInt& getArg0() { return numSlabs; } typedef IndexInt type0;inline const Grid<int>& getArg1() { return index; } typedef Grid<int> type1;inline const IndexInt& getArg2() { return layerCells; } typedef IndexInt type2;inline std::vector<IndexInt>& getArg3() { return offsets; } typedef std::vector<IndexInt> type3; void runMessage() { debMsg("Executing kernel knSumSlabCells ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, numSlabs,index,layerCells,offsets);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } IndexInt numSlabs; const Grid<int>& index; const IndexInt layerCells; std::vector<IndexInt>& offsets;   };
+
+ struct knScanSlabCells : public KernelBase { knScanSlabCells(IndexInt numSlabs, Grid<int>& index, const IndexInt layerCells, const std::vector<IndexInt>& offsets) :  KernelBase(numSlabs) ,numSlabs(numSlabs),index(index),layerCells(layerCells),offsets(offsets)   { runMessage(); run(); }   inline void op(IndexInt idx, IndexInt numSlabs, Grid<int>& index, const IndexInt layerCells, const std::vector<IndexInt>& offsets ) const {
+	const IndexInt total = (IndexInt)index.getSizeX() * index.getSizeY() * index.getSizeZ();
+	const IndexInt begin = std::min(idx * ParticleSlabs::LAYERS * layerCells, total);
+	const IndexInt end   = std::min((idx+1) * ParticleSlabs::LAYERS * layerCells, total);
+	IndexInt sum = offsets[idx];
+	for (IndexInt i=begin; i<end; ++i) {
+		const int num = index[i];
+		index[i] = sum;
+		sum += num;
+	}
+}    inline IndexInt& getArg0() { return numSlabs; } typedef IndexInt type0;inline Grid<int>& getArg1() { return index; } typedef Grid<int> type1;inline const IndexInt& getArg2() { return layerCells; } typedef IndexInt type2;inline const std::vector<IndexInt>& getArg3() { return offsets; } typedef std::vector<IndexInt> type3; void runMessage() { debMsg("Executing kernel knScanSlabCells ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, numSlabs,index,layerCells,offsets);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } IndexInt numSlabs; Grid<int>& index; const IndexInt layerCells; const std::vector<IndexInt>& offsets;   };
+
+ struct knScatterParticleIndex : public KernelBase { knScatterParticleIndex(IndexInt numSlabs, const ParticleSlabs& slabs, const BasicParticleSystem& parts, const Grid<int>& index, Grid<int>& counter, ParticleIndexSystem& indexSys) :  KernelBase(numSlabs) ,numSlabs(numSlabs),slabs(slabs),parts(parts),index(index),counter(counter),indexSys(indexSys)   { runMessage(); run(); }   inline void op(IndexInt idx, IndexInt numSlabs, const ParticleSlabs& slabs, const BasicParticleSystem& parts, const Grid<int>& index, Grid<int>& counter, ParticleIndexSystem& indexSys ) const {
+	for (IndexInt i=slabs.begin(idx); i<slabs.end(idx); ++i) {
+		const IndexInt p = slabs[i];
+		const Vec3i c = toVec3i( parts[p].pos );
+		if (! index.isInBounds(c)) continue;
+		// initialize position and index into original array
+		//indexSys[ index(c)+counter(c) ].pos        = parts[p].pos;
+		indexSys[ index(c)+counter(c) ].sourceIndex = p;
+		counter(c)++;
+	}
+}    inline IndexInt& getArg0() { return numSlabs; } typedef IndexInt type0;inline const ParticleSlabs& getArg1() { return slabs; } typedef ParticleSlabs type1;inline const BasicParticleSystem& getArg2() { return parts; } typedef BasicParticleSystem type2;inline const Grid<int>& getArg3() { return index; } typedef Grid<int> type3;inline Grid<int>& getArg4() { return counter; } typedef Grid<int> type4;inline ParticleIndexSystem& getArg5() { return indexSys; } typedef ParticleIndexSystem type5; void runMessage() { debMsg("Executing kernel knScatterParticleIndex ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, numSlabs,slabs,parts,index,counter,indexSys);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } IndexInt numSlabs; const ParticleSlabs& slabs; const BasicParticleSystem& parts; const Grid<int>& index; Grid<int>& counter; ParticleIndexSystem& indexSys;   };
+
+
 void gridParticleIndex(const BasicParticleSystem& parts, ParticleIndexSystem& indexSys, const FlagGrid& flags, Grid<int>& index, Grid<int>* counter=NULL ) {
 	bool delCounter = false;
 	if(!counter) { counter = new Grid<int>(  flags.getParent() ); delCounter=true; }
 	else         { counter->clear(); }
-	
-	// count particles in cells, and delete excess particles
+
+	// count particles in cells, particles outside the domain are skipped
+	const ParticleSlabs slabs(parts, index.getSize());
+	const IndexInt numSlabs = slabs.size(0) + slabs.size(1);
 	index.clear();
-	int inactive = 0;
-	for (IndexInt idx=0; idx<(IndexInt)parts.size(); idx++) {
-		if (parts.isActive(idx)) {
-			// check index for validity...
-			Vec3i p = toVec3i( parts.getPos(idx) );
-			if (! index.isInBounds(p)) { inactive++; continue; }
+	knCountParticleCells(numSlabs, slabs, parts, index);
 
-			index(p)++;
-		} else {
-			inactive++;
-		}
-	}
+	// convert per cell number to continuous index, each slab covers a contiguous range of cells
+	const IndexInt layerCells = index.is3D() ? index.getStrideZ() : index.getStrideY();
+	std::vector<IndexInt> offsets(numSlabs+1, 0);
+	knSumSlabCells(numSlabs, index, layerCells, offsets);
+	for (IndexInt s=0; s<numSlabs; ++s) offsets[s+1] += offsets[s];
+	knScanSlabCells(numSlabs, index, layerCells, offsets);
 
 	// note - this one might be smaller...
-	indexSys.resize( parts.size()-inactive );
-
-	// convert per cell number to continuous index
-	IndexInt idx=0;
-	FOR_IJK( index ) {
-		int num = index(i,j,k);
-		index(i,j,k) = idx;
-		idx += num;
-	}
+	indexSys.resize( offsets[numSlabs] );
 
 	// add particles to indexed array, we still need a per cell particle counter
-	for (IndexInt idx=0; idx<(IndexInt)parts.size(); idx++) {
-		if (!parts.isActive(idx)) continue;
-		Vec3i p = toVec3i( parts.getPos(idx) );
-		if (! index.isInBounds(p)) { continue; }
-
-		// initialize position and index into original array
-		//indexSys[ index(p)+(*counter)(p) ].pos        = parts[idx].pos;
-		indexSys[ index(p)+(*counter)(p) ].sourceIndex = idx;
-		(*counter)(p)++;
-	}
+	knScatterParticleIndex(numSlabs, slabs, parts, index, *counter, indexSys);
 
 	if(delCounter) delete counter;
 } static PyObject* _W_7 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "gridParticleIndex" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const BasicParticleSystem& parts = *_args.getPtr<BasicParticleSystem >("parts",0,&_lock); ParticleIndexSystem& indexSys = *_args.getPtr<ParticleIndexSystem >("indexSys",1,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",2,&_lock); Grid<int>& index = *_args.getPtr<Grid<int> >("index",3,&_lock); Grid<int>* counter = _args.getPtrOpt<Grid<int> >("counter",4,NULL ,&_lock);   _retval = getPyNone(); gridParticleIndex(parts,indexSys,flags,index,counter);  _args.check(); } pbFinalizePlugin(parent,"gridParticleIndex", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("gridParticleIndex",e.what()); return 0; } } static const Pb::Register _RP_gridParticleIndex ("","gridParticleIndex",_W_7);  extern "C" { void PbRegister_gridParticleIndex() { KEEP_UNUSED(_RP_gridParticleIndex); } } 
 
+//! sort the particle system and all its pdata into the cell order of a particle index
+//! built by gridParticleIndex, so that particle kernels access memory coherently.
+//! particles outside of the index go last, the index is updated to the new order
 
+ struct knIndexSysOrder : public KernelBase { knIndexSysOrder(ParticleIndexSystem& indexSys, std::vector<IndexInt>& order) :  KernelBase(indexSys.size()) ,indexSys(indexSys),order(order)   { runMessage(); run(); }   inline void op(IndexInt idx, ParticleIndexSystem& indexSys, std::vector<IndexInt>& order ) const {
+	order[idx] = indexSys[idx].sourceIndex;
+	indexSys[idx].sourceIndex = idx;
+}    inline ParticleIndexSystem& getArg0() { return indexSys; } typedef ParticleIndexSystem type0;inline std::vector<IndexInt>& getArg1() { return order; } typedef std::vector<IndexInt> type1; void runMessage() { debMsg("Executing kernel knIndexSysOrder ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, indexSys,order);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } ParticleIndexSystem& indexSys; std::vector<IndexInt>& order;   };
 
 
+void reorderParticles(BasicParticleSystem& parts, ParticleIndexSystem& indexSys, const Grid<int>& index) {
+	std::vector<IndexInt> order(parts.size());
+	knIndexSysOrder(indexSys, order);
 
- struct ComputeUnionLevelsetPindex : public KernelBase { ComputeUnionLevelsetPindex(const Grid<int>& index, const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int> *ptype, const int exclude) :  KernelBase(&index,0) ,index(index),parts(parts),indexSys(indexSys),phi(phi),radius(radius),ptype(ptype),exclude(exclude)   { runMessage(); run(); }  inline void op(int i, int j, int k, const Grid<int>& index, const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int> *ptype, const int exclude ) const {
+	IndexInt num = indexSys.size();
+	for (IndexInt idx=0; idx<(IndexInt)parts.size(); idx++) {
+		if (parts.isActive(idx) && index.isInBounds(toVec3i( parts.getPos(idx) ))) continue;
+		if (num == (IndexInt)order.size()) break;
+		order[num++] = idx;
+	}
+	if (num != (IndexInt)order.size()) errMsg("reorderParticles: particle index is out of date, call gridParticleIndex first");
+
+	parts.reorder(order);
+} static PyObject* _W_21 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "reorderParticles" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; BasicParticleSystem& parts = *_args.getPtr<BasicParticleSystem >("parts",0,&_lock); ParticleIndexSystem& indexSys = *_args.getPtr<ParticleIndexSystem >("indexSys",1,&_lock); const Grid<int>& index = *_args.getPtr<Grid<int> >("index",2,&_lock);   _retval = getPyNone(); reorderParticles(parts,indexSys,index);  _args.check(); } pbFinalizePlugin(parent,"reorderParticles", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("reorderParticles",e.what()); return 0; } } static const Pb::Register _RP_reorderParticles ("","reorderParticles",_W_21);  extern "C" { void PbRegister_reorderParticles() { KEEP_UNUSED(_RP_reorderParticles); } } 
+
+
+
+
+
+//! Union levelset value of a single cell, see ComputeUnionLevelsetPindex
+inline static void unionLevelsetCell(int i, int j, int k, const Grid<int>& index, const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int> *ptype, const int exclude) {
 	const Vec3 gridPos = Vec3(i,j,k) + Vec3(0.5); // shifted by half cell
 	Real phiv = radius * 1.0;  // outside
 
@@ -346,16 +420,63 @@ void gridParticleIndex(const BasicParticleSystem& parts, ParticleIndexSystem& in
 		}
 	}
 	phi(i,j,k) = phiv;
+}
+
+ struct ComputeUnionLevelsetPindex : public KernelBase { ComputeUnionLevelsetPindex(const Grid<int>& index, const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int> *ptype, const int exclude) :  KernelBase(&index,0) ,index(index),parts(parts),indexSys(indexSys),phi(phi),radius(radius),ptype(ptype),exclude(exclude)   { runMessage(); run(); }  inline void op(int i, int j, int k, const Grid<int>& index, const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int> *ptype, const int exclude ) const {
+	unionLevelsetCell(i,j,k, index, parts, indexSys, phi, radius, ptype, exclude);
 }   inline const Grid<int>& getArg0() { return index; } typedef Grid<int> type0;inline const BasicParticleSystem& getArg1() { return parts; } typedef BasicParticleSystem type1;inline const ParticleIndexSystem& getArg2() { return indexSys; } typedef ParticleIndexSystem type2;inline LevelsetGrid& getArg3() { return phi; } typedef LevelsetGrid type3;inline const Real& getArg4() { return radius; } typedef Real type4;inline const ParticleDataImpl<int> * getArg5() { return ptype; } typedef ParticleDataImpl<int>  type5;inline const int& getArg6() { return exclude; } typedef int type6; void runMessage() { debMsg("Executing kernel ComputeUnionLevelsetPindex ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ>1) { for (int k=__r.begin(); k!=(int)__r.end(); k++) for (int j=0; j<_maxY; j++) for (int i=0; i<_maxX; i++) op(i,j,k,index,parts,indexSys,phi,radius,ptype,exclude); } else { const int k=0; for (int j=__r.begin(); j!=(int)__r.end(); j++) for (int i=0; i<_maxX; i++) op(i,j,k,index,parts,indexSys,phi,radius,ptype,exclude); }  } void run() {  if (maxZ>1) tbb::parallel_for (tbb::blocked_range<IndexInt>(minZ, maxZ), *this); else tbb::parallel_for (tbb::blocked_range<IndexInt>(0, maxY), *this);  }  const Grid<int>& index; const BasicParticleSystem& parts; const ParticleIndexSystem& indexSys; LevelsetGrid& phi; const Real radius; const ParticleDataImpl<int> * ptype; const int exclude;   };
  
 
 
 
+
+//! Kernel: flag tiles with particles in the particle index
+
+
+ struct knTileHasParticles : public KernelBase { knTileHasParticles(TileMask& mask, const Grid<int>& index, const ParticleIndexSystem& indexSys) :  KernelBase(mask.numTiles()) ,mask(mask),index(index),indexSys(indexSys)   { runMessage(); run(); }   inline void op(IndexInt idx, TileMask& mask, const Grid<int>& index, const ParticleIndexSystem& indexSys ) const {
+	const Vec3i lo = mask.getTileLo(idx,0), hi = mask.getTileHi(idx,0);
+	for (int k=lo.z; k<hi.z; k++)
+	for (int j=lo.y; j<hi.y; j++)
+	for (int i=lo.x; i<hi.x; i++) {
+		IndexInt isysIdxS = index.index(i,j,k);
+		IndexInt pStart = index(isysIdxS), pEnd=0;
+		if(index.isInBounds(isysIdxS+1)) pEnd = index(isysIdxS+1);
+		else                             pEnd = indexSys.size();
+		if (pEnd > pStart) {
+			mask.setTileActive(idx, true);
+			return;
+		}
+	}
+}    inline TileMask& getArg0() { return mask; } typedef TileMask type0;inline const Grid<int>& getArg1() { return index; } typedef Grid<int> type1;inline const ParticleIndexSystem& getArg2() { return indexSys; } typedef ParticleIndexSystem type2; void runMessage() { debMsg("Executing kernel knTileHasParticles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, mask,index,indexSys);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } TileMask& mask; const Grid<int>& index; const ParticleIndexSystem& indexSys;   };
+
+//! Tiles within the neighborhood search radius of any indexed particle, all other cells are outside
+static void getParticleLevelsetTiles(TileMask& mask, const Grid<int>& index, const ParticleIndexSystem& indexSys, const Real radius) {
+	knTileHasParticles(mask, index, indexSys);
+	mask.dilate(TileMask::tilesForCells(int(radius) + 1));
+	mask.update();
+}
+
+//! Kernel: ComputeUnionLevelsetPindex, restricted to active tiles
+
+
+ struct ComputeUnionLevelsetPindexTiles : public KernelBase { ComputeUnionLevelsetPindexTiles(const TileMask& mask, const Grid<int>& index, const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude) :  KernelBase(mask.numActive()) ,mask(mask),index(index),parts(parts),indexSys(indexSys),phi(phi),radius(radius),ptype(ptype),exclude(exclude)   { runMessage(); run(); }   inline void op(IndexInt idx, const TileMask& mask, const Grid<int>& index, const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude ) const {
+	FOR_TILE_IJK_BND(mask, idx, 0) {
+		unionLevelsetCell(i,j,k, index, parts, indexSys, phi, radius, ptype, exclude);
+	}
+}    inline const TileMask& getArg0() { return mask; } typedef TileMask type0;inline const Grid<int>& getArg1() { return index; } typedef Grid<int> type1;inline const BasicParticleSystem& getArg2() { return parts; } typedef BasicParticleSystem type2;inline const ParticleIndexSystem& getArg3() { return indexSys; } typedef ParticleIndexSystem type3;inline LevelsetGrid& getArg4() { return phi; } typedef LevelsetGrid type4;inline const Real& getArg5() { return radius; } typedef Real type5;inline const ParticleDataImpl<int>* getArg6() { return ptype; } typedef ParticleDataImpl<int> type6;inline const int& getArg7() { return exclude; } typedef int type7; void runMessage() { debMsg("Executing kernel ComputeUnionLevelsetPindexTiles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, mask,index,parts,indexSys,phi,radius,ptype,exclude);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const TileMask& mask; const Grid<int>& index; const BasicParticleSystem& parts; const ParticleIndexSystem& indexSys; LevelsetGrid& phi; const Real radius; const ParticleDataImpl<int>* ptype; const int exclude;   };
+
 void unionParticleLevelset(const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, const FlagGrid& flags, const Grid<int>& index, LevelsetGrid& phi, const Real radiusFactor=1., const ParticleDataImpl<int> *ptype=NULL, const int exclude=0) {
 	// use half a cell diagonal as base radius
 	const Real radius = 0.5 * calculateRadiusFactor(phi, radiusFactor);
-	// no reset of phi necessary here 
-	ComputeUnionLevelsetPindex(index, parts, indexSys, phi, radius, ptype, exclude);
+	// no reset of phi necessary here, except for the skipped tiles of the sparse version
+	TileMask mask(phi);
+	getParticleLevelsetTiles(mask, index, indexSys, radius);
+	if (mask.useSparse()) {
+		phi.setConst(radius);
+		ComputeUnionLevelsetPindexTiles(mask, index, parts, indexSys, phi, radius, ptype, exclude);
+	} else {
+		ComputeUnionLevelsetPindex(index, parts, indexSys, phi, radius, ptype, exclude);
+	}
 
 	phi.setBound(0.5, 0);
 } static PyObject* _W_8 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "unionParticleLevelset" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const BasicParticleSystem& parts = *_args.getPtr<BasicParticleSystem >("parts",0,&_lock); const ParticleIndexSystem& indexSys = *_args.getPtr<ParticleIndexSystem >("indexSys",1,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",2,&_lock); const Grid<int>& index = *_args.getPtr<Grid<int> >("index",3,&_lock); LevelsetGrid& phi = *_args.getPtr<LevelsetGrid >("phi",4,&_lock); const Real radiusFactor = _args.getOpt<Real >("radiusFactor",5,1.,&_lock); const ParticleDataImpl<int> * ptype = _args.getPtrOpt<ParticleDataImpl<int>  >("ptype",6,NULL,&_lock); const int exclude = _args.getOpt<int >("exclude",7,0,&_lock);   _retval = getPyNone(); unionParticleLevelset(parts,indexSys,flags,index,phi,radiusFactor,ptype,exclude);  _args.check(); } pbFinalizePlugin(parent,"unionParticleLevelset", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("unionParticleLevelset",e.what()); return 0; } } static const Pb::Register _RP_unionParticleLevelset ("","unionParticleLevelset",_W_8);  extern "C" { void PbRegister_unionParticleLevelset() { KEEP_UNUSED(_RP_unionParticleLevelset); } } 
@@ -367,7 +488,8 @@ void unionParticleLevelset(const BasicParticleSystem& parts, const ParticleIndex
 
 
 
- struct ComputeAveragedLevelsetWeight : public KernelBase { ComputeAveragedLevelsetWeight(const BasicParticleSystem& parts, const Grid<int>& index, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude, Grid<Vec3>* save_pAcc = NULL, Grid<Real>* save_rAcc = NULL) :  KernelBase(&index,0) ,parts(parts),index(index),indexSys(indexSys),phi(phi),radius(radius),ptype(ptype),exclude(exclude),save_pAcc(save_pAcc),save_rAcc(save_rAcc)   { runMessage(); run(); }  inline void op(int i, int j, int k, const BasicParticleSystem& parts, const Grid<int>& index, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude, Grid<Vec3>* save_pAcc = NULL, Grid<Real>* save_rAcc = NULL ) const {
+//! Averaged levelset value of a single cell, see ComputeAveragedLevelsetWeight
+inline static void averagedLevelsetCell(int i, int j, int k, const BasicParticleSystem& parts, const Grid<int>& index, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude, Grid<Vec3>* save_pAcc, Grid<Real>* save_rAcc) {
 	const Vec3 gridPos = Vec3(i,j,k) + Vec3(0.5); // shifted by half cell
 	Real phiv = radius * 1.0; // outside 
 
@@ -412,8 +534,34 @@ void unionParticleLevelset(const BasicParticleSystem& parts, const ParticleIndex
 		if (save_rAcc) (*save_rAcc)(i, j, k) = racc;
 	}
 	phi(i,j,k) = phiv;
+}
+
+ struct ComputeAveragedLevelsetWeight : public KernelBase { ComputeAveragedLevelsetWeight(const BasicParticleSystem& parts, const Grid<int>& index, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude, Grid<Vec3>* save_pAcc = NULL, Grid<Real>* save_rAcc = NULL) :  KernelBase(&index,0) ,parts(parts),index(index),indexSys(indexSys),phi(phi),radius(radius),ptype(ptype),exclude(exclude),save_pAcc(save_pAcc),save_rAcc(save_rAcc)   { runMessage(); run(); }  inline void op(int i, int j, int k, const BasicParticleSystem& parts, const Grid<int>& index, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude, Grid<Vec3>* save_pAcc = NULL, Grid<Real>* save_rAcc = NULL ) const {
+	averagedLevelsetCell(i,j,k, parts, index, indexSys, phi, radius, ptype, exclude, save_pAcc, save_rAcc);
 }   inline const BasicParticleSystem& getArg0() { return parts; } typedef BasicParticleSystem type0;inline const Grid<int>& getArg1() { return index; } typedef Grid<int> type1;inline const ParticleIndexSystem& getArg2() { return indexSys; } typedef ParticleIndexSystem type2;inline LevelsetGrid& getArg3() { return phi; } typedef LevelsetGrid type3;inline const Real& getArg4() { return radius; } typedef Real type4;inline const ParticleDataImpl<int>* getArg5() { return ptype; } typedef ParticleDataImpl<int> type5;inline const int& getArg6() { return exclude; } typedef int type6;inline Grid<Vec3>* getArg7() { return save_pAcc; } typedef Grid<Vec3> type7;inline Grid<Real>* getArg8() { return save_rAcc; } typedef Grid<Real> type8; void runMessage() { debMsg("Executing kernel ComputeAveragedLevelsetWeight ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {  const int _maxX = maxX; const int _maxY = maxY; if (maxZ>1) { for (int k=__r.begin(); k!=(int)__r.end(); k++) for (int j=0; j<_maxY; j++) for (int i=0; i<_maxX; i++) op(i,j,k,parts,index,indexSys,phi,radius,ptype,exclude,save_pAcc,save_rAcc); } else { const int k=0; for (int j=__r.begin(); j!=(int)__r.end(); j++) for (int i=0; i<_maxX; i++) op(i,j,k,parts,index,indexSys,phi,radius,ptype,exclude,save_pAcc,save_rAcc); }  } void run() {  if (maxZ>1) tbb::parallel_for (tbb::blocked_range<IndexInt>(minZ, maxZ), *this); else tbb::parallel_for (tbb::blocked_range<IndexInt>(0, maxY), *this);  }  const BasicParticleSystem& parts; const Grid<int>& index; const ParticleIndexSystem& indexSys; LevelsetGrid& phi; const Real radius; const ParticleDataImpl<int>* ptype; const int exclude; Grid<Vec3>* save_pAcc; Grid<Real>* save_rAcc;   };
 
+
+//! Kernel: ComputeAveragedLevelsetWeight, restricted to active tiles
+
+
+ struct ComputeAveragedLevelsetWeightTiles : public KernelBase { ComputeAveragedLevelsetWeightTiles(const TileMask& mask, const BasicParticleSystem& parts, const Grid<int>& index, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude, Grid<Vec3>* save_pAcc, Grid<Real>* save_rAcc) :  KernelBase(mask.numActive()) ,mask(mask),parts(parts),index(index),indexSys(indexSys),phi(phi),radius(radius),ptype(ptype),exclude(exclude),save_pAcc(save_pAcc),save_rAcc(save_rAcc)   { runMessage(); run(); }   inline void op(IndexInt idx, const TileMask& mask, const BasicParticleSystem& parts, const Grid<int>& index, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude, Grid<Vec3>* save_pAcc, Grid<Real>* save_rAcc ) const {
+	FOR_TILE_IJK_BND(mask, idx, 0) {
+		averagedLevelsetCell(i,j,k, parts, index, indexSys, phi, radius, ptype, exclude, save_pAcc, save_rAcc);
+	}
+}    inline const TileMask& getArg0() { return mask; } typedef TileMask type0;inline const BasicParticleSystem& getArg1() { return parts; } typedef BasicParticleSystem type1;inline const Grid<int>& getArg2() { return index; } typedef Grid<int> type2;inline const ParticleIndexSystem& getArg3() { return indexSys; } typedef ParticleIndexSystem type3;inline LevelsetGrid& getArg4() { return phi; } typedef LevelsetGrid type4;inline const Real& getArg5() { return radius; } typedef Real type5;inline const ParticleDataImpl<int>* getArg6() { return ptype; } typedef ParticleDataImpl<int> type6;inline const int& getArg7() { return exclude; } typedef int type7;inline Grid<Vec3>* getArg8() { return save_pAcc; } typedef Grid<Vec3> type8;inline Grid<Real>* getArg9() { return save_rAcc; } typedef Grid<Real> type9; void runMessage() { debMsg("Executing kernel ComputeAveragedLevelsetWeightTiles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, mask,parts,index,indexSys,phi,radius,ptype,exclude,save_pAcc,save_rAcc);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const TileMask& mask; const BasicParticleSystem& parts; const Grid<int>& index; const ParticleIndexSystem& indexSys; LevelsetGrid& phi; const Real radius; const ParticleDataImpl<int>* ptype; const int exclude; Grid<Vec3>* save_pAcc; Grid<Real>* save_rAcc;   };
+
+//! Averaged levelset for all cells, skips tiles without particles nearby if possible
+static void computeAveragedLevelset(const BasicParticleSystem& parts, const Grid<int>& index, const ParticleIndexSystem& indexSys, LevelsetGrid& phi, const Real radius, const ParticleDataImpl<int>* ptype, const int exclude, Grid<Vec3>* save_pAcc = NULL, Grid<Real>* save_rAcc = NULL) {
+	TileMask mask(phi);
+	getParticleLevelsetTiles(mask, index, indexSys, radius);
+	if (mask.useSparse()) {
+		phi.setConst(radius);
+		ComputeAveragedLevelsetWeightTiles(mask, parts, index, indexSys, phi, radius, ptype, exclude, save_pAcc, save_rAcc);
+	} else {
+		ComputeAveragedLevelsetWeight(parts, index, indexSys, phi, radius, ptype, exclude, save_pAcc, save_rAcc);
+	}
+}
+
 template<class T> T smoothingValue(const Grid<T> val, int i, int j, int k, T center) {
 	return val(i,j,k);
 }
@@ -451,7 +599,7 @@ template <class T>  struct knSmoothGridNeg : public KernelBase { knSmoothGridNeg
 void averagedParticleLevelset(const BasicParticleSystem& parts, const ParticleIndexSystem& indexSys, const FlagGrid& flags, const Grid<int>& index, LevelsetGrid& phi, const Real radiusFactor=1., const int smoothen=1, const int smoothenNeg=1, const ParticleDataImpl<int>* ptype=NULL, const int exclude=0) {
 	// use half a cell diagonal as base radius
 	const Real radius = 0.5 * calculateRadiusFactor(phi, radiusFactor); 
-	ComputeAveragedLevelsetWeight(parts, index, indexSys, phi, radius, ptype, exclude);
+	computeAveragedLevelset(parts, index, indexSys, phi, radius, ptype, exclude);
 
 	// post-process level-set
 	for(int i=0; i<std::max(smoothen,smoothenNeg); ++i) {
@@ -522,7 +670,7 @@ void improvedParticleLevelset(const BasicParticleSystem& parts, const ParticleIn
 	Grid<Real> save_rAcc(flags.getParent());
 
 	const Real radius = 0.5 * calculateRadiusFactor(phi, radiusFactor); // use half a cell diagonal as base radius
-	ComputeAveragedLevelsetWeight(parts, index, indexSys, phi, radius, ptype, exclude, &save_pAcc, &save_rAcc);
+	computeAveragedLevelset(parts, index, indexSys, phi, radius, ptype, exclude, &save_pAcc, &save_rAcc);
 	correctLevelset(phi, save_pAcc, save_rAcc, radius, t_low, t_high);
 
 	// post-process level-set
@@ -579,11 +727,16 @@ template <class T>  struct knSafeDivReal : public KernelBase { knSafeDivReal(Gri
 
 
 
- struct knMapLinearVec3ToMACGrid : public KernelBase { knMapLinearVec3ToMACGrid(const BasicParticleSystem& p, const FlagGrid& flags, const MACGrid& vel, Grid<Vec3>& tmp, const ParticleDataImpl<Vec3>& pvel, const ParticleDataImpl<int>* ptype, const int exclude) :  KernelBase(p.size()) ,p(p),flags(flags),vel(vel),tmp(tmp),pvel(pvel),ptype(ptype),exclude(exclude)   { runMessage(); run(); }   inline void op(IndexInt idx, const BasicParticleSystem& p, const FlagGrid& flags, const MACGrid& vel, Grid<Vec3>& tmp, const ParticleDataImpl<Vec3>& pvel, const ParticleDataImpl<int>* ptype, const int exclude )  {
+ struct knMapLinearVec3ToMACGrid : public KernelBase { knMapLinearVec3ToMACGrid(const ParticleSlabs& slabs, const int color, const BasicParticleSystem& p, const FlagGrid& flags, const MACGrid& vel, Grid<Vec3>& tmp, const ParticleDataImpl<Vec3>& pvel, const ParticleDataImpl<int>* ptype, const int exclude) :  KernelBase(slabs.size(color)) ,slabs(slabs),color(color),p(p),flags(flags),vel(vel),tmp(tmp),pvel(pvel),ptype(ptype),exclude(exclude)   { runMessage(); run(); }   inline void op(IndexInt idx, const ParticleSlabs& slabs, const int color, const BasicParticleSystem& p, const FlagGrid& flags, const MACGrid& vel, Grid<Vec3>& tmp, const ParticleDataImpl<Vec3>& pvel, const ParticleDataImpl<int>* ptype, const int exclude ) const {
 	unusedParameter(flags);
-	if (!p.isActive(idx) || (ptype && ((*ptype)[idx] & exclude))) return;
-	vel.setInterpolated( p[idx].pos, pvel[idx], &tmp[0] );
-}    inline const BasicParticleSystem& getArg0() { return p; } typedef BasicParticleSystem type0;inline const FlagGrid& getArg1() { return flags; } typedef FlagGrid type1;inline const MACGrid& getArg2() { return vel; } typedef MACGrid type2;inline Grid<Vec3>& getArg3() { return tmp; } typedef Grid<Vec3> type3;inline const ParticleDataImpl<Vec3>& getArg4() { return pvel; } typedef ParticleDataImpl<Vec3> type4;inline const ParticleDataImpl<int>* getArg5() { return ptype; } typedef ParticleDataImpl<int> type5;inline const int& getArg6() { return exclude; } typedef int type6; void runMessage() { debMsg("Executing kernel knMapLinearVec3ToMACGrid ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; for (IndexInt i = 0; i < _sz; i++) op(i, p,flags,vel,tmp,pvel,ptype,exclude);   } const BasicParticleSystem& p; const FlagGrid& flags; const MACGrid& vel; Grid<Vec3>& tmp; const ParticleDataImpl<Vec3>& pvel; const ParticleDataImpl<int>* ptype; const int exclude;   };
+	const int slab = 2*idx + color;
+	for (IndexInt j=slabs.begin(slab); j<slabs.end(slab); ++j) {
+		const IndexInt i = slabs[j];
+		if (ptype && ((*ptype)[i] & exclude)) continue;
+		vel.setInterpolated( p[i].pos, pvel[i], &tmp[0] );
+	}
+}    inline const ParticleSlabs& getArg0() { return slabs; } typedef ParticleSlabs type0;inline const int& getArg1() { return color; } typedef int type1;inline const BasicParticleSystem& getArg2() { return p; } typedef BasicParticleSystem type2;inline const FlagGrid& getArg3() { return flags; } typedef FlagGrid type3;inline const MACGrid& getArg4() { return vel; } typedef MACGrid type4;inline Grid<Vec3>& getArg5() { return tmp; } typedef Grid<Vec3> type5;inline const ParticleDataImpl<Vec3>& getArg6() { return pvel; } typedef ParticleDataImpl<Vec3> type6;inline const ParticleDataImpl<int>* getArg7() { return ptype; } typedef ParticleDataImpl<int> type7;inline const int& getArg8() { return exclude; } typedef int type8; void runMessage() { debMsg("Executing kernel knMapLinearVec3ToMACGrid ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, slabs,color,p,flags,vel,tmp,pvel,ptype,exclude);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const ParticleSlabs& slabs; const int color; const BasicParticleSystem& p; const FlagGrid& flags; const MACGrid& vel; Grid<Vec3>& tmp; const ParticleDataImpl<Vec3>& pvel; const ParticleDataImpl<int>* ptype; const int exclude;   };
+
 
 // optionally , this function can use an existing vec3 grid to store the weights
 // this is useful in combination with the simple extrapolation function
@@ -600,7 +753,9 @@ void mapPartsToMAC(const FlagGrid& flags, MACGrid& vel, MACGrid& velOld, const B
 		weight->clear(); // make sure we start with a zero grid!
 	}
 	vel.clear();
-	knMapLinearVec3ToMACGrid( parts, flags, vel, *weight, partVel, ptype, exclude );
+	const ParticleSlabs slabs(parts, flags.getSize());
+	for (int color=0; color<2; ++color)
+		knMapLinearVec3ToMACGrid( slabs, color, parts, flags, vel, *weight, partVel, ptype, exclude );
 
 	// stomp small values in weight to zero to prevent roundoff errors
 	weight->stomp(Vec3(VECTOR_EPSILON));
@@ -614,11 +769,15 @@ void mapPartsToMAC(const FlagGrid& flags, MACGrid& vel, MACGrid& velOld, const B
 
 
 
-template <class T>  struct knMapLinear : public KernelBase { knMapLinear(const BasicParticleSystem& p, const FlagGrid& flags, const Grid<T>& target, Grid<Real>& gtmp, const ParticleDataImpl<T>& psource ) :  KernelBase(p.size()) ,p(p),flags(flags),target(target),gtmp(gtmp),psource(psource)   { runMessage(); run(); }   inline void op(IndexInt idx, const BasicParticleSystem& p, const FlagGrid& flags, const Grid<T>& target, Grid<Real>& gtmp, const ParticleDataImpl<T>& psource  )  {
+template <class T>  struct knMapLinear : public KernelBase { knMapLinear(const ParticleSlabs& slabs, const int color, const BasicParticleSystem& p, const FlagGrid& flags, const Grid<T>& target, Grid<Real>& gtmp, const ParticleDataImpl<T>& psource) :  KernelBase(slabs.size(color)) ,slabs(slabs),color(color),p(p),flags(flags),target(target),gtmp(gtmp),psource(psource)   { runMessage(); run(); }   inline void op(IndexInt idx, const ParticleSlabs& slabs, const int color, const BasicParticleSystem& p, const FlagGrid& flags, const Grid<T>& target, Grid<Real>& gtmp, const ParticleDataImpl<T>& psource ) const {
 	unusedParameter(flags);
-	if (!p.isActive(idx)) return;
-	target.setInterpolated( p[idx].pos, psource[idx], gtmp );
-}    inline const BasicParticleSystem& getArg0() { return p; } typedef BasicParticleSystem type0;inline const FlagGrid& getArg1() { return flags; } typedef FlagGrid type1;inline const Grid<T>& getArg2() { return target; } typedef Grid<T> type2;inline Grid<Real>& getArg3() { return gtmp; } typedef Grid<Real> type3;inline const ParticleDataImpl<T>& getArg4() { return psource; } typedef ParticleDataImpl<T> type4; void runMessage() { debMsg("Executing kernel knMapLinear ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void run() {   const IndexInt _sz = size; for (IndexInt i = 0; i < _sz; i++) op(i, p,flags,target,gtmp,psource);   } const BasicParticleSystem& p; const FlagGrid& flags; const Grid<T>& target; Grid<Real>& gtmp; const ParticleDataImpl<T>& psource;   }; 
+	const int slab = 2*idx + color;
+	for (IndexInt j=slabs.begin(slab); j<slabs.end(slab); ++j) {
+		const IndexInt i = slabs[j];
+		target.setInterpolated( p[i].pos, psource[i], gtmp );
+	}
+}    inline const ParticleSlabs& getArg0() { return slabs; } typedef ParticleSlabs type0;inline const int& getArg1() { return color; } typedef int type1;inline const BasicParticleSystem& getArg2() { return p; } typedef BasicParticleSystem type2;inline const FlagGrid& getArg3() { return flags; } typedef FlagGrid type3;inline const Grid<T>& getArg4() { return target; } typedef Grid<T> type4;inline Grid<Real>& getArg5() { return gtmp; } typedef Grid<Real> type5;inline const ParticleDataImpl<T>& getArg6() { return psource; } typedef ParticleDataImpl<T> type6; void runMessage() { debMsg("Executing kernel knMapLinear ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, slabs,color,p,flags,target,gtmp,psource);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const ParticleSlabs& slabs; const int color; const BasicParticleSystem& p; const FlagGrid& flags; const Grid<T>& target; Grid<Real>& gtmp; const ParticleDataImpl<T>& psource;   };
+
 
 template<class T>
 void mapLinearRealHelper(const FlagGrid& flags, Grid<T>& target,
@@ -626,7 +785,9 @@ void mapLinearRealHelper(const FlagGrid& flags, Grid<T>& target,
 {
 	Grid<Real> tmp(flags.getParent());
 	target.clear();
-	knMapLinear<T>( parts, flags, target, tmp, source ); 
+	const ParticleSlabs slabs(parts, flags.getSize());
+	for (int color=0; color<2; ++color)
+		knMapLinear<T>( slabs, color, parts, flags, target, tmp, source );
 	knSafeDivReal<T>( target, tmp );
 }
 
@@ -300,7 +300,8 @@ void solvePressure(
 	bool zeroPressureFixing = false,
 	const Grid<Real> *curv = NULL,
 	const Real surfTens = 0.0,
-	Grid<Real>* retRhs = NULL );
+	Grid<Real>* retRhs = NULL,
+	bool packedMatrix = false );
 
 //! Main function for fluid guiding , includes "regular" pressure solve
 
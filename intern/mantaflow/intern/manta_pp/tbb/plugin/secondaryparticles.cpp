@@ -113,17 +113,19 @@ void flipComputeSecondaryParticlePotentials( Grid<Real> &potTA, Grid<Real> &potW
 	knFlipComputeSecondaryParticlePotentials(potTA, potWC, potKE, neighborRatio, flags, v, normal, radius, tauMinTA, tauMaxTA, tauMinWC, tauMaxWC, tauMinKE, tauMaxKE, scaleFromManta, itype, jtype);
 } static PyObject* _W_0 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "flipComputeSecondaryParticlePotentials" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; Grid<Real> & potTA = *_args.getPtr<Grid<Real>  >("potTA",0,&_lock); Grid<Real> & potWC = *_args.getPtr<Grid<Real>  >("potWC",1,&_lock); Grid<Real> & potKE = *_args.getPtr<Grid<Real>  >("potKE",2,&_lock); Grid<Real> & neighborRatio = *_args.getPtr<Grid<Real>  >("neighborRatio",3,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",4,&_lock); const MACGrid& v = *_args.getPtr<MACGrid >("v",5,&_lock); Grid<Vec3>& normal = *_args.getPtr<Grid<Vec3> >("normal",6,&_lock); const Grid<Real>& phi = *_args.getPtr<Grid<Real> >("phi",7,&_lock); const int radius = _args.get<int >("radius",8,&_lock); const Real tauMinTA = _args.get<Real >("tauMinTA",9,&_lock); const Real tauMaxTA = _args.get<Real >("tauMaxTA",10,&_lock); const Real tauMinWC = _args.get<Real >("tauMinWC",11,&_lock); const Real tauMaxWC = _args.get<Real >("tauMaxWC",12,&_lock); const Real tauMinKE = _args.get<Real >("tauMinKE",13,&_lock); const Real tauMaxKE = _args.get<Real >("tauMaxKE",14,&_lock); const Real scaleFromManta = _args.get<Real >("scaleFromManta",15,&_lock); const int itype = _args.getOpt<int >("itype",16,FlagGrid::TypeFluid,&_lock); const int jtype = _args.getOpt<int >("jtype",17,FlagGrid::TypeObstacle,&_lock);   _retval = getPyNone(); flipComputeSecondaryParticlePotentials(potTA,potWC,potKE,neighborRatio,flags,v,normal,phi,radius,tauMinTA,tauMaxTA,tauMinWC,tauMaxWC,tauMinKE,tauMaxKE,scaleFromManta,itype,jtype);  _args.check(); } pbFinalizePlugin(parent,"flipComputeSecondaryParticlePotentials", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("flipComputeSecondaryParticlePotentials",e.what()); return 0; } } static const Pb::Register _RP_flipComputeSecondaryParticlePotentials ("","flipComputeSecondaryParticlePotentials",_W_0);  extern "C" { void PbRegister_flipComputeSecondaryParticlePotentials() { KEEP_UNUSED(_RP_flipComputeSecondaryParticlePotentials); } } 
 
-// adds secondary particles to &pts_sec for every fluid cell in &flags according to the potential grids &potTA, &potWC and &potKE
+//! secondary particles sampled in one z-slice, in the order of a serial sweep over k,j,i.
+//! the random stream is seeded per cell, so the samples don't depend on the number of threads
+struct SecondarySamples {
+	std::vector<Vec3> pos, vel;
+	std::vector<Real> life;
+	std::vector<int> flag;
+};
+
+// adds secondary particles to &out for cell i,j,k according to the potential grids &potTA, &potWC and &potKE
 // secondary particles are uniformly sampled in every fluid cell in a randomly offset cylinder in fluid movement direction
-// In contrast to flipSampleSecondaryParticles this uses more cylinders per cell and interpolates velocity and potentials.
+// In contrast to sampleSecondaryParticlesCell this uses more cylinders per cell and interpolates velocity and potentials.
 // To control number of cylinders in each dimension adjust radius(0.25=>2 cyl, 0.1666=>3 cyl, 0.125=>3cyl etc.).
-
-
-
-
-
- struct knFlipSampleSecondaryParticlesMoreCylinders : public KernelBase { knFlipSampleSecondaryParticlesMoreCylinders( const FlagGrid &flags, const MACGrid &v, BasicParticleSystem &pts_sec, ParticleDataImpl<Vec3> &v_sec, ParticleDataImpl<Real> &l_sec, const Real lMin, const Real lMax, const Grid<Real> &potTA, const Grid<Real> &potWC, const Grid<Real> &potKE, const Grid<Real> &neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype = FlagGrid::TypeFluid) :  KernelBase(&flags,0) ,flags(flags),v(v),pts_sec(pts_sec),v_sec(v_sec),l_sec(l_sec),lMin(lMin),lMax(lMax),potTA(potTA),potWC(potWC),potKE(potKE),neighborRatio(neighborRatio),c_s(c_s),c_b(c_b),k_ta(k_ta),k_wc(k_wc),dt(dt),itype(itype)   { runMessage(); run(); }  inline void op(int i, int j, int k,  const FlagGrid &flags, const MACGrid &v, BasicParticleSystem &pts_sec, ParticleDataImpl<Vec3> &v_sec, ParticleDataImpl<Real> &l_sec, const Real lMin, const Real lMax, const Grid<Real> &potTA, const Grid<Real> &potWC, const Grid<Real> &potKE, const Grid<Real> &neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype = FlagGrid::TypeFluid )  {
-
+static inline void sampleSecondaryParticlesCellMoreCylinders(int i, int j, int k, const FlagGrid &flags, const MACGrid &v, SecondarySamples &out, const Real lMin, const Real lMax, const Grid<Real> &potTA, const Grid<Real> &potWC, const Grid<Real> &potKE, const Grid<Real> &neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype) {
 	if (!(flags(i, j, k) & itype)) return;
 
 	RandomStream mRand(9832);
@@ -150,31 +152,25 @@ void flipComputeSecondaryParticlePotentials( Grid<Real> &potTA, Grid<Real> &potW
 					const Real h = mRand.getReal() * norm(dt*vi);			//distance to reference plane
 					Vec3 xd = xi + r*cos(theta)*e1 + r*sin(theta)*e2 + h*getNormalized(vi);
 					if (!flags.is3D()) xd.z = 0;
-					pts_sec.add(xd);
+					out.pos.push_back(xd);
 
-					v_sec[v_sec.size() - 1] = r*cos(theta)*e1 + r*sin(theta)*e2 + vi;	//init velocity of new particle
+					out.vel.push_back(r*cos(theta)*e1 + r*sin(theta)*e2 + vi);	//init velocity of new particle
 					Real temp = (KE + TA + WC) / 3;
-					l_sec[l_sec.size() - 1] = ((lMax - lMin) * temp) + lMin + mRand.getReal()*0.1;	//init lifetime of new particle
+					out.life.push_back(((lMax - lMin) * temp) + lMin + mRand.getReal()*0.1);	//init lifetime of new particle
 
 					//init type of new particle
-					if (neighborRatio(i, j, k) < c_s) { pts_sec[pts_sec.size() - 1].flag = ParticleBase::PSPRAY; }
-					else if (neighborRatio(i, j, k) > c_b) { pts_sec[pts_sec.size() - 1].flag = ParticleBase::PBUBBLE; }
-					else { pts_sec[pts_sec.size() - 1].flag = ParticleBase::PFOAM; }
+					if (neighborRatio(i, j, k) < c_s) { out.flag.push_back(ParticleBase::PSPRAY); }
+					else if (neighborRatio(i, j, k) > c_b) { out.flag.push_back(ParticleBase::PBUBBLE); }
+					else { out.flag.push_back(ParticleBase::PFOAM); }
 				}
 			}
 		}
 	}
-}   inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline const MACGrid& getArg1() { return v; } typedef MACGrid type1;inline BasicParticleSystem& getArg2() { return pts_sec; } typedef BasicParticleSystem type2;inline ParticleDataImpl<Vec3> & getArg3() { return v_sec; } typedef ParticleDataImpl<Vec3>  type3;inline ParticleDataImpl<Real> & getArg4() { return l_sec; } typedef ParticleDataImpl<Real>  type4;inline const Real& getArg5() { return lMin; } typedef Real type5;inline const Real& getArg6() { return lMax; } typedef Real type6;inline const Grid<Real> & getArg7() { return potTA; } typedef Grid<Real>  type7;inline const Grid<Real> & getArg8() { return potWC; } typedef Grid<Real>  type8;inline const Grid<Real> & getArg9() { return potKE; } typedef Grid<Real>  type9;inline const Grid<Real> & getArg10() { return neighborRatio; } typedef Grid<Real>  type10;inline const Real& getArg11() { return c_s; } typedef Real type11;inline const Real& getArg12() { return c_b; } typedef Real type12;inline const Real& getArg13() { return k_ta; } typedef Real type13;inline const Real& getArg14() { return k_wc; } typedef Real type14;inline const Real& getArg15() { return dt; } typedef Real type15;inline const int& getArg16() { return itype; } typedef int type16; void runMessage() { debMsg("Executing kernel knFlipSampleSecondaryParticlesMoreCylinders ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {  const int _maxX = maxX; const int _maxY = maxY; for (int k=minZ; k< maxZ; k++) for (int j=0; j< _maxY; j++) for (int i=0; i< _maxX; i++) op(i,j,k, flags,v,pts_sec,v_sec,l_sec,lMin,lMax,potTA,potWC,potKE,neighborRatio,c_s,c_b,k_ta,k_wc,dt,itype);  } const FlagGrid& flags; const MACGrid& v; BasicParticleSystem& pts_sec; ParticleDataImpl<Vec3> & v_sec; ParticleDataImpl<Real> & l_sec; const Real lMin; const Real lMax; const Grid<Real> & potTA; const Grid<Real> & potWC; const Grid<Real> & potKE; const Grid<Real> & neighborRatio; const Real c_s; const Real c_b; const Real k_ta; const Real k_wc; const Real dt; const int itype;   };
+}
 
-// adds secondary particles to &pts_sec for every fluid cell in &flags according to the potential grids &potTA, &potWC and &potKE
+// adds secondary particles to &out for cell i,j,k according to the potential grids &potTA, &potWC and &potKE
 // secondary particles are uniformly sampled in every fluid cell in a randomly offset cylinder in fluid movement direction
-
-
-
-
-
- struct knFlipSampleSecondaryParticles : public KernelBase { knFlipSampleSecondaryParticles( const FlagGrid &flags, const MACGrid &v, BasicParticleSystem &pts_sec, ParticleDataImpl<Vec3> &v_sec, ParticleDataImpl<Real> &l_sec, const Real lMin, const Real lMax, const Grid<Real> &potTA, const Grid<Real> &potWC, const Grid<Real> &potKE, const Grid<Real> &neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype = FlagGrid::TypeFluid) :  KernelBase(&flags,0) ,flags(flags),v(v),pts_sec(pts_sec),v_sec(v_sec),l_sec(l_sec),lMin(lMin),lMax(lMax),potTA(potTA),potWC(potWC),potKE(potKE),neighborRatio(neighborRatio),c_s(c_s),c_b(c_b),k_ta(k_ta),k_wc(k_wc),dt(dt),itype(itype)   { runMessage(); run(); }  inline void op(int i, int j, int k,  const FlagGrid &flags, const MACGrid &v, BasicParticleSystem &pts_sec, ParticleDataImpl<Vec3> &v_sec, ParticleDataImpl<Real> &l_sec, const Real lMin, const Real lMax, const Grid<Real> &potTA, const Grid<Real> &potWC, const Grid<Real> &potKE, const Grid<Real> &neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype = FlagGrid::TypeFluid )  {
-
+static inline void sampleSecondaryParticlesCell(int i, int j, int k, const FlagGrid &flags, const MACGrid &v, SecondarySamples &out, const Real lMin, const Real lMax, const Grid<Real> &potTA, const Grid<Real> &potWC, const Grid<Real> &potKE, const Grid<Real> &neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype) {
 	if (!(flags(i, j, k) & itype)) return;
 
 	Real KE = potKE(i, j, k);
@@ -197,33 +193,74 @@ void flipComputeSecondaryParticlePotentials( Grid<Real> &potTA, Grid<Real> &potW
 		const Real h = mRand.getReal() * norm(dt*vi);			//distance to reference plane
 		Vec3 xd = xi + r*cos(theta)*e1 + r*sin(theta)*e2 + h*getNormalized(vi);
 		if (!flags.is3D()) xd.z = 0;
-		pts_sec.add(xd);
+		out.pos.push_back(xd);
 
-		v_sec[v_sec.size() - 1] = r*cos(theta)*e1 + r*sin(theta)*e2 + vi;	//init velocity of new particle
+		out.vel.push_back(r*cos(theta)*e1 + r*sin(theta)*e2 + vi);	//init velocity of new particle
 		Real temp = (KE + TA + WC) / 3;
-		l_sec[l_sec.size() - 1] = ((lMax - lMin) * temp) + lMin + mRand.getReal()*0.1;	//init lifetime of new particle
+		out.life.push_back(((lMax - lMin) * temp) + lMin + mRand.getReal()*0.1);	//init lifetime of new particle
 
 		//init type of new particle
-		if (neighborRatio(i, j, k) < c_s) { pts_sec[pts_sec.size() - 1].flag = ParticleBase::PSPRAY; }
-		else if (neighborRatio(i, j, k) > c_b) { pts_sec[pts_sec.size() - 1].flag = ParticleBase::PBUBBLE; }
-		else { pts_sec[pts_sec.size() - 1].flag = ParticleBase::PFOAM; }
+		if (neighborRatio(i, j, k) < c_s) { out.flag.push_back(ParticleBase::PSPRAY); }
+		else if (neighborRatio(i, j, k) > c_b) { out.flag.push_back(ParticleBase::PBUBBLE); }
+		else { out.flag.push_back(ParticleBase::PFOAM); }
 	}
-}   inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline const MACGrid& getArg1() { return v; } typedef MACGrid type1;inline BasicParticleSystem& getArg2() { return pts_sec; } typedef BasicParticleSystem type2;inline ParticleDataImpl<Vec3> & getArg3() { return v_sec; } typedef ParticleDataImpl<Vec3>  type3;inline ParticleDataImpl<Real> & getArg4() { return l_sec; } typedef ParticleDataImpl<Real>  type4;inline const Real& getArg5() { return lMin; } typedef Real type5;inline const Real& getArg6() { return lMax; } typedef Real type6;inline const Grid<Real> & getArg7() { return potTA; } typedef Grid<Real>  type7;inline const Grid<Real> & getArg8() { return potWC; } typedef Grid<Real>  type8;inline const Grid<Real> & getArg9() { return potKE; } typedef Grid<Real>  type9;inline const Grid<Real> & getArg10() { return neighborRatio; } typedef Grid<Real>  type10;inline const Real& getArg11() { return c_s; } typedef Real type11;inline const Real& getArg12() { return c_b; } typedef Real type12;inline const Real& getArg13() { return k_ta; } typedef Real type13;inline const Real& getArg14() { return k_wc; } typedef Real type14;inline const Real& getArg15() { return dt; } typedef Real type15;inline const int& getArg16() { return itype; } typedef int type16; void runMessage() { debMsg("Executing kernel knFlipSampleSecondaryParticles ", 3); debMsg("Kernel range" <<  " x "<<  maxX  << " y "<< maxY  << " z "<< minZ<<" - "<< maxZ  << " "   , 4); }; void run() {  const int _maxX = maxX; const int _maxY = maxY; for (int k=minZ; k< maxZ; k++) for (int j=0; j< _maxY; j++) for (int i=0; i< _maxX; i++) op(i,j,k, flags,v,pts_sec,v_sec,l_sec,lMin,lMax,potTA,potWC,potKE,neighborRatio,c_s,c_b,k_ta,k_wc,dt,itype);  } const FlagGrid& flags; const MACGrid& v; BasicParticleSystem& pts_sec; ParticleDataImpl<Vec3> & v_sec; ParticleDataImpl<Real> & l_sec; const Real lMin; const Real lMax; const Grid<Real> & potTA; const Grid<Real> & potWC; const Grid<Real> & potKE; const Grid<Real> & neighborRatio; const Real c_s; const Real c_b; const Real k_ta; const Real k_wc; const Real dt; const int itype;   };
+}
+
+// sample all z-slices in parallel, each into its own buffer
+
+ struct knFlipSampleSecondaryParticles : public KernelBase { knFlipSampleSecondaryParticles(const FlagGrid& flags, const MACGrid& v, std::vector<SecondarySamples>& samples, const Real lMin, const Real lMax, const Grid<Real>& potTA, const Grid<Real>& potWC, const Grid<Real>& potKE, const Grid<Real>& neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype) :  KernelBase(flags.getSizeZ()) ,flags(flags),v(v),samples(samples),lMin(lMin),lMax(lMax),potTA(potTA),potWC(potWC),potKE(potKE),neighborRatio(neighborRatio),c_s(c_s),c_b(c_b),k_ta(k_ta),k_wc(k_wc),dt(dt),itype(itype)   { runMessage(); run(); }   inline void op(IndexInt idx, const FlagGrid& flags, const MACGrid& v, std::vector<SecondarySamples>& samples, const Real lMin, const Real lMax, const Grid<Real>& potTA, const Grid<Real>& potWC, const Grid<Real>& potKE, const Grid<Real>& neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype ) const {
+	for (int j = 0; j < flags.getSizeY(); j++) {
+		for (int i = 0; i < flags.getSizeX(); i++) {
+			sampleSecondaryParticlesCell(i, j, idx, flags, v, samples[idx], lMin, lMax, potTA, potWC, potKE, neighborRatio, c_s, c_b, k_ta, k_wc, dt, itype);
+		}
+	}
+}    inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline const MACGrid& getArg1() { return v; } typedef MACGrid type1;inline std::vector<SecondarySamples>& getArg2() { return samples; } typedef std::vector<SecondarySamples> type2;inline const Real& getArg3() { return lMin; } typedef Real type3;inline const Real& getArg4() { return lMax; } typedef Real type4;inline const Grid<Real>& getArg5() { return potTA; } typedef Grid<Real> type5;inline const Grid<Real>& getArg6() { return potWC; } typedef Grid<Real> type6;inline const Grid<Real>& getArg7() { return potKE; } typedef Grid<Real> type7;inline const Grid<Real>& getArg8() { return neighborRatio; } typedef Grid<Real> type8;inline const Real& getArg9() { return c_s; } typedef Real type9;inline const Real& getArg10() { return c_b; } typedef Real type10;inline const Real& getArg11() { return k_ta; } typedef Real type11;inline const Real& getArg12() { return k_wc; } typedef Real type12;inline const Real& getArg13() { return dt; } typedef Real type13;inline const int& getArg14() { return itype; } typedef int type14; void runMessage() { debMsg("Executing kernel knFlipSampleSecondaryParticles ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, flags,v,samples,lMin,lMax,potTA,potWC,potKE,neighborRatio,c_s,c_b,k_ta,k_wc,dt,itype);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const FlagGrid& flags; const MACGrid& v; std::vector<SecondarySamples>& samples; const Real lMin; const Real lMax; const Grid<Real>& potTA; const Grid<Real>& potWC; const Grid<Real>& potKE; const Grid<Real>& neighborRatio; const Real c_s; const Real c_b; const Real k_ta; const Real k_wc; const Real dt; const int itype;   };
+
+ struct knFlipSampleSecondaryParticlesMoreCylinders : public KernelBase { knFlipSampleSecondaryParticlesMoreCylinders(const FlagGrid& flags, const MACGrid& v, std::vector<SecondarySamples>& samples, const Real lMin, const Real lMax, const Grid<Real>& potTA, const Grid<Real>& potWC, const Grid<Real>& potKE, const Grid<Real>& neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype) :  KernelBase(flags.getSizeZ()) ,flags(flags),v(v),samples(samples),lMin(lMin),lMax(lMax),potTA(potTA),potWC(potWC),potKE(potKE),neighborRatio(neighborRatio),c_s(c_s),c_b(c_b),k_ta(k_ta),k_wc(k_wc),dt(dt),itype(itype)   { runMessage(); run(); }   inline void op(IndexInt idx, const FlagGrid& flags, const MACGrid& v, std::vector<SecondarySamples>& samples, const Real lMin, const Real lMax, const Grid<Real>& potTA, const Grid<Real>& potWC, const Grid<Real>& potKE, const Grid<Real>& neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype ) const {
+	for (int j = 0; j < flags.getSizeY(); j++) {
+		for (int i = 0; i < flags.getSizeX(); i++) {
+			sampleSecondaryParticlesCellMoreCylinders(i, j, idx, flags, v, samples[idx], lMin, lMax, potTA, potWC, potKE, neighborRatio, c_s, c_b, k_ta, k_wc, dt, itype);
+		}
+	}
+}    inline const FlagGrid& getArg0() { return flags; } typedef FlagGrid type0;inline const MACGrid& getArg1() { return v; } typedef MACGrid type1;inline std::vector<SecondarySamples>& getArg2() { return samples; } typedef std::vector<SecondarySamples> type2;inline const Real& getArg3() { return lMin; } typedef Real type3;inline const Real& getArg4() { return lMax; } typedef Real type4;inline const Grid<Real>& getArg5() { return potTA; } typedef Grid<Real> type5;inline const Grid<Real>& getArg6() { return potWC; } typedef Grid<Real> type6;inline const Grid<Real>& getArg7() { return potKE; } typedef Grid<Real> type7;inline const Grid<Real>& getArg8() { return neighborRatio; } typedef Grid<Real> type8;inline const Real& getArg9() { return c_s; } typedef Real type9;inline const Real& getArg10() { return c_b; } typedef Real type10;inline const Real& getArg11() { return k_ta; } typedef Real type11;inline const Real& getArg12() { return k_wc; } typedef Real type12;inline const Real& getArg13() { return dt; } typedef Real type13;inline const int& getArg14() { return itype; } typedef int type14; void runMessage() { debMsg("Executing kernel knFlipSampleSecondaryParticlesMoreCylinders ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, flags,v,samples,lMin,lMax,potTA,potWC,potKE,neighborRatio,c_s,c_b,k_ta,k_wc,dt,itype);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const FlagGrid& flags; const MACGrid& v; std::vector<SecondarySamples>& samples; const Real lMin; const Real lMax; const Grid<Real>& potTA; const Grid<Real>& potWC; const Grid<Real>& potKE; const Grid<Real>& neighborRatio; const Real c_s; const Real c_b; const Real k_ta; const Real k_wc; const Real dt; const int itype;   };
+
 
+// append the buffers in slice order
 
+ struct knAddSecondarySamples : public KernelBase { knAddSecondarySamples(const std::vector<SecondarySamples>& samples, const std::vector<IndexInt>& offsets, BasicParticleSystem& pts_sec, ParticleDataImpl<Vec3>& v_sec, ParticleDataImpl<Real>& l_sec) :  KernelBase(samples.size()) ,samples(samples),offsets(offsets),pts_sec(pts_sec),v_sec(v_sec),l_sec(l_sec)   { runMessage(); run(); }   inline void op(IndexInt idx, const std::vector<SecondarySamples>& samples, const std::vector<IndexInt>& offsets, BasicParticleSystem& pts_sec, ParticleDataImpl<Vec3>& v_sec, ParticleDataImpl<Real>& l_sec ) const {
+	const SecondarySamples& slice = samples[idx];
+	for (IndexInt n = 0; n < (IndexInt)slice.pos.size(); n++) {
+		const IndexInt to = offsets[idx] + n;
+		pts_sec[to].pos = slice.pos[n];
+		pts_sec[to].flag = slice.flag[n];
+		v_sec[to] = slice.vel[n];
+		l_sec[to] = slice.life[n];
+	}
+}    inline const std::vector<SecondarySamples>& getArg0() { return samples; } typedef std::vector<SecondarySamples> type0;inline const std::vector<IndexInt>& getArg1() { return offsets; } typedef std::vector<IndexInt> type1;inline BasicParticleSystem& getArg2() { return pts_sec; } typedef BasicParticleSystem type2;inline ParticleDataImpl<Vec3>& getArg3() { return v_sec; } typedef ParticleDataImpl<Vec3> type3;inline ParticleDataImpl<Real>& getArg4() { return l_sec; } typedef ParticleDataImpl<Real> type4; void runMessage() { debMsg("Executing kernel knAddSecondarySamples ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, samples,offsets,pts_sec,v_sec,l_sec);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } const std::vector<SecondarySamples>& samples; const std::vector<IndexInt>& offsets; BasicParticleSystem& pts_sec; ParticleDataImpl<Vec3>& v_sec; ParticleDataImpl<Real>& l_sec;   };
 
 
 
 void flipSampleSecondaryParticles( const std::string mode, const FlagGrid &flags, const MACGrid &v, BasicParticleSystem &pts_sec, ParticleDataImpl<Vec3> &v_sec, ParticleDataImpl<Real> &l_sec, const Real lMin, const Real lMax, const Grid<Real> &potTA, const Grid<Real> &potWC, const Grid<Real> &potKE, const Grid<Real> &neighborRatio, const Real c_s, const Real c_b, const Real k_ta, const Real k_wc, const Real dt, const int itype = FlagGrid::TypeFluid) {
+	std::vector<SecondarySamples> samples(flags.getSizeZ());
 	if (mode == "single") {
-		knFlipSampleSecondaryParticles(flags, v, pts_sec, v_sec, l_sec, lMin, lMax, potTA, potWC, potKE, neighborRatio, c_s, c_b, k_ta, k_wc, dt, itype);
+		knFlipSampleSecondaryParticles(flags, v, samples, lMin, lMax, potTA, potWC, potKE, neighborRatio, c_s, c_b, k_ta, k_wc, dt, itype);
 	}
 	else if (mode == "multiple") {
-		knFlipSampleSecondaryParticlesMoreCylinders(flags, v, pts_sec, v_sec, l_sec, lMin, lMax, potTA, potWC, potKE, neighborRatio, c_s, c_b, k_ta, k_wc, dt, itype);
+		knFlipSampleSecondaryParticlesMoreCylinders(flags, v, samples, lMin, lMax, potTA, potWC, potKE, neighborRatio, c_s, c_b, k_ta, k_wc, dt, itype);
 	}
 	else {
 		throw std::invalid_argument("Unknown mode: use \"single\" or \"multiple\" instead!");
 	}
+
+	std::vector<IndexInt> offsets(samples.size());
+	IndexInt num = 0;
+	for (size_t k = 0; k < samples.size(); k++) {
+		offsets[k] = num;
+		num += samples[k].pos.size();
+	}
+	const IndexInt first = pts_sec.addEntries(num);
+	for (size_t k = 0; k < offsets.size(); k++) offsets[k] += first;
+	knAddSecondarySamples(samples, offsets, pts_sec, v_sec, l_sec);
 } static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "flipSampleSecondaryParticles" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const std::string mode = _args.get<std::string >("mode",0,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",1,&_lock); const MACGrid& v = *_args.getPtr<MACGrid >("v",2,&_lock); BasicParticleSystem& pts_sec = *_args.getPtr<BasicParticleSystem >("pts_sec",3,&_lock); ParticleDataImpl<Vec3> & v_sec = *_args.getPtr<ParticleDataImpl<Vec3>  >("v_sec",4,&_lock); ParticleDataImpl<Real> & l_sec = *_args.getPtr<ParticleDataImpl<Real>  >("l_sec",5,&_lock); const Real lMin = _args.get<Real >("lMin",6,&_lock); const Real lMax = _args.get<Real >("lMax",7,&_lock); const Grid<Real> & potTA = *_args.getPtr<Grid<Real>  >("potTA",8,&_lock); const Grid<Real> & potWC = *_args.getPtr<Grid<Real>  >("potWC",9,&_lock); const Grid<Real> & potKE = *_args.getPtr<Grid<Real>  >("potKE",10,&_lock); const Grid<Real> & neighborRatio = *_args.getPtr<Grid<Real>  >("neighborRatio",11,&_lock); const Real c_s = _args.get<Real >("c_s",12,&_lock); const Real c_b = _args.get<Real >("c_b",13,&_lock); const Real k_ta = _args.get<Real >("k_ta",14,&_lock); const Real k_wc = _args.get<Real >("k_wc",15,&_lock); const Real dt = _args.get<Real >("dt",16,&_lock); const int itype = _args.getOpt<int >("itype",17,FlagGrid::TypeFluid,&_lock);   _retval = getPyNone(); flipSampleSecondaryParticles(mode,flags,v,pts_sec,v_sec,l_sec,lMin,lMax,potTA,potWC,potKE,neighborRatio,c_s,c_b,k_ta,k_wc,dt,itype);  _args.check(); } pbFinalizePlugin(parent,"flipSampleSecondaryParticles", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("flipSampleSecondaryParticles",e.what()); return 0; } } static const Pb::Register _RP_flipSampleSecondaryParticles ("","flipSampleSecondaryParticles",_W_1);  extern "C" { void PbRegister_flipSampleSecondaryParticles() { KEEP_UNUSED(_RP_flipSampleSecondaryParticles); } } 
 
 
@@ -50,7 +50,7 @@
 using namespace std;
 namespace Manta {
 
-// own namespace for globals
+// own namespace for surface turbulence helpers
 namespace SurfaceTurbulence {
 
 
@@ -79,7 +79,6 @@ struct SurfaceTurbulenceParameters {
     Real tangentRadius;
     Real bndXm, bndXp, bndYm, bndYp, bndZm, bndZp;
 };
-SurfaceTurbulenceParameters params;
 
 
 //
@@ -87,68 +86,94 @@ SurfaceTurbulenceParameters params;
 //
 struct ParticleAccelGrid{
     int res;
-    vector<int>*** indices;
+    int domainRes;
+    vector<int> cellStart;    // offsets of the cells into indices, res^3+1 entries
+    vector<int> indices;      // particle indices sorted by cell, in index order within a cell
+    vector<int> particleCell; // cell of each particle
+    vector<int> particleRank; // position of each particle within its cell
 
-    void init(int inRes) {
+    void init(int inRes, int inDomainRes) {
         res = inRes;
-        indices = new vector<int>**[res];
-        for(int i=0; i<res; i++){
-            indices[i] = new vector<int>*[res];
-            for(int j=0; j<res; j++) {
-                indices[i][j] = new vector<int>[res];
-            }
-        }
+        domainRes = inDomainRes;
+        cellStart.assign(res*res*res+1, 0);
+        indices.clear();
     }
 
-    void fillWith(const BasicParticleSystem& particles) {
-        // clear
-        for(int i=0; i<res; i++) {
-        for(int j=0; j<res; j++) {
-        for(int k=0; k<res; k++) {
-            indices[i][j][k].clear();
-        }}}
-
-        // fill
-        for(int id=0;id<particles.size();id++) {
-            Vec3 pos = particles.getPos(id);
-            int i = clamp<int>(floor(pos.x/params.res*res), 0, res-1);
-            int j = clamp<int>(floor(pos.y/params.res*res), 0, res-1);
-            int k = clamp<int>(floor(pos.z/params.res*res), 0, res-1);
-            indices[i][j][k].push_back(id);
-        }
+    inline int cellCoord(Real x) const {
+        return clamp<int>(floor(x/domainRes*res), 0, res-1);
+    }
+    inline int cellIndex(int i, int j, int k) const {
+        return (i*res + j)*res + k;
+    }
+    inline int cellIndex(const Vec3& pos) const {
+        return cellIndex(cellCoord(pos.x), cellCoord(pos.y), cellCoord(pos.z));
     }
 
-    void fillWith(const ParticleDataImpl<Vec3>& particles){
-        // clear
-        for(int i=0; i<res; i++) {
-        for(int j=0; j<res; j++) {
-        for(int k=0; k<res; k++) {
-            indices[i][j][k].clear();
-        }}}
+    void fillWith(const BasicParticleSystem& particles);
+    void fillWith(const ParticleDataImpl<Vec3>& particles);
+    void sortParticles();
+};
 
-        // fill
-        for(int id=0;id<particles.size();id++) {
-            Vec3 pos = particles[id];
-            int i = clamp<int>(floor(pos.x/params.res*res), 0, res-1);
-            int j = clamp<int>(floor(pos.y/params.res*res), 0, res-1);
-            int k = clamp<int>(floor(pos.z/params.res*res), 0, res-1);
-            indices[i][j][k].push_back(id);
-        }
+ struct computeParticleCells : public KernelBase { computeParticleCells( const BasicParticleSystem& particles, const ParticleAccelGrid& accel, vector<int>& particleCell ) :  KernelBase(particles.size()) ,particles(particles),accel(accel),particleCell(particleCell)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystem& particles, const ParticleAccelGrid& accel, vector<int>& particleCell  ) const {
+    particleCell[idx] = accel.cellIndex(particles.getPos(idx));
+}    inline const BasicParticleSystem& getArg0() { return particles; } typedef BasicParticleSystem type0;inline const ParticleAccelGrid& getArg1() { return accel; } typedef ParticleAccelGrid type1;inline vector<int>& getArg2() { return particleCell; } typedef vector<int> type2; void runMessage() { debMsg("Executing kernel computeParticleCells ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, particles,accel,particleCell);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystem& particles; const ParticleAccelGrid& accel; vector<int>& particleCell;   };
+#line 109 "plugin/surfaceturbulence.cpp"
+
+
+
+ struct computePositionCells : public KernelBase { computePositionCells( const ParticleDataImpl<Vec3>& particles, const ParticleAccelGrid& accel, vector<int>& particleCell ) :  KernelBase(particles.size()) ,particles(particles),accel(accel),particleCell(particleCell)   { runMessage(); run(); }   inline void op(IndexInt idx,  const ParticleDataImpl<Vec3>& particles, const ParticleAccelGrid& accel, vector<int>& particleCell  ) const {
+    particleCell[idx] = accel.cellIndex(particles[idx]);
+}    inline const ParticleDataImpl<Vec3>& getArg0() { return particles; } typedef ParticleDataImpl<Vec3> type0;inline const ParticleAccelGrid& getArg1() { return accel; } typedef ParticleAccelGrid type1;inline vector<int>& getArg2() { return particleCell; } typedef vector<int> type2; void runMessage() { debMsg("Executing kernel computePositionCells ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, particles,accel,particleCell);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const ParticleDataImpl<Vec3>& particles; const ParticleAccelGrid& accel; vector<int>& particleCell;   };
+#line 116 "plugin/surfaceturbulence.cpp"
+
+
+
+ struct scatterParticleIndices : public KernelBase { scatterParticleIndices( const vector<int>& particleCell, const vector<int>& particleRank, const vector<int>& cellStart, vector<int>& indices ) :  KernelBase(particleCell.size()) ,particleCell(particleCell),particleRank(particleRank),cellStart(cellStart),indices(indices)   { runMessage(); run(); }   inline void op(IndexInt idx,  const vector<int>& particleCell, const vector<int>& particleRank, const vector<int>& cellStart, vector<int>& indices  ) const {
+    indices[cellStart[particleCell[idx]] + particleRank[idx]] = idx;
+}    inline const vector<int>& getArg0() { return particleCell; } typedef vector<int> type0;inline const vector<int>& getArg1() { return particleRank; } typedef vector<int> type1;inline const vector<int>& getArg2() { return cellStart; } typedef vector<int> type2;inline vector<int>& getArg3() { return indices; } typedef vector<int> type3; void runMessage() { debMsg("Executing kernel scatterParticleIndices ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, particleCell,particleRank,cellStart,indices);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const vector<int>& particleCell; const vector<int>& particleRank; const vector<int>& cellStart; vector<int>& indices;   };
+#line 123 "plugin/surfaceturbulence.cpp"
+
+
+void ParticleAccelGrid::fillWith(const BasicParticleSystem& particles) {
+    particleCell.resize(particles.size());
+    computeParticleCells(particles, *this, particleCell);
+    sortParticles();
+}
+
+void ParticleAccelGrid::fillWith(const ParticleDataImpl<Vec3>& particles) {
+    particleCell.resize(particles.size());
+    computePositionCells(particles, *this, particleCell);
+    sortParticles();
+}
+
+// counting sort of the particles by cell, the buffers are kept between fills
+void ParticleAccelGrid::sortParticles() {
+    const int numCells = res*res*res;
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    particleRank.resize(particleCell.size());
+    for(int id=0; id<(int)particleCell.size(); id++) {
+        particleRank[id] = cellStart[particleCell[id]+1]++;
     }
-};
+    for(int c=0; c<numCells; c++) {
+        cellStart[c+1] += cellStart[c];
+    }
+    indices.resize(particleCell.size());
+    scatterParticleIndices(particleCell, particleRank, cellStart, indices);
+}
 
 #define LOOP_NEIGHBORS_BEGIN(points, center, radius) \
-    int minI = clamp<int>(floor((center.x-radius)/params.res*points.accel->res), 0, points.accel->res-1); \
-    int maxI = clamp<int>(floor((center.x+radius)/params.res*points.accel->res), 0, points.accel->res-1); \
-    int minJ = clamp<int>(floor((center.y-radius)/params.res*points.accel->res), 0, points.accel->res-1); \
-    int maxJ = clamp<int>(floor((center.y+radius)/params.res*points.accel->res), 0, points.accel->res-1); \
-    int minK = clamp<int>(floor((center.z-radius)/params.res*points.accel->res), 0, points.accel->res-1); \
-    int maxK = clamp<int>(floor((center.z+radius)/params.res*points.accel->res), 0, points.accel->res-1); \
+    int minI = points.accel->cellCoord(center.x-radius); \
+    int maxI = points.accel->cellCoord(center.x+radius); \
+    int minJ = points.accel->cellCoord(center.y-radius); \
+    int maxJ = points.accel->cellCoord(center.y+radius); \
+    int minK = points.accel->cellCoord(center.z-radius); \
+    int maxK = points.accel->cellCoord(center.z+radius); \
     for(int i=minI; i<=maxI; i++) { \
     for(int j=minJ; j<=maxJ; j++) { \
     for(int k=minK; k<=maxK; k++) { \
-        for(int idLOOPNEIGHBORS=0;idLOOPNEIGHBORS<(int)points.accel->indices[i][j][k].size();idLOOPNEIGHBORS++) { \
-            int idn = points.accel->indices[i][j][k][idLOOPNEIGHBORS]; \
+        const int cellLOOPNEIGHBORS = points.accel->cellIndex(i,j,k); \
+        for(int idLOOPNEIGHBORS=points.accel->cellStart[cellLOOPNEIGHBORS];idLOOPNEIGHBORS<points.accel->cellStart[cellLOOPNEIGHBORS+1];idLOOPNEIGHBORS++) { \
+            int idn = points.accel->indices[idLOOPNEIGHBORS]; \
             if(points.isActive(idn)) {
 #define LOOP_NEIGHBORS_END \
             } \
@@ -210,49 +235,45 @@ struct BasicParticleSystemWrapper : PointSetWrapper {
     void kill(int id) {points->kill(id);}
 
     bool hasNeighbor(Vec3 pos, Real radius) const {
-        bool answer = false;
-        int minI = clamp<int>(floor((pos.x-radius)/params.res*accel->res), 0, accel->res-1);
-        int maxI = clamp<int>(floor((pos.x+radius)/params.res*accel->res), 0, accel->res-1);
-        int minJ = clamp<int>(floor((pos.y-radius)/params.res*accel->res), 0, accel->res-1);
-        int maxJ = clamp<int>(floor((pos.y+radius)/params.res*accel->res), 0, accel->res-1);
-        int minK = clamp<int>(floor((pos.z-radius)/params.res*accel->res), 0, accel->res-1);
-        int maxK = clamp<int>(floor((pos.z+radius)/params.res*accel->res), 0, accel->res-1);
+        int minI = accel->cellCoord(pos.x-radius);
+        int maxI = accel->cellCoord(pos.x+radius);
+        int minJ = accel->cellCoord(pos.y-radius);
+        int maxJ = accel->cellCoord(pos.y+radius);
+        int minK = accel->cellCoord(pos.z-radius);
+        int maxK = accel->cellCoord(pos.z+radius);
         for(int i=minI; i<=maxI; i++) {
         for(int j=minJ; j<=maxJ; j++) {
         for(int k=minK; k<=maxK; k++) {
-            for(int id=0;id<(int)accel->indices[i][j][k].size();id++) {
-                if(points->isActive(accel->indices[i][j][k][id]) &&
-                   norm(points->getPos(accel->indices[i][j][k][id]) - pos) <= radius
-                ) {answer = true; break;}
+            const int cell = accel->cellIndex(i,j,k);
+            for(int id=accel->cellStart[cell];id<accel->cellStart[cell+1];id++) {
+                if(points->isActive(accel->indices[id]) &&
+                   norm(points->getPos(accel->indices[id]) - pos) <= radius
+                ) {return true;}
             }
-        if(answer)break;}
-        if(answer)break;}
-        if(answer)break;}
-        return answer;
+        }}}
+        return false;
     }
 
     bool hasNeighborOtherThanItself(int idx, Real radius) const {
-        bool answer = false;
         Vec3 pos = points->getPos(idx);
-        int minI = clamp<int>(floor((pos.x-radius)/params.res*accel->res), 0, accel->res-1);
-        int maxI = clamp<int>(floor((pos.x+radius)/params.res*accel->res), 0, accel->res-1);
-        int minJ = clamp<int>(floor((pos.y-radius)/params.res*accel->res), 0, accel->res-1);
-        int maxJ = clamp<int>(floor((pos.y+radius)/params.res*accel->res), 0, accel->res-1);
-        int minK = clamp<int>(floor((pos.z-radius)/params.res*accel->res), 0, accel->res-1);
-        int maxK = clamp<int>(floor((pos.z+radius)/params.res*accel->res), 0, accel->res-1);
+        int minI = accel->cellCoord(pos.x-radius);
+        int maxI = accel->cellCoord(pos.x+radius);
+        int minJ = accel->cellCoord(pos.y-radius);
+        int maxJ = accel->cellCoord(pos.y+radius);
+        int minK = accel->cellCoord(pos.z-radius);
+        int maxK = accel->cellCoord(pos.z+radius);
         for(int i=minI; i<=maxI; i++) {
         for(int j=minJ; j<=maxJ; j++) {
         for(int k=minK; k<=maxK; k++) {
-            for(int id=0;id<(int)accel->indices[i][j][k].size();id++) {
-                if(accel->indices[i][j][k][id] != idx &&
-                   points->isActive(accel->indices[i][j][k][id]) &&
-                   norm(points->getPos(accel->indices[i][j][k][id]) - pos) <= radius
-                ) {answer = true; break;}
+            const int cell = accel->cellIndex(i,j,k);
+            for(int id=accel->cellStart[cell];id<accel->cellStart[cell+1];id++) {
+                if(accel->indices[id] != idx &&
+                   points->isActive(accel->indices[id]) &&
+                   norm(points->getPos(accel->indices[id]) - pos) <= radius
+                ) {return true;}
             }
-        if(answer)break;}
-        if(answer)break;}
-        if(answer)break;}
-        return answer;
+        }}}
+        return false;
     }
     
     void removeInvalidIndices(vector<int>& indices) {
@@ -284,14 +305,25 @@ struct ParticleDataImplVec3Wrapper : PointSetWrapper {
 
 
 //
-// **** globals ****
+// **** per solver state ****
 //
-ParticleAccelGrid accelCoarse, accelSurface;
-BasicParticleSystemWrapper coarseParticles(&accelCoarse), surfacePoints(&accelSurface);
-ParticleDataImplVec3Wrapper coarseParticlesPrevPos(&accelCoarse); // WARNING: reusing the coarse accel grid to save space, don't query coarseParticlesPrevPos and coarseParticles at the same time.
-vector<Vec3> tempSurfaceVec3; // to store misc info on surface points
-vector<Real> tempSurfaceFloat; // to store misc info on surface points
-int frameCount = 0;
+struct SurfaceTurbulenceContext {
+    SurfaceTurbulenceParameters params;
+    ParticleAccelGrid accelCoarse, accelSurface;
+    BasicParticleSystemWrapper coarseParticles, surfacePoints;
+    ParticleDataImplVec3Wrapper coarseParticlesPrevPos; // WARNING: reusing the coarse accel grid to save space, don't query coarseParticlesPrevPos and coarseParticles at the same time.
+    vector<Vec3> tempSurfaceVec3; // to store misc info on surface points
+    vector<Real> tempSurfaceFloat; // to store misc info on surface points
+    int frameCount;
+
+    SurfaceTurbulenceContext() :
+        coarseParticles(&accelCoarse), surfacePoints(&accelSurface),
+        coarseParticlesPrevPos(&accelCoarse), frameCount(0) {}
+};
+
+// keep one surface turbulence state per fluid solver, so that multiple domains
+// don't share surface points or neighbor grids; release it with releaseSurfaceTurbulence
+static std::map<FluidSolver*, SurfaceTurbulenceContext*> gMapContexts;
 
 
 
@@ -308,7 +340,7 @@ Real exponentialWeight(Real distance, Real radius, Real falloff) {
     return expf(-falloff*tmp*tmp);
 }
 
-Real weightKernelAdvection(Real distance) {
+Real weightKernelAdvection(Real distance, const SurfaceTurbulenceParameters& params) {
     if(distance > 2.f*params.outerRadius) {
         return 0;
     } else {
@@ -316,11 +348,11 @@ Real weightKernelAdvection(Real distance) {
     }
 }
 
-Real weightKernelCoarseDensity(Real distance) {
+Real weightKernelCoarseDensity(Real distance, const SurfaceTurbulenceParameters& params) {
     return exponentialWeight(distance, params.outerRadius, 2.0f);
 }
 
-Real weightSurfaceNormal(Real distance) {
+Real weightSurfaceNormal(Real distance, const SurfaceTurbulenceParameters& params) {
     if(distance > params.normalRadius) {
         return 0;
     } else {
@@ -328,7 +360,7 @@ Real weightSurfaceNormal(Real distance) {
     }
 }
 
-Real weightSurfaceTangent(Real distance) {
+Real weightSurfaceTangent(Real distance, const SurfaceTurbulenceParameters& params) {
     if(distance > params.tangentRadius) {
         return 0;
     } else {
@@ -341,7 +373,7 @@ Real weightSurfaceTangent(Real distance) {
 // **** utility ****
 //
 
-bool isInDomain(Vec3 pos)
+bool isInDomain(Vec3 pos, const SurfaceTurbulenceParameters& params)
 {
     return params.bndXm <= pos.x && pos.x <= params.bndXp &&
            params.bndYm <= pos.y && pos.y <= params.bndYp &&
@@ -359,10 +391,13 @@ Real smoothstep( Real edgeLeft, Real edgeRight, Real val ){
 //
 
 void initFines(
-    const BasicParticleSystemWrapper& coarseParticles,
-    BasicParticleSystemWrapper& surfacePoints,
+    SurfaceTurbulenceContext& ctx,
     const FlagGrid& flags
 ){
+    const SurfaceTurbulenceParameters& params = ctx.params;
+    const BasicParticleSystemWrapper& coarseParticles = ctx.coarseParticles;
+    BasicParticleSystemWrapper& surfacePoints = ctx.surfacePoints;
+
     unsigned int discretization = (unsigned int) M_PI*(params.outerRadius+params.innerRadius)/params.meanFineDistance;
     Real dtheta = 2*params.meanFineDistance/(params.outerRadius+params.innerRadius);
     Real outerRadius2 = params.outerRadius*params.outerRadius;
@@ -422,7 +457,7 @@ void initFines(
 
 
 
- struct advectSurfacePoints : public KernelBase { advectSurfacePoints( BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, const ParticleDataImplVec3Wrapper& coarseParticlesPrevPos ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),coarseParticles(coarseParticles),coarseParticlesPrevPos(coarseParticlesPrevPos)   { runMessage(); run(); }   inline void op(IndexInt idx,  BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, const ParticleDataImplVec3Wrapper& coarseParticlesPrevPos  ) const {
+ struct advectSurfacePoints : public KernelBase { advectSurfacePoints( BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, const ParticleDataImplVec3Wrapper& coarseParticlesPrevPos, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),coarseParticles(coarseParticles),coarseParticlesPrevPos(coarseParticlesPrevPos),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, const ParticleDataImplVec3Wrapper& coarseParticlesPrevPos, const SurfaceTurbulenceParameters& params  ) const {
     if(surfacePoints.isActive(idx)) {
         Vec3 avgDisplacement(0,0,0);
         Real totalWeight = 0;
@@ -433,7 +468,7 @@ void initFines(
             {
                 Vec3 disp = coarseParticles.getPos(idn) - coarseParticlesPrevPos.getVec3(idn);
                 Real distance = norm(coarseParticlesPrevPos.getVec3(idn) - p);
-                Real w = weightKernelAdvection(distance);
+                Real w = weightKernelAdvection(distance, params);
                 avgDisplacement += w * disp;
                 totalWeight += w;
             }
@@ -441,7 +476,7 @@ void initFines(
         if(totalWeight != 0) avgDisplacement /= totalWeight;
         surfacePoints.setPos(idx, p + avgDisplacement);
     }
-}    inline BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const BasicParticleSystemWrapper& getArg1() { return coarseParticles; } typedef BasicParticleSystemWrapper type1;inline const ParticleDataImplVec3Wrapper& getArg2() { return coarseParticlesPrevPos; } typedef ParticleDataImplVec3Wrapper type2; void runMessage() { debMsg("Executing kernel advectSurfacePoints ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,coarseParticles,coarseParticlesPrevPos);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  BasicParticleSystemWrapper& surfacePoints; const BasicParticleSystemWrapper& coarseParticles; const ParticleDataImplVec3Wrapper& coarseParticlesPrevPos;   };
+}    inline BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const BasicParticleSystemWrapper& getArg1() { return coarseParticles; } typedef BasicParticleSystemWrapper type1;inline const ParticleDataImplVec3Wrapper& getArg2() { return coarseParticlesPrevPos; } typedef ParticleDataImplVec3Wrapper type2;inline const SurfaceTurbulenceParameters& getArg3() { return params; } typedef SurfaceTurbulenceParameters type3; void runMessage() { debMsg("Executing kernel advectSurfacePoints ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,coarseParticles,coarseParticlesPrevPos,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  BasicParticleSystemWrapper& surfacePoints; const BasicParticleSystemWrapper& coarseParticles; const ParticleDataImplVec3Wrapper& coarseParticlesPrevPos; const SurfaceTurbulenceParameters& params;   };
 
 
 //
@@ -449,7 +484,8 @@ void initFines(
 //
 Real computeConstraintLevel(
         const BasicParticleSystemWrapper& coarseParticles,
-        Vec3 pos
+        Vec3 pos,
+        const SurfaceTurbulenceParameters& params
 ){
     Real lvl = 0.0f;
     LOOP_NEIGHBORS_BEGIN(coarseParticles, pos, 1.5f*params.outerRadius)
@@ -462,7 +498,8 @@ Real computeConstraintLevel(
 
 Vec3 computeConstraintGradient(
         const BasicParticleSystemWrapper& coarseParticles,
-        Vec3 pos
+        Vec3 pos,
+        const SurfaceTurbulenceParameters& params
 ){
     Vec3 gradient(0,0,0);
     LOOP_NEIGHBORS_BEGIN(coarseParticles, pos, 1.5f*params.outerRadius)
@@ -481,11 +518,11 @@ Vec3 computeConstraintGradient(
 
 
 
- struct computeSurfaceNormals : public KernelBase { computeSurfaceNormals( const BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, ParticleDataImpl<Vec3>& surfaceNormals ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),coarseParticles(coarseParticles),surfaceNormals(surfaceNormals)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, ParticleDataImpl<Vec3>& surfaceNormals  ) const {
+ struct computeSurfaceNormals : public KernelBase { computeSurfaceNormals( const BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, ParticleDataImpl<Vec3>& surfaceNormals, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),coarseParticles(coarseParticles),surfaceNormals(surfaceNormals),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, ParticleDataImpl<Vec3>& surfaceNormals, const SurfaceTurbulenceParameters& params  ) const {
         Vec3 pos = surfacePoints.getPos(idx);
 
         // approx normal with gradient
-        Vec3 gradient = computeConstraintGradient(coarseParticles, pos);
+        Vec3 gradient = computeConstraintGradient(coarseParticles, pos, params);
 
         // get tangent frame
         Vec3 n = getNormalized(gradient);
@@ -503,7 +540,7 @@ Vec3 computeConstraintGradient(
                  Real x = dot(gPos - pos, t1);
                  Real y = dot(gPos - pos, t2);
                  Real z = dot(gPos - pos, n);
-                 Real w = weightSurfaceNormal(norm(pos - gPos));
+                 Real w = weightSurfaceNormal(norm(pos - gPos), params);
                  swx2 += w*x*x;
                  swy2 += w*y*y;
                  swxy += w*x*y;
@@ -527,7 +564,7 @@ Vec3 computeConstraintGradient(
             if(dot(gradient, normal) < 0) {normal = -normal;}
             surfaceNormals[idx] = normal;
         }
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const BasicParticleSystemWrapper& getArg1() { return coarseParticles; } typedef BasicParticleSystemWrapper type1;inline ParticleDataImpl<Vec3>& getArg2() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type2; void runMessage() { debMsg("Executing kernel computeSurfaceNormals ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,coarseParticles,surfaceNormals);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const BasicParticleSystemWrapper& coarseParticles; ParticleDataImpl<Vec3>& surfaceNormals;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const BasicParticleSystemWrapper& getArg1() { return coarseParticles; } typedef BasicParticleSystemWrapper type1;inline ParticleDataImpl<Vec3>& getArg2() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type2;inline const SurfaceTurbulenceParameters& getArg3() { return params; } typedef SurfaceTurbulenceParameters type3; void runMessage() { debMsg("Executing kernel computeSurfaceNormals ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,coarseParticles,surfaceNormals,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const BasicParticleSystemWrapper& coarseParticles; ParticleDataImpl<Vec3>& surfaceNormals; const SurfaceTurbulenceParameters& params;   };
 
 
 //
@@ -538,32 +575,32 @@ Vec3 computeConstraintGradient(
 
 
 
- struct computeAveragedNormals : public KernelBase { computeAveragedNormals( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals  ) const {
+ struct computeAveragedNormals : public KernelBase { computeAveragedNormals( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, vector<Vec3>& tempSurfaceVec3, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals),tempSurfaceVec3(tempSurfaceVec3),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, vector<Vec3>& tempSurfaceVec3, const SurfaceTurbulenceParameters& params  ) const {
     Vec3 pos = surfacePoints.getPos(idx);
     Vec3 newNormal = Vec3(0,0,0);
     LOOP_NEIGHBORS_BEGIN(surfacePoints, pos, params.normalRadius)
-        Real w = weightSurfaceNormal(norm(pos - surfacePoints.getPos(idn)));
+        Real w = weightSurfaceNormal(norm(pos - surfacePoints.getPos(idn)), params);
         newNormal += w * surfaceNormals[idn];
     LOOP_NEIGHBORS_END
     tempSurfaceVec3[idx] = getNormalized(newNormal);
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1; void runMessage() { debMsg("Executing kernel computeAveragedNormals ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1;inline vector<Vec3>& getArg2() { return tempSurfaceVec3; } typedef vector<Vec3> type2;inline const SurfaceTurbulenceParameters& getArg3() { return params; } typedef SurfaceTurbulenceParameters type3; void runMessage() { debMsg("Executing kernel computeAveragedNormals ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals,tempSurfaceVec3,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals; vector<Vec3>& tempSurfaceVec3; const SurfaceTurbulenceParameters& params;   };
 
 
 
 
 
- struct assignNormals : public KernelBase { assignNormals( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Vec3>& surfaceNormals ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Vec3>& surfaceNormals  ) const {
+ struct assignNormals : public KernelBase { assignNormals( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Vec3>& surfaceNormals, const vector<Vec3>& tempSurfaceVec3 ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals),tempSurfaceVec3(tempSurfaceVec3)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Vec3>& surfaceNormals, const vector<Vec3>& tempSurfaceVec3  ) const {
     surfaceNormals[idx] = tempSurfaceVec3[idx];
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1; void runMessage() { debMsg("Executing kernel assignNormals ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Vec3>& surfaceNormals;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1;inline const vector<Vec3>& getArg2() { return tempSurfaceVec3; } typedef vector<Vec3> type2; void runMessage() { debMsg("Executing kernel assignNormals ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals,tempSurfaceVec3);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Vec3>& surfaceNormals; const vector<Vec3>& tempSurfaceVec3;   };
 
 void smoothSurfaceNormals(
-        const BasicParticleSystemWrapper& surfacePoints,
+        SurfaceTurbulenceContext& ctx,
         ParticleDataImpl<Vec3>& surfaceNormals
 ){
-    tempSurfaceVec3.resize(surfacePoints.size());
+    ctx.tempSurfaceVec3.resize(ctx.surfacePoints.size());
     
-    computeAveragedNormals(surfacePoints, surfaceNormals);
-    assignNormals(surfacePoints, surfaceNormals);
+    computeAveragedNormals(ctx.surfacePoints, surfaceNormals, ctx.tempSurfaceVec3, ctx.params);
+    assignNormals(ctx.surfacePoints, surfaceNormals, ctx.tempSurfaceVec3);
 }
 
 
@@ -573,14 +610,18 @@ void smoothSurfaceNormals(
 //
 
 void addDeleteSurfacePoints(
-        BasicParticleSystemWrapper& surfacePoints
+        SurfaceTurbulenceContext& ctx
 ){
+    const SurfaceTurbulenceParameters& params = ctx.params;
+    const BasicParticleSystemWrapper& coarseParticles = ctx.coarseParticles;
+    BasicParticleSystemWrapper& surfacePoints = ctx.surfacePoints;
+
     int fixedSize = surfacePoints.size();
     for (int idx=0; idx<fixedSize; idx++) {
         // compute proxy tangent displacement
         Vec3 pos = surfacePoints.getPos(idx);
 
-        Vec3 gradient = computeConstraintGradient(coarseParticles, pos);
+        Vec3 gradient = computeConstraintGradient(coarseParticles, pos, params);
 
         Real wt = 0;
         Vec3 tangentDisplacement(0,0,0);
@@ -594,7 +635,7 @@ void addDeleteSurfacePoints(
                 Vec3 dn = dot(dir, gradient)*gradient;
                 Vec3 dt = dir - dn;
     
-                Real w = weightSurfaceTangent(length);
+                Real w = weightSurfaceTangent(length, params);
                 wt += w;
                 tangentDisplacement += w * dt;
             }
@@ -604,7 +645,7 @@ void addDeleteSurfacePoints(
         // check density criterion, add surface point if necessary
         Vec3 creationPos = pos + params.meanFineDistance*tangentDisplacement;
         if(
-            isInDomain(creationPos) &&
+            isInDomain(creationPos, params) &&
             !surfacePoints.hasNeighbor(creationPos, params.meanFineDistance-(1e-6))
         ) {
             //create point
@@ -622,7 +663,7 @@ void addDeleteSurfacePoints(
     fixedSize = surfacePoints.size();
     for (int idx=0; idx<fixedSize; idx++) {
         if(
-            !isInDomain(surfacePoints.getPos(idx)) ||
+            !isInDomain(surfacePoints.getPos(idx), params) ||
             surfacePoints.hasNeighborOtherThanItself(idx, 0.67*params.meanFineDistance)
         ) {
             surfacePoints.kill(idx);
@@ -641,7 +682,7 @@ void addDeleteSurfacePoints(
     // delete surface point if too far from constraint
     fixedSize = surfacePoints.size();
     for (int idx=0; idx<fixedSize; idx++) {
-        Real level = computeConstraintLevel(coarseParticles, surfacePoints.getPos(idx));
+        Real level = computeConstraintLevel(coarseParticles, surfacePoints.getPos(idx), params);
         if(level < -0.2 || level > 1.2) {
             surfacePoints.kill(idx);
         }
@@ -661,22 +702,22 @@ void addDeleteSurfacePoints(
 
 
 
- struct computeSurfaceDensities : public KernelBase { computeSurfaceDensities( const BasicParticleSystemWrapper& surfacePoints, void* dummy ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),dummy(dummy)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, void* dummy  ) const {
+ struct computeSurfaceDensities : public KernelBase { computeSurfaceDensities( const BasicParticleSystemWrapper& surfacePoints, vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),tempSurfaceFloat(tempSurfaceFloat),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params  ) const {
     Vec3 pos = surfacePoints.getPos(idx);
     Real density = 0;
     LOOP_NEIGHBORS_BEGIN(surfacePoints, pos, params.normalRadius)
         LOOP_GHOSTS_POS_BEGIN(surfacePoints.getPos(idn), params.normalRadius)
-            density += weightSurfaceNormal(norm(pos-gPos));
+            density += weightSurfaceNormal(norm(pos-gPos), params);
         LOOP_GHOSTS_END
     LOOP_NEIGHBORS_END
     tempSurfaceFloat[idx] = density;
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline void* getArg1() { return dummy; } typedef void type1; void runMessage() { debMsg("Executing kernel computeSurfaceDensities ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,dummy);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; void* dummy;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline vector<Real>& getArg1() { return tempSurfaceFloat; } typedef vector<Real> type1;inline const SurfaceTurbulenceParameters& getArg2() { return params; } typedef SurfaceTurbulenceParameters type2; void runMessage() { debMsg("Executing kernel computeSurfaceDensities ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,tempSurfaceFloat,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; vector<Real>& tempSurfaceFloat; const SurfaceTurbulenceParameters& params;   };
 
 
 
 
 
- struct computeSurfaceDisplacements : public KernelBase { computeSurfaceDisplacements( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals  ) const {
+ struct computeSurfaceDisplacements : public KernelBase { computeSurfaceDisplacements( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, vector<Vec3>& tempSurfaceVec3, const vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals),tempSurfaceVec3(tempSurfaceVec3),tempSurfaceFloat(tempSurfaceFloat),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, vector<Vec3>& tempSurfaceVec3, const vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params  ) const {
     Vec3 pos = surfacePoints.getPos(idx);
     Vec3 normal = surfaceNormals[idx];
     
@@ -691,7 +732,7 @@ void addDeleteSurfacePoints(
             Vec3 dn = dot(dir,surfaceNormals[idx])*surfaceNormals[idx];
             Vec3 dt = dir - dn;
             if(tempSurfaceFloat[idn]==0) {continue;}
-            Real w = weightSurfaceNormal( length ) / tempSurfaceFloat[idn];
+            Real w = weightSurfaceNormal( length , params) / tempSurfaceFloat[idn];
             
             Vec3 crossVec = getNormalized(cross(normal, -dir));
             Vec3 projectedNormal = getNormalized(gNormal - dot(crossVec,gNormal)*crossVec);
@@ -711,27 +752,27 @@ void addDeleteSurfacePoints(
     displacementNormal  *= .75f;
     displacementTangent *= .25f * params.meanFineDistance;
     tempSurfaceVec3[idx] = displacementNormal + displacementTangent;
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1; void runMessage() { debMsg("Executing kernel computeSurfaceDisplacements ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1;inline vector<Vec3>& getArg2() { return tempSurfaceVec3; } typedef vector<Vec3> type2;inline const vector<Real>& getArg3() { return tempSurfaceFloat; } typedef vector<Real> type3;inline const SurfaceTurbulenceParameters& getArg4() { return params; } typedef SurfaceTurbulenceParameters type4; void runMessage() { debMsg("Executing kernel computeSurfaceDisplacements ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals,tempSurfaceVec3,tempSurfaceFloat,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals; vector<Vec3>& tempSurfaceVec3; const vector<Real>& tempSurfaceFloat; const SurfaceTurbulenceParameters& params;   };
 
 
 
 
 
- struct applySurfaceDisplacements : public KernelBase { applySurfaceDisplacements( BasicParticleSystemWrapper& surfacePoints, void* dummy ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),dummy(dummy)   { runMessage(); run(); }   inline void op(IndexInt idx,  BasicParticleSystemWrapper& surfacePoints, void* dummy  ) const {
+ struct applySurfaceDisplacements : public KernelBase { applySurfaceDisplacements( BasicParticleSystemWrapper& surfacePoints, const vector<Vec3>& tempSurfaceVec3 ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),tempSurfaceVec3(tempSurfaceVec3)   { runMessage(); run(); }   inline void op(IndexInt idx,  BasicParticleSystemWrapper& surfacePoints, const vector<Vec3>& tempSurfaceVec3  ) const {
     surfacePoints.setPos(idx, surfacePoints.getPos(idx) + tempSurfaceVec3[idx]);
-}    inline BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline void* getArg1() { return dummy; } typedef void type1; void runMessage() { debMsg("Executing kernel applySurfaceDisplacements ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,dummy);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  BasicParticleSystemWrapper& surfacePoints; void* dummy;   };
+}    inline BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const vector<Vec3>& getArg1() { return tempSurfaceVec3; } typedef vector<Vec3> type1; void runMessage() { debMsg("Executing kernel applySurfaceDisplacements ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,tempSurfaceVec3);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  BasicParticleSystemWrapper& surfacePoints; const vector<Vec3>& tempSurfaceVec3;   };
 
 
 void regularizeSurfacePoints(
-        BasicParticleSystemWrapper& surfacePoints,
+        SurfaceTurbulenceContext& ctx,
         const ParticleDataImpl<Vec3>& surfaceNormals
 ){
-    tempSurfaceVec3.resize(surfacePoints.size());
-    tempSurfaceFloat.resize(surfacePoints.size()); 
+    ctx.tempSurfaceVec3.resize(ctx.surfacePoints.size());
+    ctx.tempSurfaceFloat.resize(ctx.surfacePoints.size()); 
     
-    computeSurfaceDensities(surfacePoints, 0);
-    computeSurfaceDisplacements(surfacePoints, surfaceNormals);
-    applySurfaceDisplacements(surfacePoints, 0);
+    computeSurfaceDensities(ctx.surfacePoints, ctx.tempSurfaceFloat, ctx.params);
+    computeSurfaceDisplacements(ctx.surfacePoints, surfaceNormals, ctx.tempSurfaceVec3, ctx.tempSurfaceFloat, ctx.params);
+    applySurfaceDisplacements(ctx.surfacePoints, ctx.tempSurfaceVec3);
 }
 
 
@@ -739,15 +780,15 @@ void regularizeSurfacePoints(
 
 
 
- struct constrainSurface : public KernelBase { constrainSurface( BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),coarseParticles(coarseParticles)   { runMessage(); run(); }   inline void op(IndexInt idx,  BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles  ) const {
+ struct constrainSurface : public KernelBase { constrainSurface( BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),coarseParticles(coarseParticles),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  BasicParticleSystemWrapper& surfacePoints, const BasicParticleSystemWrapper& coarseParticles, const SurfaceTurbulenceParameters& params  ) const {
         Vec3 pos = surfacePoints.getPos(idx);
-        Real level = computeConstraintLevel(coarseParticles, surfacePoints.getPos(idx));
+        Real level = computeConstraintLevel(coarseParticles, surfacePoints.getPos(idx), params);
         if(level > 1) {
-            surfacePoints.setPos(idx, pos - (params.outerRadius-params.innerRadius)*(level-1)*computeConstraintGradient(coarseParticles, surfacePoints.getPos(idx)));
+            surfacePoints.setPos(idx, pos - (params.outerRadius-params.innerRadius)*(level-1)*computeConstraintGradient(coarseParticles, surfacePoints.getPos(idx), params));
         }else if(level < 0) {
-            surfacePoints.setPos(idx, pos - (params.outerRadius-params.innerRadius)*  level  *computeConstraintGradient(coarseParticles, surfacePoints.getPos(idx)));
+            surfacePoints.setPos(idx, pos - (params.outerRadius-params.innerRadius)*  level  *computeConstraintGradient(coarseParticles, surfacePoints.getPos(idx), params));
         }
-}    inline BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const BasicParticleSystemWrapper& getArg1() { return coarseParticles; } typedef BasicParticleSystemWrapper type1; void runMessage() { debMsg("Executing kernel constrainSurface ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,coarseParticles);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  BasicParticleSystemWrapper& surfacePoints; const BasicParticleSystemWrapper& coarseParticles;   };
+}    inline BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const BasicParticleSystemWrapper& getArg1() { return coarseParticles; } typedef BasicParticleSystemWrapper type1;inline const SurfaceTurbulenceParameters& getArg2() { return params; } typedef SurfaceTurbulenceParameters type2; void runMessage() { debMsg("Executing kernel constrainSurface ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,coarseParticles,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  BasicParticleSystemWrapper& surfacePoints; const BasicParticleSystemWrapper& coarseParticles; const SurfaceTurbulenceParameters& params;   };
 
 
 
@@ -757,7 +798,7 @@ void regularizeSurfacePoints(
 
 
 
- struct interpolateNewWaveData : public KernelBase { interpolateNewWaveData( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveH, ParticleDataImpl<Real>& surfaceWaveDtH, ParticleDataImpl<Real>& surfaceWaveSeed, ParticleDataImpl<Real>& surfaceWaveSeedAmplitude ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceWaveH(surfaceWaveH),surfaceWaveDtH(surfaceWaveDtH),surfaceWaveSeed(surfaceWaveSeed),surfaceWaveSeedAmplitude(surfaceWaveSeedAmplitude)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveH, ParticleDataImpl<Real>& surfaceWaveDtH, ParticleDataImpl<Real>& surfaceWaveSeed, ParticleDataImpl<Real>& surfaceWaveSeedAmplitude  ) const {
+ struct interpolateNewWaveData : public KernelBase { interpolateNewWaveData( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveH, ParticleDataImpl<Real>& surfaceWaveDtH, ParticleDataImpl<Real>& surfaceWaveSeed, ParticleDataImpl<Real>& surfaceWaveSeedAmplitude, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceWaveH(surfaceWaveH),surfaceWaveDtH(surfaceWaveDtH),surfaceWaveSeed(surfaceWaveSeed),surfaceWaveSeedAmplitude(surfaceWaveSeedAmplitude),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveH, ParticleDataImpl<Real>& surfaceWaveDtH, ParticleDataImpl<Real>& surfaceWaveSeed, ParticleDataImpl<Real>& surfaceWaveSeedAmplitude, const SurfaceTurbulenceParameters& params  ) const {
     if(surfacePoints.getStatus(idx) & ParticleBase::PNEW) {
         Vec3 pos = surfacePoints.getPos(idx);
         surfaceWaveH[idx] = 0;
@@ -765,7 +806,7 @@ void regularizeSurfacePoints(
         Real wTotal = 0;
         LOOP_NEIGHBORS_BEGIN(surfacePoints, pos, params.tangentRadius)
             if(!(surfacePoints.getStatus(idn) & ParticleBase::PNEW)) {
-                Real w = weightSurfaceTangent(norm( pos - surfacePoints.getPos(idn) ));
+                Real w = weightSurfaceTangent(norm( pos - surfacePoints.getPos(idn) ), params);
                 surfaceWaveH[idx] += w * surfaceWaveH[idn];
                 surfaceWaveDtH[idx] += w * surfaceWaveDtH[idn];
                 surfaceWaveSeed[idx] += w * surfaceWaveSeed[idn];
@@ -780,12 +821,11 @@ void regularizeSurfacePoints(
             surfaceWaveSeedAmplitude[idx] /= wTotal;
         }
     }
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Real>& getArg1() { return surfaceWaveH; } typedef ParticleDataImpl<Real> type1;inline ParticleDataImpl<Real>& getArg2() { return surfaceWaveDtH; } typedef ParticleDataImpl<Real> type2;inline ParticleDataImpl<Real>& getArg3() { return surfaceWaveSeed; } typedef ParticleDataImpl<Real> type3;inline ParticleDataImpl<Real>& getArg4() { return surfaceWaveSeedAmplitude; } typedef ParticleDataImpl<Real> type4; void runMessage() { debMsg("Executing kernel interpolateNewWaveData ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceWaveH,surfaceWaveDtH,surfaceWaveSeed,surfaceWaveSeedAmplitude);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Real>& surfaceWaveH; ParticleDataImpl<Real>& surfaceWaveDtH; ParticleDataImpl<Real>& surfaceWaveSeed; ParticleDataImpl<Real>& surfaceWaveSeedAmplitude;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Real>& getArg1() { return surfaceWaveH; } typedef ParticleDataImpl<Real> type1;inline ParticleDataImpl<Real>& getArg2() { return surfaceWaveDtH; } typedef ParticleDataImpl<Real> type2;inline ParticleDataImpl<Real>& getArg3() { return surfaceWaveSeed; } typedef ParticleDataImpl<Real> type3;inline ParticleDataImpl<Real>& getArg4() { return surfaceWaveSeedAmplitude; } typedef ParticleDataImpl<Real> type4;inline const SurfaceTurbulenceParameters& getArg5() { return params; } typedef SurfaceTurbulenceParameters type5; void runMessage() { debMsg("Executing kernel interpolateNewWaveData ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceWaveH,surfaceWaveDtH,surfaceWaveSeed,surfaceWaveSeedAmplitude,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Real>& surfaceWaveH; ParticleDataImpl<Real>& surfaceWaveDtH; ParticleDataImpl<Real>& surfaceWaveSeed; ParticleDataImpl<Real>& surfaceWaveSeedAmplitude; const SurfaceTurbulenceParameters& params;   };
 
 
 void surfaceMaintenance(
-        const BasicParticleSystemWrapper& coarseParticles,
-        BasicParticleSystemWrapper& surfacePoints,
+        SurfaceTurbulenceContext& ctx,
         ParticleDataImpl<Vec3>& surfaceNormals,
         ParticleDataImpl<Real>& surfaceWaveH,
         ParticleDataImpl<Real>& surfaceWaveDtH,
@@ -793,19 +833,22 @@ void surfaceMaintenance(
         ParticleDataImpl<Real>& surfaceWaveSeedAmplitude,
         int nbIterations
 ){
+    const BasicParticleSystemWrapper& coarseParticles = ctx.coarseParticles;
+    BasicParticleSystemWrapper& surfacePoints = ctx.surfacePoints;
+
     int countIterations = nbIterations;
     while(countIterations > 0) {
-        addDeleteSurfacePoints(surfacePoints);
+        addDeleteSurfacePoints(ctx);
         surfacePoints.updateAccel();
-        computeSurfaceNormals(surfacePoints, coarseParticles, surfaceNormals);
-        smoothSurfaceNormals(surfacePoints, surfaceNormals);
+        computeSurfaceNormals(surfacePoints, coarseParticles, surfaceNormals, ctx.params);
+        smoothSurfaceNormals(ctx, surfaceNormals);
 
-        regularizeSurfacePoints(surfacePoints, surfaceNormals);
+        regularizeSurfacePoints(ctx, surfaceNormals);
         surfacePoints.updateAccel();
-        constrainSurface(surfacePoints, coarseParticles);
+        constrainSurface(surfacePoints, coarseParticles, ctx.params);
         surfacePoints.updateAccel();
 
-        interpolateNewWaveData(surfacePoints, surfaceWaveH, surfaceWaveDtH, surfaceWaveSeed, surfaceWaveSeedAmplitude);
+        interpolateNewWaveData(surfacePoints, surfaceWaveH, surfaceWaveDtH, surfaceWaveSeed, surfaceWaveSeedAmplitude, ctx.params);
         
         countIterations--;
     }
@@ -834,7 +877,7 @@ void surfaceMaintenance(
 
 
 
- struct computeSurfaceWaveNormal : public KernelBase { computeSurfaceWaveNormal( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, const ParticleDataImpl<Real>& surfaceWaveH ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals),surfaceWaveH(surfaceWaveH)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, const ParticleDataImpl<Real>& surfaceWaveH  ) const {
+ struct computeSurfaceWaveNormal : public KernelBase { computeSurfaceWaveNormal( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, const ParticleDataImpl<Real>& surfaceWaveH, vector<Vec3>& tempSurfaceVec3, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals),surfaceWaveH(surfaceWaveH),tempSurfaceVec3(tempSurfaceVec3),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, const ParticleDataImpl<Real>& surfaceWaveH, vector<Vec3>& tempSurfaceVec3, const SurfaceTurbulenceParameters& params  ) const {
     Vec3 pos = surfacePoints.getPos(idx);
 
     // get tangent frame
@@ -853,7 +896,7 @@ void surfaceMaintenance(
             Real x = dot(gPos - pos, t1);
             Real y = dot(gPos - pos, t2);
             Real z = surfaceWaveH[idn];
-            Real w = weightSurfaceTangent(norm(pos - gPos));
+            Real w = weightSurfaceTangent(norm(pos - gPos), params);
             swx2 += w*x*x;
             swy2 += w*y*y;
             swxy += w*x*y;
@@ -876,14 +919,14 @@ void surfaceMaintenance(
         Vec3 waveNormal = -getNormalized(vx*abc.x + vy*abc.y - Vec3(0,0,1));
         tempSurfaceVec3[idx] = waveNormal;
     }
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1;inline const ParticleDataImpl<Real>& getArg2() { return surfaceWaveH; } typedef ParticleDataImpl<Real> type2; void runMessage() { debMsg("Executing kernel computeSurfaceWaveNormal ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals,surfaceWaveH);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals; const ParticleDataImpl<Real>& surfaceWaveH;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1;inline const ParticleDataImpl<Real>& getArg2() { return surfaceWaveH; } typedef ParticleDataImpl<Real> type2;inline vector<Vec3>& getArg3() { return tempSurfaceVec3; } typedef vector<Vec3> type3;inline const SurfaceTurbulenceParameters& getArg4() { return params; } typedef SurfaceTurbulenceParameters type4; void runMessage() { debMsg("Executing kernel computeSurfaceWaveNormal ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals,surfaceWaveH,tempSurfaceVec3,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals; const ParticleDataImpl<Real>& surfaceWaveH; vector<Vec3>& tempSurfaceVec3; const SurfaceTurbulenceParameters& params;   };
 
 
 
 
 
 
- struct computeSurfaceWaveLaplacians : public KernelBase { computeSurfaceWaveLaplacians( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, const ParticleDataImpl<Real>& surfaceWaveH ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals),surfaceWaveH(surfaceWaveH)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, const ParticleDataImpl<Real>& surfaceWaveH  ) const {
+ struct computeSurfaceWaveLaplacians : public KernelBase { computeSurfaceWaveLaplacians( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, const ParticleDataImpl<Real>& surfaceWaveH, const vector<Vec3>& tempSurfaceVec3, vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals),surfaceWaveH(surfaceWaveH),tempSurfaceVec3(tempSurfaceVec3),tempSurfaceFloat(tempSurfaceFloat),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, const ParticleDataImpl<Real>& surfaceWaveH, const vector<Vec3>& tempSurfaceVec3, vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params  ) const {
     Real laplacian = 0;
     Real wTotal = 0;
     Vec3 pPos = surfacePoints.getPos(idx);
@@ -911,7 +954,7 @@ void surfaceMaintenance(
                 Real dirX = dot(tangentDir, t1);
                 Real dirY = dot(tangentDir, t2);
                 Real dz = nh - ph - (-pWaveNormal.x/pWaveNormal.z)*dirX - (-pWaveNormal.y/pWaveNormal.z)*dirY;
-                Real w = weightSurfaceTangent(norm(pPos - gPos));
+                Real w = weightSurfaceTangent(norm(pPos - gPos), params);
                 wTotal += w;
                 laplacian += clamp(w * 4*dz/(lengthDir*lengthDir), Real(-100.), Real(100.) );
             LOOP_GHOSTS_END
@@ -919,7 +962,7 @@ void surfaceMaintenance(
         if(wTotal != 0) {tempSurfaceFloat[idx] = laplacian/wTotal;}
         else {tempSurfaceFloat[idx] = 0;}
     }
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1;inline const ParticleDataImpl<Real>& getArg2() { return surfaceWaveH; } typedef ParticleDataImpl<Real> type2; void runMessage() { debMsg("Executing kernel computeSurfaceWaveLaplacians ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals,surfaceWaveH);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals; const ParticleDataImpl<Real>& surfaceWaveH;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1;inline const ParticleDataImpl<Real>& getArg2() { return surfaceWaveH; } typedef ParticleDataImpl<Real> type2;inline const vector<Vec3>& getArg3() { return tempSurfaceVec3; } typedef vector<Vec3> type3;inline vector<Real>& getArg4() { return tempSurfaceFloat; } typedef vector<Real> type4;inline const SurfaceTurbulenceParameters& getArg5() { return params; } typedef SurfaceTurbulenceParameters type5; void runMessage() { debMsg("Executing kernel computeSurfaceWaveLaplacians ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals,surfaceWaveH,tempSurfaceVec3,tempSurfaceFloat,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals; const ParticleDataImpl<Real>& surfaceWaveH; const vector<Vec3>& tempSurfaceVec3; vector<Real>& tempSurfaceFloat; const SurfaceTurbulenceParameters& params;   };
 
 
 
@@ -928,7 +971,7 @@ void surfaceMaintenance(
 
 
 
- struct evolveWave : public KernelBase { evolveWave( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveH, ParticleDataImpl<Real>& surfaceWaveDtH, const ParticleDataImpl<Real>& surfaceWaveSeed ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceWaveH(surfaceWaveH),surfaceWaveDtH(surfaceWaveDtH),surfaceWaveSeed(surfaceWaveSeed)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveH, ParticleDataImpl<Real>& surfaceWaveDtH, const ParticleDataImpl<Real>& surfaceWaveSeed  ) const {
+ struct evolveWave : public KernelBase { evolveWave( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveH, ParticleDataImpl<Real>& surfaceWaveDtH, const ParticleDataImpl<Real>& surfaceWaveSeed, const vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceWaveH(surfaceWaveH),surfaceWaveDtH(surfaceWaveDtH),surfaceWaveSeed(surfaceWaveSeed),tempSurfaceFloat(tempSurfaceFloat),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveH, ParticleDataImpl<Real>& surfaceWaveDtH, const ParticleDataImpl<Real>& surfaceWaveSeed, const vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params  ) const {
     surfaceWaveDtH[idx] += params.waveSpeed*params.waveSpeed * params.dt * tempSurfaceFloat[idx];
     surfaceWaveDtH[idx] /= (1 + params.dt * params.waveDamping);
     surfaceWaveH[idx]   += params.dt * surfaceWaveDtH[idx];
@@ -938,14 +981,14 @@ void surfaceMaintenance(
     // clamp H and DtH (to prevent rare extreme behaviors)
     surfaceWaveDtH[idx] = clamp(surfaceWaveDtH[idx], -params.waveMaxFrequency*params.waveMaxAmplitude, params.waveMaxFrequency*params.waveMaxAmplitude);
     surfaceWaveH[idx]   = clamp(surfaceWaveH[idx], -params.waveMaxAmplitude, params.waveMaxAmplitude);
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Real>& getArg1() { return surfaceWaveH; } typedef ParticleDataImpl<Real> type1;inline ParticleDataImpl<Real>& getArg2() { return surfaceWaveDtH; } typedef ParticleDataImpl<Real> type2;inline const ParticleDataImpl<Real>& getArg3() { return surfaceWaveSeed; } typedef ParticleDataImpl<Real> type3; void runMessage() { debMsg("Executing kernel evolveWave ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceWaveH,surfaceWaveDtH,surfaceWaveSeed);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Real>& surfaceWaveH; ParticleDataImpl<Real>& surfaceWaveDtH; const ParticleDataImpl<Real>& surfaceWaveSeed;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Real>& getArg1() { return surfaceWaveH; } typedef ParticleDataImpl<Real> type1;inline ParticleDataImpl<Real>& getArg2() { return surfaceWaveDtH; } typedef ParticleDataImpl<Real> type2;inline const ParticleDataImpl<Real>& getArg3() { return surfaceWaveSeed; } typedef ParticleDataImpl<Real> type3;inline const vector<Real>& getArg4() { return tempSurfaceFloat; } typedef vector<Real> type4;inline const SurfaceTurbulenceParameters& getArg5() { return params; } typedef SurfaceTurbulenceParameters type5; void runMessage() { debMsg("Executing kernel evolveWave ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceWaveH,surfaceWaveDtH,surfaceWaveSeed,tempSurfaceFloat,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Real>& surfaceWaveH; ParticleDataImpl<Real>& surfaceWaveDtH; const ParticleDataImpl<Real>& surfaceWaveSeed; const vector<Real>& tempSurfaceFloat; const SurfaceTurbulenceParameters& params;   };
 
 
 
 
 
 
- struct computeSurfaceCurvature : public KernelBase { computeSurfaceCurvature( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals  ) const {
+ struct computeSurfaceCurvature : public KernelBase { computeSurfaceCurvature( const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceNormals(surfaceNormals),tempSurfaceFloat(tempSurfaceFloat),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, const ParticleDataImpl<Vec3>& surfaceNormals, vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params  ) const {
     Vec3 pPos = surfacePoints.getPos(idx);
     Real wTotal = 0;
     Real curv = 0;
@@ -960,33 +1003,33 @@ void surfaceMaintenance(
 
             Real distn = dot(dir, pNormal);
 
-            Real w = weightSurfaceNormal(dist);
+            Real w = weightSurfaceNormal(dist, params);
             curv += w * distn;
             wTotal += w;
         LOOP_GHOSTS_END
     LOOP_NEIGHBORS_END
     if(wTotal!=0) {curv /= wTotal;}
     tempSurfaceFloat[idx] = fabs(curv);
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1; void runMessage() { debMsg("Executing kernel computeSurfaceCurvature ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline const ParticleDataImpl<Vec3>& getArg1() { return surfaceNormals; } typedef ParticleDataImpl<Vec3> type1;inline vector<Real>& getArg2() { return tempSurfaceFloat; } typedef vector<Real> type2;inline const SurfaceTurbulenceParameters& getArg3() { return params; } typedef SurfaceTurbulenceParameters type3; void runMessage() { debMsg("Executing kernel computeSurfaceCurvature ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceNormals,tempSurfaceFloat,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; const ParticleDataImpl<Vec3>& surfaceNormals; vector<Real>& tempSurfaceFloat; const SurfaceTurbulenceParameters& params;   };
 
 
 
 
 
 
- struct smoothCurvature : public KernelBase { smoothCurvature( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveSource ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceWaveSource(surfaceWaveSource)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveSource  ) const {
+ struct smoothCurvature : public KernelBase { smoothCurvature( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveSource, const vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceWaveSource(surfaceWaveSource),tempSurfaceFloat(tempSurfaceFloat),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveSource, const vector<Real>& tempSurfaceFloat, const SurfaceTurbulenceParameters& params  ) const {
     Vec3 pPos = surfacePoints.getPos(idx);
     Real curv = 0;
     Real wTotal = 0;
     
     LOOP_NEIGHBORS_BEGIN(surfacePoints, pPos, params.normalRadius)
-        Real w = weightSurfaceNormal(norm( pPos - surfacePoints.getPos(idn) ));
+        Real w = weightSurfaceNormal(norm( pPos - surfacePoints.getPos(idn) ), params);
         curv += w * tempSurfaceFloat[idn];
         wTotal += w;                
     LOOP_NEIGHBORS_END
     if(wTotal!=0) {curv /= wTotal;}
     surfaceWaveSource[idx] = curv;
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Real>& getArg1() { return surfaceWaveSource; } typedef ParticleDataImpl<Real> type1; void runMessage() { debMsg("Executing kernel smoothCurvature ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceWaveSource);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Real>& surfaceWaveSource;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Real>& getArg1() { return surfaceWaveSource; } typedef ParticleDataImpl<Real> type1;inline const vector<Real>& getArg2() { return tempSurfaceFloat; } typedef vector<Real> type2;inline const SurfaceTurbulenceParameters& getArg3() { return params; } typedef SurfaceTurbulenceParameters type3; void runMessage() { debMsg("Executing kernel smoothCurvature ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceWaveSource,tempSurfaceFloat,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Real>& surfaceWaveSource; const vector<Real>& tempSurfaceFloat; const SurfaceTurbulenceParameters& params;   };
 
 
 
@@ -995,7 +1038,7 @@ void surfaceMaintenance(
 
 
 
- struct seedWaves : public KernelBase { seedWaves( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveSeed, ParticleDataImpl<Real>& surfaceWaveSeedAmplitude, ParticleDataImpl<Real>& surfaceWaveSource ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceWaveSeed(surfaceWaveSeed),surfaceWaveSeedAmplitude(surfaceWaveSeedAmplitude),surfaceWaveSource(surfaceWaveSource)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveSeed, ParticleDataImpl<Real>& surfaceWaveSeedAmplitude, ParticleDataImpl<Real>& surfaceWaveSource  ) const {
+ struct seedWaves : public KernelBase { seedWaves( const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveSeed, ParticleDataImpl<Real>& surfaceWaveSeedAmplitude, ParticleDataImpl<Real>& surfaceWaveSource, int frameCount, const SurfaceTurbulenceParameters& params ) :  KernelBase(surfacePoints.size()) ,surfacePoints(surfacePoints),surfaceWaveSeed(surfaceWaveSeed),surfaceWaveSeedAmplitude(surfaceWaveSeedAmplitude),surfaceWaveSource(surfaceWaveSource),frameCount(frameCount),params(params)   { runMessage(); run(); }   inline void op(IndexInt idx,  const BasicParticleSystemWrapper& surfacePoints, ParticleDataImpl<Real>& surfaceWaveSeed, ParticleDataImpl<Real>& surfaceWaveSeedAmplitude, ParticleDataImpl<Real>& surfaceWaveSource, int frameCount, const SurfaceTurbulenceParameters& params  ) const {
     Real source = smoothstep(params.waveSeedingCurvatureThresholdRegionCenter - params.waveSeedingCurvatureThresholdRegionRadius, params.waveSeedingCurvatureThresholdRegionCenter + params.waveSeedingCurvatureThresholdRegionRadius, (Real) surfaceWaveSource[idx]) * 2.f - 1.f;
     Real freq = params.waveSeedFrequency;
     Real theta = params.dt * frameCount * params.waveSpeed * freq;
@@ -1007,12 +1050,12 @@ void surfaceMaintenance(
 
     // source values for display (not used after this point anyway)
     surfaceWaveSource[idx] = (source>=0) ? 1 : 0;
-}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Real>& getArg1() { return surfaceWaveSeed; } typedef ParticleDataImpl<Real> type1;inline ParticleDataImpl<Real>& getArg2() { return surfaceWaveSeedAmplitude; } typedef ParticleDataImpl<Real> type2;inline ParticleDataImpl<Real>& getArg3() { return surfaceWaveSource; } typedef ParticleDataImpl<Real> type3; void runMessage() { debMsg("Executing kernel seedWaves ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceWaveSeed,surfaceWaveSeedAmplitude,surfaceWaveSource);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Real>& surfaceWaveSeed; ParticleDataImpl<Real>& surfaceWaveSeedAmplitude; ParticleDataImpl<Real>& surfaceWaveSource;   };
+}    inline const BasicParticleSystemWrapper& getArg0() { return surfacePoints; } typedef BasicParticleSystemWrapper type0;inline ParticleDataImpl<Real>& getArg1() { return surfaceWaveSeed; } typedef ParticleDataImpl<Real> type1;inline ParticleDataImpl<Real>& getArg2() { return surfaceWaveSeedAmplitude; } typedef ParticleDataImpl<Real> type2;inline ParticleDataImpl<Real>& getArg3() { return surfaceWaveSource; } typedef ParticleDataImpl<Real> type3;inline int& getArg4() { return frameCount; } typedef int type4;inline const SurfaceTurbulenceParameters& getArg5() { return params; } typedef SurfaceTurbulenceParameters type5; void runMessage() { debMsg("Executing kernel seedWaves ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, surfacePoints,surfaceWaveSeed,surfaceWaveSeedAmplitude,surfaceWaveSource,frameCount,params);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   }  const BasicParticleSystemWrapper& surfacePoints; ParticleDataImpl<Real>& surfaceWaveSeed; ParticleDataImpl<Real>& surfaceWaveSeedAmplitude; ParticleDataImpl<Real>& surfaceWaveSource; int frameCount; const SurfaceTurbulenceParameters& params;   };
 
 
 
 void surfaceWaves(
-        const BasicParticleSystemWrapper& surfacePoints,
+        SurfaceTurbulenceContext& ctx,
         const ParticleDataImpl<Vec3>& surfaceNormals,
         ParticleDataImpl<Real>& surfaceWaveH,
         ParticleDataImpl<Real>& surfaceWaveDtH,
@@ -1020,13 +1063,16 @@ void surfaceWaves(
         ParticleDataImpl<Real>& surfaceWaveSeed,
         ParticleDataImpl<Real>& surfaceWaveSeedAmplitude
 ){
+    const SurfaceTurbulenceParameters& params = ctx.params;
+    const BasicParticleSystemWrapper& surfacePoints = ctx.surfacePoints;
+
     addSeed(surfacePoints, surfaceWaveH, surfaceWaveSeed);
-    computeSurfaceWaveNormal(surfacePoints, surfaceNormals, surfaceWaveH);
-    computeSurfaceWaveLaplacians(surfacePoints, surfaceNormals, surfaceWaveH);
-    evolveWave(surfacePoints, surfaceWaveH, surfaceWaveDtH, surfaceWaveSeed);
-    computeSurfaceCurvature(surfacePoints, surfaceNormals);
-    smoothCurvature(surfacePoints, surfaceWaveSource);
-    seedWaves(surfacePoints, surfaceWaveSeed, surfaceWaveSeedAmplitude, surfaceWaveSource);
+    computeSurfaceWaveNormal(surfacePoints, surfaceNormals, surfaceWaveH, ctx.tempSurfaceVec3, params);
+    computeSurfaceWaveLaplacians(surfacePoints, surfaceNormals, surfaceWaveH, ctx.tempSurfaceVec3, ctx.tempSurfaceFloat, params);
+    evolveWave(surfacePoints, surfaceWaveH, surfaceWaveDtH, surfaceWaveSeed, ctx.tempSurfaceFloat, params);
+    computeSurfaceCurvature(surfacePoints, surfaceNormals, ctx.tempSurfaceFloat, params);
+    smoothCurvature(surfacePoints, surfaceWaveSource, ctx.tempSurfaceFloat, params);
+    seedWaves(surfacePoints, surfaceWaveSeed, surfaceWaveSeedAmplitude, surfaceWaveSource, ctx.frameCount, params);
 }
 
 
@@ -1073,6 +1119,24 @@ void particleSurfaceTurbulence( const FlagGrid& flags, BasicParticleSystem& coar
     begin = std::chrono::high_resolution_clock::now();
 #	endif
     
+    // get the state of this solver
+    FluidSolver* solver = flags.getParent();
+    SurfaceTurbulenceContext* ctxPtr = gMapContexts[solver];
+    if(!ctxPtr) {
+        ctxPtr = new SurfaceTurbulenceContext();
+        gMapContexts[solver] = ctxPtr;
+    }
+    SurfaceTurbulenceContext& ctx = *ctxPtr;
+    SurfaceTurbulenceParameters& params = ctx.params;
+    BasicParticleSystemWrapper& coarseParticles = ctx.coarseParticles;
+    BasicParticleSystemWrapper& surfacePoints = ctx.surfacePoints;
+    ParticleDataImplVec3Wrapper& coarseParticlesPrevPos = ctx.coarseParticlesPrevPos;
+
+    // different surface points for this solver, start over
+    if(surfacePoints.points != &surfPoints) {
+        ctx.frameCount = 0;
+    }
+
     // wrap data
     coarseParticles.points = &coarseParts;
     coarseParticlesPrevPos.points = &coarsePartsPrevPos;
@@ -1097,26 +1161,26 @@ void particleSurfaceTurbulence( const FlagGrid& flags, BasicParticleSystem& coar
     // compute other parameters
     params.innerRadius = params.outerRadius/2.0;
     params.meanFineDistance = M_PI*(params.outerRadius+params.innerRadius)/params.surfaceDensity;
-    params.constraintA = logf(2.0f/(1.0f + weightKernelCoarseDensity(params.outerRadius+params.innerRadius)))/(powf((params.outerRadius+params.innerRadius)/2,2) - params.innerRadius*params.innerRadius);
+    params.constraintA = logf(2.0f/(1.0f + weightKernelCoarseDensity(params.outerRadius+params.innerRadius, params)))/(powf((params.outerRadius+params.innerRadius)/2,2) - params.innerRadius*params.innerRadius);
     params.normalRadius = 0.5f*(params.outerRadius + params.innerRadius);
     params.tangentRadius = 2.1f*params.meanFineDistance;
     params.bndXm = params.bndYm = params.bndZm = 2;
     params.bndXp = params.bndYp = params.bndZp = params.res-2;
 
-    if(frameCount==0) {
+    if(ctx.frameCount==0) {
 
         // initialize accel grids
-        accelCoarse.init(2.f*res/params.outerRadius);
-        accelSurface.init(1.f*res/(2.f*params.meanFineDistance));
+        ctx.accelCoarse.init(2.f*res/params.outerRadius, res);
+        ctx.accelSurface.init(1.f*res/(2.f*params.meanFineDistance), res);
 
         // update coarse accel structure
         coarseParticles.updateAccel();
 
         // create surface points
-        initFines(coarseParticles, surfacePoints, flags);
+        initFines(ctx, flags);
 
         // smooth surface
-        surfaceMaintenance(coarseParticles, surfacePoints, surfaceNormals, surfaceWaveH, surfaceWaveDtH, surfaceWaveSeed, surfaceWaveSeedAmplitude, 6*params.nbSurfaceMaintenanceIterations);
+        surfaceMaintenance(ctx, surfaceNormals, surfaceWaveH, surfaceWaveDtH, surfaceWaveSeed, surfaceWaveSeedAmplitude, 6*params.nbSurfaceMaintenanceIterations);
 
         // set wave values to zero
         for (int idx=0; idx<surfacePoints.size(); idx++) {
@@ -1132,19 +1196,19 @@ void particleSurfaceTurbulence( const FlagGrid& flags, BasicParticleSystem& coar
         coarseParticlesPrevPos.updateAccel();
 
         //advect surface points following coarse particles
-        advectSurfacePoints(surfacePoints, coarseParticles, coarseParticlesPrevPos);
+        advectSurfacePoints(surfacePoints, coarseParticles, coarseParticlesPrevPos, params);
         surfacePoints.updateAccel();
 
         // update acceleration structure for surface points
         coarseParticles.updateAccel();
 
         //surface maintenance
-        surfaceMaintenance(coarseParticles, surfacePoints, surfaceNormals, surfaceWaveH, surfaceWaveDtH, surfaceWaveSeed, surfaceWaveSeedAmplitude, params.nbSurfaceMaintenanceIterations);
+        surfaceMaintenance(ctx, surfaceNormals, surfaceWaveH, surfaceWaveDtH, surfaceWaveSeed, surfaceWaveSeedAmplitude, params.nbSurfaceMaintenanceIterations);
         
         // surface waves
-        surfaceWaves(surfacePoints, surfaceNormals, surfaceWaveH, surfaceWaveDtH, surfaceWaveSource, surfaceWaveSeed, surfaceWaveSeedAmplitude);
+        surfaceWaves(ctx, surfaceNormals, surfaceWaveH, surfaceWaveDtH, surfaceWaveSource, surfaceWaveSeed, surfaceWaveSeedAmplitude);
     }
-    frameCount++;
+    ctx.frameCount++;
 
     // save positions as previous positions for next step
     for(int id=0;id<coarseParticles.size();id++) {
@@ -1170,6 +1234,25 @@ void particleSurfaceTurbulence( const FlagGrid& flags, BasicParticleSystem& coar
 #	endif
 } static PyObject* _W_0 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "particleSurfaceTurbulence" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",0,&_lock); BasicParticleSystem& coarseParts = *_args.getPtr<BasicParticleSystem >("coarseParts",1,&_lock); ParticleDataImpl<Vec3>& coarsePartsPrevPos = *_args.getPtr<ParticleDataImpl<Vec3> >("coarsePartsPrevPos",2,&_lock); BasicParticleSystem& surfPoints = *_args.getPtr<BasicParticleSystem >("surfPoints",3,&_lock); ParticleDataImpl<Vec3>& surfaceNormals = *_args.getPtr<ParticleDataImpl<Vec3> >("surfaceNormals",4,&_lock); ParticleDataImpl<Real>& surfaceWaveH = *_args.getPtr<ParticleDataImpl<Real> >("surfaceWaveH",5,&_lock); ParticleDataImpl<Real>& surfaceWaveDtH = *_args.getPtr<ParticleDataImpl<Real> >("surfaceWaveDtH",6,&_lock); BasicParticleSystem& surfacePointsDisplaced = *_args.getPtr<BasicParticleSystem >("surfacePointsDisplaced",7,&_lock); ParticleDataImpl<Real>& surfaceWaveSource = *_args.getPtr<ParticleDataImpl<Real> >("surfaceWaveSource",8,&_lock); ParticleDataImpl<Real>& surfaceWaveSeed = *_args.getPtr<ParticleDataImpl<Real> >("surfaceWaveSeed",9,&_lock); ParticleDataImpl<Real>& surfaceWaveSeedAmplitude = *_args.getPtr<ParticleDataImpl<Real> >("surfaceWaveSeedAmplitude",10,&_lock); int res = _args.get<int >("res",11,&_lock); Real outerRadius = _args.getOpt<Real >("outerRadius",12,1.0f,&_lock); int surfaceDensity = _args.getOpt<int >("surfaceDensity",13,20,&_lock); int nbSurfaceMaintenanceIterations = _args.getOpt<int >("nbSurfaceMaintenanceIterations",14,4,&_lock); Real dt = _args.getOpt<Real >("dt",15,0.005f,&_lock); Real waveSpeed = _args.getOpt<Real >("waveSpeed",16,16.0f,&_lock); Real waveDamping = _args.getOpt<Real >("waveDamping",17,0.0f,&_lock); Real waveSeedFrequency = _args.getOpt<Real >("waveSeedFrequency",18,4,&_lock); Real waveMaxAmplitude = _args.getOpt<Real >("waveMaxAmplitude",19,0.25f,&_lock); Real waveMaxFrequency = _args.getOpt<Real >("waveMaxFrequency",20,800,&_lock); Real waveMaxSeedingAmplitude = _args.getOpt<Real >("waveMaxSeedingAmplitude",21,0.5,&_lock); Real waveSeedingCurvatureThresholdRegionCenter = _args.getOpt<Real >("waveSeedingCurvatureThresholdRegionCenter",22,0.025f,&_lock); Real waveSeedingCurvatureThresholdRegionRadius = _args.getOpt<Real >("waveSeedingCurvatureThresholdRegionRadius",23,0.01f,&_lock); Real waveSeedStepSizeRatioOfMax = _args.getOpt<Real >("waveSeedStepSizeRatioOfMax",24,0.05f ,&_lock);   _retval = getPyNone(); particleSurfaceTurbulence(flags,coarseParts,coarsePartsPrevPos,surfPoints,surfaceNormals,surfaceWaveH,surfaceWaveDtH,surfacePointsDisplaced,surfaceWaveSource,surfaceWaveSeed,surfaceWaveSeedAmplitude,res,outerRadius,surfaceDensity,nbSurfaceMaintenanceIterations,dt,waveSpeed,waveDamping,waveSeedFrequency,waveMaxAmplitude,waveMaxFrequency,waveMaxSeedingAmplitude,waveSeedingCurvatureThresholdRegionCenter,waveSeedingCurvatureThresholdRegionRadius,waveSeedStepSizeRatioOfMax);  _args.check(); } pbFinalizePlugin(parent,"particleSurfaceTurbulence", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("particleSurfaceTurbulence",e.what()); return 0; } } static const Pb::Register _RP_particleSurfaceTurbulence ("","particleSurfaceTurbulence",_W_0);  extern "C" { void PbRegister_particleSurfaceTurbulence() { KEEP_UNUSED(_RP_particleSurfaceTurbulence); } } 
 
+//! release the surface turbulence state of a solver (or of all solvers)
+
+
+void releaseSurfaceTurbulence(FluidSolver* solver=nullptr) {
+    // release all?
+    if(!solver) {
+        for(std::map<FluidSolver*, SurfaceTurbulenceContext*>::iterator it = gMapContexts.begin(); it != gMapContexts.end(); it++) {
+            if(it->first != nullptr) releaseSurfaceTurbulence(it->first);
+        }
+        return;
+    }
+
+    SurfaceTurbulenceContext* ctx = gMapContexts[solver];
+    if(ctx) {
+        delete ctx;
+        gMapContexts[solver] = nullptr;
+    }
+} static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "releaseSurfaceTurbulence" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; FluidSolver* solver = _args.getPtrOpt<FluidSolver >("solver",0,nullptr,&_lock);   _retval = getPyNone(); releaseSurfaceTurbulence(solver);  _args.check(); } pbFinalizePlugin(parent,"releaseSurfaceTurbulence", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("releaseSurfaceTurbulence",e.what()); return 0; } } static const Pb::Register _RP_releaseSurfaceTurbulence ("","releaseSurfaceTurbulence",_W_1);  extern "C" { void PbRegister_releaseSurfaceTurbulence() { KEEP_UNUSED(_RP_releaseSurfaceTurbulence); } } 
+
 
 
 
@@ -1180,7 +1263,7 @@ void debugCheckParts(const BasicParticleSystem& parts, const FlagGrid& flags) {
             debMsg("bad position??? "<<idx<<" "<< parts.getPos(idx) ,1 ); exit(1);
         }
     }
-} static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "debugCheckParts" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const BasicParticleSystem& parts = *_args.getPtr<BasicParticleSystem >("parts",0,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",1,&_lock);   _retval = getPyNone(); debugCheckParts(parts,flags);  _args.check(); } pbFinalizePlugin(parent,"debugCheckParts", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("debugCheckParts",e.what()); return 0; } } static const Pb::Register _RP_debugCheckParts ("","debugCheckParts",_W_1);  extern "C" { void PbRegister_debugCheckParts() { KEEP_UNUSED(_RP_debugCheckParts); } } 
+} static PyObject* _W_2 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); FluidSolver *parent = _args.obtainParent(); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(parent, "debugCheckParts" , !noTiming ); PyObject *_retval = 0; { ArgLocker _lock; const BasicParticleSystem& parts = *_args.getPtr<BasicParticleSystem >("parts",0,&_lock); const FlagGrid& flags = *_args.getPtr<FlagGrid >("flags",1,&_lock);   _retval = getPyNone(); debugCheckParts(parts,flags);  _args.check(); } pbFinalizePlugin(parent,"debugCheckParts", !noTiming ); return _retval; } catch(std::exception& e) { pbSetError("debugCheckParts",e.what()); return 0; } } static const Pb::Register _RP_debugCheckParts ("","debugCheckParts",_W_2);  extern "C" { void PbRegister_debugCheckParts() { KEEP_UNUSED(_RP_debugCheckParts); } } 
 
 
 
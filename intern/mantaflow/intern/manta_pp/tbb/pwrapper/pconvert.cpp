@@ -84,6 +84,9 @@ template<> PyObject* toPy<Vec4>(const Vec4& v) {
 	float x=(float)v.x, y=(float)v.y, z=(float)v.z;
 	return PyObject_CallFunction((PyObject*)&PbVec4Type, (char*)"ffff", x, y, z);
 }
+template<> PyObject* toPy<Half>(const Half& v) {
+	return PyFloat_FromDouble((Real)v);
+}
 template<> PyObject* toPy<PbClass*>(const PbClass_Ptr& obj) {
 	return obj->getPyObject();
 }
@@ -104,6 +107,9 @@ template<> double fromPy<double>(PyObject* obj) {
 	if (PyLong_Check(obj)) return PyLong_AsDouble(obj);
 	errMsg("argument is not a double");    
 }
+template<> Half fromPy<Half>(PyObject* obj) {
+	return Half(fromPy<Real>(obj));
+}
 template<> PyObject* fromPy<PyObject*>(PyObject *obj) {
 	return obj;
 }
@@ -211,6 +217,22 @@ template<> PbTypeVec fromPy<PbTypeVec>(PyObject* obj) {
 		errMsg("argument is not a type tuple");
 	return vec;
 }
+template<> std::vector<PbClass*> fromPy<std::vector<PbClass*> >(PyObject* obj) {
+	std::vector<PbClass*> vec;
+	if (PyList_Check(obj) || PyTuple_Check(obj)) {
+		int sz = PySequence_Size(obj);
+		for (int i=0; i< sz; i++) {
+			PyObject* item = PyList_Check(obj) ? PyList_GetItem(obj,i) : PyTuple_GetItem(obj,i);
+			PbClass* pbo = Pb::objFromPy(item);
+			if (!pbo)
+				errMsg("argument is not a list of manta objects");
+			vec.push_back(pbo);
+		}
+	}
+	else
+		errMsg("argument is not a list or tuple");
+	return vec;
+}
 
 template<class T> T* tmpAlloc(PyObject* obj,std::vector<void*>* tmp) {
 	if (!tmp) throw Error("dynamic de-ref not supported for this type");
@@ -229,6 +251,7 @@ template<> Vec3* fromPyPtr<Vec3>(PyObject* obj, std::vector<void*>* tmp) { retur
 template<> Vec3i* fromPyPtr<Vec3i>(PyObject* obj, std::vector<void*>* tmp) { return tmpAlloc<Vec3i>(obj,tmp); }
 template<> Vec4* fromPyPtr<Vec4>(PyObject* obj, std::vector<void*>* tmp) { return tmpAlloc<Vec4>(obj,tmp); }
 template<> Vec4i* fromPyPtr<Vec4i>(PyObject* obj, std::vector<void*>* tmp) { return tmpAlloc<Vec4i>(obj,tmp); }
+template<> Half* fromPyPtr<Half>(PyObject* obj, std::vector<void*>* tmp) { return tmpAlloc<Half>(obj,tmp); }
 
 template<> bool isPy<float>(PyObject* obj) {
 #if PY_MAJOR_VERSION <= 2
@@ -242,6 +265,9 @@ template<> bool isPy<double>(PyObject* obj) {
 #endif
 	return PyFloat_Check(obj) || PyLong_Check(obj);
 }
+template<> bool isPy<Half>(PyObject* obj) {
+	return isPy<Real>(obj);
+}
 template<> bool isPy<PyObject*>(PyObject *obj) {
 	return true;
 }
@@ -57,6 +57,7 @@ template<> Vec3* fromPyPtr<Vec3>(PyObject* obj, std::vector<void*>* tmp);
 template<> Vec3i* fromPyPtr<Vec3i>(PyObject* obj, std::vector<void*>* tmp);
 template<> Vec4* fromPyPtr<Vec4>(PyObject* obj, std::vector<void*>* tmp);
 template<> Vec4i* fromPyPtr<Vec4i>(PyObject* obj, std::vector<void*>* tmp);
+template<> Half* fromPyPtr<Half>(PyObject* obj, std::vector<void*>* tmp);
 
 PyObject* incref(PyObject* obj);
 template<class T> PyObject* toPy(const T& v) { 
@@ -92,8 +93,10 @@ template<> Vec3 fromPy<Vec3>(PyObject* obj);
 template<> Vec3i fromPy<Vec3i>(PyObject* obj);
 template<> Vec4 fromPy<Vec4>(PyObject* obj);
 template<> Vec4i fromPy<Vec4i>(PyObject* obj);
+template<> Half fromPy<Half>(PyObject* obj);
 template<> PbType fromPy<PbType>(PyObject* obj);
 template<> PbTypeVec fromPy<PbTypeVec>(PyObject* obj);
+template<> std::vector<PbClass*> fromPy<std::vector<PbClass*> >(PyObject* obj);
 
 template<> PyObject* toPy<int>( const int& v);
 template<> PyObject* toPy<std::string>( const std::string& val);
@@ -104,6 +107,7 @@ template<> PyObject* toPy<Vec3i>( const Vec3i& v);
 template<> PyObject* toPy<Vec3>( const Vec3& v);
 template<> PyObject* toPy<Vec4i>( const Vec4i& v);
 template<> PyObject* toPy<Vec4>( const Vec4& v);
+template<> PyObject* toPy<Half>( const Half& v);
 typedef PbClass* PbClass_Ptr;
 template<> PyObject* toPy<PbClass*>( const PbClass_Ptr & obj);
 
@@ -118,6 +122,7 @@ template<> bool isPy<Vec3>(PyObject* obj);
 template<> bool isPy<Vec3i>(PyObject* obj);
 template<> bool isPy<Vec4>(PyObject* obj);
 template<> bool isPy<Vec4i>(PyObject* obj);
+template<> bool isPy<Half>(PyObject* obj);
 template<> bool isPy<PbType>(PyObject* obj);
 
 //! Encapsulation of python arguments
@@ -0,0 +1,131 @@
+// DO NOT EDIT !
+// This file is generated using the MantaFlow preprocessor (prep generate).
+
+
+
+
+/******************************************************************************
+ *
+ * MantaFlow fluid solver framework
+ *
+ * This program is free software, distributed under the terms of the
+ * Apache License, Version 2.0 
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Active tile mask for sparse iteration over dense grids
+ *
+ ******************************************************************************/
+
+#include "tilemask.h"
+
+using namespace std;
+namespace Manta {
+
+TileMask::TileMask(const GridBase& grid) :
+	mSize(grid.getSize()), m3D(grid.is3D())
+{
+	mTiles = Vec3i((mSize.x + TileSize-1) / TileSize, (mSize.y + TileSize-1) / TileSize, m3D ? (mSize.z + TileSize-1) / TileSize : 1);
+	mActive.resize((IndexInt)mTiles.x * mTiles.y * mTiles.z, 0);
+}
+
+void TileMask::clear() {
+	std::fill(mActive.begin(), mActive.end(), 0);
+	mList.clear();
+}
+
+//! Kernel: flag tiles with non-zero values
+
+
+ struct knTileNonZero : public KernelBase { knTileNonZero(TileMask& mask, const Grid<Real>& grid) :  KernelBase(mask.numTiles()) ,mask(mask),grid(grid)   { runMessage(); run(); }   inline void op(IndexInt idx, TileMask& mask, const Grid<Real>& grid ) const {
+	const Vec3i lo = mask.getTileLo(idx,0), hi = mask.getTileHi(idx,0);
+	for (int k=lo.z; k<hi.z; k++)
+	for (int j=lo.y; j<hi.y; j++)
+	for (int i=lo.x; i<hi.x; i++) {
+		if (grid(i,j,k) != 0.) {
+			mask.setTileActive(idx, true);
+			return;
+		}
+	}
+}    inline TileMask& getArg0() { return mask; } typedef TileMask type0;inline const Grid<Real>& getArg1() { return grid; } typedef Grid<Real> type1; void runMessage() { debMsg("Executing kernel knTileNonZero ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, mask,grid);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } TileMask& mask; const Grid<Real>& grid;   };
+
+void TileMask::activateNonZero(const Grid<Real>& grid) {
+	knTileNonZero(*this, grid);
+}
+
+//! Kernel: flag tiles with non-zero values, only checks the active tiles of region
+
+
+ struct knTileNonZeroRegion : public KernelBase { knTileNonZeroRegion(TileMask& mask, const Grid<Real>& grid, const TileMask& region) :  KernelBase(region.numActive()) ,mask(mask),grid(grid),region(region)   { runMessage(); run(); }   inline void op(IndexInt idx, TileMask& mask, const Grid<Real>& grid, const TileMask& region ) const {
+	const IndexInt tile = region.getActiveTile(idx);
+	const Vec3i lo = mask.getTileLo(tile,0), hi = mask.getTileHi(tile,0);
+	for (int k=lo.z; k<hi.z; k++)
+	for (int j=lo.y; j<hi.y; j++)
+	for (int i=lo.x; i<hi.x; i++) {
+		if (grid(i,j,k) != 0.) {
+			mask.setTileActive(tile, true);
+			return;
+		}
+	}
+}    inline TileMask& getArg0() { return mask; } typedef TileMask type0;inline const Grid<Real>& getArg1() { return grid; } typedef Grid<Real> type1;inline const TileMask& getArg2() { return region; } typedef TileMask type2; void runMessage() { debMsg("Executing kernel knTileNonZeroRegion ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, mask,grid,region);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } TileMask& mask; const Grid<Real>& grid; const TileMask& region;   };
+
+void TileMask::activateNonZero(const Grid<Real>& grid, const TileMask& region) {
+	assertMsg(region.numTiles() == numTiles(), "TileMask: region has a different size");
+	knTileNonZeroRegion(*this, grid, region);
+}
+
+void TileMask::activateRegion(const Vec3i& lo, const Vec3i& hi) {
+	const Vec3i tlo(std::max(lo.x, 0) / TileSize, std::max(lo.y, 0) / TileSize, m3D ? std::max(lo.z, 0) / TileSize : 0);
+	const Vec3i chi(std::min(hi.x, mSize.x), std::min(hi.y, mSize.y), m3D ? std::min(hi.z, mSize.z) : 1);
+	for (int k=tlo.z; k*TileSize<chi.z; k++)
+	for (int j=tlo.y; j*TileSize<chi.y; j++)
+	for (int i=tlo.x; i*TileSize<chi.x; i++)
+		mActive[(IndexInt)i + (IndexInt)mTiles.x * (j + (IndexInt)mTiles.y * k)] = 1;
+}
+
+//! Kernel: flag tiles containing cells of given type
+
+
+ struct knTileHasType : public KernelBase { knTileHasType(TileMask& mask, const FlagGrid& flags, int type) :  KernelBase(mask.numTiles()) ,mask(mask),flags(flags),type(type)   { runMessage(); run(); }   inline void op(IndexInt idx, TileMask& mask, const FlagGrid& flags, int type ) const {
+	const Vec3i lo = mask.getTileLo(idx,0), hi = mask.getTileHi(idx,0);
+	for (int k=lo.z; k<hi.z; k++)
+	for (int j=lo.y; j<hi.y; j++)
+	for (int i=lo.x; i<hi.x; i++) {
+		if (flags(i,j,k) & type) {
+			mask.setTileActive(idx, true);
+			return;
+		}
+	}
+}    inline TileMask& getArg0() { return mask; } typedef TileMask type0;inline const FlagGrid& getArg1() { return flags; } typedef FlagGrid type1;inline int& getArg2() { return type; } typedef int type2; void runMessage() { debMsg("Executing kernel knTileHasType ", 3); debMsg("Kernel range" <<  " size "<<  size  << " "   , 4); }; void operator() (const tbb::blocked_range<IndexInt>& __r) const {   for (IndexInt idx=__r.begin(); idx!=(IndexInt)__r.end(); idx++) op(idx, mask,flags,type);   } void run() {   tbb::parallel_for (tbb::blocked_range<IndexInt>(0, size), *this);   } TileMask& mask; const FlagGrid& flags; int type;   };
+
+void TileMask::activateType(const FlagGrid& flags, int type) {
+	knTileHasType(*this, flags, type);
+}
+
+void TileMask::dilate(int n) {
+	if (n <= 0) return;
+
+	// separable max filter, one pass per axis
+	std::vector<char> tmp(mActive.size());
+	const IndexInt stride[3] = { 1, mTiles.x, (IndexInt)mTiles.x * mTiles.y };
+	for (int axis=0; axis<(m3D ? 3 : 2); axis++) {
+		const int len = mTiles[axis];
+		for (IndexInt t=0; t<numTiles(); t++) {
+			const int pos = (t / stride[axis]) % len;
+			char set = 0;
+			for (int o=std::max(0, pos-n); o<=std::min(len-1, pos+n) && !set; o++)
+				set = mActive[t + (o-pos) * stride[axis]];
+			tmp[t] = set;
+		}
+		mActive.swap(tmp);
+	}
+}
+
+void TileMask::update() {
+	mList.clear();
+	for (IndexInt t=0; t<numTiles(); t++) {
+		if (mActive[t]) mList.push_back(t);
+	}
+	debMsg("TileMask: " << numActive() << " of " << numTiles() << " tiles active", 3);
+}
+
+} // namespace
@@ -0,0 +1,106 @@
+// DO NOT EDIT !
+// This file is generated using the MantaFlow preprocessor (prep generate).
+
+
+
+
+/******************************************************************************
+ *
+ * MantaFlow fluid solver framework
+ *
+ * This program is free software, distributed under the terms of the
+ * Apache License, Version 2.0 
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Active tile mask for sparse iteration over dense grids
+ *
+ ******************************************************************************/
+
+#ifndef _TILEMASK_H
+#define _TILEMASK_H
+
+#include <vector>
+#include "grid.h"
+
+namespace Manta {
+
+//! Active tile mask
+/*! Splits the domain into tiles of TileSize^3 cells (TileSize^2 in 2D) and keeps a list
+ *  of active tiles. Grid storage stays dense, but kernels whose result is trivial far away
+ *  from fluid (empty cells, zero densities) can loop over the active tiles only, so their
+ *  cost scales with the fluid volume instead of the domain size. */
+class TileMask {
+public:
+	static const int TileSize = 8;
+
+	TileMask(const GridBase& grid);
+
+	//! flag all tiles inactive
+	void clear();
+	//! flag tile containing cell p as active
+	inline void activateCell(const Vec3i& p) { mActive[tileIndex(p)] = 1; }
+	inline void setTileActive(IndexInt tile, bool set) { mActive[tile] = set ? 1 : 0; }
+	inline bool isTileActive(IndexInt tile) const { return mActive[tile] != 0; }
+
+	//! flag tiles that contain at least one non-zero value
+	void activateNonZero(const Grid<Real>& grid);
+	//! same, but only checks the active tiles of region (e.g. the tiles a kernel wrote to)
+	void activateNonZero(const Grid<Real>& grid, const TileMask& region);
+	//! flag tiles overlapping the cell range [lo, hi)
+	void activateRegion(const Vec3i& lo, const Vec3i& hi);
+	//! flag tiles that contain at least one cell of the given type(s)
+	void activateType(const FlagGrid& flags, int type);
+	//! grow active region by n tiles in each direction
+	void dilate(int n);
+	//! rebuild list of active tiles, needs to be called after changing the mask
+	void update();
+
+	inline IndexInt numTiles() const { return (IndexInt)mActive.size(); }
+	inline IndexInt numActive() const { return (IndexInt)mList.size(); }
+	inline Real activeFraction() const { return numTiles() ? (Real)numActive() / numTiles() : 0.; }
+	//! sparse iteration only pays off if a good part of the domain can be skipped
+	inline bool useSparse() const { return activeFraction() <= 0.5; }
+
+	//! cell range [lo, hi) of a tile, cells closer than bnd to the domain border are excluded
+	inline Vec3i getTileLo(IndexInt tile, int bnd) const;
+	inline Vec3i getTileHi(IndexInt tile, int bnd) const;
+	inline IndexInt getActiveTile(IndexInt n) const { return mList[n]; }
+	//! cell range of n-th active tile
+	inline Vec3i getActiveLo(IndexInt n, int bnd) const { return getTileLo(mList[n], bnd); }
+	inline Vec3i getActiveHi(IndexInt n, int bnd) const { return getTileHi(mList[n], bnd); }
+
+	//! number of tiles needed to cover a distance in cells
+	static inline int tilesForCells(Real cells) { return (int)ceil(cells / TileSize); }
+
+protected:
+	inline IndexInt tileIndex(const Vec3i& p) const {
+		return (IndexInt)(p.x/TileSize) + (IndexInt)mTiles.x * ((p.y/TileSize) + (IndexInt)mTiles.y * (p.z/TileSize));
+	}
+
+	Vec3i mSize;
+	Vec3i mTiles;
+	bool m3D;
+	std::vector<char> mActive;
+	std::vector<IndexInt> mList;
+};
+
+Vec3i TileMask::getTileLo(IndexInt tile, int bnd) const {
+	const Vec3i t(tile % mTiles.x, (tile / mTiles.x) % mTiles.y, tile / ((IndexInt)mTiles.x * mTiles.y));
+	return Vec3i(std::max(t.x*TileSize, bnd), std::max(t.y*TileSize, bnd), m3D ? std::max(t.z*TileSize, bnd) : 0);
+}
+
+Vec3i TileMask::getTileHi(IndexInt tile, int bnd) const {
+	const Vec3i t(tile % mTiles.x, (tile / mTiles.x) % mTiles.y, tile / ((IndexInt)mTiles.x * mTiles.y));
+	return Vec3i(std::min((t.x+1)*TileSize, mSize.x-bnd), std::min((t.y+1)*TileSize, mSize.y-bnd), m3D ? std::min((t.z+1)*TileSize, mSize.z-bnd) : 1);
+}
+
+//! loop over all cells of n-th active tile, use from kernels running over mask.numActive()
+#define FOR_TILE_IJK_BND(mask, n, bnd) \
+	for(int k=(mask).getActiveLo(n,bnd).z, __kmax=(mask).getActiveHi(n,bnd).z; k<__kmax; k++) \
+		for(int j=(mask).getActiveLo(n,bnd).y, __jmax=(mask).getActiveHi(n,bnd).y; j<__jmax; j++) \
+			for(int i=(mask).getActiveLo(n,bnd).x, __imax=(mask).getActiveHi(n,bnd).x; i<__imax; i++)
+
+} // namespace
+
+#endif
+
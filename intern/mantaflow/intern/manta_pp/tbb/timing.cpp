@@ -24,20 +24,167 @@
  ******************************************************************************/
 
 #include "timing.h"
+#include "particle.h"
 #include <fstream>
+#include <chrono>
+#include <thread>
+#if defined(WIN32) || defined(_WIN32)
+#	include <windows.h>
+#else
+#	include <sys/resource.h>
+#endif
 
 using namespace std;
 namespace Manta {
 
-TimingData::TimingData() : updated(false), num(0) {
+TimingData::TimingData() : updated(false), num(0), mProfile(NULL), mChromeTrace(false), mFirstEvent(true),
+	mProfileSteps(0), mProfileStart(0), mEventStart(0), mEventCpu(0) {
+}
+
+TimingData::~TimingData() {
+	stopProfile();
+}
+
+//! wall clock time in microseconds
+static double wallTimeUs() {
+	return (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//! cpu time of all threads of the process in microseconds
+static double cpuTimeUs() {
+#if defined(WIN32) || defined(_WIN32)
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;   u.HighPart = user.dwHighDateTime;
+	return (double)(k.QuadPart + u.QuadPart) / 10.; // 100ns units
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+	return (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 + (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+static string jsonString(const string& s) {
+	string out = "\"";
+	for (size_t i = 0; i < s.size(); i++) {
+		if (s[i] == '"' || s[i] == '\\') out += '\\';
+		if ((unsigned char)s[i] >= 0x20) out += s[i];
+	}
+	return out + "\"";
+}
+
+void TimingData::startProfile(const string& filename, bool chromeTrace) {
+	stopProfile();
+	mProfile = new ofstream(filename.c_str());
+	if (!mProfile->good()) {
+		delete mProfile;
+		mProfile = NULL;
+		errMsg("can't open " + filename + " as profile");
+	}
+	mChromeTrace = chromeTrace;
+	mFirstEvent = true;
+	mProfileSteps = 0;
+	mProfileStart = wallTimeUs();
+	mCounters.clear();
+	// the plugin that opened the profile started before it, don't write an event for it
+	mLastPlugin.clear();
+	// array format of the trace event format, viewers accept it without the closing bracket
+	// so profiles of aborted runs stay readable
+	if (mChromeTrace) *mProfile << "[";
+	debMsg("Writing profile to " << filename, 1);
+}
+
+void TimingData::stopProfile() {
+	if (!mProfile) return;
+	if (mChromeTrace) *mProfile << "\n]\n";
+	mProfile->close();
+	delete mProfile;
+	mProfile = NULL;
+}
+
+void TimingData::addCounter(const string& name, double value) {
+	if (mProfile) mCounters[name] += value;
+}
+
+void TimingData::setCounter(const string& name, double value) {
+	if (mProfile) mCounters[name] = value;
+}
+
+void TimingData::writeProfileEvent(FluidSolver* parent, const string& name) {
+	const double end = wallTimeUs();
+	const double wall = end - mEventStart;
+	const int threads = std::max(1, (int)std::thread::hardware_concurrency());
+	// average number of busy threads, and the fraction of the machine that was used
+	const double cpu = (wall > 0) ? std::min((cpuTimeUs() - mEventCpu) / wall, (double)threads) : 0;
+	ostream& out = *mProfile;
+	if (mChromeTrace) {
+		out << (mFirstEvent ? "\n" : ",\n");
+		out << "{\"name\":" << jsonString(name) << ",\"cat\":\"plugin\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+			<< ",\"ts\":" << (long long)(mEventStart - mProfileStart) << ",\"dur\":" << (long long)wall << ",\"args\":{";
+	} else {
+		out << "{\"type\":\"plugin\",\"name\":" << jsonString(name) << ",\"step\":" << mProfileSteps
+			<< ",\"ts\":" << (long long)(mEventStart - mProfileStart) << ",\"dur\":" << (long long)wall << ",";
+	}
+	out << "\"solver\":" << jsonString(parent ? parent->getName() : "") << ",\"cpu\":" << cpu
+		<< ",\"threads\":" << threads << ",\"utilization\":" << cpu / threads;
+	for (map<string, double>::iterator it = mCounters.begin(); it != mCounters.end(); it++)
+		out << "," << jsonString(it->first) << ":" << it->second;
+	out << (mChromeTrace ? "}}" : "}\n");
+	mFirstEvent = false;
+	mCounters.clear();
+}
+
+void TimingData::writeProfileStep(FluidSolver* parent) {
+	const double ts = wallTimeUs() - mProfileStart;
+	// particle counts of all systems of this solver
+	std::ostringstream parts;
+	for (int i = 0; i < PbClass::getNumInstances(); i++) {
+		ParticleBase* p = dynamic_cast<ParticleBase*>(PbClass::getInstance(i));
+		if (!p || p->getParent() != parent || p->getType() == ParticleBase::INDEX) continue;
+		parts << (parts.tellp() > 0 ? "," : "") << jsonString(p->getName()) << ":" << p->getSizeSlow();
+	}
+	ostream& out = *mProfile;
+	const double mb = 1. / (1024. * 1024.);
+	const string solver = jsonString(parent ? parent->getName() : "");
+	if (mChromeTrace) {
+		out << (mFirstEvent ? "\n" : ",\n");
+		out << "{\"name\":\"step\",\"cat\":\"step\",\"ph\":\"i\",\"s\":\"p\",\"pid\":0,\"tid\":0,\"ts\":" << (long long)ts
+			<< ",\"args\":{\"solver\":" << solver;
+		if (parent) out << ",\"frame\":" << parent->mFrame << ",\"dt\":" << parent->mDt
+			<< ",\"gridMB\":" << parent->getGridMemory() * mb << ",\"tempGridMB\":" << parent->getTempGridPeak() * mb;
+		out << "}}";
+		if (parts.tellp() > 0)
+			out << ",\n{\"name\":\"particles\",\"ph\":\"C\",\"pid\":0,\"ts\":" << (long long)ts << ",\"args\":{" << parts.str() << "}}";
+	} else {
+		out << "{\"type\":\"step\",\"step\":" << mProfileSteps << ",\"ts\":" << (long long)ts << ",\"solver\":" << solver;
+		if (parent) out << ",\"frame\":" << parent->mFrame << ",\"time\":" << parent->mTimeTotal << ",\"dt\":" << parent->mDt
+			<< ",\"gridMB\":" << parent->getGridMemory() * mb << ",\"tempGridMB\":" << parent->getTempGridPeak() * mb;
+		out << ",\"particles\":{" << parts.str() << "}}\n";
+	}
+	mFirstEvent = false;
+	mProfileSteps++;
+	mProfile->flush();
 }
 
 void TimingData::start(FluidSolver* parent, const string& name) {
 	mLastPlugin = name;
 	mPluginTimer.get();
+	if (mProfile) {
+		mCounters.clear();
+		mEventStart = wallTimeUs();
+		mEventCpu = cpuTimeUs();
+	}
 }
 
 void TimingData::stop(FluidSolver* parent, const string& name) {
+	if (mProfile && mLastPlugin == name) {
+		if (name == "FluidSolver::step")
+			writeProfileStep(parent);
+		else
+			writeProfileEvent(parent, name);
+	}
 	if (mLastPlugin == name && name != "FluidSolver::step") {
 		updated = true;
 		const string parentName = parent ? parent->getName() : "";
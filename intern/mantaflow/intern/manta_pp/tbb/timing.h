@@ -28,12 +28,14 @@
 
 #include "manta.h"
 #include <map>
+#include <iosfwd>
 namespace Manta { 
 
 
 class TimingData {
 private:
 	TimingData();
+	~TimingData();
 public:
 	static TimingData& instance() { static TimingData a; return a; }
 
@@ -41,8 +43,20 @@ public:
 	void saveMean(const std::string& filename);
 	void start(FluidSolver* parent, const std::string& name);
 	void stop(FluidSolver* parent, const std::string& name);
+
+	//! write every plugin call and solver step to a profile file, either as JSON lines
+	//! or in the Chrome trace event format (chrome://tracing, Perfetto)
+	void startProfile(const std::string& filename, bool chromeTrace);
+	void stopProfile();
+	inline bool profiling() const { return mProfile != NULL; }
+	//! counters of the running plugin, e.g. CG iterations or bytes read from files.
+	//! addCounter accumulates values, setCounter keeps the last one. Only call from the main thread
+	void addCounter(const std::string& name, double value);
+	void setCounter(const std::string& name, double value);
 protected:
 	void step();
+	void writeProfileEvent(FluidSolver* parent, const std::string& name);
+	void writeProfileStep(FluidSolver* parent);
 	struct TimingSet {
 		TimingSet() : num(0),updated(false) { cur.clear(); total.clear(); }
 		MuTime cur, total;
@@ -56,13 +70,26 @@ protected:
 	MuTime mPluginTimer;
 	std::string mLastPlugin;
 	std::map<std::string, std::vector<TimingSet> > mData;
+
+	// profile output, NULL if no profile is written
+	std::ofstream* mProfile;
+	bool mChromeTrace;
+	bool mFirstEvent;
+	int mProfileSteps;
+	//! wall clock and process cpu time at the start of the profile and of the running plugin, in microseconds
+	double mProfileStart, mEventStart, mEventCpu;
+	std::map<std::string, double> mCounters;
 };
 
 // Python interface
 class Timings : public PbClass {public:
 	Timings() :PbClass(0){} static int _W_0 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { PbClass* obj = Pb::objFromPy(_self); if (obj) delete obj; try { PbArgs _args(_linargs, _kwds); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(0, "Timings::Timings" , !noTiming ); { ArgLocker _lock;  obj = new Timings(); obj->registerObject(_self, &_args); _args.check(); } pbFinalizePlugin(obj->getParent(),"Timings::Timings" , !noTiming ); return 0; } catch(std::exception& e) { pbSetError("Timings::Timings",e.what()); return -1; } }
 	
-	void display() { TimingData::instance().print(); } static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); Timings* pbo = dynamic_cast<Timings*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "Timings::display" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock;  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->display();  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"Timings::display" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("Timings::display",e.what()); return 0; } } 	void saveMean(std::string file) { TimingData::instance().saveMean(file); } static PyObject* _W_2 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); Timings* pbo = dynamic_cast<Timings*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "Timings::saveMean" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock; std::string file = _args.get<std::string >("file",0,&_lock);  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->saveMean(file);  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"Timings::saveMean" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("Timings::saveMean",e.what()); return 0; } } public: PbArgs _args; }
+	void display() { TimingData::instance().print(); } static PyObject* _W_1 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); Timings* pbo = dynamic_cast<Timings*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "Timings::display" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock;  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->display();  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"Timings::display" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("Timings::display",e.what()); return 0; } } 	void saveMean(std::string file) { TimingData::instance().saveMean(file); } static PyObject* _W_2 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); Timings* pbo = dynamic_cast<Timings*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "Timings::saveMean" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock; std::string file = _args.get<std::string >("file",0,&_lock);  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->saveMean(file);  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"Timings::saveMean" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("Timings::saveMean",e.what()); return 0; } }
+
+	//! profile all following plugin calls, see TimingData::startProfile
+	void startProfile(std::string file, bool chromeTrace=false) { TimingData::instance().startProfile(file, chromeTrace); } static PyObject* _W_3 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); Timings* pbo = dynamic_cast<Timings*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "Timings::startProfile" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock; std::string file = _args.get<std::string >("file",0,&_lock); bool chromeTrace = _args.getOpt<bool >("chromeTrace",1,false,&_lock);  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->startProfile(file,chromeTrace);  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"Timings::startProfile" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("Timings::startProfile",e.what()); return 0; } }
+	void stopProfile() { TimingData::instance().stopProfile(); } static PyObject* _W_4 (PyObject* _self, PyObject* _linargs, PyObject* _kwds) { try { PbArgs _args(_linargs, _kwds); Timings* pbo = dynamic_cast<Timings*>(Pb::objFromPy(_self)); bool noTiming = _args.getOpt<bool>("notiming", -1, 0); pbPreparePlugin(pbo->getParent(), "Timings::stopProfile" , !noTiming); PyObject *_retval = 0; { ArgLocker _lock;  pbo->_args.copy(_args);  _retval = getPyNone(); pbo->stopProfile();  pbo->_args.check(); } pbFinalizePlugin(pbo->getParent(),"Timings::stopProfile" , !noTiming); return _retval; } catch(std::exception& e) { pbSetError("Timings::stopProfile",e.what()); return 0; } } public: PbArgs _args; }
 #define _C_Timings
 ;
 
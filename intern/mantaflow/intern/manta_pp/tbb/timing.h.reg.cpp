@@ -16,6 +16,8 @@ namespace Manta {
  static const Pb::Register _R_17 ("Timings","Timings",Timings::_W_0); 
  static const Pb::Register _R_18 ("Timings","display",Timings::_W_1); 
  static const Pb::Register _R_19 ("Timings","saveMean",Timings::_W_2); 
+ static const Pb::Register _R_20 ("Timings","startProfile",Timings::_W_3); 
+ static const Pb::Register _R_21 ("Timings","stopProfile",Timings::_W_4); 
 #endif
 extern "C" {
 void PbRegister_file_16()
@@ -24,5 +26,7 @@ void PbRegister_file_16()
 	KEEP_UNUSED(_R_17);
 	KEEP_UNUSED(_R_18);
 	KEEP_UNUSED(_R_19);
+	KEEP_UNUSED(_R_20);
+	KEEP_UNUSED(_R_21);
 }
 }}
\ No newline at end of file
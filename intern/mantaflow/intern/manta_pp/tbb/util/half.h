@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ * MantaFlow fluid solver framework
+ * Copyright 2011-2016 Tobias Pfaff, Nils Thuerey
+ *
+ * This program is free software, distributed under the terms of the
+ * GNU General Public License (GPL)
+ * http://www.gnu.org/licenses
+ *
+ * 16 bit floating point storage type
+ *
+ ******************************************************************************/
+
+#ifndef _HALF_H
+#define _HALF_H
+
+#include <string.h>
+#include <stdint.h>
+#include "vectorbase.h"
+
+namespace Manta {
+
+//! IEEE 754 half precision value, storage only
+//! all arithmetic goes through the implicit conversion to Real, i.e. values
+//! are converted on load and rounded (to nearest even) on store. Grid<Half>
+//! can be used for passive quantities to halve the memory bandwidth of
+//! kernels which mostly stream data, e.g. advection.
+class Half {
+public:
+	inline Half() : bits(0) {}
+	inline Half(const Real v) : bits(fromFloat((float)v)) {}
+
+	inline operator Real() const { return (Real)toFloat(bits); }
+
+	inline Half& operator+=(const Real v) { bits = fromFloat((float)(Real(*this) + v)); return *this; }
+	inline Half& operator-=(const Real v) { bits = fromFloat((float)(Real(*this) - v)); return *this; }
+	inline Half& operator*=(const Real v) { bits = fromFloat((float)(Real(*this) * v)); return *this; }
+	inline Half& operator/=(const Real v) { bits = fromFloat((float)(Real(*this) / v)); return *this; }
+
+	//! raw bit pattern
+	uint16_t bits;
+
+protected:
+	static inline uint32_t floatBits(const float f) { uint32_t u; memcpy(&u, &f, sizeof(u)); return u; }
+	static inline float bitsFloat(const uint32_t u) { float f; memcpy(&f, &u, sizeof(f)); return f; }
+
+	static inline float toFloat(const uint16_t h) {
+		// rebias exponent with a single multiply, also handles zero and denormals
+		uint32_t o = (uint32_t)(h & 0x7fff) << 13;
+		const float f = bitsFloat(o) * bitsFloat((254u - 15) << 23);
+		o = floatBits(f);
+		if (f >= bitsFloat((127u + 16) << 23)) {
+			// inf / nan
+			o |= 255u << 23;
+		}
+		return bitsFloat(o | ((uint32_t)(h & 0x8000) << 16));
+	}
+
+	static inline uint16_t fromFloat(const float f) {
+		uint32_t u = floatBits(f);
+		const uint32_t sign = u & 0x80000000u;
+		uint16_t o;
+		u ^= sign;
+		if (u >= (127u + 16) << 23) {
+			// overflow to inf, keep nans quiet
+			o = (u > 255u << 23) ? 0x7e00 : 0x7c00;
+		}
+		else if (u < 113u << 23) {
+			// denormal or zero, let the fpu do the rounding
+			const uint32_t denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+			o = (uint16_t)(floatBits(bitsFloat(u) + bitsFloat(denormMagic)) - denormMagic);
+		}
+		else {
+			// normal, round to nearest even
+			const uint32_t mantOdd = (u >> 13) & 1;
+			u += ((uint32_t)(15 - 127) << 23) + 0xfff + mantOdd;
+			o = (uint16_t)(u >> 13);
+		}
+		return o | (uint16_t)(sign >> 16);
+	}
+};
+
+//! type used for computations on values stored as T
+template<class T> struct ComputeType { typedef T type; };
+template<> struct ComputeType<Half> { typedef Real type; };
+
+template<> inline Half safeDivide<Half>(const Half& a, const Half& b) { return Half(safeDivide<Real>(a, b)); }
+
+} // namespace
+
+#endif
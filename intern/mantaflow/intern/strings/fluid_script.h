@@ -57,6 +57,32 @@ const std::string manta_debuglevel = "\n\
 def set_manta_debuglevel(level):\n\
     setDebugLevel(level=level)\n # level 0 = mute all output from manta\n";
 
+//////////////////////////////////////////////////////////////////////
+// FILE WRITER
+//////////////////////////////////////////////////////////////////////
+
+const std::string manta_file_writer = "\n\
+def set_manta_file_writer(threads, queue_size):\n\
+    setFileWriteThreads(threads=threads, queueSize=queue_size) # threads = 0 writes cache files synchronously\n";
+
+const std::string manta_flush_writes = "\n\
+try:\n\
+    flushFileWrites()\n\
+except Exception as e:\n\
+    mantaMsg(str(e))\n";
+
+//////////////////////////////////////////////////////////////////////
+// PROFILING
+//////////////////////////////////////////////////////////////////////
+
+const std::string manta_start_profile = "\n\
+def manta_start_profile(file, chrome_trace):\n\
+    Timings().startProfile(file=file, chromeTrace=chrome_trace, notiming=True)\n";
+
+const std::string manta_stop_profile = "\n\
+def manta_stop_profile():\n\
+    Timings().stopProfile(notiming=True)\n";
+
 //////////////////////////////////////////////////////////////////////
 // SOLVERS
 //////////////////////////////////////////////////////////////////////
@@ -281,6 +307,7 @@ fluid_particles_dict_s$ID$ = dict(ppSnd=ppSnd_sp$ID$, pVelSnd=pVelSnd_pp$ID$, pL
 
 const std::string fluid_pre_step = "\n\
 def fluid_pre_step_$ID$():\n\
+    global preconditioner_s$ID$\n\
     mantaMsg('Fluid pre step')\n\
     x_vel_s$ID$.clear()\n\
     y_vel_s$ID$.clear()\n\
@@ -315,7 +342,7 @@ def fluid_pre_step_$ID$():\n\
     # If obstacle has velocity, i.e. is a moving obstacle, switch to dynamic preconditioner\n\
     if using_smoke_s$ID$ and using_obstacle_s$ID$ and obvelC_s$ID$.getMax() > 0:\n\
         mantaMsg('Using dynamic preconditioner')\n\
-        preconditioner_s$ID$ = PcMGStatic\n\
+        preconditioner_s$ID$ = PcMGDynamic\n\
     else:\n\
         mantaMsg('Using static preconditioner')\n\
         preconditioner_s$ID$ = PcMGStatic\n";
@@ -345,6 +372,11 @@ def fluid_post_step_$ID$():\n\
 
 const std::string fluid_delete_all = "\n\
 mantaMsg('Deleting fluid')\n\
+# Make sure all cache files are on disk\n\
+try:\n\
+    flushFileWrites()\n\
+except Exception as e:\n\
+    mantaMsg(str(e))\n\
 # Clear all helper dictionaries first\n\
 mantaMsg('Clear helper dictionaries')\n\
 if 'liquid_data_dict_s$ID$' in globals(): liquid_data_dict_s$ID$.clear()\n\
@@ -366,10 +398,12 @@ for var in list(globals()):\n\
     if var.endswith('_s$ID$') or var.endswith('_sn$ID$') or var.endswith('_sm$ID$') or var.endswith('_sp$ID$') or var.endswith('_sg$ID$'):\n\
         del globals()[var]\n\
 \n\
-# Extra cleanup for multigrid and fluid guiding\n\
+# Extra cleanup for multigrid, surface turbulence and fluid guiding\n\
 mantaMsg('Release multigrid')\n\
 if 's$ID$' in globals(): releaseMG(s$ID$)\n\
 if 'sn$ID$' in globals(): releaseMG(sn$ID$)\n\
+mantaMsg('Release surface turbulence')\n\
+if 's$ID$' in globals(): releaseSurfaceTurbulence(s$ID$)\n\
 mantaMsg('Release fluid guiding')\n\
 releaseBlurPrecomp()\n\
 \n\
@@ -397,7 +431,15 @@ gc.collect()\n";
 
 const std::string fluid_cache_helper = "\n\
 def fluid_cache_get_framenr_formatted_$ID$(framenr):\n\
-    return str(framenr).zfill(4) # framenr with leading zeroes\n";
+    return str(framenr).zfill(4) # framenr with leading zeroes\n\
+\n\
+# Formats that store a whole grid dict in one file per frame, as (save, load) functions\n\
+def fluid_cache_multigrid_io_$ID$(file_format):\n\
+    if file_format == '.vdb':\n\
+        return saveGridsVDB, loadGridsVDB\n\
+    if file_format == '.mpc':\n\
+        return savePlaybackCache, loadPlaybackCache\n\
+    return None\n";
 
 const std::string fluid_bake_multiprocessing = "\n\
 def fluid_cache_multiprocessing_start_$ID$(function, framenr, format_data=None, format_noise=None, format_mesh=None, format_particles=None, format_guiding=None, path_data=None, path_noise=None, path_mesh=None, path_particles=None, path_guiding=None):\n\
@@ -542,9 +584,20 @@ def bake_guiding_$ID$(path_guiding, framenr, format_guiding):\n\
 //////////////////////////////////////////////////////////////////////
 
 const std::string fluid_file_import = "\n\
-def fluid_file_import_s$ID$(dict, path, framenr, file_format):\n\
+def fluid_file_import_s$ID$(dict, path, framenr, file_format, grids_name=None):\n\
     try:\n\
         framenr = fluid_cache_get_framenr_formatted_$ID$(framenr)\n\
+        # Grid dicts are stored in one multi-grid file per frame for OpenVDB and playback caches\n\
+        multigrid_io = fluid_cache_multigrid_io_$ID$(file_format)\n\
+        if multigrid_io and grids_name:\n\
+            file = os.path.join(path, grids_name + '_' + framenr + file_format)\n\
+            if os.path.isfile(file):\n\
+                multigrid_io[1](name=file, grids=list(dict.values()), names=','.join(dict.keys()))\n\
+                return\n\
+            if file_format != '.vdb':\n\
+                mantaMsg('Could not load file ' + str(file))\n\
+                return\n\
+            # Older OpenVDB caches have one file per grid\n\
         for name, object in dict.items():\n\
             file = os.path.join(path, name + '_' + framenr + file_format)\n\
             if os.path.isfile(file):\n\
@@ -563,27 +616,33 @@ def fluid_load_particles_$ID$(path, framenr, file_format):\n\
 const std::string fluid_load_data = "\n\
 def fluid_load_data_$ID$(path, framenr, file_format):\n\
     mantaMsg('Fluid load data, frame ' + str(framenr))\n\
-    fluid_file_import_s$ID$(dict=fluid_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_import_s$ID$(dict=fluid_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='fluid_data')\n";
 
 const std::string fluid_load_guiding = "\n\
 def fluid_load_guiding_$ID$(path, framenr, file_format):\n\
     mantaMsg('Fluid load guiding, frame ' + str(framenr))\n\
-    fluid_file_import_s$ID$(dict=fluid_guiding_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_import_s$ID$(dict=fluid_guiding_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='fluid_guiding')\n";
 
 const std::string fluid_load_vel = "\n\
 def fluid_load_vel_$ID$(path, framenr, file_format):\n\
     mantaMsg('Fluid load vel, frame ' + str(framenr))\n\
     vel_dict = dict(vel=guidevel_sg$ID$)\n\
-    fluid_file_import_s$ID$(dict=vel_dict, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_import_s$ID$(dict=vel_dict, path=path, framenr=framenr, file_format=file_format, grids_name='fluid_data')\n";
 
 //////////////////////////////////////////////////////////////////////
 // EXPORT
 //////////////////////////////////////////////////////////////////////
 
 const std::string fluid_file_export = "\n\
-def fluid_file_export_s$ID$(dict, path, framenr, file_format, mode_override=False):\n\
+def fluid_file_export_s$ID$(dict, path, framenr, file_format, mode_override=False, grids_name=None):\n\
     try:\n\
         framenr = fluid_cache_get_framenr_formatted_$ID$(framenr)\n\
+        # Grid dicts are stored in one multi-grid file per frame for OpenVDB and playback caches\n\
+        multigrid_io = fluid_cache_multigrid_io_$ID$(file_format)\n\
+        if multigrid_io and grids_name:\n\
+            file = os.path.join(path, grids_name + '_' + framenr + file_format)\n\
+            if not os.path.isfile(file) or mode_override: multigrid_io[0](name=file, grids=list(dict.values()), names=','.join(dict.keys()))\n\
+            return\n\
         for name, object in dict.items():\n\
             file = os.path.join(path, name + '_' + framenr + file_format)\n\
             if not os.path.isfile(file) or mode_override: object.save(file)\n\
@@ -599,12 +658,12 @@ def fluid_save_particles_$ID$(path, framenr, file_format):\n\
 const std::string fluid_save_data = "\n\
 def fluid_save_data_$ID$(path, framenr, file_format):\n\
     mantaMsg('Fluid save data, frame ' + str(framenr))\n\
-    fluid_file_export_s$ID$(dict=fluid_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_export_s$ID$(dict=fluid_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='fluid_data')\n";
 
 const std::string fluid_save_guiding = "\n\
 def fluid_save_guiding_$ID$(path, framenr, file_format):\n\
     mantaMsg('Fluid save guiding, frame ' + str(framenr))\n\
-    fluid_file_export_s$ID$(dict=fluid_guiding_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_export_s$ID$(dict=fluid_guiding_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='fluid_guiding')\n";
 
 //////////////////////////////////////////////////////////////////////
 // STANDALONE MODE
@@ -49,7 +49,9 @@ concaveLower_s$ID$     = $MESH_CONCAVE_LOWER$\n\
 smoothenPos_s$ID$      = $MESH_SMOOTHEN_POS$\n\
 smoothenNeg_s$ID$      = $MESH_SMOOTHEN_NEG$\n\
 randomness_s$ID$       = $PARTICLE_RANDOMNESS$\n\
-surfaceTension_s$ID$   = $LIQUID_SURFACE_TENSION$\n";
+surfaceTension_s$ID$   = $LIQUID_SURFACE_TENSION$\n\
+reorderInterval_s$ID$  = 4 # sort particles into cell order every n steps, 0 to disable\n\
+reorderCount_s$ID$     = 0\n";
 
 //////////////////////////////////////////////////////////////////////
 // GRIDS & MESH & PARTICLESYSTEM
@@ -149,6 +151,7 @@ def liquid_adaptive_step_$ID$(framenr):\n\
 
 const std::string liquid_step = "\n\
 def liquid_step_$ID$():\n\
+    global reorderCount_s$ID$\n\
     mantaMsg('Liquid step')\n\
     \n\
     mantaMsg('Advecting particles')\n\
@@ -166,6 +169,9 @@ def liquid_step_$ID$():\n\
     \n\
     # create level set of particles\n\
     gridParticleIndex(parts=pp_s$ID$, flags=flags_s$ID$, indexSys=pindex_s$ID$, index=gpi_s$ID$)\n\
+    if reorderInterval_s$ID$ > 0 and reorderCount_s$ID$ % reorderInterval_s$ID$ == 0:\n\
+        reorderParticles(parts=pp_s$ID$, indexSys=pindex_s$ID$, index=gpi_s$ID$)\n\
+    reorderCount_s$ID$ += 1\n\
     unionParticleLevelset(pp_s$ID$, pindex_s$ID$, flags_s$ID$, gpi_s$ID$, phiParts_s$ID$)\n\
     \n\
     # combine level set of particles with grid level set\n\
@@ -293,7 +299,7 @@ def liquid_step_particles_$ID$():\n\
 const std::string liquid_load_data = "\n\
 def liquid_load_data_$ID$(path, framenr, file_format):\n\
     mantaMsg('Liquid load data')\n\
-    fluid_file_import_s$ID$(dict=liquid_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_import_s$ID$(dict=liquid_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='liquid_data')\n";
 
 const std::string liquid_load_flip = "\n\
 def liquid_load_flip_$ID$(path, framenr, file_format):\n\
@@ -317,7 +323,7 @@ def liquid_load_meshvel_$ID$(path, framenr, file_format):\n\
 const std::string liquid_save_data = "\n\
 def liquid_save_data_$ID$(path, framenr, file_format):\n\
     mantaMsg('Liquid save data')\n\
-    fluid_file_export_s$ID$(dict=liquid_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_export_s$ID$(dict=liquid_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='liquid_data')\n";
 
 const std::string liquid_save_flip = "\n\
 def liquid_save_flip_$ID$(path, framenr, file_format):\n\
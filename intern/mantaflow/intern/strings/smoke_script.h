@@ -296,23 +296,17 @@ def smoke_adaptive_step_noise_$ID$(framenr):\n\
 const std::string smoke_step = "\n\
 def smoke_step_$ID$():\n\
     mantaMsg('Smoke step low')\n\
-    mantaMsg('Advecting density')\n\
-    advectSemiLagrange(flags=flags_s$ID$, vel=vel_s$ID$, grid=density_s$ID$, order=$ADVECT_ORDER$)\n\
-    \n\
+    # all scalar fields share one back-trace through vel\n\
+    advectGrids_s$ID$ = [density_s$ID$]\n\
     if using_heat_s$ID$:\n\
-        mantaMsg('Advecting heat')\n\
-        advectSemiLagrange(flags=flags_s$ID$, vel=vel_s$ID$, grid=heat_s$ID$, order=$ADVECT_ORDER$)\n\
-    \n\
+        advectGrids_s$ID$ += [heat_s$ID$]\n\
     if using_fire_s$ID$:\n\
-        mantaMsg('Advecting fire')\n\
-        advectSemiLagrange(flags=flags_s$ID$, vel=vel_s$ID$, grid=fuel_s$ID$, order=$ADVECT_ORDER$)\n\
-        advectSemiLagrange(flags=flags_s$ID$, vel=vel_s$ID$, grid=react_s$ID$, order=$ADVECT_ORDER$)\n\
-    \n\
+        advectGrids_s$ID$ += [fuel_s$ID$, react_s$ID$]\n\
     if using_colors_s$ID$:\n\
-        mantaMsg('Advecting colors')\n\
-        advectSemiLagrange(flags=flags_s$ID$, vel=vel_s$ID$, grid=color_r_s$ID$, order=$ADVECT_ORDER$)\n\
-        advectSemiLagrange(flags=flags_s$ID$, vel=vel_s$ID$, grid=color_g_s$ID$, order=$ADVECT_ORDER$)\n\
-        advectSemiLagrange(flags=flags_s$ID$, vel=vel_s$ID$, grid=color_b_s$ID$, order=$ADVECT_ORDER$)\n\
+        advectGrids_s$ID$ += [color_r_s$ID$, color_g_s$ID$, color_b_s$ID$]\n\
+    \n\
+    mantaMsg('Advecting density, heat, fire and colors')\n\
+    advectSemiLagrangeMulti(flags=flags_s$ID$, vel=vel_s$ID$, grids=advectGrids_s$ID$, order=$ADVECT_ORDER$)\n\
     \n\
     mantaMsg('Advecting velocity')\n\
     advectSemiLagrange(flags=flags_s$ID$, vel=vel_s$ID$, grid=vel_s$ID$, order=$ADVECT_ORDER$, openBounds=doOpen_s$ID$, boundaryWidth=boundaryWidth_s$ID$)\n\
@@ -396,20 +390,15 @@ def step_noise_$ID$():\n\
         sStr_s$ID$ *= 0.06 # magic kolmogorov factor \n\
         sPos_s$ID$ *= 2.0 \n\
     \n\
+    advectGrids_sn$ID$ = [density_sn$ID$]\n\
+    if using_fire_s$ID$:\n\
+        advectGrids_sn$ID$ += [fuel_sn$ID$, react_sn$ID$]\n\
+    if using_colors_s$ID$:\n\
+        advectGrids_sn$ID$ += [color_r_sn$ID$, color_g_sn$ID$, color_b_sn$ID$]\n\
+    \n\
     for substep in range(int(upres_sn$ID$)):\n\
-        if using_colors_s$ID$: \n\
-            mantaMsg('Advecting colors noise')\n\
-            advectSemiLagrange(flags=flags_sn$ID$, vel=vel_sn$ID$, grid=color_r_sn$ID$, order=$ADVECT_ORDER$, openBounds=doOpen_s$ID$)\n\
-            advectSemiLagrange(flags=flags_sn$ID$, vel=vel_sn$ID$, grid=color_g_sn$ID$, order=$ADVECT_ORDER$, openBounds=doOpen_s$ID$)\n\
-            advectSemiLagrange(flags=flags_sn$ID$, vel=vel_sn$ID$, grid=color_b_sn$ID$, order=$ADVECT_ORDER$, openBounds=doOpen_s$ID$)\n\
-        \n\
-        if using_fire_s$ID$: \n\
-            mantaMsg('Advecting fire noise')\n\
-            advectSemiLagrange(flags=flags_sn$ID$, vel=vel_sn$ID$, grid=fuel_sn$ID$, order=$ADVECT_ORDER$, openBounds=doOpen_s$ID$)\n\
-            advectSemiLagrange(flags=flags_sn$ID$, vel=vel_sn$ID$, grid=react_sn$ID$, order=$ADVECT_ORDER$, openBounds=doOpen_s$ID$)\n\
-        \n\
-        mantaMsg('Advecting density noise')\n\
-        advectSemiLagrange(flags=flags_sn$ID$, vel=vel_sn$ID$, grid=density_sn$ID$, order=$ADVECT_ORDER$, openBounds=doOpen_s$ID$)\n\
+        mantaMsg('Advecting density, fire and colors noise')\n\
+        advectSemiLagrangeMulti(flags=flags_sn$ID$, vel=vel_sn$ID$, grids=advectGrids_sn$ID$, order=$ADVECT_ORDER$)\n\
 \n\
 def process_burn_noise_$ID$():\n\
     mantaMsg('Process burn noise')\n\
@@ -426,12 +415,12 @@ def update_flame_noise_$ID$():\n\
 const std::string smoke_load_data = "\n\
 def smoke_load_data_$ID$(path, framenr, file_format):\n\
     mantaMsg('Smoke load data')\n\
-    fluid_file_import_s$ID$(dict=smoke_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_import_s$ID$(dict=smoke_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='smoke_data')\n";
 
 const std::string smoke_load_noise = "\n\
 def smoke_load_noise_$ID$(path, framenr, file_format):\n\
     mantaMsg('Smoke load noise')\n\
-    fluid_file_import_s$ID$(dict=smoke_noise_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_import_s$ID$(dict=smoke_noise_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='smoke_noise')\n";
 
 //////////////////////////////////////////////////////////////////////
 // EXPORT
@@ -440,12 +429,12 @@ def smoke_load_noise_$ID$(path, framenr, file_format):\n\
 const std::string smoke_save_data = "\n\
 def smoke_save_data_$ID$(path, framenr, file_format):\n\
     mantaMsg('Smoke save data')\n\
-    fluid_file_export_s$ID$(dict=smoke_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_export_s$ID$(dict=smoke_data_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='smoke_data')\n";
 
 const std::string smoke_save_noise = "\n\
 def smoke_save_noise_$ID$(path, framenr, file_format):\n\
     mantaMsg('Smoke save noise')\n\
-    fluid_file_export_s$ID$(dict=smoke_noise_dict_s$ID$, path=path, framenr=framenr, file_format=file_format)\n";
+    fluid_file_export_s$ID$(dict=smoke_noise_dict_s$ID$, path=path, framenr=framenr, file_format=file_format, grids_name='smoke_noise')\n";
 
 //////////////////////////////////////////////////////////////////////
 // STANDALONE MODE
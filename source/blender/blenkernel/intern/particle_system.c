@@ -3836,10 +3836,12 @@ static void particles_manta_step(
 			ParticleSettings *part = psys->part;
 			ParticleData *pa=NULL;
 
-			int p, totpart, tottypepart = 0;
+			int p, totpart = 0, tottypepart = 0;
 			int flagActivePart, activeParts = 0;
 			float posX, posY, posZ, velX, velY, velZ;
 			float resX, resY, resZ;
+			int *flags;
+			float *positions, *velocities;
 			int upres[3] = {1};
 			char debugStrBuffer[256];
 
@@ -3863,10 +3865,30 @@ static void particles_manta_step(
 			}
 			if (part->type == PART_MANTA_SPRAY || part->type == PART_MANTA_BUBBLE || part->type == PART_MANTA_FOAM || part->type == PART_MANTA_TRACER) {
 				totpart = liquid_get_num_snd_particles(sds->fluid);
+			}
+
+			// Sanity check: no particle files present yet
+			if (!totpart)
+				return;
+
+			// Fetch all particle data at once instead of querying the fluid object per particle
+			flags      = MEM_calloc_arrayN(totpart, sizeof(int), "manta_particle_flags");
+			positions  = MEM_calloc_arrayN(totpart, sizeof(float[3]), "manta_particle_positions");
+			velocities = MEM_calloc_arrayN(totpart, sizeof(float[3]), "manta_particle_velocities");
+
+			if (part->type == PART_MANTA_FLIP) {
+				liquid_get_flip_particle_flags(sds->fluid, flags, totpart, sizeof(int));
+				liquid_get_flip_particle_positions(sds->fluid, positions, totpart, sizeof(float[3]));
+				liquid_get_flip_particle_velocities(sds->fluid, velocities, totpart, sizeof(float[3]));
+			}
+			else {
+				liquid_get_snd_particle_flags(sds->fluid, flags, totpart, sizeof(int));
+				liquid_get_snd_particle_positions(sds->fluid, positions, totpart, sizeof(float[3]));
+				liquid_get_snd_particle_velocities(sds->fluid, velocities, totpart, sizeof(float[3]));
 
 				// tottypepart is the amount of particles of a snd particle type
 				for (p=0; p<totpart; p++) {
-					flagActivePart = liquid_get_snd_particle_flag_at(sds->fluid, p);
+					flagActivePart = flags[p];
 					if ((part->type == PART_MANTA_SPRAY) && (flagActivePart & PSPRAY)) tottypepart++;
 					if ((part->type == PART_MANTA_BUBBLE) && (flagActivePart & PBUBBLE)) tottypepart++;
 					if ((part->type == PART_MANTA_FOAM) && (flagActivePart & PFOAM)) tottypepart++;
@@ -3874,9 +3896,13 @@ static void particles_manta_step(
 				}
 			}
 
-			// Sanity check: no particle files present yet
-			if (!tottypepart)
+			// Sanity check: no particles of this type present yet
+			if (!tottypepart) {
+				MEM_freeN(flags);
+				MEM_freeN(positions);
+				MEM_freeN(velocities);
 				return;
+			}
 
 			tottypepart = (use_render_params) ? tottypepart : (part->disp*tottypepart) / 100;
 
@@ -3890,8 +3916,9 @@ static void particles_manta_step(
 
 			for (p=0, pa=psys->particles; p<totpart; p++) {
 
+				flagActivePart = flags[p];
+
 				if (part->type == PART_MANTA_FLIP) {
-					flagActivePart = liquid_get_flip_particle_flag_at(sds->fluid, p);
 
 //					// Upres FLIP have custom (upscaled) res values
 					// TODO (sebbas): Future option might load highres FLIP particle system
@@ -3912,8 +3939,6 @@ static void particles_manta_step(
 					}
 				}
 				else if (part->type == PART_MANTA_SPRAY || part->type == PART_MANTA_BUBBLE || part->type == PART_MANTA_FOAM || part->type == PART_MANTA_TRACER) {
-					flagActivePart = liquid_get_snd_particle_flag_at(sds->fluid, p);
-
 					resX = (float) liquid_get_particle_res_x(sds->fluid);
 					resY = (float) liquid_get_particle_res_y(sds->fluid);
 					resZ = (float) liquid_get_particle_res_z(sds->fluid);
@@ -3922,7 +3947,7 @@ static void particles_manta_step(
 				}
 				else {
 					BLI_snprintf(debugStrBuffer, sizeof(debugStrBuffer), "particles_manta_step::error - unknown particle system type\n");
-					return;
+					break;
 				}
 				// printf("part->type: %d, flagActivePart: %d\n", part->type, flagActivePart);
 
@@ -3934,22 +3959,12 @@ static void particles_manta_step(
 
 				// printf("system type is %d and particle type is %d\n", part->type, flagActivePart);
 
-				if (part->type == PART_MANTA_FLIP) {
-					posX = liquid_get_flip_particle_position_x_at(sds->fluid, p);
-					posY = liquid_get_flip_particle_position_y_at(sds->fluid, p);
-					posZ = liquid_get_flip_particle_position_z_at(sds->fluid, p);
-					velX = liquid_get_flip_particle_velocity_x_at(sds->fluid, p);
-					velY = liquid_get_flip_particle_velocity_y_at(sds->fluid, p);
-					velZ = liquid_get_flip_particle_velocity_z_at(sds->fluid, p);
-				}
-				else if (part->type == PART_MANTA_SPRAY || part->type == PART_MANTA_BUBBLE || part->type == PART_MANTA_FOAM || part->type == PART_MANTA_TRACER) {
-					posX = liquid_get_snd_particle_position_x_at(sds->fluid, p);
-					posY = liquid_get_snd_particle_position_y_at(sds->fluid, p);
-					posZ = liquid_get_snd_particle_position_z_at(sds->fluid, p);
-					velX = liquid_get_snd_particle_velocity_x_at(sds->fluid, p);
-					velY = liquid_get_snd_particle_velocity_y_at(sds->fluid, p);
-					velZ = liquid_get_snd_particle_velocity_z_at(sds->fluid, p);
-				}
+				posX = positions[p * 3];
+				posY = positions[p * 3 + 1];
+				posZ = positions[p * 3 + 2];
+				velX = velocities[p * 3];
+				velY = velocities[p * 3 + 1];
+				velZ = velocities[p * 3 + 2];
 
 				// Only show active particles, i.e. filter out dead particles that just Mantaflow needs
 				if ((flagActivePart & PDELETE)==0) { // mantaflow convention: PDELETE == inactive particle
@@ -4011,6 +4026,10 @@ static void particles_manta_step(
 				// Increase particle setting here. totpart may be larger (snd parts)
 				pa++;
 			}
+			MEM_freeN(flags);
+			MEM_freeN(positions);
+			MEM_freeN(velocities);
+
 			// printf("active parts: %d\n", activeParts);
 			totpart = psys->totpart = part->totpart = activeParts;
 
@@ -879,8 +879,6 @@ void smokeModifier_copy(const struct SmokeModifierData *smd, struct SmokeModifie
 
 // forward decleration
 static void smoke_calc_transparency(SmokeDomainSettings *sds, Scene *scene);
-static float calc_voxel_transp(float *result, float *input, int res[3], int *pixel, float *tRay, float correct);
-static void update_mesh_distances(int index, float *mesh_distances, BVHTreeFromMesh *treeData, const float ray_start[3], float surface_thickness);
 
 static int get_lamp(Scene *scene, float *light)
 {
@@ -906,6 +904,316 @@ static int get_lamp(Scene *scene, float *light)
 	return found_lamp;
 }
 
+/**********************************************************
+ *	Mesh to levelset
+ **********************************************************/
+
+/* Width in cells of the band around the surface with exact distances and closest triangles.
+ * Needs to cover the surface distance used for obstacle velocities. */
+#define MESH_SDF_BAND 2.0f
+
+typedef struct MeshSDFData {
+	const MVert *mvert;
+	const MLoop *mloop;
+	const MLoopTri *looptri;
+	const int *min, *res;
+
+	/* triangles per z-layer (band) or per y-row (winding), bucket_start has res + 1 entries */
+	int *bucket_start, *bucket_tris;
+	int axis;
+
+	float *dist;
+	int *tri;
+} MeshSDFData;
+
+static void mesh_sdf_tri_co(const MeshSDFData *data, int t, const float *r_co[3])
+{
+	const MLoopTri *lt = &data->looptri[t];
+	r_co[0] = data->mvert[data->mloop[lt->tri[0]].v].co;
+	r_co[1] = data->mvert[data->mloop[lt->tri[1]].v].co;
+	r_co[2] = data->mvert[data->mloop[lt->tri[2]].v].co;
+}
+
+/* Range of cells along axis whose centers are within pad of the triangle bounds. */
+static bool mesh_sdf_cell_range(const MeshSDFData *data, const float *co[3], int axis, float pad, int *r_lo, int *r_hi)
+{
+	const float co_min = min_fff(co[0][axis], co[1][axis], co[2][axis]);
+	const float co_max = max_fff(co[0][axis], co[1][axis], co[2][axis]);
+
+	/* cell centers are at min + i + 0.5 */
+	*r_lo = max_ii((int)ceilf(co_min - pad - 0.5f) - data->min[axis], 0);
+	*r_hi = min_ii((int)floorf(co_max + pad - 0.5f) - data->min[axis], data->res[axis] - 1);
+	return *r_lo <= *r_hi;
+}
+
+static void mesh_sdf_bucket_tris(MeshSDFData *data, int numtris, int axis, float pad)
+{
+	const int n = data->res[axis];
+	int *start = MEM_callocN(sizeof(int) * (n + 1), "mesh_sdf_bucket_start");
+	int *fill, *tris;
+	int t, i, lo, hi;
+
+	for (t = 0; t < numtris; t++) {
+		const float *co[3];
+		mesh_sdf_tri_co(data, t, co);
+		if (mesh_sdf_cell_range(data, co, axis, pad, &lo, &hi)) {
+			for (i = lo; i <= hi; i++) start[i + 1]++;
+		}
+	}
+	for (i = 0; i < n; i++) start[i + 1] += start[i];
+
+	tris = MEM_mallocN(sizeof(int) * max_ii(start[n], 1), "mesh_sdf_bucket_tris");
+	fill = MEM_dupallocN(start);
+	for (t = 0; t < numtris; t++) {
+		const float *co[3];
+		mesh_sdf_tri_co(data, t, co);
+		if (mesh_sdf_cell_range(data, co, axis, pad, &lo, &hi)) {
+			for (i = lo; i <= hi; i++) tris[fill[i]++] = t;
+		}
+	}
+	MEM_freeN(fill);
+
+	data->bucket_start = start;
+	data->bucket_tris = tris;
+	data->axis = axis;
+}
+
+static void mesh_sdf_free_buckets(MeshSDFData *data)
+{
+	MEM_SAFE_FREE(data->bucket_start);
+	MEM_SAFE_FREE(data->bucket_tris);
+}
+
+/* Exact distances for all cells of one z-layer within the band of a triangle. */
+static void mesh_sdf_band_task_cb(
+        void *__restrict userdata,
+        const int z,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	MeshSDFData *data = userdata;
+	const int *min = data->min, *res = data->res;
+
+	for (int b = data->bucket_start[z]; b < data->bucket_start[z + 1]; b++) {
+		const int t = data->bucket_tris[b];
+		const float *co[3];
+		int lo[2], hi[2];
+
+		mesh_sdf_tri_co(data, t, co);
+		if (!mesh_sdf_cell_range(data, co, 0, MESH_SDF_BAND, &lo[0], &hi[0]) ||
+		    !mesh_sdf_cell_range(data, co, 1, MESH_SDF_BAND, &lo[1], &hi[1]))
+		{
+			continue;
+		}
+
+		for (int y = lo[1]; y <= hi[1]; y++) {
+			for (int x = lo[0]; x <= hi[0]; x++) {
+				const int index = fluid_get_index(x, res[0], y, res[1], z);
+				const float pos[3] = {min[0] + x + 0.5f, min[1] + y + 0.5f, min[2] + z + 0.5f};
+				float nearest[3];
+
+				closest_on_tri_to_point_v3(nearest, pos, co[0], co[1], co[2]);
+				const float dist = len_v3v3(nearest, pos);
+				if (dist < data->dist[index]) {
+					data->dist[index] = dist;
+					data->tri[index] = t;
+				}
+			}
+		}
+	}
+}
+
+/* Robust 2D orientation test with consistent tie breaking for points on edges and vertices,
+ * so that a ray through a shared edge or vertex is only counted once. */
+static int mesh_sdf_orientation(double x1, double y1, double x2, double y2, double *r_twice_signed_area)
+{
+	*r_twice_signed_area = y1 * x2 - x1 * y2;
+	if (*r_twice_signed_area > 0) return 1;
+	else if (*r_twice_signed_area < 0) return -1;
+	else if (y2 > y1) return 1;
+	else if (y2 < y1) return -1;
+	else if (x1 > x2) return 1;
+	else if (x1 < x2) return -1;
+	return 0;
+}
+
+/* Barycentric weights of (x0, y0) in the projected triangle, returns 0 if outside, otherwise
+ * 1 for triangles facing +z and -1 for triangles facing -z. */
+static int mesh_sdf_point_in_tri_2d(double x0, double y0, const float *co[3], double r_bary[3])
+{
+	const double x1 = co[0][0] - x0, y1 = co[0][1] - y0;
+	const double x2 = co[1][0] - x0, y2 = co[1][1] - y0;
+	const double x3 = co[2][0] - x0, y3 = co[2][1] - y0;
+
+	const int sign_a = mesh_sdf_orientation(x2, y2, x3, y3, &r_bary[0]);
+	if (sign_a == 0) return 0;
+	const int sign_b = mesh_sdf_orientation(x3, y3, x1, y1, &r_bary[1]);
+	if (sign_b != sign_a) return 0;
+	const int sign_c = mesh_sdf_orientation(x1, y1, x2, y2, &r_bary[2]);
+	if (sign_c != sign_a) return 0;
+
+	const double sum = r_bary[0] + r_bary[1] + r_bary[2];
+	if (sum == 0.0) return 0;
+	r_bary[0] /= sum;
+	r_bary[1] /= sum;
+	r_bary[2] /= sum;
+	return (sum < 0.0) ? 1 : -1;
+}
+
+/* Sign for all cells of one y-row: count the triangles crossed along z by each column of cells,
+ * weighted by their facing. A cell is inside if it has more entering than leaving crossings
+ * below and above, so open meshes (e.g. planes) do not mark a whole half space as inside. */
+static void mesh_sdf_sign_task_cb(
+        void *__restrict userdata,
+        const int y,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	MeshSDFData *data = userdata;
+	const int *min = data->min, *res = data->res;
+	const int nz = res[2] + 1;
+	int *winding = MEM_callocN(sizeof(int) * res[0] * nz, "mesh_sdf_winding");
+
+	/* crossing between cell centers z - 1 and z is stored at z */
+	for (int b = data->bucket_start[y]; b < data->bucket_start[y + 1]; b++) {
+		const int t = data->bucket_tris[b];
+		const float *co[3];
+		int lo, hi;
+
+		mesh_sdf_tri_co(data, t, co);
+		if (!mesh_sdf_cell_range(data, co, 0, 0.0f, &lo, &hi)) continue;
+
+		for (int x = lo; x <= hi; x++) {
+			double bary[3];
+			const int facing = mesh_sdf_point_in_tri_2d(min[0] + x + 0.5, min[1] + y + 0.5, co, bary);
+			if (facing == 0) continue;
+
+			const double hit_z = bary[0] * co[0][2] + bary[1] * co[1][2] + bary[2] * co[2][2];
+			int z = (int)ceil(hit_z - 0.5 - min[2]);
+			CLAMP(z, 0, res[2]);
+			winding[x * nz + z] += facing;
+		}
+	}
+
+	for (int x = 0; x < res[0]; x++) {
+		const int *w = &winding[x * nz];
+		int total = 0, below = 0;
+
+		for (int z = 0; z < nz; z++) total += w[z];
+		for (int z = 0; z < res[2]; z++) {
+			/* entering crossings below face -z, entering crossings above face +z */
+			below += w[z];
+			if (-below > 0 && total - below > 0) {
+				const int index = fluid_get_index(x, res[0], y, res[1], z);
+				data->dist[index] = -data->dist[index];
+			}
+		}
+	}
+
+	MEM_freeN(winding);
+}
+
+/* Propagate closest triangles along the grid lines of one layer, forward and backward. */
+static void mesh_sdf_sweep_task_cb(
+        void *__restrict userdata,
+        const int layer,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	MeshSDFData *data = userdata;
+	const int *min = data->min, *res = data->res;
+	const int axis = data->axis;
+	/* lines along x and y are processed per z-layer, lines along z per y-row */
+	const int other = (axis == 0) ? 1 : 0;
+	const int stride[3] = {1, res[0], res[0] * res[1]};
+	const int n = res[axis];
+
+	for (int l = 0; l < res[other]; l++) {
+		int cell[3];
+		cell[axis] = 0;
+		cell[other] = l;
+		cell[3 - axis - other] = layer;
+		const int start = fluid_get_index(cell[0], res[0], cell[1], res[1], cell[2]);
+
+		for (int dir = 1; dir >= -1; dir -= 2) {
+			for (int i = (dir > 0) ? 1 : n - 2; i >= 0 && i < n; i += dir) {
+				const int index = start + i * stride[axis];
+				const int prev = index - dir * stride[axis];
+				const int t = data->tri[prev];
+
+				/* band cells are exact already, and the distance to t can't be less than the
+				 * distance of the previous cell minus one */
+				if (t == -1 || t == data->tri[index] || fabsf(data->dist[index]) <= MESH_SDF_BAND ||
+				    fabsf(data->dist[prev]) - 1.0f >= fabsf(data->dist[index]))
+				{
+					continue;
+				}
+
+				const float *co[3];
+				float pos[3], nearest[3];
+				mesh_sdf_tri_co(data, t, co);
+				cell[axis] = i;
+				pos[0] = min[0] + cell[0] + 0.5f;
+				pos[1] = min[1] + cell[1] + 0.5f;
+				pos[2] = min[2] + cell[2] + 0.5f;
+				closest_on_tri_to_point_v3(nearest, pos, co[0], co[1], co[2]);
+
+				const float dist = len_v3v3(nearest, pos);
+				if (dist < fabsf(data->dist[index])) {
+					data->dist[index] = (data->dist[index] < 0.0f) ? -dist : dist;
+					data->tri[index] = t;
+				}
+			}
+		}
+	}
+}
+
+/* Signed distances from a triangle mesh (vertices in domain cell space) for the cells of the
+ * grid region min .. min + res, negative inside. Triangles are rasterized into a narrow band
+ * with exact distances, the sign comes from crossings along z and, if full is set, the
+ * remaining cells get the distance to the closest triangle propagated by axis sweeps.
+ * Without full, cells outside the band are FLT_MAX and unsigned. r_tri (optional) returns the
+ * closest triangle of each cell or -1. */
+static void mesh_sdf_compute(
+        const MVert *mvert, const MLoop *mloop, const MLoopTri *looptri, int numtris,
+        const int min[3], const int res[3], bool full, float *r_dist, int *r_tri)
+{
+	const int total_cells = res[0] * res[1] * res[2];
+	int *tri = r_tri ? r_tri : MEM_mallocN(sizeof(int) * total_cells, "mesh_sdf_tri");
+	int i;
+
+	MeshSDFData data = {
+	    .mvert = mvert, .mloop = mloop, .looptri = looptri,
+	    .min = min, .res = res, .dist = r_dist, .tri = tri,
+	};
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+
+	for (i = 0; i < total_cells; i++) {
+		r_dist[i] = FLT_MAX;
+		tri[i] = -1;
+	}
+
+	/* exact distances in the band, per z-layer */
+	mesh_sdf_bucket_tris(&data, numtris, 2, MESH_SDF_BAND);
+	BLI_task_parallel_range(0, res[2], &data, mesh_sdf_band_task_cb, &settings);
+	mesh_sdf_free_buckets(&data);
+
+	if (full) {
+		/* inside / outside, per y-row */
+		mesh_sdf_bucket_tris(&data, numtris, 1, 0.0f);
+		BLI_task_parallel_range(0, res[1], &data, mesh_sdf_sign_task_cb, &settings);
+		mesh_sdf_free_buckets(&data);
+
+		/* fill the rest, x and y lines per z-layer, z lines per y-row. The first round reaches
+		 * every cell, the second one corrects most of the error of axis-only propagation */
+		for (int round = 0; round < 6; round++) {
+			data.axis = round % 3;
+			BLI_task_parallel_range(0, res[(data.axis == 2) ? 1 : 2], &data, mesh_sdf_sweep_task_cb, &settings);
+		}
+	}
+
+	if (!r_tri) MEM_freeN(tri);
+}
+
 /**********************************************************
  *	Obstacles
  **********************************************************/
@@ -916,7 +1224,8 @@ typedef struct ObstaclesFromDMData {
 	const MVert *mvert;
 	const MLoop *mloop;
 	const MLoopTri *looptri;
-	BVHTreeFromMesh *tree;
+	const float *mesh_distances;
+	const int *mesh_tris;
 
 	bool has_velocity;
 	float *vert_vel;
@@ -942,22 +1251,21 @@ static void obstacles_from_derivedmesh_task_cb(
 			const int index = fluid_get_index(x - sds->res_min[0], sds->res[0], y - sds->res_min[1], sds->res[1], z - sds->res_min[2]);
 
 			float ray_start[3] = {(float)x + 0.5f, (float)y + 0.5f, (float)z + 0.5f};
-			BVHTreeNearest nearest = {0};
-			nearest.index = -1;
-			nearest.dist_sq = surface_distance * surface_distance; /* find_nearest uses squared distance */
+			const int nearest_tri = data->mesh_tris[index];
 			bool hasIncObj = false;
 
-			/* find the nearest point on the mesh */
-			if (BLI_bvhtree_find_nearest(data->tree->tree, ray_start, &nearest, data->tree->nearest_callback, data->tree) != -1) {
-				const MLoopTri *lt = &data->looptri[nearest.index];
-				float weights[3];
+			/* nearest point on the mesh, the closest triangle is exact within the band */
+			if (nearest_tri != -1 && fabsf(data->mesh_distances[index]) <= surface_distance) {
+				const MLoopTri *lt = &data->looptri[nearest_tri];
+				float nearest[3], weights[3];
 				int v1, v2, v3;
 
 				/* calculate barycentric weights for nearest point */
 				v1 = data->mloop[lt->tri[0]].v;
 				v2 = data->mloop[lt->tri[1]].v;
 				v3 = data->mloop[lt->tri[2]].v;
-				interp_weights_tri_v3(weights, data->mvert[v1].co, data->mvert[v2].co, data->mvert[v3].co, nearest.co);
+				closest_on_tri_to_point_v3(nearest, ray_start, data->mvert[v1].co, data->mvert[v2].co, data->mvert[v3].co);
+				interp_weights_tri_v3(weights, data->mvert[v1].co, data->mvert[v2].co, data->mvert[v3].co, nearest);
 
 				if (data->has_velocity)
 				{
@@ -1011,7 +1319,7 @@ static void obstacles_from_derivedmesh_task_cb(
 
 			/* Get distance to mesh surface from both within and outside grid (mantaflow phi grid) */
 			if (data->distances_map) {
-				update_mesh_distances(index, data->distances_map, data->tree, ray_start, data->scs->surface_distance);
+				data->distances_map[index] = MIN2(data->distances_map[index], data->mesh_distances[index] - data->scs->surface_distance);
 
 				/* Ensure that num objects are also counted inside object. But dont count twice (see object inc for nearest point) */
 				if (data->distances_map[index] < 0 && !hasIncObj) {
@@ -1032,8 +1340,7 @@ static void obstacles_from_derivedmesh(
 		MVert *mvert = NULL;
 		const MLoopTri *looptri;
 		const MLoop *mloop;
-		BVHTreeFromMesh treeData = {NULL};
-		int numverts, i;
+		int numverts, numtris, i;
 
 		float *vert_vel = NULL;
 		bool has_velocity = false;
@@ -1044,6 +1351,7 @@ static void obstacles_from_derivedmesh(
 		mloop = dm->getLoopArray(dm);
 		looptri = dm->getLoopTriArray(dm);
 		numverts = dm->getNumVerts(dm);
+		numtris = dm->getNumLoopTri(dm);
 
 		/* TODO (sebbas):
 		 * Make vert_vel init optional?
@@ -1087,10 +1395,17 @@ static void obstacles_from_derivedmesh(
 			copy_v3_v3(&scs->verts_old[i * 3], co);
 		}
 
-		if (bvhtree_from_mesh_get(&treeData, dm, BVHTREE_FROM_LOOPTRI, 4)) {
+		if (numtris > 0) {
+			/* signed distances and closest triangles of all domain cells,
+			 * the sign and far field are only needed for the levelset */
+			float *mesh_distances = MEM_mallocN(sizeof(float) * sds->total_cells, "fluid_obs_mesh_distances");
+			int *mesh_tris = MEM_mallocN(sizeof(int) * sds->total_cells, "fluid_obs_mesh_tris");
+			mesh_sdf_compute(mvert, mloop, looptri, numtris, sds->res_min, sds->res, distances_map != NULL, mesh_distances, mesh_tris);
+
 			ObstaclesFromDMData data = {
 			    .sds = sds, .scs = scs, .mvert = mvert, .mloop = mloop, .looptri = looptri,
-			    .tree = &treeData, .has_velocity = has_velocity, .vert_vel = vert_vel,
+			    .mesh_distances = mesh_distances, .mesh_tris = mesh_tris,
+			    .has_velocity = has_velocity, .vert_vel = vert_vel,
 			    .velocityX = velocityX, .velocityY = velocityY, .velocityZ = velocityZ,
 			    .num_objects = num_objects, .distances_map = distances_map
 			};
@@ -1101,9 +1416,10 @@ static void obstacles_from_derivedmesh(
 			                        &data,
 			                        obstacles_from_derivedmesh_task_cb,
 			                        &settings);
+
+			MEM_freeN(mesh_distances);
+			MEM_freeN(mesh_tris);
 		}
-		/* free bvh tree */
-		free_bvhtree_from_mesh(&treeData);
 		dm->release(dm);
 
 		if (vert_vel) MEM_freeN(vert_vel);
@@ -1725,50 +2041,6 @@ static void emit_from_particles(
 	}
 }
 
-/* Calculate map of (minimum) distances to flow/obstacle surface. Distances outside mesh are positive, inside negative */
-static void update_mesh_distances(int index, float *mesh_distances, BVHTreeFromMesh *treeData, const float ray_start[3], float surface_thickness) {
-
-	float min_dist = 9999.f;
-
-	/* Raycasts in 26 directions (6 main axis + 12 quadrant diagonals (2D) + 8 octant diagonals (3D)) */
-	float ray_dirs[26][3] = { {  1.0f, 0.0f,  0.0f }, { 0.0f,  1.0f,  0.0f }, {  0.0f,  0.0f,  1.0f },
-							  { -1.0f, 0.0f,  0.0f }, { 0.0f, -1.0f,  0.0f }, {  0.0f,  0.0f, -1.0f },
-							  {  1.0f, 1.0f,  0.0f }, { 1.0f, -1.0f,  0.0f }, { -1.0f,  1.0f,  0.0f }, { -1.0f, -1.0f,  0.0f },
-							  {  1.0f, 0.0f,  1.0f }, { 1.0f,  0.0f, -1.0f }, { -1.0f,  0.0f,  1.0f }, { -1.0f,  0.0f, -1.0f },
-							  {  0.0f, 1.0f,  1.0f }, { 0.0f,  1.0f, -1.0f }, {  0.0f, -1.0f,  1.0f }, {  0.0f, -1.0f, -1.0f },
-							  {  1.0f, 1.0f,  1.0f }, { 1.0f, -1.0f,  1.0f }, { -1.0f,  1.0f,  1.0f }, { -1.0f, -1.0f,  1.0f },
-							  {  1.0f, 1.0f, -1.0f }, { 1.0f, -1.0f, -1.0f }, { -1.0f,  1.0f, -1.0f }, { -1.0f, -1.0f, -1.0f } };
-	size_t ray_cnt = sizeof ray_dirs / sizeof ray_dirs[0];
-
-	/* If stays true, a point is considered to be inside the mesh */
-	bool inside = true;
-
-	/* Check all ray directions */
-	for (int i = 0; i < ray_cnt; i++) {
-		BVHTreeRayHit hit_tree = {0};
-		hit_tree.index = -1;
-		hit_tree.dist = 9999;
-
-		normalize_v3(ray_dirs[i]);
-		BLI_bvhtree_ray_cast(treeData->tree, ray_start, ray_dirs[i], 0.0f, &hit_tree, treeData->raycast_callback, treeData);
-
-		/* Ray did not hit mesh. Current point definitely not inside mesh. */
-		if (hit_tree.index == -1) { inside = false; continue; }
-
-		/* Save new minimum hit dist */
-		min_dist = MIN2(min_dist, hit_tree.dist);
-
-		/* Ray and normal are in opposing directions. Current point definitely not inside mesh. */
-		if (dot_v3v3(ray_dirs[i], hit_tree.no) < 0) { inside = false; }
-	}
-
-	/* Levelset is negative inside mesh */
-	if (inside) min_dist *= (-1.0f);
-
-	/* Update mesh distance in map */
-	mesh_distances[index] = MIN2(mesh_distances[index], min_dist-surface_thickness);
-}
-
 static void sample_derivedmesh(
         SmokeFlowSettings *sfs,
         const MVert *mvert, const MLoop *mloop, const MLoopTri *mlooptri, const MLoopUV *mloopuv,
@@ -1954,9 +2226,6 @@ static void emit_from_derivedmesh_task_cb(
 						em->influence, em->velocity, index, data->sds->base_res, data->flow_center,
 						data->tree, ray_start, data->vert_vel, data->has_velocity, data->defgrp_index, data->dvert,
 						(float)lx, (float)ly, (float)lz);
-
-				/* Calculate levelset from meshes. Result in em->distances */
-				update_mesh_distances(index, em->distances, data->tree, ray_start, data->sfs->surface_distance);
 			}
 
 			/* take high res samples if required */
@@ -2073,6 +2342,14 @@ static void emit_from_derivedmesh(Object *flow_ob, SmokeDomainSettings *sds, Smo
 		clampBoundsInDomain(sds, em->min, em->max, NULL, NULL, (int)ceil(sfs->surface_distance), dt);
 		em_allocateData(em, sfs->flags & FLUID_FLOW_INITVELOCITY, hires_multiplier);
 
+		/* Calculate levelset from meshes. Result in em->distances */
+		if (em->distances) {
+			mesh_sdf_compute(mvert, mloop, mlooptri, dm->getNumLoopTri(dm), em->min, em->res, true, em->distances, NULL);
+			for (i = 0; i < em->total_cells; i++) {
+				em->distances[i] -= sfs->surface_distance;
+			}
+		}
+
 		/* setup loop bounds */
 		for (i = 0; i < 3; i++) {
 			min[i] = em->min[i] * hires_multiplier;
@@ -2872,6 +3149,16 @@ static void update_flowsfluids(
 //						}  // bigdensity
 					} // low res loop
 
+			/* tell the solver where smoke can appear, so it doesn't have to scan the domain for it */
+			if (sfs->behavior != FLUID_FLOW_BEHAVIOR_OUTFLOW) {
+				int region_min[3], region_max[3];
+				for (int i = 0; i < 3; i++) {
+					region_min[i] = em->min[i] - sds->res_min[i];
+					region_max[i] = em->max[i] - sds->res_min[i];
+				}
+				fluid_add_inflow_region(sds->fluid, region_min, region_max);
+			}
+
 			// free emission maps
 			em_freeData(em);
 
@@ -2994,14 +3281,101 @@ static void update_effectors(Scene *scene, Object *ob, SmokeDomainSettings *sds,
 	pdEndEffectors(&effectors);
 }
 
+typedef struct CreateLiquidMeshData {
+	SmokeDomainSettings *sds;
+	Object *ob;
+
+	MVert *mverts;
+	MPoly *mpolys;
+	MLoop *mloops;
+	short *normals;
+	const float *normals_fl;
+	const int *tris;
+	SmokeVertexVelocity *velarray;
+
+	float max_size;
+	float vel_mult;
+	short mp_mat_nr;
+	char mp_flag;
+} CreateLiquidMeshData;
+
+static void liquid_mesh_verts_task_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	CreateLiquidMeshData *data = userdata;
+	SmokeDomainSettings *sds = data->sds;
+	Object *ob = data->ob;
+	MVert *mv = &data->mverts[i];
+
+	// if reading raw data directly from manta, normalize now
+	if ((sds->cache_flag & FLUID_DOMAIN_BAKED_MESH) == 0)
+	{
+		// normalize to unit cube around 0
+		mv->co[0] -= ((float) sds->res[0]*sds->mesh_scale)*0.5f;
+		mv->co[1] -= ((float) sds->res[1]*sds->mesh_scale)*0.5f;
+		mv->co[2] -= ((float) sds->res[2]*sds->mesh_scale)*0.5f;
+		mv->co[0] *= sds->dx / sds->mesh_scale;
+		mv->co[1] *= sds->dx / sds->mesh_scale;
+		mv->co[2] *= sds->dx / sds->mesh_scale;
+	}
+
+	mv->co[0] *= data->max_size / fabsf(ob->size[0]);
+	mv->co[1] *= data->max_size / fabsf(ob->size[1]);
+	mv->co[2] *= data->max_size / fabsf(ob->size[2]);
+}
+
+static void liquid_mesh_normals_task_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	CreateLiquidMeshData *data = userdata;
+
+	normal_float_to_short_v3(&data->normals[i * 3], &data->normals_fl[i * 3]);
+}
+
+static void liquid_mesh_polys_task_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	CreateLiquidMeshData *data = userdata;
+	MPoly *mp = &data->mpolys[i];
+	MLoop *ml = &data->mloops[i * 3];
+
+	/* initialize from existing face */
+	mp->mat_nr = data->mp_mat_nr; // TODO (sebbas)
+	mp->flag =   data->mp_flag; // TODO (sebbas)
+
+	mp->loopstart = i * 3;
+	mp->totloop = 3;
+
+	ml[0].v = data->tris[i * 3];
+	ml[1].v = data->tris[i * 3 + 1];
+	ml[2].v = data->tris[i * 3 + 2];
+}
+
+static void liquid_mesh_vertvels_task_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	CreateLiquidMeshData *data = userdata;
+
+	mul_v3_fl(data->velarray[i].vel, data->vel_mult);
+}
+
 static DerivedMesh *createLiquidMesh(SmokeDomainSettings *sds, DerivedMesh *orgdm, Object* ob)
 {
 	DerivedMesh *dm;
 	MVert *mverts;
 	MPoly *mpolys;
 	MLoop *mloops;
-	short *normals, *no_s;
-	float no[3];
+	short *normals;
+	float *normals_fl;
+	int *tris;
 	float min[3];
 	float max[3];
 	float size[3];
@@ -3016,10 +3390,6 @@ static DerivedMesh *createLiquidMesh(SmokeDomainSettings *sds, DerivedMesh *orgd
 		mp_example = *mpoly;
 	}
 
-	const short mp_mat_nr = mp_example.mat_nr;
-	const char mp_flag    = mp_example.flag;
-
-	int i;
 	int num_verts, num_normals, num_faces;
 
 	if (!sds->fluid)
@@ -3039,13 +3409,13 @@ static DerivedMesh *createLiquidMesh(SmokeDomainSettings *sds, DerivedMesh *orgd
 		return NULL;
 
 	dm     = CDDM_new(num_verts, 0, 0, num_faces * 3, num_faces);
+	if (!dm)
+		return NULL;
+
 	mverts = CDDM_get_verts(dm);
 	mpolys = CDDM_get_polys(dm);
 	mloops = CDDM_get_loops(dm);
 
-	if (!dm)
-		return NULL;
-
 	// Get size (dimension) but considering scaling scaling
 	copy_v3_v3(cell_size_scaled, sds->cell_size);
 	mul_v3_v3(cell_size_scaled, ob->size);
@@ -3053,66 +3423,40 @@ static DerivedMesh *createLiquidMesh(SmokeDomainSettings *sds, DerivedMesh *orgd
 	VECMADD(max, sds->p0, cell_size_scaled, sds->res_max);
 	sub_v3_v3v3(size, max, min);
 
-	// Biggest dimension will be used for upscaling
-	float max_size = MAX3(size[0], size[1], size[2]);
+	CreateLiquidMeshData data = {
+		.sds = sds, .ob = ob,
+		.mverts = mverts, .mpolys = mpolys, .mloops = mloops,
+		.mp_mat_nr = mp_example.mat_nr, .mp_flag = mp_example.flag,
+	};
 
-	// Vertices
-	for (i = 0; i < num_verts; i++, mverts++)
-	{
-		// read raw data. is normalized cube around domain origin
-		mverts->co[0] = liquid_get_vertex_x_at(sds->fluid, i);
-		mverts->co[1] = liquid_get_vertex_y_at(sds->fluid, i);
-		mverts->co[2] = liquid_get_vertex_z_at(sds->fluid, i);
+	// Biggest dimension will be used for upscaling
+	data.max_size = MAX3(size[0], size[1], size[2]);
 
-		// if reading raw data directly from manta, normalize now
-		if ((sds->cache_flag & FLUID_DOMAIN_BAKED_MESH) == 0)
-		{
-			// normalize to unit cube around 0
-			mverts->co[0] -= ((float) sds->res[0]*sds->mesh_scale)*0.5f;
-			mverts->co[1] -= ((float) sds->res[1]*sds->mesh_scale)*0.5f;
-			mverts->co[2] -= ((float) sds->res[2]*sds->mesh_scale)*0.5f;
-			mverts->co[0] *= sds->dx / sds->mesh_scale;
-			mverts->co[1] *= sds->dx / sds->mesh_scale;
-			mverts->co[2] *= sds->dx / sds->mesh_scale;
-		}
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 1024;
 
-		mverts->co[0] *= max_size / fabsf(ob->size[0]);
-		mverts->co[1] *= max_size / fabsf(ob->size[1]);
-		mverts->co[2] *= max_size / fabsf(ob->size[2]);
-
-//		printf("mverts->co[0]: %f, mverts->co[1]: %f, mverts->co[2]: %f\n", mverts->co[0], mverts->co[1], mverts->co[2]);
-	}
+	// Vertices, raw data is copied straight into the vertex array and then normalized to a cube around domain origin
+	liquid_get_vertices(sds->fluid, mverts->co, num_verts, sizeof(MVert));
+	BLI_task_parallel_range(0, num_verts, &data, liquid_mesh_verts_task_cb, &settings);
 
 	// Normals
 	normals = MEM_callocN(sizeof(short) * num_normals * 3, "liquid_tmp_normals");
+	normals_fl = MEM_malloc_arrayN(num_normals, sizeof(float[3]), "liquid_tmp_normals_fl");
+	liquid_get_normals(sds->fluid, normals_fl, num_normals, sizeof(float[3]));
 
-	for (i = 0, no_s = normals; i < num_normals; no_s += 3, i++)
-	{
-		no[0] = liquid_get_normal_x_at(sds->fluid, i);
-		no[1] = liquid_get_normal_y_at(sds->fluid, i);
-		no[2] = liquid_get_normal_z_at(sds->fluid, i);
-
-		normal_float_to_short_v3(no_s, no);
-
-//		printf("no_s[0]: %d, no_s[1]: %d, no_s[2]: %d\n", no_s[0], no_s[1], no_s[2]);
-	}
+	data.normals = normals;
+	data.normals_fl = normals_fl;
+	BLI_task_parallel_range(0, num_normals, &data, liquid_mesh_normals_task_cb, &settings);
+	MEM_freeN(normals_fl);
 
 	// Triangles
-	for (i = 0; i < num_faces; i++, mpolys++, mloops += 3)
-	{
-		/* initialize from existing face */
-		mpolys->mat_nr = mp_mat_nr; // TODO (sebbas)
-		mpolys->flag =   mp_flag; // TODO (sebbas)
-
-		mpolys->loopstart = i * 3;
-		mpolys->totloop = 3;
+	tris = MEM_malloc_arrayN(num_faces, sizeof(int[3]), "liquid_tmp_tris");
+	liquid_get_triangles(sds->fluid, tris, num_faces, sizeof(int[3]));
 
-		mloops[0].v = liquid_get_triangle_x_at(sds->fluid, i);
-		mloops[1].v = liquid_get_triangle_y_at(sds->fluid, i);
-		mloops[2].v = liquid_get_triangle_z_at(sds->fluid, i);
-
-//		printf("mloops[0].v: %d, mloops[1].v: %d, mloops[2].v: %d\n", mloops[0].v, mloops[1].v, mloops[2].v);
-	}
+	data.tris = tris;
+	BLI_task_parallel_range(0, num_faces, &data, liquid_mesh_polys_task_cb, &settings);
+	MEM_freeN(tris);
 
 	if (!num_normals)
 		CDDM_calc_normals(dm);
@@ -3131,19 +3475,12 @@ static DerivedMesh *createLiquidMesh(SmokeDomainSettings *sds, DerivedMesh *orgd
 	sds->mesh_velocities = MEM_calloc_arrayN(dm->getNumVerts(dm), sizeof(SmokeVertexVelocity), "Fluidmesh_vertvelocities");
 	sds->totvert = dm->getNumVerts(dm);
 
-	SmokeVertexVelocity *velarray = NULL;
-	velarray = sds->mesh_velocities;
-
 	float time_mult = 25.f * DT_DEFAULT;
 
-	for (i = 0; i < num_verts; i++, mverts++)
-	{
-		velarray[i].vel[0] = liquid_get_vertvel_x_at(sds->fluid, i) * (sds->dx / time_mult);
-		velarray[i].vel[1] = liquid_get_vertvel_y_at(sds->fluid, i) * (sds->dx / time_mult);
-		velarray[i].vel[2] = liquid_get_vertvel_z_at(sds->fluid, i) * (sds->dx / time_mult);
-
-//		printf("velarray[%d].vel[0]: %f, velarray[%d].vel[1]: %f, velarray[%d].vel[2]: %f\n", i, velarray[i].vel[0], i, velarray[i].vel[1], i, velarray[i].vel[2]);
-	}
+	data.velarray = sds->mesh_velocities;
+	data.vel_mult = sds->dx / time_mult;
+	num_verts = liquid_get_vertvels(sds->fluid, data.velarray->vel, num_verts, sizeof(SmokeVertexVelocity));
+	BLI_task_parallel_range(0, num_verts, &data, liquid_mesh_vertvels_task_cb, &settings);
 
 	return dm;
 }
@@ -3280,7 +3617,10 @@ static void smoke_step(
 
 		if (sds->total_cells > 1) {
 			update_effectors(scene, ob, sds, sdt); // DG TODO? problem --> uses forces instead of velocity, need to check how they need to be changed with variable dt
-			fluid_bake_data(sds->fluid, smd, frame);
+			/* a failed step leaves the grids partly updated, don't keep stepping on them */
+			if (!fluid_bake_data(sds->fluid, smd, frame)) {
+				break;
+			}
 		}
 	}
 	if (sds->type == FLUID_DOMAIN_TYPE_GAS) {
@@ -3523,112 +3863,130 @@ struct DerivedMesh *smokeModifier_do(SmokeModifierData *smd, Scene *scene, Objec
 	}
 }
 
-static float calc_voxel_transp(float *result, float *input, int res[3], int *pixel, float *tRay, float correct)
+/* Transmittance from the lamp is propagated outwards in shells of constant chebyshev distance
+ * to the lamp cell. Every cell takes one step towards the lamp along its dominant axis and
+ * interpolates the transmittance of the previous shell there, so the cells of a shell don't
+ * depend on each other and each shell is filled in parallel. */
+
+typedef struct TransparencyData {
+	const float *density;
+	float *shadow;
+	const int *res;
+	int light_cell[3];
+	int shell;
+	float correct;
+} TransparencyData;
+
+static float transparency_upstream(const TransparencyData *data, const int cell[3])
 {
-	const size_t index = fluid_get_index(pixel[0], res[0], pixel[1], res[1], pixel[2]);
-
-	// T_ray *= T_vox
-	*tRay *= expf(input[index] * correct);
+	const int *res = data->res;
+	const int shell = data->shell;
+	int d[3], base[3], axis, a1, a2, i, j, k;
+	float frac[3], t = 0.0f;
 
-	if (result[index] < 0.0f)
-	{
-		result[index] = *tRay;
+	if (shell == 0) {
+		return 1.0f;
 	}
 
-	return *tRay;
-}
+	for (i = 0; i < 3; i++) {
+		d[i] = data->light_cell[i] - cell[i];
+	}
+	axis = (abs(d[0]) == shell) ? 0 : ((abs(d[1]) == shell) ? 1 : 2);
 
-static void bresenham_linie_3D(int x1, int y1, int z1, int x2, int y2, int z2, float *tRay, bresenham_callback cb, float *result, float *input, int res[3], float correct)
-{
-	int dx, dy, dz, i, l, m, n, x_inc, y_inc, z_inc, err_1, err_2, dx2, dy2, dz2;
-	int pixel[3];
-
-	pixel[0] = x1;
-	pixel[1] = y1;
-	pixel[2] = z1;
-
-	dx = x2 - x1;
-	dy = y2 - y1;
-	dz = z2 - z1;
-
-	x_inc = (dx < 0) ? -1 : 1;
-	l = abs(dx);
-	y_inc = (dy < 0) ? -1 : 1;
-	m = abs(dy);
-	z_inc = (dz < 0) ? -1 : 1;
-	n = abs(dz);
-	dx2 = l << 1;
-	dy2 = m << 1;
-	dz2 = n << 1;
-
-	if ((l >= m) && (l >= n)) {
-		err_1 = dy2 - l;
-		err_2 = dz2 - l;
-		for (i = 0; i < l; i++) {
-			if (cb(result, input, res, pixel, tRay, correct) <= FLT_EPSILON)
-				break;
-			if (err_1 > 0) {
-				pixel[1] += y_inc;
-				err_1 -= dx2;
-			}
-			if (err_2 > 0) {
-				pixel[2] += z_inc;
-				err_2 -= dx2;
-			}
-			err_1 += dy2;
-			err_2 += dz2;
-			pixel[0] += x_inc;
+	/* point one cell closer to the lamp along the ray, lies in the previous shell */
+	for (i = 0; i < 3; i++) {
+		if (i == axis) {
+			base[i] = cell[i] + ((d[i] < 0) ? -1 : 1);
+			frac[i] = 0.0f;
+		}
+		else {
+			const float p = (float)cell[i] + (float)d[i] / (float)shell;
+			base[i] = (int)floorf(p);
+			frac[i] = p - (float)base[i];
 		}
 	}
-	else if ((m >= l) && (m >= n)) {
-		err_1 = dx2 - m;
-		err_2 = dz2 - m;
-		for (i = 0; i < m; i++) {
-			if (cb(result, input, res, pixel, tRay, correct) <= FLT_EPSILON)
-				break;
-			if (err_1 > 0) {
-				pixel[0] += x_inc;
-				err_1 -= dy2;
+
+	/* bilinear interpolation across the ray, light enters unattenuated from outside the domain */
+	a1 = (axis + 1) % 3;
+	a2 = (axis + 2) % 3;
+	for (j = 0; j < 2; j++) {
+		for (k = 0; k < 2; k++) {
+			const float w = (j ? frac[a1] : 1.0f - frac[a1]) * (k ? frac[a2] : 1.0f - frac[a2]);
+			int c[3];
+
+			if (w <= 0.0f) {
+				continue;
 			}
-			if (err_2 > 0) {
-				pixel[2] += z_inc;
-				err_2 -= dy2;
+			copy_v3_v3_int(c, base);
+			c[a1] += j;
+			c[a2] += k;
+
+			if (c[0] < 0 || c[0] >= res[0] || c[1] < 0 || c[1] >= res[1] || c[2] < 0 || c[2] >= res[2]) {
+				t += w;
+			}
+			else {
+				t += w * data->shadow[fluid_get_index(c[0], res[0], c[1], res[1], c[2])];
 			}
-			err_1 += dx2;
-			err_2 += dz2;
-			pixel[1] += y_inc;
 		}
 	}
-	else {
-		err_1 = dy2 - n;
-		err_2 = dx2 - n;
-		for (i = 0; i < n; i++) {
-			if (cb(result, input, res, pixel, tRay, correct) <= FLT_EPSILON)
-				break;
-			if (err_1 > 0) {
-				pixel[1] += y_inc;
-				err_1 -= dz2;
-			}
-			if (err_2 > 0) {
-				pixel[0] += x_inc;
-				err_2 -= dz2;
+
+	return min_ff(t, 1.0f);
+}
+
+static void smoke_calc_transparency_task_cb(
+        void *__restrict userdata,
+        const int z,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	TransparencyData *data = userdata;
+	const int *res = data->res;
+	const int *lc = data->light_cell;
+	const int shell = data->shell;
+	const int dz = abs(z - lc[2]);
+
+	if (dz > shell) {
+		return;
+	}
+
+	for (int y = 0; y < res[1]; y++) {
+		const int dy = abs(y - lc[1]);
+		int x_min, x_max, x_step;
+
+		if (dy > shell) {
+			continue;
+		}
+		/* whole row on the top/bottom faces of the shell, only the two side cells otherwise */
+		if (dz == shell || dy == shell) {
+			x_min = max_ii(lc[0] - shell, 0);
+			x_max = min_ii(lc[0] + shell, res[0] - 1);
+			x_step = 1;
+		}
+		else {
+			x_min = lc[0] - shell;
+			x_max = lc[0] + shell;
+			x_step = max_ii(2 * shell, 1);
+		}
+
+		for (int x = x_min; x <= x_max; x += x_step) {
+			int cell[3] = {x, y, z};
+			size_t index;
+
+			if (x < 0 || x >= res[0]) {
+				continue;
 			}
-			err_1 += dy2;
-			err_2 += dx2;
-			pixel[2] += z_inc;
+			index = fluid_get_index(x, res[0], y, res[1], z);
+
+			// convention -> from a RGBA float array, use G value for tRay
+			data->shadow[index] = transparency_upstream(data, cell) * expf(data->density[index] * data->correct);
 		}
 	}
-	cb(result, input, res, pixel, tRay, correct);
 }
 
 static void smoke_calc_transparency(SmokeDomainSettings *sds, Scene *scene)
 {
-	float bv[6] = {0};
 	float light[3];
-	int a, z, slabsize = sds->res[0] * sds->res[1], size = sds->res[0] * sds->res[1] * sds->res[2];
-	float *density = smoke_get_density(sds->fluid);
-	float *shadow = smoke_get_shadow(sds->fluid);
-	float correct = -7.0f * sds->dx;
+	int shell_min = 0, shell_max = 0;
+	TransparencyData data;
 
 	if (!get_lamp(scene, light)) return;
 
@@ -3638,58 +3996,30 @@ static void smoke_calc_transparency(SmokeDomainSettings *sds, Scene *scene)
 	light[1] = (light[1] - sds->p0[1]) / sds->cell_size[1] - 0.5f - (float)sds->res_min[1];
 	light[2] = (light[2] - sds->p0[2]) / sds->cell_size[2] - 0.5f - (float)sds->res_min[2];
 
-	for (a = 0; a < size; a++)
-		shadow[a] = -1.0f;
-
-	/* calculate domain bounds in sim cell space */
-	// 0,2,4 = 0.0f
-	bv[1] = (float)sds->res[0]; // x
-	bv[3] = (float)sds->res[1]; // y
-	bv[5] = (float)sds->res[2]; // z
-
-	for (z = 0; z < sds->res[2]; z++)
-	{
-		size_t index = z * slabsize;
-		int x, y;
+	data.density = smoke_get_density(sds->fluid);
+	data.shadow = smoke_get_shadow(sds->fluid);
+	data.res = sds->res;
+	data.correct = -7.0f * sds->dx;
 
-		for (y = 0; y < sds->res[1]; y++)
-			for (x = 0; x < sds->res[0]; x++, index++)
-			{
-				float voxelCenter[3];
-				float pos[3];
-				int cell[3];
-				float tRay = 1.0;
-
-				if (shadow[index] >= 0.0f)
-					continue;
-				voxelCenter[0] = (float)x;
-				voxelCenter[1] = (float)y;
-				voxelCenter[2] = (float)z;
-
-				// get starting cell (light pos)
-				if (BLI_bvhtree_bb_raycast(bv, light, voxelCenter, pos) > FLT_EPSILON)
-				{
-					// we're ouside -> use point on side of domain
-					cell[0] = (int)floor(pos[0]);
-					cell[1] = (int)floor(pos[1]);
-					cell[2] = (int)floor(pos[2]);
-				}
-				else {
-					// we're inside -> use light itself
-					cell[0] = (int)floor(light[0]);
-					cell[1] = (int)floor(light[1]);
-					cell[2] = (int)floor(light[2]);
-				}
-				/* clamp within grid bounds */
-				CLAMP(cell[0], 0, sds->res[0] - 1);
-				CLAMP(cell[1], 0, sds->res[1] - 1);
-				CLAMP(cell[2], 0, sds->res[2] - 1);
+	/* range of shells that intersect the domain */
+	for (int i = 0; i < 3; i++) {
+		const int lc = (int)floorf(light[i]);
+		const int dist_min = (lc < 0) ? -lc : max_ii(lc - (sds->res[i] - 1), 0);
+		const int dist_max = max_ii(abs(lc), abs(lc - (sds->res[i] - 1)));
 
-				bresenham_linie_3D(cell[0], cell[1], cell[2], x, y, z, &tRay, calc_voxel_transp, shadow, density, sds->res, correct);
+		data.light_cell[i] = lc;
+		shell_min = max_ii(shell_min, dist_min);
+		shell_max = max_ii(shell_max, dist_max);
+	}
 
-				// convention -> from a RGBA float array, use G value for tRay
-				shadow[index] = tRay;
-			}
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	for (data.shell = shell_min; data.shell <= shell_max; data.shell++) {
+		BLI_task_parallel_range(0, sds->res[2],
+		                        &data,
+		                        smoke_calc_transparency_task_cb,
+		                        &settings);
 	}
 }
 
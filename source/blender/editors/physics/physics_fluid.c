@@ -1308,6 +1308,14 @@ static void fluid_manta_bake_endjob(void *customdata)
 	FluidMantaflowJob *job = customdata;
 	SmokeDomainSettings *sds = job->smd->domain;
 
+#ifdef WITH_MANTA
+	/* Cache files of the last frames might still be written in the background */
+	fluid_flush_writes(sds->fluid);
+	if (G.debug & G_DEBUG_JOBS) {
+		fluid_stop_profile(sds->fluid);
+	}
+#endif
+
 	G.is_rendering = false;
 	BKE_spacedata_draw_locks(false);
 
@@ -1416,6 +1424,16 @@ static void fluid_manta_bake_startjob(void *customdata, short *stop, short *do_u
 	}
 	DAG_id_tag_update(&job->ob->id, OB_RECALC_DATA);
 
+#ifdef WITH_MANTA
+	/* Write a Chrome trace of all plugin calls and counters next to the cache files */
+	if (G.debug & G_DEBUG_JOBS) {
+		char profileName[FILE_MAXFILE];
+		BLI_snprintf(profileName, sizeof(profileName), "profile_%s.json", job->type + strlen("MANTA_OT_"));
+		BLI_path_join(tmpDir, sizeof(tmpDir), sds->cache_directory, profileName, NULL);
+		fluid_start_profile(sds->fluid, tmpDir, 1);
+	}
+#endif
+
 	fluid_manta_bake_sequence(job);
 
 	if (do_update)
@@ -1518,6 +1536,11 @@ static void fluid_manta_free_startjob(void *customdata, short *stop, short *do_u
 	G.is_rendering = true;
 	BKE_spacedata_draw_locks(true);
 
+#ifdef WITH_MANTA
+	/* Pending cache writes would otherwise recreate files after deletion */
+	fluid_flush_writes(sds->fluid);
+#endif
+
 	if (STREQ(job->type, "MANTA_OT_free_data"))
 	{
 		sds->cache_flag &= ~(FLUID_DOMAIN_BAKING_DATA|FLUID_DOMAIN_BAKED_DATA|
@@ -67,6 +67,7 @@ enum {
 	FLUID_DOMAIN_FILE_RAW = (1 << 2),
 	FLUID_DOMAIN_FILE_OBJECT = (1 << 3),
 	FLUID_DOMAIN_FILE_BIN_OBJECT = (1 << 4),
+	FLUID_DOMAIN_FILE_PLAYBACK = (1 << 5),
 };
 
 /* slice method */
@@ -440,6 +440,12 @@ static EnumPropertyItem *rna_Smoke_cachetype_volume_itemf(
 	tmp.description = "Raw file format";
 	RNA_enum_item_add(&item, &totitem, &tmp);
 
+	tmp.value = FLUID_DOMAIN_FILE_PLAYBACK;
+	tmp.identifier = "PLAYBACK";
+	tmp.name = "Playback Cache";
+	tmp.description = "Uncompressed file format that is memory-mapped for fast timeline scrubbing, needs more disk space";
+	RNA_enum_item_add(&item, &totitem, &tmp);
+
 	RNA_enum_item_end(&item, &totitem);
 	*r_free = true;
 